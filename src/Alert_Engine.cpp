@@ -0,0 +1,454 @@
+/**
+ * @file Alert_Engine.cpp
+ * @brief Implementation of the sensor alert rules
+ */
+
+#include "Alert_Engine.h"
+#include "Sensor_History.h"
+#include "Log_Ring.h"
+#include <algorithm>
+#include <math.h>
+
+Alert_Engine::Alert_Engine()
+  : _count(0), _pendingCount(0), _linear(false), _logging(true), _qHead(0), _qCount(0), _cooldownMs(0) {
+  memset(_rules, 0, sizeof(_rules));
+  memset(_levels, 0, sizeof(_levels));
+  memset(_start, 0, sizeof(_start));
+  for (uint8_t g = 0; g < SIGNAL_COUNT; g++) _signal[g] = NAN;
+  memset(_lastDistinct, 0, sizeof(_lastDistinct));
+  memset(_lastChangeMs, 0, sizeof(_lastChangeMs));
+  memset(_lastMs, 0, sizeof(_lastMs));
+  resetStats();
+}
+
+void Alert_Engine::resetStats() {
+  _evaluations = 0;
+  _cycles = 0;
+  _maxCycles = 0;
+  _visited = 0;
+  _events = 0;
+  _suppressed = 0;
+  _dropped = 0;
+}
+
+const char* Alert_Engine::stateName(State s) {
+  switch (s) {
+    case STATE_IDLE:    return "idle";
+    case STATE_PENDING: return "pending";
+    case STATE_ACTIVE:  return "active";
+    default:            return "?";
+  }
+}
+
+const char* Alert_Engine::signalName(uint8_t signal) {
+  switch (signal) {
+    case ALERT_VALUE: return "value";
+    case ALERT_RATE:  return "rate";
+    case ALERT_STUCK: return "stuck";
+    default:          return "?";
+  }
+}
+
+// ============================================================================
+// RULE TEXT
+// ============================================================================
+
+/**
+ * @brief Cursor over one rule's text
+ */
+struct RuleParser {
+  const char* p;
+  const char* end;
+  char word[16];
+
+  bool next() {
+    while (p < end && isspace((unsigned char)*p)) p++;
+    if (p >= end) return false;
+    uint8_t n = 0;
+    while (p < end && !isspace((unsigned char)*p)) {
+      if (n < sizeof(word) - 1) word[n++] = *p;
+      p++;
+    }
+    word[n] = '\0';
+    return true;
+  }
+
+  bool is(const char* s) const { return strcasecmp(word, s) == 0; }
+
+  bool number(float& out) {
+    if (!next()) return false;
+    char* e;
+    out = strtof(word, &e);
+    return e != word && *e == '\0';
+  }
+};
+
+/**
+ * @brief Parse one rule
+ * @return nullptr if valid, otherwise the reason
+ */
+static const char* parseRule(RuleParser& r, uint8_t& channel, uint8_t& signal, bool& above,
+                             float& level, float& hyst, uint32_t& forMs, uint8_t& actions) {
+  signal = ALERT_VALUE;
+  hyst = 0;
+  forMs = 0;
+  actions = 0;
+
+  r.next();
+  for (channel = 0; channel < SENSOR_CHANNELS; channel++) {
+    if (r.is(Sensor_Pipeline::channelName(channel))) break;
+  }
+  if (channel == SENSOR_CHANNELS) return "unknown channel";
+
+  if (!r.next()) return "missing condition";
+  if (r.is("rate")) {
+    signal = ALERT_RATE;
+    if (!r.next()) return "missing operator";
+  } else if (r.is("stuck")) {
+    signal = ALERT_STUCK;
+    above = true;
+    if (!r.number(level) || level <= 0) return "stuck needs seconds";
+  }
+  if (signal != ALERT_STUCK) {
+    if (r.is(">")) above = true;
+    else if (r.is("<")) above = false;
+    else return "operator must be > or <";
+    if (!r.number(level)) return "level must be a number";
+  }
+
+  while (r.next()) {
+    float v;
+    if (r.is("hyst")) {
+      if (!r.number(v) || v < 0) return "hyst needs a value >= 0";
+      hyst = v;
+    } else if (r.is("for")) {
+      if (!r.number(v) || v < 0 || v > 86400) return "for needs 0-86400 seconds";
+      forMs = (uint32_t)(v * 1000);
+    } else if (r.is("sms")) {
+      actions |= ALERT_SMS;
+    } else if (r.is("email")) {
+      actions |= ALERT_EMAIL;
+    } else if (r.is("post")) {
+      actions |= ALERT_POST;
+    } else if (!r.is("log")) {
+      return "unknown option";
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Hash of everything that defines a rule (not its state)
+ */
+static uint32_t ruleKey(const Alert_Engine::Rule& r) {
+  uint32_t words[5] = { (uint32_t)r.channel | (uint32_t)r.signal << 8 | (uint32_t)r.above << 16 |
+                        (uint32_t)r.actions << 24, 0, 0, r.forMs, 0 };
+  memcpy(&words[1], &r.level, sizeof(float));
+  memcpy(&words[2], &r.clear, sizeof(float));
+  uint32_t h = 2166136261u;
+  for (uint32_t w : words) h = (h ^ w) * 16777619u;
+  return h;
+}
+
+bool Alert_Engine::compile(const char* text, char* err, size_t errLen) {
+  // Last notification of each rule, carried over to the same rule in the new text
+  struct Carry {
+    uint32_t key;
+    uint32_t notifiedMs;
+  };
+  static Carry carry[MAX_RULES];
+  uint8_t carried = 0;
+
+  // Pass 0 validates, pass 1 replaces the rules
+  for (uint8_t pass = 0; pass < 2; pass++) {
+    if (pass) {
+      for (uint8_t i = 0; i < _count; i++) {
+        if (_rules[i].notifiedMs) carry[carried++] = { ruleKey(_rules[i]), _rules[i].notifiedMs };
+      }
+      clearRules();
+    }
+    uint8_t n = 0;
+    const char* p = text ? text : "";
+    while (*p) {
+      const char* end = p;
+      while (*end && *end != ';' && *end != '\n') end++;
+
+      RuleParser r = { p, end, "" };
+      RuleParser probe = r;
+      if (probe.next()) {
+        uint8_t ch, sig, actions;
+        bool above = true;
+        float level, hyst;
+        uint32_t forMs;
+        const char* why = parseRule(r, ch, sig, above, level, hyst, forMs, actions);
+        n++;
+        if (!why && n > MAX_RULES) why = "too many rules";
+        if (why) {
+          snprintf(err, errLen, "rule %u: %s", n, why);
+          return false;
+        }
+        if (pass) addRule(ch, sig, above, level, hyst, forMs, actions);
+      }
+      p = *end ? end + 1 : end;
+    }
+  }
+  build();
+
+  // An unchanged rule stays in its cooldown: a condition that is still
+  // present is not notified again just because the rules were saved
+  for (uint8_t i = 0; i < _count; i++) {
+    uint32_t key = ruleKey(_rules[i]);
+    for (uint8_t c = 0; c < carried; c++) {
+      if (carry[c].notifiedMs && carry[c].key == key) {
+        _rules[i].notifiedMs = carry[c].notifiedMs;
+        carry[c].notifiedMs = 0;       // One new rule per old one
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+void Alert_Engine::describe(uint8_t i, char* buf, size_t len) const {
+  const Rule& r = _rules[i];
+  float hyst = fabsf(r.level - r.clear);
+  int n;
+  if (r.signal == ALERT_STUCK) {
+    n = snprintf(buf, len, "%s stuck %g", Sensor_Pipeline::channelName(r.channel), r.level);
+  } else {
+    n = snprintf(buf, len, "%s%s %c %g", Sensor_Pipeline::channelName(r.channel),
+                 r.signal == ALERT_RATE ? " rate" : "", r.above ? '>' : '<', r.level);
+    if (hyst > 0 && n < (int)len) n += snprintf(buf + n, len - n, " hyst %g", hyst);
+  }
+  if (r.forMs && n < (int)len) n += snprintf(buf + n, len - n, " for %g", r.forMs / 1000.0f);
+  if ((r.actions & ALERT_SMS) && n < (int)len) n += snprintf(buf + n, len - n, " sms");
+  if ((r.actions & ALERT_EMAIL) && n < (int)len) n += snprintf(buf + n, len - n, " email");
+  if ((r.actions & ALERT_POST) && n < (int)len) n += snprintf(buf + n, len - n, " post");
+}
+
+// ============================================================================
+// TABLE
+// ============================================================================
+
+void Alert_Engine::clearRules() {
+  _count = 0;
+  _pendingCount = 0;
+  _qCount = 0;
+  memset(_start, 0, sizeof(_start));
+}
+
+bool Alert_Engine::addRule(uint8_t channel, uint8_t signal, bool above, float level, float hyst,
+                           uint32_t forMs, uint8_t actions) {
+  if (_count >= MAX_RULES || channel >= SENSOR_CHANNELS || signal >= ALERT_SIGNALS) return false;
+  Rule& r = _rules[_count++];
+  memset(&r, 0, sizeof(r));
+  r.channel = channel;
+  r.signal = signal;
+  r.above = above;
+  r.level = level;
+  r.clear = above ? level - hyst : level + hyst;
+  r.forMs = forMs;
+  r.actions = actions;
+  r.state = STATE_IDLE;
+  return true;
+}
+
+void Alert_Engine::build() {
+  // Counting sort by signal, then sort each signal's levels
+  uint16_t counts[SIGNAL_COUNT + 1] = { 0 };
+  for (uint8_t i = 0; i < _count; i++) counts[_rules[i].channel * ALERT_SIGNALS + _rules[i].signal] += 2;
+  _start[0] = 0;
+  for (uint8_t g = 0; g < SIGNAL_COUNT; g++) _start[g + 1] = _start[g] + counts[g];
+
+  uint16_t fill[SIGNAL_COUNT];
+  memcpy(fill, _start, sizeof(fill));
+  for (uint8_t i = 0; i < _count; i++) {
+    const Rule& r = _rules[i];
+    uint8_t g = r.channel * ALERT_SIGNALS + r.signal;
+    _levels[fill[g]++] = { r.level, i };
+    _levels[fill[g]++] = { r.clear, i };
+  }
+  for (uint8_t g = 0; g < SIGNAL_COUNT; g++) {
+    std::sort(_levels + _start[g], _levels + _start[g + 1],
+              [](const Level& a, const Level& b) { return a.value < b.value; });
+  }
+
+  // Re-evaluate everything against the next sample, from IDLE
+  for (uint8_t g = 0; g < SIGNAL_COUNT; g++) _signal[g] = NAN;
+  for (uint8_t i = 0; i < _count; i++) {
+    _rules[i].state = STATE_IDLE;
+    _rules[i].sinceMs = 0;
+    _rules[i].notifiedMs = 0;
+  }
+  _pendingCount = 0;
+}
+
+// ============================================================================
+// EVALUATION
+// ============================================================================
+
+void Alert_Engine::setPending(uint8_t i, bool pending) {
+  if (pending) {
+    _pending[_pendingCount++] = i;
+    return;
+  }
+  for (uint8_t k = 0; k < _pendingCount; k++) {
+    if (_pending[k] == i) {
+      _pending[k] = _pending[--_pendingCount];
+      return;
+    }
+  }
+}
+
+void Alert_Engine::emit(uint8_t i, bool raised, float x, uint32_t ms) {
+  Rule& r = _rules[i];
+  r.value = x;
+  _events++;
+  if (raised) r.raised++;
+
+  if (_logging) {
+    char text[64];
+    describe(i, text, sizeof(text));
+    if (raised) LOG_W(LOG_ALERT, "Rule %u raised (%s) at %d/100", i + 1, text, (int)lroundf(x * 100));
+    else LOG_I(LOG_ALERT, "Rule %u cleared (%s)", i + 1, text);
+  }
+
+  if (!r.actions) return;
+  if (raised) {
+    if (r.notifiedMs && ms - r.notifiedMs < _cooldownMs) {
+      _suppressed++;
+      return;
+    }
+    r.notifiedMs = ms;
+  } else if (!r.notifiedMs) {
+    return;                            // Raise was not notified either
+  }
+  if (_qCount == QUEUE_LEN) {
+    _dropped++;
+    return;
+  }
+  _queue[(_qHead + _qCount++) % QUEUE_LEN] = { i, raised, x, ms };
+}
+
+void Alert_Engine::visit(uint8_t i, float x, uint32_t ms) {
+  Rule& r = _rules[i];
+  bool holds = r.above ? x > r.level : x < r.level;
+
+  switch (r.state) {
+    case STATE_IDLE:
+      if (!holds) return;
+      r.sinceMs = ms;
+      if (r.forMs) {
+        r.state = STATE_PENDING;
+        setPending(i, true);
+      } else {
+        r.state = STATE_ACTIVE;
+        emit(i, true, x, ms);
+      }
+      return;
+
+    case STATE_PENDING:
+      if (holds) return;
+      r.state = STATE_IDLE;
+      setPending(i, false);
+      return;
+
+    case STATE_ACTIVE:
+      if (r.above ? x < r.clear : x > r.clear) {
+        r.state = STATE_IDLE;
+        r.sinceMs = ms;
+        emit(i, false, x, ms);
+      }
+      return;
+  }
+}
+
+void Alert_Engine::evaluate(const Sensor_Sample& s) {
+  uint32_t c0 = ESP.getCycleCount();
+  uint32_t visited = 0;
+  uint32_t ms = s.ms;
+
+  for (uint8_t ch = 0; ch < SENSOR_CHANNELS; ch++) {
+    if (!s.has(ch)) continue;
+    float v = s.value[ch];
+    float* sig = &_signal[ch * ALERT_SIGNALS];
+    float next[ALERT_SIGNALS];
+
+    // Value, smoothed rate (per minute) and time since the last change
+    bool first = isnan(sig[ALERT_VALUE]);
+    next[ALERT_VALUE] = v;
+    if (first) {
+      next[ALERT_RATE] = 0;
+      _lastDistinct[ch] = v;
+      _lastChangeMs[ch] = ms;
+    } else {
+      uint32_t dt = ms - _lastMs[ch];
+      float inst = dt ? (v - sig[ALERT_VALUE]) * 60000.0f / dt : 0;
+      next[ALERT_RATE] = sig[ALERT_RATE] + (inst - sig[ALERT_RATE]) * dt / (RATE_TAU_MS + dt);
+      if (fabsf(v - _lastDistinct[ch]) * Sensor_History::scale(ch) >= 0.5f) {
+        _lastDistinct[ch] = v;
+        _lastChangeMs[ch] = ms;
+      }
+    }
+    next[ALERT_STUCK] = (ms - _lastChangeMs[ch]) / 1000.0f;
+    _lastMs[ch] = ms;
+
+    for (uint8_t k = 0; k < ALERT_SIGNALS; k++) {
+      uint8_t g = ch * ALERT_SIGNALS + k;
+      float a = sig[k], b = next[k];
+      sig[k] = b;
+      const Level* lo = _levels + _start[g];
+      const Level* hi = _levels + _start[g + 1];
+      if (lo == hi || _linear) continue;
+
+      if (!first) {
+        // Only rules with a level between the old and new value can change
+        float from = min(a, b), to = max(a, b);
+        lo = std::lower_bound(lo, hi, from, [](const Level& l, float x) { return l.value < x; });
+        hi = std::upper_bound(lo, hi, to, [](float x, const Level& l) { return x < l.value; });
+      }
+      for (const Level* l = lo; l < hi; l++) {
+        visit(l->rule, b, ms);
+        visited++;
+      }
+    }
+
+    if (_linear) {
+      for (uint8_t i = 0; i < _count; i++) {
+        if (_rules[i].channel != ch) continue;
+        visit(i, sig[_rules[i].signal], ms);
+        visited++;
+      }
+    }
+  }
+
+  // Rules waiting for their minimum duration
+  for (uint8_t k = 0; k < _pendingCount;) {
+    uint8_t i = _pending[k];
+    Rule& r = _rules[i];
+    if (ms - r.sinceMs >= r.forMs) {
+      float x = _signal[r.channel * ALERT_SIGNALS + r.signal];
+      r.state = STATE_ACTIVE;
+      r.sinceMs = ms;
+      _pending[k] = _pending[--_pendingCount];
+      emit(i, true, x, ms);
+      continue;
+    }
+    k++;
+  }
+  visited += _pendingCount;
+
+  uint32_t cycles = ESP.getCycleCount() - c0;
+  _evaluations++;
+  _cycles += cycles;
+  _visited += visited;
+  if (cycles > _maxCycles) _maxCycles = cycles;
+}
+
+bool Alert_Engine::pop(Event& e) {
+  if (!_qCount) return false;
+  e = _queue[_qHead];
+  _qHead = (_qHead + 1) % QUEUE_LEN;
+  _qCount--;
+  return true;
+}
@@ -0,0 +1,223 @@
+/**
+ * @file Alert_Engine.h
+ * @brief Sensor alert rules compiled into a per-signal evaluation table
+ * @version 1.0.0
+ *
+ * @details
+ * Rules are written as text (stored in the configuration), one per line
+ * or separated by ';':
+ *
+ *   temperature > 30 hyst 0.5 for 60 sms email
+ *   humidity < 25 for 300 email
+ *   temperature rate > 2 for 30 sms       (units per minute)
+ *   light stuck 900 email                 (seconds without a change)
+ *   humidity > 80 for 600 post            (HTTP POST over the uplink)
+ *
+ *   <channel> [rate|stuck] <op> <level> [hyst <delta>] [for <seconds>] [sms] [email] [post]
+ *
+ * Channels are temperature, humidity and light. Each channel feeds three
+ * signals: its value, its rate of change (per minute, smoothed over
+ * RATE_TAU_MS) and stuck time (seconds since the value last changed by a
+ * fixed-point step). "stuck" implies '>'.
+ *
+ * A rule is PENDING while its condition holds and ACTIVE once it held for
+ * the minimum duration ("for"); that raises an event. It clears when the
+ * signal goes back past the level by the hysteresis ("hyst"): below
+ * level - hyst for '>' rules, above level + hyst for '<' rules.
+ *
+ * Compiled table: per signal, the levels of all its rules (trigger level
+ * and clear level) are sorted. When a signal moves from a to b, only rules
+ * with a level in [a, b] can change state; a binary search finds them. The
+ * only other per-sample work is the list of PENDING rules waiting for their
+ * duration. Evaluation cost therefore depends on how many levels a sample
+ * crosses, not on the number of rules.
+ *
+ * Raised and cleared events go to a small queue drained by the caller,
+ * which sends the notifications outside the sample path. A rule notifies
+ * at most once per cooldown.
+ *
+ * Usage:
+ *   Alert_Engine alerts;
+ *   alerts.compile(alertCfg.rules, err, sizeof(err));
+ *   alerts.evaluate(sample);                          // Every sample
+ *   Alert_Engine::Event e;
+ *   while (alerts.pop(e)) { ... }                     // Send notifications
+ */
+
+#ifndef ALERT_ENGINE_H
+#define ALERT_ENGINE_H
+
+#include <Arduino.h>
+#include "Sensor_Pipeline.h"
+
+enum AlertSignal {
+  ALERT_VALUE,
+  ALERT_RATE,          // Units per minute
+  ALERT_STUCK,         // Seconds since the last change
+  ALERT_SIGNALS
+};
+
+enum AlertAction {
+  ALERT_SMS = 0x01,
+  ALERT_EMAIL = 0x02,
+  ALERT_POST = 0x04
+};
+
+class Alert_Engine {
+public:
+  static const uint8_t MAX_RULES = 100;
+  static const uint8_t QUEUE_LEN = 8;
+  static const uint32_t RATE_TAU_MS = 30000;
+  static const uint8_t SIGNAL_COUNT = SENSOR_CHANNELS * ALERT_SIGNALS;
+
+  enum State : uint8_t {
+    STATE_IDLE,
+    STATE_PENDING,     // Condition holds, waiting for the minimum duration
+    STATE_ACTIVE
+  };
+
+  /**
+   * @brief One compiled rule and its state
+   */
+  struct Rule {
+    uint8_t channel;
+    uint8_t signal;          // AlertSignal
+    bool above;              // '>' (true) or '<'
+    uint8_t actions;         // AlertAction mask
+    float level;
+    float clear;             // Level the signal must pass to clear
+    uint32_t forMs;
+
+    State state;
+    uint32_t sinceMs;        // Start of PENDING / ACTIVE
+    uint32_t notifiedMs;
+    uint32_t raised;         // Times it became ACTIVE
+    float value;             // Signal value at the last transition
+  };
+
+  /**
+   * @brief Raised or cleared rule, for the notification path
+   */
+  struct Event {
+    uint8_t rule;
+    bool raised;             // false: cleared
+    float value;
+    uint32_t ms;
+  };
+
+  Alert_Engine();
+
+  /**
+   * @brief Parse rule text and rebuild the table (all rules start IDLE)
+   *
+   * A rule that is also in the new text keeps its last notification time,
+   * so the cooldown still holds back a condition that is raised again.
+   * @param err Receives "rule <n>: <reason>" on failure
+   * @return false on a syntax error (the previous rules are kept)
+   */
+  bool compile(const char* text, char* err, size_t errLen);
+
+  /**
+   * @brief Add one rule (call build() afterwards)
+   */
+  bool addRule(uint8_t channel, uint8_t signal, bool above, float level, float hyst,
+               uint32_t forMs, uint8_t actions);
+  void clearRules();
+
+  /**
+   * @brief Rebuild the table; every rule restarts IDLE on the next sample
+   */
+  void build();
+
+  /**
+   * @brief Evaluate one sample (loop task)
+   */
+  void evaluate(const Sensor_Sample& s);
+
+  /**
+   * @brief Take the oldest queued event
+   */
+  bool pop(Event& e);
+
+  /**
+   * @brief Minimum time between notifications of one rule
+   */
+  void setCooldown(uint32_t ms) { _cooldownMs = ms; }
+
+  /**
+   * @brief Check every rule on every sample instead of using the table
+   * (baseline for the benchmark)
+   */
+  void setLinear(bool linear) { _linear = linear; }
+
+  /**
+   * @brief Log raised/cleared events to the log ring (default on)
+   */
+  void setLogging(bool on) { _logging = on; }
+
+  uint8_t ruleCount() const { return _count; }
+  const Rule& rule(uint8_t i) const { return _rules[i]; }
+  float signalValue(uint8_t ch, uint8_t signal) const { return _signal[ch * ALERT_SIGNALS + signal]; }
+
+  /**
+   * @brief Rule as text, in the syntax compile() accepts
+   */
+  void describe(uint8_t i, char* buf, size_t len) const;
+  static const char* stateName(State s);
+  static const char* signalName(uint8_t signal);
+
+  // Evaluation cost
+  uint32_t evaluations() const { return _evaluations; }
+  uint32_t avgCycles() const { return _evaluations ? (uint32_t)(_cycles / _evaluations) : 0; }
+  uint32_t maxCycles() const { return _maxCycles; }
+  float avgVisited() const { return _evaluations ? (float)_visited / _evaluations : 0; }
+  uint32_t events() const { return _events; }
+  uint32_t suppressed() const { return _suppressed; }   // Within the cooldown
+  uint32_t dropped() const { return _dropped; }         // Queue full
+  void resetStats();
+
+private:
+  /**
+   * @brief One entry of a signal's sorted level list
+   */
+  struct Level {
+    float value;
+    uint8_t rule;
+  };
+
+  void visit(uint8_t i, float x, uint32_t ms);
+  void setPending(uint8_t i, bool pending);
+  void emit(uint8_t i, bool raised, float x, uint32_t ms);
+
+  Rule _rules[MAX_RULES];
+  uint8_t _count;
+
+  // Compiled table: levels of signal g are _levels[_start[g] .. _start[g + 1])
+  Level _levels[2 * MAX_RULES];
+  uint16_t _start[SIGNAL_COUNT + 1];
+  uint8_t _pending[MAX_RULES];
+  uint8_t _pendingCount;
+
+  // Signal state
+  float _signal[SIGNAL_COUNT];       // NAN until the first sample
+  float _lastDistinct[SENSOR_CHANNELS];
+  uint32_t _lastChangeMs[SENSOR_CHANNELS];
+  uint32_t _lastMs[SENSOR_CHANNELS];
+  bool _linear;
+  bool _logging;
+
+  Event _queue[QUEUE_LEN];
+  uint8_t _qHead;
+  uint8_t _qCount;
+  uint32_t _cooldownMs;
+
+  uint32_t _evaluations;
+  uint64_t _cycles;
+  uint32_t _maxCycles;
+  uint64_t _visited;
+  uint32_t _events;
+  uint32_t _suppressed;
+  uint32_t _dropped;
+};
+
+#endif // ALERT_ENGINE_H
@@ -0,0 +1,103 @@
+/**
+ * @file Boot_Timeline.cpp
+ * @brief Implementation of the boot phase profiler
+ */
+
+#include "Boot_Timeline.h"
+#include <esp_system.h>
+
+static const uint32_t TIMELINE_MAGIC = 0x544C4E42;  // "BNLT"
+
+// Not cleared at reset; validated with magic + checksum
+RTC_NOINIT_ATTR static Boot_Timeline::Record s_current;
+RTC_NOINIT_ATTR static Boot_Timeline::Record s_previous;
+
+static uint32_t checksum(const Boot_Timeline::Record& r) {
+  const uint32_t* w = (const uint32_t*)&r;
+  size_t n = offsetof(Boot_Timeline::Record, checksum) / sizeof(uint32_t);
+  uint32_t sum = 0x9E3779B9;
+  for (size_t i = 0; i < n; i++) sum = (sum ^ w[i]) * 16777619u;
+  return sum;
+}
+
+static bool isValid(const Boot_Timeline::Record& r) {
+  return r.magic == TIMELINE_MAGIC && r.checksum == checksum(r);
+}
+
+Boot_Timeline::Boot_Timeline() {
+}
+
+void Boot_Timeline::begin() {
+  uint32_t now = micros();
+  uint32_t boots = 1;
+
+  if (isValid(s_current)) {
+    s_previous = s_current;
+    boots = s_current.bootCount + 1;
+  } else {
+    memset(&s_previous, 0, sizeof(s_previous));  // Power-on: nothing to keep
+  }
+
+  memset(&s_current, 0, sizeof(s_current));
+  s_current.magic = TIMELINE_MAGIC;
+  s_current.bootCount = boots;
+  s_current.resetReason = (uint32_t)esp_reset_reason();
+  s_current.startUs = now;
+  s_current.checksum = checksum(s_current);
+}
+
+void Boot_Timeline::mark(Phase phase) {
+  if (phase >= PHASE_COUNT || s_current.us[phase]) return;
+  s_current.us[phase] = micros();
+  s_current.checksum = checksum(s_current);
+}
+
+const Boot_Timeline::Record& Boot_Timeline::current() const {
+  return s_current;
+}
+
+const Boot_Timeline::Record* Boot_Timeline::previous() const {
+  return isValid(s_previous) ? &s_previous : nullptr;
+}
+
+uint32_t Boot_Timeline::deltaUs(const Record& r, Phase phase) {
+  if (phase >= PHASE_COUNT || !r.us[phase]) return 0;
+  if (phase > PHASE_READY && r.us[PHASE_READY]) return r.us[phase] - r.us[PHASE_READY];
+  for (int i = phase - 1; i >= 0; i--) {
+    if (r.us[i]) return r.us[phase] - r.us[i];
+  }
+  return r.us[phase] - r.startUs;
+}
+
+const char* Boot_Timeline::phaseName(Phase phase) {
+  switch (phase) {
+    case PHASE_SERIAL:        return "serial";
+    case PHASE_DRD:           return "drd";
+    case PHASE_FS:            return "fs_mount";
+    case PHASE_CONFIG:        return "config_load";
+    case PHASE_AP:            return "ap_up";
+    case PHASE_STA_START:     return "sta_connect_start";
+    case PHASE_MODEM:         return "modem_start";
+    case PHASE_ROUTES:        return "routes_ready";
+    case PHASE_READY:         return "portal_ready";
+    case PHASE_STA_CONNECTED: return "sta_connected";
+    case PHASE_MODEM_READY:   return "modem_ready";
+    default:                  return "unknown";
+  }
+}
+
+const char* Boot_Timeline::resetReasonName(uint8_t reason) {
+  switch (reason) {
+    case ESP_RST_POWERON:   return "power_on";
+    case ESP_RST_EXT:       return "external";
+    case ESP_RST_SW:        return "software";
+    case ESP_RST_PANIC:     return "panic";
+    case ESP_RST_INT_WDT:   return "int_wdt";
+    case ESP_RST_TASK_WDT:  return "task_wdt";
+    case ESP_RST_WDT:       return "wdt";
+    case ESP_RST_DEEPSLEEP: return "deep_sleep";
+    case ESP_RST_BROWNOUT:  return "brownout";
+    case ESP_RST_SDIO:      return "sdio";
+    default:                return "unknown";
+  }
+}
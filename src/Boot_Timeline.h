@@ -0,0 +1,102 @@
+/**
+ * @file Boot_Timeline.h
+ * @brief Boot phase markers with microsecond timestamps kept in RTC memory
+ * @version 1.0.0
+ *
+ * @details
+ * setup() calls mark() at the end of each boot phase. Timestamps are
+ * micros() since the application started and cost one store each, so the
+ * markers can stay in production builds.
+ *
+ * The timeline lives in RTC_NOINIT memory, which survives software resets,
+ * watchdog resets and the reset button (but not power loss). begin() moves
+ * the previous boot's timeline aside before recording the new one, so a
+ * boot that ended in a crash or watchdog reset can still be inspected
+ * after the restart. A magic value and checksum reject the random content
+ * RTC memory has after power-on.
+ *
+ * PHASE_STA_CONNECTED (WiFi connect callback) and PHASE_MODEM_READY (modem
+ * bring-up in loop()) usually come after setup() has returned.
+ *
+ * Usage:
+ *   Boot_Timeline bootTimeline;
+ *   bootTimeline.begin();                        // First thing in setup()
+ *   bootTimeline.mark(Boot_Timeline::PHASE_FS);  // After each phase
+ */
+
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <Arduino.h>
+
+class Boot_Timeline {
+public:
+  /**
+   * @brief Boot phases, in the order setup() normally reaches them
+   */
+  enum Phase {
+    PHASE_SERIAL,         // Serial up (includes the post-begin delay)
+    PHASE_DRD,            // Double reset detection done
+    PHASE_FS,             // Filesystem mounted
+    PHASE_CONFIG,         // Settings loaded
+    PHASE_AP,             // Soft-AP up
+    PHASE_STA_START,      // STA connect requested (if a network is saved)
+    PHASE_MODEM,          // Modem bring-up started (main mode only)
+    PHASE_ROUTES,         // HTTP routes registered
+    PHASE_READY,          // Server started: portal reachable
+    PHASE_STA_CONNECTED,  // First STA connection (after setup)
+    PHASE_MODEM_READY,    // Modem answered and configured (after setup)
+    PHASE_COUNT
+  };
+
+  /**
+   * @brief One boot's timeline
+   */
+  struct Record {
+    uint32_t magic;
+    uint32_t bootCount;     // Boots since the last power loss
+    uint32_t resetReason;   // esp_reset_reason() (32-bit so the struct has no padding)
+    uint32_t startUs;       // micros() when begin() ran
+    uint32_t us[PHASE_COUNT];  // 0 = not reached
+    uint32_t checksum;
+  };
+
+  Boot_Timeline();
+
+  /**
+   * @brief Archive the previous timeline and start a new one
+   */
+  void begin();
+
+  /**
+   * @brief Record the end of a phase (first call per boot wins)
+   */
+  void mark(Phase phase);
+
+  const Record& current() const;
+  const Record* previous() const;  // nullptr after power-on
+
+  /**
+   * @brief Time from application start to PHASE_READY in ms (0 if not reached)
+   */
+  static uint32_t readyMs(const Record& r) { return r.us[PHASE_READY] / 1000; }
+
+  /**
+   * @brief True if the boot reached PHASE_READY later than budgetMs
+   */
+  static bool overBudget(const Record& r, uint32_t budgetMs) { return readyMs(r) > budgetMs; }
+
+  /**
+   * @brief Duration of a reached phase in us (0 if not reached)
+   *
+   * Measured from the previous reached phase (or from begin()). Phases
+   * after PHASE_READY are measured from PHASE_READY, since loop() work
+   * between them is not part of the boot.
+   */
+  static uint32_t deltaUs(const Record& r, Phase phase);
+
+  static const char* phaseName(Phase phase);
+  static const char* resetReasonName(uint8_t reason);
+};
+
+#endif // BOOT_TIMELINE_H
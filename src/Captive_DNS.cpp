@@ -0,0 +1,98 @@
+/**
+ * @file Captive_DNS.cpp
+ * @brief Implementation of the captive-portal DNS responder
+ */
+
+#include "Captive_DNS.h"
+
+static const size_t DNS_HEADER_LEN = 12;
+static const uint16_t DNS_TYPE_A = 1;
+
+Captive_DNS::Captive_DNS()
+  : _answerA(), _queries(0), _answeredA(0), _answeredEmpty(0), _dropped(0),
+    _maxHandleUs(0), _totalHandleUs(0) {
+}
+
+bool Captive_DNS::start(uint16_t port, const IPAddress& ip) {
+  setIP(ip);
+  if (!_udp.listen(port)) {
+    Serial.println(" Captive DNS: failed to bind UDP port");
+    return false;
+  }
+  _udp.onPacket([this](AsyncUDPPacket& packet) { handlePacket(packet); });
+  return true;
+}
+
+void Captive_DNS::setIP(const IPAddress& ip) {
+  _ip = ip;
+  const uint8_t answer[16] = {
+    0xC0, 0x0C,                                   // Pointer to the question name
+    0x00, DNS_TYPE_A, 0x00, 0x01,                 // Type A, class IN
+    (uint8_t)(ANSWER_TTL >> 24), (uint8_t)(ANSWER_TTL >> 16),
+    (uint8_t)(ANSWER_TTL >> 8), (uint8_t)ANSWER_TTL,
+    0x00, 0x04,                                   // RDLENGTH
+    ip[0], ip[1], ip[2], ip[3]
+  };
+  memcpy(_answerA, answer, sizeof(_answerA));
+}
+
+void Captive_DNS::stop() {
+  _udp.close();
+}
+
+uint32_t Captive_DNS::avgHandleUs() const {
+  uint32_t n = _answeredA + _answeredEmpty;
+  return n ? (uint32_t)(_totalHandleUs / n) : 0;
+}
+
+void Captive_DNS::handlePacket(AsyncUDPPacket& packet) {
+  uint32_t t0 = micros();
+  _queries++;
+
+  const uint8_t* q = packet.data();
+  size_t len = packet.length();
+
+  // Only standard queries (QR=0, OPCODE=0) with exactly one question,
+  // and only from clients on the soft-AP network
+  if (len < DNS_HEADER_LEN + 5 || len > MAX_PACKET ||
+      (q[2] & 0xF8) != 0 || q[4] != 0 || q[5] != 1 ||
+      packet.localIP() != _ip) {
+    _dropped++;
+    return;
+  }
+
+  // Walk the QNAME labels to find the end of the question
+  size_t pos = DNS_HEADER_LEN;
+  while (pos < len && q[pos] != 0) {
+    if (q[pos] & 0xC0) { _dropped++; return; }  // No compression in questions
+    pos += q[pos] + 1;
+  }
+  if (pos + 5 > len) { _dropped++; return; }
+  uint16_t qtype = (q[pos + 1] << 8) | q[pos + 2];
+  size_t questionEnd = pos + 5;
+
+  uint8_t reply[MAX_PACKET + sizeof(_answerA)];
+  memcpy(reply, q, questionEnd);          // ID, flags, counts and question
+  reply[2] = 0x84 | (q[2] & 0x01);        // QR, AA, keep RD
+  reply[3] = 0x00;                        // RA=0, RCODE=NOERROR
+  reply[6] = 0; reply[7] = 0;             // ANCOUNT (set below)
+  reply[8] = 0; reply[9] = 0;             // NSCOUNT
+  reply[10] = 0; reply[11] = 0;           // ARCOUNT (drop EDNS OPT)
+
+  size_t out = questionEnd;
+  if (qtype == DNS_TYPE_A) {
+    reply[7] = 1;
+    memcpy(reply + out, _answerA, sizeof(_answerA));
+    out += sizeof(_answerA);
+    _answeredA++;
+  } else {
+    // AAAA, HTTPS, SVCB, ...: NODATA so the client asks for A right away
+    _answeredEmpty++;
+  }
+
+  packet.write(reply, out);
+
+  uint32_t took = micros() - t0;
+  _totalHandleUs += took;
+  if (took > _maxHandleUs) _maxHandleUs = took;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file Captive_DNS.h
+ * @brief Captive-portal DNS responder running on the AsyncUDP task
+ * @version 1.0.0
+ *
+ * @details
+ * Replaces DNSServer::processNextRequest(), which was only serviced once per
+ * loop() iteration, so every blocking handler (modem AT exchanges, SMTP)
+ * stalled DNS and phones declared the portal dead.
+ *
+ * Packets are handled in the AsyncUDP callback, independent of loop():
+ * - A queries get the question echoed back plus a precomputed 16-byte
+ *   answer record pointing at the soft-AP IP.
+ * - AAAA, HTTPS/SVCB and every other type get an immediate NOERROR reply
+ *   with no answers, so clients fall back to A instead of timing out.
+ * - Only packets that arrive on the soft-AP address are answered; queries
+ *   coming in over the STA link are ignored.
+ *
+ * Usage:
+ *   Captive_DNS captiveDns;
+ *   captiveDns.start(53, WiFi.softAPIP());
+ */
+
+#ifndef CAPTIVE_DNS_H
+#define CAPTIVE_DNS_H
+
+#include <Arduino.h>
+#include <AsyncUDP.h>
+
+class Captive_DNS {
+public:
+  static const uint32_t ANSWER_TTL = 60;     // Seconds clients may cache the portal IP
+  static const size_t MAX_PACKET = 512;      // Classic DNS UDP limit
+
+  Captive_DNS();
+
+  /**
+   * @brief Start answering on the given port
+   * @param port UDP port (53)
+   * @param ip Address returned for every A query
+   * @return true if the UDP socket was bound
+   */
+  bool start(uint16_t port, const IPAddress& ip);
+
+  /**
+   * @brief Change the address returned for A queries
+   */
+  void setIP(const IPAddress& ip);
+
+  void stop();
+
+  // Statistics (updated from the AsyncUDP task)
+  uint32_t queries() const { return _queries; }
+  uint32_t answeredA() const { return _answeredA; }
+  uint32_t answeredEmpty() const { return _answeredEmpty; }
+  uint32_t dropped() const { return _dropped; }
+  uint32_t maxHandleUs() const { return _maxHandleUs; }
+  uint32_t avgHandleUs() const;
+
+private:
+  void handlePacket(AsyncUDPPacket& packet);
+
+  AsyncUDP _udp;
+  IPAddress _ip;
+  uint8_t _answerA[16];  // Name pointer, type A, class IN, TTL, RDLENGTH, address
+
+  volatile uint32_t _queries;
+  volatile uint32_t _answeredA;
+  volatile uint32_t _answeredEmpty;
+  volatile uint32_t _dropped;
+  volatile uint32_t _maxHandleUs;
+  volatile uint64_t _totalHandleUs;
+};
+
+#endif // CAPTIVE_DNS_H
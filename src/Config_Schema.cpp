@@ -0,0 +1,220 @@
+/**
+ * @file Config_Schema.cpp
+ * @brief Schema-driven JSON, validation and binary encoding for config structs
+ */
+
+#include "Config_Schema.h"
+#include <errno.h>
+
+static inline void putU16(uint8_t* p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static inline uint16_t getU16(const uint8_t* p) {
+  return p[0] | (p[1] << 8);
+}
+
+// ============================================================================
+// JSON
+// ============================================================================
+
+void cfgToJson(const ConfigSchema& schema, const void* obj, JsonObject out, bool api) {
+  const uint8_t* base = (const uint8_t*)obj;
+
+  for (uint8_t i = 0; i < schema.count; i++) {
+    const ConfigField& f = schema.fields[i];
+    const uint8_t* p = base + f.offset;
+    if (f.type == CFG_BLOB) continue;
+    if (api && (f.flags & CFG_INTERNAL)) continue;
+
+    switch (f.type) {
+      case CFG_STR:
+        if (api && (f.flags & CFG_SECRET)) {
+          out[f.key] = *(const char*)p ? CFG_SECRET_MASK : "";
+        } else {
+          out[f.key] = (const char*)p;
+        }
+        break;
+      case CFG_INT: {
+        int32_t v;
+        memcpy(&v, p, sizeof(v));
+        out[f.key] = v;
+        break;
+      }
+      case CFG_BOOL:
+        out[f.key] = *(const bool*)p;
+        break;
+    }
+  }
+}
+
+/**
+ * @brief Check one JSON value against its field
+ * @return nullptr if valid, otherwise the reason (without the field name)
+ */
+/**
+ * @brief Parse a whole string as a decimal integer ("12abc" and "" fail)
+ */
+static bool parseInt(const char* s, long& x) {
+  char* end;
+  errno = 0;
+  x = strtol(s, &end, 10);
+  return end != s && *end == '\0' && errno != ERANGE;
+}
+
+static const char* checkField(const ConfigField& f, JsonVariantConst v, char* buf, size_t len) {
+  switch (f.type) {
+    case CFG_STR: {
+      if (!v.is<const char*>()) return "must be a string";
+      size_t n = strlen(v.as<const char*>());
+      if (n == 0 && (f.flags & CFG_REQUIRED)) return "is required";
+      if (n > (size_t)f.size - 1) {
+        snprintf(buf, len, "too long (max %u characters)", (unsigned)f.size - 1);
+        return buf;
+      }
+      if (n > 0 && f.lo > 0 && n < (size_t)f.lo) {
+        snprintf(buf, len, "must be at least %ld characters or empty", (long)f.lo);
+        return buf;
+      }
+      return nullptr;
+    }
+    case CFG_INT: {
+      long x;
+      if (v.is<long>()) x = v.as<long>();
+      else if (!v.is<const char*>() || !parseInt(v.as<const char*>(), x)) return "must be a number";
+      if (x < f.lo || x > f.hi) {
+        snprintf(buf, len, "must be between %ld and %ld", (long)f.lo, (long)f.hi);
+        return buf;
+      }
+      return nullptr;
+    }
+    case CFG_BOOL:
+      return v.is<bool>() ? nullptr : "must be true or false";
+  }
+  return "is not settable";
+}
+
+bool cfgFromJson(const ConfigSchema& schema, void* obj, JsonObjectConst in, bool api,
+                 char* err, size_t errLen) {
+  uint8_t* base = (uint8_t*)obj;
+  char reason[48];
+
+  // Validate everything first so a bad field leaves the struct untouched
+  for (uint8_t pass = 0; pass < 2; pass++) {
+    for (uint8_t i = 0; i < schema.count; i++) {
+      const ConfigField& f = schema.fields[i];
+      if (f.type == CFG_BLOB) continue;
+      if (api && (f.flags & CFG_INTERNAL)) continue;
+
+      JsonVariantConst v = in[f.key];
+      if (v.isNull()) continue;  // Absent: keep current value
+      if (api && (f.flags & CFG_SECRET) && v.is<const char*>() &&
+          strcmp(v.as<const char*>(), CFG_SECRET_MASK) == 0) {
+        continue;  // Masked value posted back unchanged
+      }
+
+      if (pass == 0) {
+        const char* why = checkField(f, v, reason, sizeof(reason));
+        if (why) {
+          snprintf(err, errLen, "%s %s", f.key, why);
+          return false;
+        }
+        continue;
+      }
+
+      uint8_t* p = base + f.offset;
+      switch (f.type) {
+        case CFG_STR: {
+          const char* str = v.as<const char*>();
+          memcpy(p, str, strlen(str) + 1);  // Length checked in pass 0
+          break;
+        }
+        case CFG_INT: {
+          long n = 0;
+          if (v.is<const char*>()) parseInt(v.as<const char*>(), n);  // Checked in pass 0
+          else n = v.as<long>();
+          int32_t x = n;
+          memcpy(p, &x, sizeof(x));
+          break;
+        }
+        case CFG_BOOL:
+          *(bool*)p = v.as<bool>();
+          break;
+      }
+    }
+  }
+  return true;
+}
+
+// ============================================================================
+// BINARY
+// ============================================================================
+
+size_t cfgEncode(const ConfigSchema& schema, const void* obj, uint8_t* out, size_t cap) {
+  const uint8_t* base = (const uint8_t*)obj;
+  if (cap < 4) return 0;
+  size_t o = 4;  // Section header written last
+
+  for (uint8_t i = 0; i < schema.count; i++) {
+    const ConfigField& f = schema.fields[i];
+    const uint8_t* p = base + f.offset;
+    size_t n = (f.type == CFG_STR) ? strnlen((const char*)p, f.size) : f.size;
+    if (o + 4 + n > cap) return 0;
+
+    putU16(out + o, f.id);
+    putU16(out + o + 2, n);
+    memcpy(out + o + 4, p, n);
+    o += 4 + n;
+  }
+
+  putU16(out, schema.id);
+  putU16(out + 2, o - 4);
+  return o;
+}
+
+bool cfgDecode(const ConfigSchema& schema, void* obj, const uint8_t* record, size_t len) {
+  uint8_t* base = (uint8_t*)obj;
+
+  // Locate the section
+  size_t pos = 0;
+  const uint8_t* sec = nullptr;
+  size_t secLen = 0;
+  while (pos + 4 <= len) {
+    uint16_t id = getU16(record + pos);
+    uint16_t n = getU16(record + pos + 2);
+    if (pos + 4 + n > len) return false;
+    if (id == schema.id) {
+      sec = record + pos + 4;
+      secLen = n;
+      break;
+    }
+    pos += 4 + n;
+  }
+  if (!sec) return false;
+
+  // Apply known fields; unknown ids are skipped
+  pos = 0;
+  while (pos + 4 <= secLen) {
+    uint16_t id = getU16(sec + pos);
+    uint16_t n = getU16(sec + pos + 2);
+    if (pos + 4 + n > secLen) break;
+    const uint8_t* data = sec + pos + 4;
+    pos += 4 + n;
+
+    for (uint8_t i = 0; i < schema.count; i++) {
+      const ConfigField& f = schema.fields[i];
+      if (f.id != id) continue;
+      uint8_t* p = base + f.offset;
+      if (f.type == CFG_STR) {
+        size_t c = n < (size_t)f.size - 1 ? n : f.size - 1;
+        memcpy(p, data, c);
+        p[c] = '\0';
+      } else if (n == f.size) {
+        memcpy(p, data, n);  // Size change = layout change; keep the default
+      }
+      break;
+    }
+  }
+  return true;
+}
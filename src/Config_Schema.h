@@ -0,0 +1,156 @@
+/**
+ * @file Config_Schema.h
+ * @brief Compile-time field schema for configuration structures
+ * @version 1.0.0
+ *
+ * @details
+ * Each configuration structure lists its fields once in an X-macro:
+ *
+ *   #define USER_CONFIG_FIELDS(X) \
+ *     X(STR, name,  64, "", 0, 0, 0) \
+ *     X(INT, port,   0, 465, 1, 65535, 0)
+ *
+ * Columns: kind, name, size, default, lo, hi, flags
+ * - STR   char[size] buffer; lo = minimum length when not empty
+ * - INT   int32_t; lo/hi = allowed range (size unused)
+ * - BOOL  bool (size, lo, hi unused)
+ * - BLOB  POD member whose type is given in the size column; binary only
+ *
+ * Flags:
+ * - CFG_SECRET    API output shows "[SET]"/"" instead of the value; posting
+ *                 "[SET]" back (or leaving the key out) keeps the value
+ * - CFG_INTERNAL  Not part of the JSON API (persisted only)
+ * - CFG_REQUIRED  String must not be empty
+ *
+ * CFG_DECLARE expands the list into member declarations with defaults and
+ * CFG_DEFINE_SCHEMA into a static table of ConfigField descriptors. The
+ * generic functions below use that table for JSON output, validated JSON
+ * input and the binary record, so adding a field is a one-line change.
+ *
+ * Binary encoding (per structure):
+ *   section: id (u16) | length (u16) | fields...
+ *   field:   id (u16) | length (u16) | bytes
+ * Ids are hashes of the structure/field names; unknown ids are skipped and
+ * missing fields keep their defaults, so fields can be added or removed
+ * without a migration step.
+ */
+
+#ifndef CONFIG_SCHEMA_H
+#define CONFIG_SCHEMA_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <stddef.h>
+
+#define CFG_SECRET_MASK "[SET]"
+
+enum ConfigFieldType : uint8_t {
+  CFG_STR,
+  CFG_INT,
+  CFG_BOOL,
+  CFG_BLOB
+};
+
+enum ConfigFieldFlags : uint8_t {
+  CFG_SECRET = 0x01,
+  CFG_INTERNAL = 0x02,
+  CFG_REQUIRED = 0x04
+};
+
+/**
+ * @brief 16-bit FNV-1a fold, evaluated at compile time for literals
+ */
+constexpr uint32_t cfgFnv(const char* s, uint32_t h = 2166136261u) {
+  return *s ? cfgFnv(s + 1, (h ^ (uint8_t)*s) * 16777619u) : h;
+}
+constexpr uint16_t cfgHash16(const char* s) {
+  return (uint16_t)(cfgFnv(s) ^ (cfgFnv(s) >> 16));
+}
+
+/**
+ * @brief One field of a configuration structure
+ */
+struct ConfigField {
+  const char* key;
+  uint16_t id;
+  uint8_t type;     // ConfigFieldType
+  uint8_t flags;    // ConfigFieldFlags
+  uint16_t offset;
+  uint16_t size;
+  int32_t lo;
+  int32_t hi;
+};
+
+/**
+ * @brief Field table of one configuration structure
+ */
+struct ConfigSchema {
+  const char* name;
+  uint16_t id;
+  const ConfigField* fields;
+  uint8_t count;
+};
+
+// ---- Member declarations -------------------------------------------------
+#define CFG_DECL_STR(name, size, def)  char name[size] = def;
+#define CFG_DECL_INT(name, size, def)  int32_t name = def;
+#define CFG_DECL_BOOL(name, size, def) bool name = def;
+#define CFG_DECL_BLOB(name, type, def) type name;
+#define CFG_DECLARE(kind, name, size, def, lo, hi, flags) CFG_DECL_##kind(name, size, def)
+
+// ---- Descriptor table ----------------------------------------------------
+#define CFG_FIELD(kind, name, size, def, lo, hi, flags) \
+  { #name, cfgHash16(#name), CFG_##kind, (uint8_t)(flags), \
+    (uint16_t)offsetof(CfgT, name), (uint16_t)sizeof(CfgT::name), (lo), (hi) },
+
+#define CFG_DEFINE_SCHEMA(S, FIELDS) \
+  const ConfigSchema& S::schema() { \
+    typedef S CfgT; \
+    static const ConfigField fields[] = { FIELDS(CFG_FIELD) }; \
+    static const ConfigSchema s = { #S, cfgHash16(#S), fields, \
+                                    (uint8_t)(sizeof(fields) / sizeof(fields[0])) }; \
+    return s; \
+  }
+
+// ---- Generic operations --------------------------------------------------
+
+/**
+ * @brief Write fields to a JSON object
+ * @param api true: skip CFG_INTERNAL fields and mask CFG_SECRET ones
+ */
+void cfgToJson(const ConfigSchema& schema, const void* obj, JsonObject out, bool api);
+
+/**
+ * @brief Validate and apply fields from a JSON object
+ * @param api true: reject CFG_INTERNAL keys silently, honour "[SET]" for secrets
+ * @param err Receives "<field> ..." on failure
+ * @return true if all present fields were valid (nothing is changed otherwise)
+ *
+ * Keys that are absent keep their current value.
+ */
+bool cfgFromJson(const ConfigSchema& schema, void* obj, JsonObjectConst in, bool api,
+                 char* err, size_t errLen);
+
+/**
+ * @brief Append the binary section of obj to out
+ * @return Bytes written, 0 if it did not fit
+ */
+size_t cfgEncode(const ConfigSchema& schema, const void* obj, uint8_t* out, size_t cap);
+
+/**
+ * @brief Find this schema's section in a record and apply its fields
+ * @return true if the section was present
+ */
+bool cfgDecode(const ConfigSchema& schema, void* obj, const uint8_t* record, size_t len);
+
+/**
+ * @brief Copy a C string into a fixed buffer (truncated, always terminated)
+ */
+template <size_t N>
+inline void cfgSet(char (&dst)[N], const char* src) {
+  size_t n = src ? strnlen(src, N - 1) : 0;
+  memcpy(dst, src, n);
+  dst[n] = '\0';
+}
+
+#endif // CONFIG_SCHEMA_H
@@ -0,0 +1,163 @@
+/**
+ * @file Config_Store.cpp
+ * @brief Implementation of the binary NVS configuration record
+ */
+
+#include "Config_Store.h"
+#include <esp_system.h>
+
+static const char* NAMESPACE = "config";
+static const char* KEY_RECORD = "rec";
+
+// 12-byte header + payload staging buffer shared by load(), save() and flush()
+static uint8_t s_raw[12 + CONFIG_RECORD_MAX];
+
+// Instance flushed by the shutdown handler (esp_restart() takes no context)
+static Config_Store* s_flushOnRestart = nullptr;
+
+static void flushBeforeRestart() {
+  if (s_flushOnRestart) s_flushOnRestart->flush();
+}
+
+Config_Store::Config_Store()
+  : _encoder(nullptr), _dirty(false), _dirtySince(0), _lastMark(0), _marks(0), _flushes(0),
+    _lastCrc(0), _loadUs(0), _saveUs(0), _saves(0), _writes(0), _bytes(0), _storedVersion(0),
+    _recordSize(0) {
+}
+
+uint32_t Config_Store::crc32(const uint8_t* data, size_t len) {
+  uint32_t crc = 0xFFFFFFFF;
+  while (len--) {
+    crc ^= *data++;
+    for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
+Config_Store::LoadResult Config_Store::load(uint8_t* buf, size_t cap, size_t& len) {
+  uint32_t t0 = micros();
+  LoadResult result = LOAD_EMPTY;
+  len = 0;
+
+  if (!_prefs.begin(NAMESPACE, true)) {
+    _loadUs = micros() - t0;
+    return LOAD_EMPTY;  // Namespace does not exist yet
+  }
+
+  size_t stored = _prefs.getBytesLength(KEY_RECORD);
+  if (stored >= sizeof(Header)) {
+    // One read for header + payload
+    static_assert(sizeof(Header) == 12, "header size is part of the record format");
+    uint8_t* raw = s_raw;
+    size_t n = stored <= sizeof(s_raw) ? _prefs.getBytes(KEY_RECORD, raw, stored) : 0;
+
+    Header hdr;
+    memcpy(&hdr, raw, sizeof(hdr));
+    const uint8_t* body = raw + sizeof(Header);
+
+    if (n < sizeof(Header) || hdr.magic != CONFIG_MAGIC || hdr.version > CONFIG_SCHEMA_VERSION ||
+        n != sizeof(Header) + hdr.length || hdr.length > cap ||
+        crc32(body, hdr.length) != hdr.crc) {
+      Serial.printf(" Config record rejected (version %u, %u bytes)\n", hdr.version, (unsigned)stored);
+      result = LOAD_CORRUPT;
+    } else {
+      memcpy(buf, body, hdr.length);
+      len = hdr.length;
+      _storedVersion = hdr.version;
+      _recordSize = n;
+      if (hdr.version == CONFIG_SCHEMA_VERSION) _lastCrc = hdr.crc;
+      result = LOAD_OK;
+    }
+  }
+
+  _prefs.end();
+  _loadUs = micros() - t0;
+  return result;
+}
+
+bool Config_Store::save(const uint8_t* payload, size_t len) {
+  if (len > CONFIG_RECORD_MAX) return false;
+  memmove(s_raw + sizeof(Header), payload, len);
+  return writeStaged(len);
+}
+
+void Config_Store::setEncoder(Encoder fn) {
+  _encoder = fn;
+  if (!s_flushOnRestart) {
+    s_flushOnRestart = this;
+    esp_register_shutdown_handler(flushBeforeRestart);
+  }
+}
+
+void Config_Store::markDirty() {
+  _lastMark = millis();
+  if (!_dirty) _dirtySince = _lastMark;
+  _dirty = true;
+  _marks++;
+}
+
+bool Config_Store::flush() {
+  if (!_dirty || !_encoder) return true;
+  _flushes++;
+  // Encode straight into the staging buffer behind the header
+  size_t len = _encoder(s_raw + sizeof(Header), CONFIG_RECORD_MAX);
+  if (!len) {
+    Serial.println(" Config record does not fit, not saved");
+    return false;
+  }
+  bool ok = writeStaged(len);
+  if (ok) _dirty = false;  // On failure loop() retries after the next debounce
+  return ok;
+}
+
+void Config_Store::loop() {
+  if (!_dirty) return;
+  uint32_t now = millis();
+  if (now - _lastMark >= DEBOUNCE_MS || now - _dirtySince >= DIRTY_MAX_MS) {
+    if (!flush()) _lastMark = _dirtySince = now;
+  }
+}
+
+bool Config_Store::writeStaged(size_t len) {
+  uint32_t t0 = micros();
+  _saves++;
+
+  uint8_t* raw = s_raw;
+  uint32_t crc = crc32(raw + sizeof(Header), len);
+  if (crc == _lastCrc) {
+    _saveUs = micros() - t0;
+    return true;  // Unchanged, nothing to write
+  }
+
+  Header hdr = { CONFIG_MAGIC, CONFIG_SCHEMA_VERSION, (uint16_t)len, crc };
+  memcpy(raw, &hdr, sizeof(hdr));
+  size_t total = sizeof(hdr) + len;
+
+  bool ok = false;
+  if (_prefs.begin(NAMESPACE, false)) {
+    ok = _prefs.putBytes(KEY_RECORD, raw, total) == total;
+    _prefs.end();
+  }
+
+  if (ok) {
+    _lastCrc = crc;
+    _storedVersion = CONFIG_SCHEMA_VERSION;
+    _recordSize = total;
+    _writes++;
+    _bytes += total;
+  } else {
+    Serial.println(" Config record write failed");
+  }
+  _saveUs = micros() - t0;
+  return ok;
+}
+
+void Config_Store::erase() {
+  if (_prefs.begin(NAMESPACE, false)) {
+    _prefs.clear();
+    _prefs.end();
+  }
+  _lastCrc = 0;
+  _storedVersion = 0;
+  _dirty = false;
+}
@@ -0,0 +1,206 @@
+/**
+ * @file Config_Store.h
+ * @brief Versioned, CRC-protected configuration record stored as one NVS blob
+ * @version 1.2.0
+ *
+ * @details
+ * All persistent settings (WiFi, GSM, user, email) are encoded into one
+ * record by the config schema (Config_Schema.h) and stored with a small
+ * header in the "config" NVS namespace. Boot reads the whole record with a
+ * single getBytes() instead of opening and parsing four JSON files.
+ *
+ * Header fields:
+ * - magic    Identifies the record ("CFG1")
+ * - version  CONFIG_SCHEMA_VERSION the record was written with
+ * - length   Payload size in bytes
+ * - crc      CRC-32 of the payload
+ *
+ * Version 1 records used the fixed ConfigRecordV1 layout below; from
+ * version 2 the payload is the schema's id/length encoding, which needs no
+ * migration when fields are added. Records from a newer firmware, a bad
+ * magic or a CRC mismatch are rejected.
+ *
+ * save() skips the write when the payload CRC matches what is already
+ * stored, so repeated saves of unchanged settings cost no flash writes.
+ *
+ * Deferred writes: request handlers call markDirty() instead of save().
+ * loop() encodes and writes the record once no change has been made for
+ * DEBOUNCE_MS (or DIRTY_MAX_MS after the first change), so a burst of
+ * saves costs one flash write and handlers never wait for NVS. flush()
+ * writes immediately and is also run from a shutdown handler, so
+ * esp_restart() does not lose pending changes. NVS replaces a blob
+ * atomically (the old value stays valid until the new one is committed),
+ * so a power loss leaves either the previous or the new record.
+ *
+ * Usage:
+ *   Config_Store store;
+ *   store.setEncoder(encodeAll);   // size_t encodeAll(uint8_t* buf, size_t cap)
+ *   size_t len;
+ *   if (store.load(buf, sizeof(buf), len) == Config_Store::LOAD_OK) { ... }
+ *   store.markDirty();             // From handlers
+ *   store.loop();                  // From loop()
+ */
+
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+#define CONFIG_SCHEMA_VERSION 2
+#define CONFIG_RECORD_MAX 3072  // Payload bytes (alert rules take up to 1 KB)
+#define CONFIG_MAGIC 0x31474643  // "CFG1"
+
+/**
+ * @brief Fixed payload layout written by schema version 1 (read-only)
+ */
+struct ConfigRecordV1 {
+  struct Wifi {
+    char staSsid[33];
+    char staPass[65];
+    char apSsid[33];
+    char apPass[65];
+    uint8_t staAutoConnect;
+    uint8_t profileCount;
+    struct {
+      char ssid[33];
+      char pass[65];
+      uint8_t priority;
+    } profiles[5];
+    uint8_t staBssid[6];     // All zero = unknown
+    uint8_t staChannel;
+    uint8_t staReuseIp;
+    uint32_t staIp;          // 0 = unset
+    uint32_t staGateway;
+    uint32_t staMask;
+    uint32_t staDns;
+  } wifi;
+
+  struct Gsm {
+    char carrierName[33];
+    char apn[64];
+    char apnUser[33];
+    char apnPass[33];
+  } gsm;
+
+  struct User {
+    char name[64];
+    char email[64];
+    char phone[24];
+  } user;
+
+  struct Email {
+    char smtpHost[64];
+    uint16_t smtpPort;
+    char emailAccount[64];
+    char emailPassword[64];
+    char senderName[64];
+  } email;
+};
+
+class Config_Store {
+public:
+  /**
+   * @brief Result of load()
+   */
+  enum LoadResult {
+    LOAD_OK,        // Record loaded (see storedVersion())
+    LOAD_EMPTY,     // No record stored yet
+    LOAD_CORRUPT    // Bad magic, CRC or newer version
+  };
+
+  /**
+   * @brief Fills buf with the current payload, returns its length (0 = error)
+   */
+  typedef size_t (*Encoder)(uint8_t* buf, size_t cap);
+
+  static const uint32_t DEBOUNCE_MS = 2000;   // Quiet time before a deferred write
+  static const uint32_t DIRTY_MAX_MS = 10000; // Upper bound while changes keep coming
+
+  Config_Store();
+
+  /**
+   * @brief Set the payload encoder used by flush() and loop()
+   * Also registers the shutdown handler that flushes before a restart.
+   */
+  void setEncoder(Encoder fn);
+
+  /**
+   * @brief Read the record payload
+   * @param buf Receives the payload
+   * @param cap Size of buf
+   * @param len Payload length on success
+   */
+  LoadResult load(uint8_t* buf, size_t cap, size_t& len);
+
+  /**
+   * @brief Write the record unless it is unchanged
+   * @return true if the stored record matches the payload afterwards
+   */
+  bool save(const uint8_t* payload, size_t len);
+
+  /**
+   * @brief Note that settings changed; the record is written later by loop()
+   */
+  void markDirty();
+
+  /**
+   * @brief Encode and write pending changes now
+   * @return true if nothing was pending or the write succeeded
+   */
+  bool flush();
+
+  /**
+   * @brief Write pending changes once the debounce window has passed
+   */
+  void loop();
+
+  bool isDirty() const { return _dirty; }
+  uint32_t dirtyAgeMs() const { return _dirty ? millis() - _dirtySince : 0; }
+
+  /**
+   * @brief Remove the stored record (factory reset)
+   */
+  void erase();
+
+  // Statistics
+  uint32_t lastLoadUs() const { return _loadUs; }
+  uint32_t lastSaveUs() const { return _saveUs; }
+  uint32_t saveCount() const { return _saves; }        // save()/flush() record writes attempted
+  uint32_t markCount() const { return _marks; }        // markDirty() calls
+  uint32_t flushCount() const { return _flushes; }     // Deferred/forced flushes
+  uint32_t writeCount() const { return _writes; }      // Actual NVS writes
+  uint32_t bytesWritten() const { return _bytes; }
+  uint16_t storedVersion() const { return _storedVersion; }
+  size_t recordSize() const { return _recordSize; }     // Header + payload of the stored record
+
+  static uint32_t crc32(const uint8_t* data, size_t len);
+
+private:
+  struct __attribute__((packed)) Header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t length;
+    uint32_t crc;
+  };
+
+  Preferences _prefs;
+  bool writeStaged(size_t len);
+
+  Encoder _encoder;
+  bool _dirty;
+  uint32_t _dirtySince;  // First change since the last flush
+  uint32_t _lastMark;    // Latest change
+  uint32_t _marks;
+  uint32_t _flushes;
+  uint32_t _lastCrc;     // CRC of the stored payload (0 = unknown)
+  uint32_t _loadUs;
+  uint32_t _saveUs;
+  uint32_t _saves;
+  uint32_t _writes;
+  uint32_t _bytes;
+  uint16_t _storedVersion;
+  size_t _recordSize;
+};
+
+#endif // CONFIG_STORE_H
@@ -0,0 +1,119 @@
+/**
+ * @file DRD_Manager.cpp
+ * @brief Implementation of the RTC-memory reset detector
+ */
+
+#include "DRD_Manager.h"
+
+static const uint32_t DRD_MAGIC = 0x44524431;  // "DRD1"
+
+/**
+ * @brief Detector state kept across warm resets
+ */
+struct DrdRecord {
+  uint32_t magic;
+  uint32_t count;      // Resets in a row so far
+  uint32_t armed;      // Window still open: the next reset continues the count
+  uint32_t nvsArmed;   // NVS fallback holds a count that must be cleared
+  uint32_t checksum;
+};
+
+// Not cleared at reset; validated with magic + checksum
+RTC_NOINIT_ATTR static DrdRecord s_drd;
+
+static uint32_t checksum(const DrdRecord& r) {
+  const uint32_t* w = (const uint32_t*)&r;
+  size_t n = offsetof(DrdRecord, checksum) / sizeof(uint32_t);
+  uint32_t sum = 0x9E3779B9;
+  for (size_t i = 0; i < n; i++) sum = (sum ^ w[i]) * 16777619u;
+  return sum;
+}
+
+static void seal(DrdRecord& r) {
+  r.magic = DRD_MAGIC;
+  r.checksum = checksum(r);
+}
+
+DRD_Manager::DRD_Manager(uint32_t timeoutMs, uint8_t maxResets)
+  : timeout(timeoutMs), maxResets(maxResets < 2 ? 2 : maxResets), count(1),
+    countSource(SOURCE_RTC), windowClosed(true), detectTime(0), nvsWrites(0) {
+}
+
+bool DRD_Manager::detectDoubleReset() {
+  uint32_t t0 = micros();
+
+  if (s_drd.magic == DRD_MAGIC && s_drd.checksum == checksum(s_drd)) {
+    // Warm reset: everything needed is in RTC memory
+    countSource = SOURCE_RTC;
+    count = s_drd.armed ? s_drd.count + 1 : 1;
+  } else {
+    // RTC memory lost: the previous boot may have armed NVS
+    countSource = SOURCE_NVS;
+    uint8_t stored = readNvsCount();
+    count = stored ? stored + 1 : 1;
+    s_drd.nvsArmed = stored ? 1 : 0;
+  }
+  if (count > maxResets) count = 1;
+
+  bool armed = count < maxResets;
+  s_drd.count = count;
+  s_drd.armed = armed;
+
+  if (countSource == SOURCE_NVS && armed) {
+    // Survive another power loss within the window (one write, cleared by loop())
+    writeNvsCount(count);
+    s_drd.nvsArmed = 1;
+  } else if (!armed && s_drd.nvsArmed) {
+    clearFlag();
+  }
+  seal(s_drd);
+  windowClosed = !armed && !s_drd.nvsArmed;
+  detectTime = micros() - t0;
+
+  Serial.println("=== DRD Detection ===");
+  Serial.printf("Reset count: %u of %u (%s)\n", count, maxResets, sourceName(countSource));
+  Serial.printf("Timeout window: %u ms\n", timeout);
+  Serial.printf("Detection: %u us, %u flash writes\n", detectTime, nvsWrites);
+  if (count >= 2) Serial.println("DOUBLE RESET DETECTED!");
+
+  return count >= 2;
+}
+
+void DRD_Manager::clearFlag() {
+  s_drd.armed = 0;
+  if (s_drd.nvsArmed) {
+    // Also removes the keys written by the old NVS-only detector
+    if (prefs.begin(NAMESPACE, false)) {
+      prefs.clear();
+      prefs.end();
+      nvsWrites++;
+    }
+    s_drd.nvsArmed = 0;
+  }
+  seal(s_drd);
+  Serial.println("DRD flag cleared");
+}
+
+void DRD_Manager::loop() {
+  if (!windowClosed && millis() > timeout) {
+    clearFlag();
+    windowClosed = true;
+  }
+}
+
+uint8_t DRD_Manager::readNvsCount() {
+  if (!prefs.begin(NAMESPACE, true)) return 0;  // Namespace does not exist
+  uint32_t stored = prefs.getUInt(KEY_COUNT, 0);
+  prefs.end();
+  return stored > 255 ? 0 : (uint8_t)stored;
+}
+
+void DRD_Manager::writeNvsCount(uint8_t value) {
+  if (!prefs.begin(NAMESPACE, false)) {
+    Serial.println("ERROR: Cannot open DRD preferences");
+    return;
+  }
+  prefs.putUInt(KEY_COUNT, value);
+  prefs.end();
+  nvsWrites++;
+}
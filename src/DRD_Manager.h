@@ -5,12 +5,24 @@
 #include <Preferences.h>
 
 /**
- * @brief Double Reset Detection Manager
- * 
- * Detects when the ESP32 is reset twice within a configurable time window.
- * Uses NVS (Non-Volatile Storage) via Preferences to persist reset detection
- * state across power cycles.
- * 
+ * @brief Double (multi) Reset Detection Manager
+ *
+ * Counts resets that happen within a configurable time window of the
+ * previous boot. The count lives in RTC_NOINIT memory, which survives
+ * software, watchdog and panic resets, so a warm reset costs no flash
+ * access at all. A magic value and checksum reject the random content RTC
+ * memory has after power loss.
+ *
+ * Power loss (and the EN/reset button on boards where it cuts the chip's
+ * power domain) clears RTC memory. Only on those boots is NVS used: the
+ * count is read back and one write arms it, and loop() removes it again
+ * after the window. Boots with a valid RTC record never touch NVS.
+ *
+ * With maxResets > 2 more than two modes can be selected: resetCount()
+ * is 1 for a normal boot, 2 after a double reset, 3 after a triple reset,
+ * and so on. Reaching maxResets disarms the detector, so the next reset
+ * starts over at 1.
+ *
  * Usage:
  *   DRD_Manager drd(3000);  // 3 second window
  *   if (drd.detectDoubleReset()) {
@@ -18,119 +30,54 @@
  *   } else {
  *     // Load primary dashboard
  *   }
+ *   // in loop():
+ *   drd.loop();
  */
 class DRD_Manager {
-private:
-  Preferences prefs;
-  const char* NAMESPACE = "drd";
-  const char* KEY_FLAG = "flag";
-  const char* KEY_TIME = "time";
-  const char* KEY_COUNT = "count";
-  
-  uint32_t timeout;           // Detection window in milliseconds
-  bool doubleResetDetected;   // Detection result flag
-  
 public:
+  /**
+   * @brief Where the reset count came from
+   */
+  enum Source {
+    SOURCE_RTC,   // Warm reset, RTC record valid
+    SOURCE_NVS    // RTC memory lost (power-on), NVS fallback
+  };
+
   /**
    * @brief Constructor
-   * @param timeoutMs Time window for double reset detection (default: 3000ms)
+   * @param timeoutMs Time window for reset detection (default: 3000ms)
+   * @param maxResets Highest count reported before starting over (default: 2)
    */
-  DRD_Manager(uint32_t timeoutMs = 3000) : timeout(timeoutMs), doubleResetDetected(false) {}
-  
+  DRD_Manager(uint32_t timeoutMs = 3000, uint8_t maxResets = 2);
+
   /**
-   * @brief Detect if a double reset occurred
-   * @return true if double reset detected, false otherwise
-   * 
+   * @brief Count this reset and report whether it completes a double reset
+   * @return true if resetCount() >= 2
+   *
    * Call this in setup() as early as possible.
-   * Detection logic:
-   * 1. Check if flag exists and is within timeout window
-   * 2. If yes, increment counter and check if >= 2
-   * 3. If double reset detected, clear flag and return true
-   * 4. If not, set flag with current time
    */
-  bool detectDoubleReset() {
-    if (!prefs.begin(NAMESPACE, false)) {
-      Serial.println("ERROR: Cannot open DRD preferences");
-      return false;
-    }
-    
-    bool flagExists = prefs.isKey(KEY_FLAG);
-    uint32_t lastResetTime = prefs.getUInt(KEY_TIME, 0);
-    uint32_t resetCount = prefs.getUInt(KEY_COUNT, 0);
-    uint32_t currentTime = millis();
-    
-    Serial.println("=== DRD Detection ===");
-    Serial.printf("Flag exists: %s\n", flagExists ? "YES" : "NO");
-    Serial.printf("Last reset: %u ms ago\n", currentTime - lastResetTime);
-    Serial.printf("Reset count: %u\n", resetCount);
-    Serial.printf("Timeout window: %u ms\n", timeout);
-    
-    if (flagExists) {
-      // Flag exists - check if within timeout window
-      uint32_t timeSinceLastReset = currentTime - lastResetTime;
-      
-      if (timeSinceLastReset < timeout) {
-        // Within timeout window - increment counter
-        resetCount++;
-        Serial.printf("Within window! Count now: %u\n", resetCount);
-        
-        if (resetCount >= 2) {
-          // Double reset detected!
-          Serial.println("DOUBLE RESET DETECTED!");
-          doubleResetDetected = true;
-          
-          // Clear the flag
-          prefs.clear();
-          prefs.end();
-          Serial.println("DRD flag cleared");
-          return true;
-        } else {
-          // First reset in window, update counter
-          prefs.putUInt(KEY_COUNT, resetCount);
-          prefs.putUInt(KEY_TIME, currentTime);
-        }
-      } else {
-        // Outside timeout window - reset counter
-        Serial.println("Outside window - resetting counter");
-        prefs.putUInt(KEY_COUNT, 1);
-        prefs.putUInt(KEY_TIME, currentTime);
-      }
-    } else {
-      // No flag exists - first reset, create flag
-      Serial.println("First reset - creating flag");
-      prefs.putBool(KEY_FLAG, true);
-      prefs.putUInt(KEY_TIME, currentTime);
-      prefs.putUInt(KEY_COUNT, 1);
-    }
-    
-    prefs.end();
-    doubleResetDetected = false;
-    return false;
-  }
-  
+  bool detectDoubleReset();
+
   /**
-   * @brief Clear the double reset detection flag
-   * 
-   * Call this after the timeout period has elapsed in normal operation
-   * to reset the detection state. This prevents false positives from
-   * resets that occur after the timeout window.
+   * @brief Resets in a row within the window, including this one (1..maxResets)
+   *
+   * Valid after detectDoubleReset().
    */
-  void clearFlag() {
-    if (prefs.begin(NAMESPACE, false)) {
-      prefs.clear();
-      prefs.end();
-      Serial.println("DRD flag cleared");
-    }
-  }
-  
+  uint8_t resetCount() const { return count; }
+
+  /**
+   * @brief Disarm the detector (the next reset counts as the first one)
+   */
+  void clearFlag();
+
   /**
    * @brief Check if double reset was detected
    * @return true if double reset was detected during initialization
    */
   bool wasDoubleResetDetected() const {
-    return doubleResetDetected;
+    return count >= 2;
   }
-  
+
   /**
    * @brief Set a custom timeout window
    * @param timeoutMs New timeout in milliseconds
@@ -138,7 +85,7 @@ public:
   void setTimeout(uint32_t timeoutMs) {
     timeout = timeoutMs;
   }
-  
+
   /**
    * @brief Get current timeout setting
    * @return Timeout in milliseconds
@@ -146,25 +93,37 @@ public:
   uint32_t getTimeout() const {
     return timeout;
   }
-  
+
   /**
-   * @brief Loop function to auto-clear flag after timeout
-   * 
-   * Call this in loop() to automatically clear the flag after
-   * the timeout period has elapsed. This ensures the flag doesn't
-   * persist indefinitely.
+   * @brief Disarm the detector once the window has elapsed
+   *
+   * Call this in loop(). Only writes to flash if the NVS fallback was
+   * armed on this boot.
    */
-  void loop() {
-    static unsigned long startTime = millis();
-    static bool flagCleared = false;
-    
-    if (!flagCleared && (millis() - startTime) > timeout) {
-      if (!doubleResetDetected) {
-        clearFlag();
-      }
-      flagCleared = true;
-    }
-  }
+  void loop();
+
+  // Detection statistics
+  Source source() const { return countSource; }
+  static const char* sourceName(Source s) { return s == SOURCE_RTC ? "rtc" : "nvs"; }
+  uint32_t detectUs() const { return detectTime; }     // Time spent in detectDoubleReset()
+  uint8_t flashWrites() const { return nvsWrites; }    // NVS writes this boot (incl. clearing)
+  uint8_t getMaxResets() const { return maxResets; }
+
+private:
+  const char* NAMESPACE = "drd";
+  const char* KEY_COUNT = "count";
+
+  Preferences prefs;
+  uint32_t timeout;           // Detection window in milliseconds
+  uint8_t maxResets;          // Count wraps to 1 after this
+  uint8_t count;              // Detection result
+  Source countSource;
+  bool windowClosed;          // loop() has disarmed the detector
+  uint32_t detectTime;
+  uint8_t nvsWrites;
+
+  uint8_t readNvsCount();
+  void writeNvsCount(uint8_t value);
 };
 
-#endif // DRD_MANAGER_H
\ No newline at end of file
+#endif // DRD_MANAGER_H
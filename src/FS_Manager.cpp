@@ -0,0 +1,261 @@
+/**
+ * @file FS_Manager.cpp
+ * @brief Implementation of the LittleFS storage layer
+ */
+
+#include "FS_Manager.h"
+#include <SPIFFS.h>
+
+static const char* BENCH_FILL_FILE = "/bench.fill";
+static const char* BENCH_TEST_FILE = "/bench.dat";
+static const char* TMP_SUFFIX = ".tmp";
+
+FS_Manager::FS_Manager()
+  : _mounted(false), _formatted(false), _mountUs(0), _migratedFiles(0), _skippedFiles(0),
+    _spiffsMountUs(0), _migrationUs(0), _writes(0), _writeFailures(0), _lastWriteUs(0),
+    _maxWriteUs(0), _bench(BENCH_IDLE), _benchLevel(0), _benchRows(0), _benchIterations(0),
+    _benchSize(0) {
+}
+
+bool FS_Manager::begin() {
+  uint32_t t0 = micros();
+  _mounted = LittleFS.begin(false);
+  _mountUs = micros() - t0;
+
+  if (!_mounted) {
+    // Not LittleFS yet: SPIFFS partition from older firmware, or blank
+    if (!migrateFromSpiffs()) {
+      t0 = micros();
+      _mounted = LittleFS.begin(true);  // Formats the partition
+      _mountUs = micros() - t0;
+      _formatted = _mounted;
+    }
+  }
+
+  if (!_mounted) {
+    Serial.println(" LittleFS mount failed");
+    return false;
+  }
+
+  removeTempFiles();
+  Serial.printf(" LittleFS mounted in %u us (%u/%u bytes used)\n",
+                _mountUs, (unsigned)LittleFS.usedBytes(), (unsigned)LittleFS.totalBytes());
+  return true;
+}
+
+bool FS_Manager::migrateFromSpiffs() {
+  uint32_t t0 = micros();
+  if (!SPIFFS.begin(false)) return false;
+  _spiffsMountUs = micros() - t0;
+
+  struct Entry {
+    char path[33];
+    size_t offset;
+    size_t len;
+  };
+  Entry entries[MIGRATE_MAX_FILES];
+  uint8_t count = 0;
+  uint8_t* data = (uint8_t*)malloc(MIGRATE_MAX_BYTES);
+  size_t used = 0;
+  if (!data) {
+    // Formatting now would lose the files: leave SPIFFS for the next boot
+    SPIFFS.end();
+    Serial.println(" No RAM for the SPIFFS copy, migration postponed");
+    return true;
+  }
+
+  File root = SPIFFS.open("/");
+  File f = root.openNextFile();
+  while (f) {
+    size_t n = f.size();
+    if (count >= MIGRATE_MAX_FILES || used + n > MIGRATE_MAX_BYTES ||
+        strlen(f.path()) >= sizeof(entries[0].path)) {
+      Serial.printf(" Not migrating %s (%u bytes)\n", f.path(), (unsigned)n);
+      _skippedFiles++;
+    } else {
+      Entry& e = entries[count++];
+      strcpy(e.path, f.path());
+      e.offset = used;
+      e.len = f.read(data + used, n);
+      used += e.len;
+    }
+    f.close();
+    f = root.openNextFile();
+  }
+  root.close();
+  SPIFFS.end();
+
+  // Reformat as LittleFS and write the files back
+  uint32_t t1 = micros();
+  _mounted = LittleFS.begin(true);
+  _mountUs = micros() - t1;
+  _formatted = _mounted;
+  if (_mounted) {
+    for (uint8_t i = 0; i < count; i++) {
+      if (writeAtomic(entries[i].path, data + entries[i].offset, entries[i].len)) _migratedFiles++;
+    }
+  }
+  free(data);
+
+  _migrationUs = micros() - t0;
+  Serial.printf(" Migrated %u files from SPIFFS to LittleFS in %u us (%u skipped)\n",
+                _migratedFiles, _migrationUs, _skippedFiles);
+  return _mounted;
+}
+
+void FS_Manager::removeTempFiles() {
+  char stale[MIGRATE_MAX_FILES][33];
+  uint8_t n = 0;
+
+  File root = LittleFS.open("/");
+  File f = root.openNextFile();
+  while (f) {
+    const char* p = f.path();
+    size_t len = strlen(p);
+    if (n < MIGRATE_MAX_FILES && len >= 4 && len < sizeof(stale[0]) &&
+        strcmp(p + len - 4, TMP_SUFFIX) == 0) {
+      strcpy(stale[n++], p);
+    }
+    f.close();
+    f = root.openNextFile();
+  }
+  root.close();
+
+  for (uint8_t i = 0; i < n; i++) {
+    Serial.printf(" Removing interrupted write %s\n", stale[i]);
+    LittleFS.remove(stale[i]);
+  }
+}
+
+bool FS_Manager::writeAtomic(const char* path, const uint8_t* data, size_t len) {
+  uint32_t t0 = micros();
+  char tmp[48];
+  snprintf(tmp, sizeof(tmp), "%s%s", path, TMP_SUFFIX);
+
+  bool ok = false;
+  File f = LittleFS.open(tmp, "w");
+  if (f) {
+    ok = f.write(data, len) == len;
+    f.close();  // Commits the new file
+    ok = ok && LittleFS.rename(tmp, path);
+    if (!ok) LittleFS.remove(tmp);
+  }
+
+  _lastWriteUs = micros() - t0;
+  if (_lastWriteUs > _maxWriteUs) _maxWriteUs = _lastWriteUs;
+  if (ok) {
+    _writes++;
+  } else {
+    _writeFailures++;
+    Serial.printf(" Atomic write of %s failed\n", path);
+  }
+  return ok;
+}
+
+// ============================================================================
+// BENCHMARK
+// ============================================================================
+
+bool FS_Manager::startBenchmark(size_t writeSize, uint8_t iterations) {
+  if (!_mounted || _bench != BENCH_IDLE) return false;
+  _benchSize = constrain(writeSize, (size_t)16, (size_t)FILL_CHUNK);
+  _benchIterations = constrain(iterations, (uint8_t)1, (uint8_t)50);
+  _benchLevel = 0;
+  _benchRows = 0;
+  _bench = BENCH_FILL;
+  Serial.printf(" FS benchmark started (%u bytes x %u per level)\n",
+                (unsigned)_benchSize, _benchIterations);
+  return true;
+}
+
+size_t FS_Manager::fillTarget(uint8_t level) const {
+  return LittleFS.totalBytes() * (level * 25) / 100;
+}
+
+void FS_Manager::loop() {
+  switch (_bench) {
+    case BENCH_IDLE:
+      break;
+
+    case BENCH_FILL: {
+      if (LittleFS.usedBytes() >= fillTarget(_benchLevel)) {
+        if (_filler) _filler.close();
+        _bench = BENCH_MEASURE;
+        break;
+      }
+      if (!_filler) _filler = LittleFS.open(BENCH_FILL_FILE, "a");
+      static uint8_t chunk[512];
+      memset(chunk, 0xA5, sizeof(chunk));
+      size_t written = 0;
+      for (size_t i = 0; i < FILL_CHUNK / sizeof(chunk); i++) {
+        written += _filler ? _filler.write(chunk, sizeof(chunk)) : 0;
+      }
+      if (written < FILL_CHUNK) {
+        // Filesystem full before reaching the level: measure what we have
+        if (_filler) _filler.close();
+        _bench = BENCH_MEASURE;
+      }
+      break;
+    }
+
+    case BENCH_MEASURE:
+      measureLevel();
+      _benchLevel++;
+      _bench = _benchLevel < BENCH_LEVELS ? BENCH_FILL : BENCH_CLEANUP;
+      break;
+
+    case BENCH_CLEANUP:
+      LittleFS.remove(BENCH_FILL_FILE);
+      LittleFS.remove(BENCH_TEST_FILE);
+      _bench = BENCH_IDLE;
+      Serial.println(" FS benchmark finished");
+      break;
+  }
+}
+
+void FS_Manager::measureLevel() {
+  BenchRow& row = _rows[_benchRows++];
+  size_t total = LittleFS.totalBytes();
+  row.fillPct = total ? (uint8_t)(LittleFS.usedBytes() * 100 / total) : 0;
+
+  uint32_t t0 = micros();
+  LittleFS.end();
+  _mounted = LittleFS.begin(false);
+  row.mountUs = micros() - t0;
+
+  uint8_t* buf = (uint8_t*)malloc(_benchSize);
+  row.writeAvgUs = row.writeMaxUs = row.readAvgUs = 0;
+  if (!_mounted || !buf) {
+    free(buf);
+    return;
+  }
+
+  // Benchmark writes are not counted in the regular write statistics
+  uint32_t writes = _writes, failures = _writeFailures, maxUs = _maxWriteUs, lastUs = _lastWriteUs;
+
+  uint64_t writeSum = 0, readSum = 0;
+  for (uint8_t i = 0; i < _benchIterations; i++) {
+    memset(buf, i, _benchSize);
+    writeAtomic(BENCH_TEST_FILE, buf, _benchSize);
+    writeSum += _lastWriteUs;
+    if (_lastWriteUs > row.writeMaxUs) row.writeMaxUs = _lastWriteUs;
+
+    t0 = micros();
+    File f = LittleFS.open(BENCH_TEST_FILE, "r");
+    if (f) {
+      f.read(buf, _benchSize);
+      f.close();
+    }
+    readSum += micros() - t0;
+  }
+  _writes = writes;
+  _writeFailures = failures;
+  _maxWriteUs = maxUs;
+  _lastWriteUs = lastUs;
+  row.writeAvgUs = writeSum / _benchIterations;
+  row.readAvgUs = readSum / _benchIterations;
+  free(buf);
+
+  Serial.printf("  FS bench %u%%: mount %u us, write avg %u / max %u us, read avg %u us\n",
+                row.fillPct, row.mountUs, row.writeAvgUs, row.writeMaxUs, row.readAvgUs);
+}
@@ -0,0 +1,153 @@
+/**
+ * @file FS_Manager.h
+ * @brief LittleFS mount, one-time SPIFFS migration, atomic file writes
+ * @version 1.0.0
+ *
+ * @details
+ * The data partition ("spiffs" label in the default partition table) is
+ * mounted as LittleFS. LittleFS is copy-on-write with power-loss safe
+ * metadata, mounts in roughly constant time and has no SPIFFS-style GC
+ * pauses that grow with the fill level.
+ *
+ * Migration (first boot after the switch):
+ * - LittleFS.begin(false) fails on a SPIFFS-formatted partition.
+ * - The partition is mounted as SPIFFS and every file up to
+ *   MIGRATE_MAX_BYTES in total is copied into RAM. This needs the
+ *   partition at the offset and size SPIFFS was written with, which
+ *   partitions.csv keeps.
+ * - The partition is formatted as LittleFS and the files are written back
+ *   with writeAtomic(). Later boots mount LittleFS directly.
+ * - loadConfig() then finds the legacy JSON files, imports them into the
+ *   NVS record and deletes them.
+ * - If the RAM copy cannot be allocated, nothing is formatted and the
+ *   migration runs again at the next boot (LittleFS stays unmounted).
+ *
+ * Atomic replace:
+ *   writeAtomic() writes "<path>.tmp", closes it (LittleFS commits on
+ *   close) and renames it over <path>. littlefs renames atomically, so a
+ *   power cut leaves either the old or the new file, never a partial one.
+ *   Stale .tmp files from an interrupted write are removed by begin().
+ *
+ * Benchmark:
+ *   startBenchmark() fills the filesystem to 0/25/50/75 % with a filler
+ *   file (one FILL_CHUNK per loop() call, so the web server keeps running)
+ *   and at each level measures remount time and atomic write/read latency.
+ *
+ * Usage:
+ *   FS_Manager storage;
+ *   storage.begin();
+ *   storage.writeAtomic("/file.json", data, len);
+ *   // in loop():
+ *   storage.loop();
+ */
+
+#ifndef FS_MANAGER_H
+#define FS_MANAGER_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+class FS_Manager {
+public:
+  static const size_t MIGRATE_MAX_BYTES = 16384;  // RAM used for the SPIFFS copy
+  static const size_t MIGRATE_MAX_FILES = 16;
+  static const size_t FILL_CHUNK = 4096;           // Filler bytes written per loop()
+  static const uint8_t BENCH_LEVELS = 4;           // 0, 25, 50, 75 %
+
+  /**
+   * @brief Results for one fill level
+   */
+  struct BenchRow {
+    uint8_t fillPct;       // Fill level measured at
+    uint32_t mountUs;      // end() + begin()
+    uint32_t writeAvgUs;   // writeAtomic() of the test size
+    uint32_t writeMaxUs;
+    uint32_t readAvgUs;    // Open + read + close
+  };
+
+  FS_Manager();
+
+  /**
+   * @brief Mount LittleFS, migrating a SPIFFS partition on first use
+   * @return true if LittleFS is mounted
+   */
+  bool begin();
+
+  /**
+   * @brief Replace a file atomically (temp file + rename)
+   * @return true if the new content is in place
+   */
+  bool writeAtomic(const char* path, const uint8_t* data, size_t len);
+
+  /**
+   * @brief Start the fill-level benchmark (runs from loop())
+   * @param writeSize Bytes per test write
+   * @param iterations Writes/reads per level
+   * @return false if not mounted or already running
+   */
+  bool startBenchmark(size_t writeSize = 1024, uint8_t iterations = 10);
+
+  /**
+   * @brief Advance a running benchmark
+   */
+  void loop();
+
+  fs::FS& fs() { return LittleFS; }
+  bool isMounted() const { return _mounted; }
+
+  // Boot / migration statistics
+  uint32_t mountUs() const { return _mountUs; }
+  bool formatted() const { return _formatted; }           // Partition was (re)formatted this boot
+  uint8_t migratedFiles() const { return _migratedFiles; }
+  uint8_t skippedFiles() const { return _skippedFiles; }  // Too large to migrate
+  uint32_t spiffsMountUs() const { return _spiffsMountUs; }
+  uint32_t migrationUs() const { return _migrationUs; }
+
+  // Write statistics
+  uint32_t atomicWrites() const { return _writes; }
+  uint32_t writeFailures() const { return _writeFailures; }
+  uint32_t lastWriteUs() const { return _lastWriteUs; }
+  uint32_t maxWriteUs() const { return _maxWriteUs; }
+
+  // Benchmark state
+  bool benchRunning() const { return _bench != BENCH_IDLE; }
+  uint8_t benchCount() const { return _benchRows; }
+  const BenchRow& benchRow(uint8_t i) const { return _rows[i]; }
+  size_t benchWriteSize() const { return _benchSize; }
+
+private:
+  enum BenchState {
+    BENCH_IDLE,
+    BENCH_FILL,      // Growing the filler file to the next level
+    BENCH_MEASURE,   // Remount + write/read timings
+    BENCH_CLEANUP    // Removing the filler and test files
+  };
+
+  bool migrateFromSpiffs();
+  void removeTempFiles();
+  void measureLevel();
+  size_t fillTarget(uint8_t level) const;
+
+  bool _mounted;
+  bool _formatted;
+  uint32_t _mountUs;
+  uint8_t _migratedFiles;
+  uint8_t _skippedFiles;
+  uint32_t _spiffsMountUs;
+  uint32_t _migrationUs;
+
+  uint32_t _writes;
+  uint32_t _writeFailures;
+  uint32_t _lastWriteUs;
+  uint32_t _maxWriteUs;
+
+  BenchState _bench;
+  uint8_t _benchLevel;
+  uint8_t _benchRows;
+  uint8_t _benchIterations;
+  size_t _benchSize;
+  File _filler;
+  BenchRow _rows[BENCH_LEVELS];
+};
+
+#endif // FS_MANAGER_H
@@ -38,6 +38,7 @@
  */
 
 #include "GSM_Test.h"
+#include "Log_Ring.h"
 #include "SMTP.h"  // Include SMTP library for GSM email functionality
 
 // ============================================================================
@@ -57,7 +58,9 @@
  * No actual hardware initialization occurs in the constructor.
  */
 GSM_Test::GSM_Test(HardwareSerial& modemSerial, int rxPin, int txPin, long baudRate)
-  : _modemSerial(modemSerial), _rxPin(rxPin), _txPin(txPin), _baudRate(baudRate), _smtpClient(nullptr), _smtpPort(465) {
+  : _modemSerial(modemSerial), _rxPin(rxPin), _txPin(txPin), _baudRate(baudRate), _smtpClient(nullptr), _smtpPort(465),
+    _initState(INIT_OFF), _initStep(0), _initStart(0), _probeStart(0), _readyAt(0), _lastSend(0), _probes(0),
+    _simReady(false), _lineLen(0), _atCommands(0), _atFailures(0), _atBusyMs(0) {
 }
 
 /**
@@ -66,24 +69,135 @@ GSM_Test::GSM_Test(HardwareSerial& modemSerial, int rxPin, int txPin, long baudR
  * @details
  * This method performs the actual hardware initialization:
  * 1. Configures the serial port with the specified baud rate and pin assignments
- * 2. Waits 2 seconds for the modem to initialize
+ * 2. Starts the asynchronous bring-up driven by loop()
  * 3. Prints initialization information to the Serial monitor
  * 
  * @note This method should be called once in setup() after constructing the object.
- * The 2-second delay is necessary to allow the modem to boot up and become ready.
+ * It no longer waits for the modem to boot; loop() polls AT until it answers.
  */
 void GSM_Test::begin() {
   // Initialize serial communication with the modem
   _modemSerial.begin(_baudRate, SERIAL_8N1, _rxPin, _txPin);
   
-  // Wait for modem to initialize (SIMCom A76xx requires startup time)
-  delay(2000);
+  _initState = INIT_PROBING;
+  _initStep = 0;
+  _initStart = millis();
+  _probeStart = _initStart;
+  _readyAt = 0;
+  _lastSend = 0;
+  _probes = 0;
+  _simReady = false;
+  _lineLen = 0;
   
   // Log initialization details for debugging
-  Serial.println("GSM_Test: Modem initialized");
-  Serial.println("GSM_Test: RX Pin = " + String(_rxPin));
-  Serial.println("GSM_Test: TX Pin = " + String(_txPin));
-  Serial.println("GSM_Test: Baud Rate = " + String(_baudRate));
+  LOG_I(LOG_GSM, "Modem bring-up started (RX %d, TX %d, %u baud)", _rxPin, _txPin, (unsigned)_baudRate);
+}
+
+// ============================================================================
+// ASYNCHRONOUS BRING-UP
+// ============================================================================
+
+// One-time settings applied after the first OK, in order
+static const char* const INIT_COMMANDS[] = {
+  "ATE0",         // Echo off
+  "AT+CMEE=2",    // Verbose +CME ERROR texts
+  "AT+CREG=2",    // +CREG with LAC and cell id
+  "AT+COPS=3,0",  // Long alphanumeric operator name
+  "AT+CPIN?"      // SIM state (reported, not required for ready)
+};
+static const uint8_t INIT_COMMAND_COUNT = sizeof(INIT_COMMANDS) / sizeof(INIT_COMMANDS[0]);
+
+const char* GSM_Test::initStateName(InitState state) {
+  switch (state) {
+    case INIT_OFF:         return "off";
+    case INIT_PROBING:     return "initialising";
+    case INIT_CONFIGURING: return "initialising";
+    case INIT_READY:       return "ready";
+    case INIT_NO_RESPONSE: return "not_responding";
+    default:               return "unknown";
+  }
+}
+
+bool GSM_Test::readLine() {
+  while (_modemSerial.available()) {
+    char c = _modemSerial.read();
+    if (c == '\r') continue;
+    if (c == '\n') {
+      if (_lineLen == 0) continue;  // Blank line between responses
+      _line[_lineLen] = '\0';
+      _lineLen = 0;
+      return true;
+    }
+    if (_lineLen < sizeof(_line) - 1) _line[_lineLen++] = c;
+  }
+  return false;
+}
+
+void GSM_Test::sendInitStep() {
+  if (_initStep >= INIT_COMMAND_COUNT) {
+    _initState = INIT_READY;
+    _readyAt = millis();
+    LOG_I(LOG_GSM, "Modem ready after %u ms (%u AT probes, SIM %s)",
+                  initMs(), _probes, _simReady ? "ready" : "not ready");
+    return;
+  }
+  _modemSerial.println(INIT_COMMANDS[_initStep]);
+  _lastSend = millis();
+}
+
+void GSM_Test::loop() {
+  uint32_t now = millis();
+
+  switch (_initState) {
+    case INIT_OFF:
+    case INIT_READY:
+      return;  // Serial belongs to the blocking AT methods once ready
+
+    case INIT_PROBING:
+    case INIT_NO_RESPONSE:
+      while (readLine()) {
+        if (strcmp(_line, "OK") == 0) {
+          _initState = INIT_CONFIGURING;
+          _initStep = 0;
+          sendInitStep();
+          return;
+        }
+      }
+      if (_initState == INIT_PROBING && now - _probeStart >= INIT_TIMEOUT_MS) {
+        _initState = INIT_NO_RESPONSE;
+        LOG_W(LOG_GSM, "Modem not responding, probing every 5 s");
+      }
+      if (!_lastSend || now - _lastSend >= (_initState == INIT_PROBING ? AT_POLL_MS : AT_RETRY_MS)) {
+        _modemSerial.println("AT");
+        _lastSend = now;
+        _probes++;
+      }
+      return;
+
+    case INIT_CONFIGURING:
+      while (readLine()) {
+        if (strncmp(_line, "+CPIN:", 6) == 0) {
+          _simReady = strstr(_line, "READY") != nullptr;
+        } else if (strcmp(_line, "OK") == 0 || strncmp(_line, "ERROR", 5) == 0 ||
+                   strncmp(_line, "+CME ERROR", 10) == 0) {
+          // An unsupported setting is not fatal; move on
+          if (strcmp(_line, "OK") != 0) {
+            LOG_I(LOG_GSM, "%s -> %s", INIT_COMMANDS[_initStep], _line);
+          }
+          _initStep++;
+          sendInitStep();
+          if (_initState == INIT_READY) return;
+        }
+      }
+      if (now - _lastSend >= CMD_TIMEOUT_MS) {
+        // Modem went quiet (reset?): start over
+        LOG_W(LOG_GSM, "No reply to %s, probing again", INIT_COMMANDS[_initStep]);
+        _initState = INIT_PROBING;
+        _probeStart = now;
+        _lastSend = 0;
+      }
+      return;
+  }
 }
 
 // ============================================================================
@@ -106,18 +220,18 @@ void GSM_Test::begin() {
  * that require SIM card functionality (calls, SMS, network operations).
  */
 bool GSM_Test::checkSIM() {
-  Serial.println("GSM_Test: Checking SIM card status...");
+  LOG_I(LOG_GSM, "Checking SIM card status...");
   
   // Send AT+CPIN? command to check SIM status
   String response = sendATCommand("AT+CPIN?");
   
   // Check for "READY" status in the response
   if (response.indexOf("READY") >= 0) {
-    Serial.println("GSM_Test: ✓ SIM card is ready");
+    LOG_I(LOG_GSM, "✓ SIM card is ready");
     return true;
   } else {
-    Serial.println("GSM_Test: ✗ SIM card not ready");
-    Serial.println("GSM_Test: Response: " + response);
+    LOG_W(LOG_GSM, "✗ SIM card not ready");
+    LOG_D(LOG_GSM, "Response: %s", response);
     return false;
   }
 }
@@ -144,11 +258,11 @@ bool GSM_Test::checkSIM() {
  * @warning Ensure the SIM card is ready and has sufficient credit before calling.
  */
 bool GSM_Test::makeCall(String phoneNumber) {
-  Serial.println("GSM_Test: Making call to " + phoneNumber);
+  LOG_I(LOG_GSM, "Making call to %s", phoneNumber);
   
   // First verify SIM card is ready for operations
   if (!checkSIM()) {
-    Serial.println("GSM_Test: ✗ Cannot make call - SIM not ready");
+    LOG_W(LOG_GSM, "✗ Cannot make call - SIM not ready");
     return false;
   }
   
@@ -158,11 +272,11 @@ bool GSM_Test::makeCall(String phoneNumber) {
   
   // Check for successful call initiation
   if (response.indexOf("OK") >= 0) {
-    Serial.println("GSM_Test: ✓ Call initiated successfully");
+    LOG_I(LOG_GSM, "✓ Call initiated successfully");
     return true;
   } else {
-    Serial.println("GSM_Test: ✗ Call failed to initiate");
-    Serial.println("GSM_Test: Response: " + response);
+    LOG_W(LOG_GSM, "✗ Call failed to initiate");
+    LOG_D(LOG_GSM, "Response: %s", response);
     return false;
   }
 }
@@ -179,18 +293,18 @@ bool GSM_Test::makeCall(String phoneNumber) {
  * If no call is active, the modem may respond with "ERROR" but this is normal.
  */
 bool GSM_Test::hangupCall() {
-  Serial.println("GSM_Test: Hanging up call...");
+  LOG_I(LOG_GSM, "Hanging up call...");
   
   // Send ATH command to terminate active call
   String response = sendATCommand("ATH");
   
   // Check for successful hangup
   if (response.indexOf("OK") >= 0) {
-    Serial.println("GSM_Test: ✓ Call ended successfully");
+    LOG_I(LOG_GSM, "✓ Call ended successfully");
     return true;
   } else {
-    Serial.println("GSM_Test: ✗ Hangup failed");
-    Serial.println("GSM_Test: Response: " + response);
+    LOG_W(LOG_GSM, "✗ Hangup failed");
+    LOG_D(LOG_GSM, "Response: %s", response);
     return false;
   }
 }
@@ -221,25 +335,25 @@ bool GSM_Test::hangupCall() {
  * @warning Ensure the SIM card is ready and has sufficient credit.
  */
 bool GSM_Test::sendSMS(String phoneNumber, String message) {
-  Serial.println("GSM_Test: Sending SMS to " + phoneNumber);
-  Serial.println("GSM_Test: Message: " + message);
+  LOG_I(LOG_GSM, "Sending SMS to %s", phoneNumber);
+  LOG_I(LOG_GSM, "Message: %s", message);
   
   // First verify SIM card is ready for operations
   if (!checkSIM()) {
-    Serial.println("GSM_Test: ✗ Cannot send SMS - SIM not ready");
+    LOG_W(LOG_GSM, "✗ Cannot send SMS - SIM not ready");
     return false;
   }
   
   // Set SMS to text mode (required for text SMS)
   String response = sendATCommand("AT+CMGF=1");
   if (response.indexOf("OK") < 0) {
-    Serial.println("GSM_Test: ✗ Failed to set SMS text mode");
+    LOG_W(LOG_GSM, "✗ Failed to set SMS text mode");
     return false;
   }
   
   // Send SMS command with phone number
   String smsCommand = "AT+CMGS=\"" + phoneNumber + "\"";
-  Serial.println("GSM_Test: Sending command: " + smsCommand);
+  LOG_D(LOG_GSM, "Sending command: %s", smsCommand);
   
   // Send the command and wait for '>' prompt
   _modemSerial.print(smsCommand);
@@ -247,7 +361,7 @@ bool GSM_Test::sendSMS(String phoneNumber, String message) {
   
   // Wait for '>' prompt (modem ready to receive message)
   if (!waitForResponse(">", 5000)) {
-    Serial.println("GSM_Test: ✗ No '>' prompt received");
+    LOG_W(LOG_GSM, "✗ No '>' prompt received");
     return false;
   }
   
@@ -260,11 +374,11 @@ bool GSM_Test::sendSMS(String phoneNumber, String message) {
   
   // Check for successful SMS delivery (+CMGS response and OK)
   if (smsResponse.indexOf("+CMGS:") >= 0 && smsResponse.indexOf("OK") >= 0) {
-    Serial.println("GSM_Test: ✓ SMS sent successfully");
+    LOG_I(LOG_GSM, "✓ SMS sent successfully");
     return true;
   } else {
-    Serial.println("GSM_Test: ✗ SMS failed to send");
-    Serial.println("GSM_Test: Response: " + smsResponse);
+    LOG_W(LOG_GSM, "✗ SMS failed to send");
+    LOG_D(LOG_GSM, "Response: %s", smsResponse);
     return false;
   }
 }
@@ -292,7 +406,7 @@ bool GSM_Test::sendSMS(String phoneNumber, String message) {
  * @warning Use with caution as incorrect AT commands can affect modem operation.
  */
 String GSM_Test::sendATCommand(String command, unsigned long timeout) {
-  Serial.println("GSM_Test: Sending: " + command);
+  LOG_D(LOG_GSM, "Sending: %s", command);
   
   // Clear any pending data from the serial buffer
   while (_modemSerial.available()) {
@@ -304,7 +418,12 @@ String GSM_Test::sendATCommand(String command, unsigned long timeout) {
   _modemSerial.print("\r\n");
   
   // Wait for and return the complete response
-  return waitForAnyResponse(timeout);
+  uint32_t start = millis();
+  String response = waitForAnyResponse(timeout);
+  _atBusyMs += millis() - start;
+  _atCommands++;
+  if (response.length() == 0 || response.indexOf("ERROR") >= 0) _atFailures++;
+  return response;
 }
 
 // ============================================================================
@@ -336,7 +455,7 @@ bool GSM_Test::waitForResponse(String expectedResponse, unsigned long timeout) {
       
       // Check if expected response is found
       if (response.indexOf(expectedResponse) >= 0) {
-        Serial.println("GSM_Test: Received: " + response);
+        LOG_D(LOG_GSM, "Received: %s", response);
         return true;
       }
     }
@@ -344,8 +463,8 @@ bool GSM_Test::waitForResponse(String expectedResponse, unsigned long timeout) {
   }
   
   // Timeout occurred
-  Serial.println("GSM_Test: Timeout waiting for: " + expectedResponse);
-  Serial.println("GSM_Test: Received: " + response);
+  LOG_W(LOG_GSM, "Timeout waiting for: %s", expectedResponse);
+  LOG_D(LOG_GSM, "Received: %s", response);
   return false;
 }
 
@@ -374,7 +493,7 @@ String GSM_Test::waitForAnyResponse(unsigned long timeout) {
     delay(10);  // Small delay to prevent excessive CPU usage
   }
   
-  Serial.println("GSM_Test: Response: " + response);
+  LOG_D(LOG_GSM, "Response: %s", response);
   return response;
 }
 
@@ -396,16 +515,16 @@ GSM_Test::NetworkInfo GSM_Test::detectCarrierNetwork() {
   networkInfo.locationAreaCode = "Unknown";
   networkInfo.cellId = "Unknown";
   
-  Serial.println("GSM_Test: Detecting carrier network information...");
+  LOG_I(LOG_GSM, "Detecting carrier network information...");
   
   // Check if SIM is ready first
   if (!checkSIM()) {
-    Serial.println("GSM_Test: ✗ Cannot detect network - SIM not ready");
+    LOG_W(LOG_GSM, "✗ Cannot detect network - SIM not ready");
     return networkInfo;
   }
   
   // Get network operator information
-  Serial.println("GSM_Test: Getting network operator info...");
+  LOG_I(LOG_GSM, "Getting network operator info...");
   String response = sendATCommand("AT+COPS?");
   
   if (response.indexOf("+COPS:") >= 0) {
@@ -415,7 +534,7 @@ GSM_Test::NetworkInfo GSM_Test::detectCarrierNetwork() {
     if (end == -1) end = response.length();
     
     String operatorInfo = response.substring(start, end);
-    Serial.println("GSM_Test: Operator info: " + operatorInfo);
+    LOG_D(LOG_GSM, "Operator info: %s", operatorInfo);
     
     // Extract carrier name (format: +COPS: 0,0,"CARRIER_NAME",2)
     int quoteStart = operatorInfo.indexOf("\"");
@@ -431,7 +550,7 @@ GSM_Test::NetworkInfo GSM_Test::detectCarrierNetwork() {
   }
   
   // Get signal strength and quality
-  Serial.println("GSM_Test: Getting signal strength...");
+  LOG_I(LOG_GSM, "Getting signal strength...");
   response = sendATCommand("AT+CSQ");
   
   if (response.indexOf("+CSQ:") >= 0) {
@@ -440,7 +559,7 @@ GSM_Test::NetworkInfo GSM_Test::detectCarrierNetwork() {
     if (end == -1) end = response.length();
     
     String signalInfo = response.substring(start, end);
-    Serial.println("GSM_Test: Signal info: " + signalInfo);
+    LOG_D(LOG_GSM, "Signal info: %s", signalInfo);
     
     // Parse signal strength and quality (format: +CSQ: 20,99)
     int commaPos = signalInfo.indexOf(",");
@@ -460,7 +579,7 @@ GSM_Test::NetworkInfo GSM_Test::detectCarrierNetwork() {
   }
   
   // Get network registration status
-  Serial.println("GSM_Test: Getting network registration status...");
+  LOG_I(LOG_GSM, "Getting network registration status...");
   response = sendATCommand("AT+CREG?");
   
   if (response.indexOf("+CREG:") >= 0) {
@@ -469,7 +588,7 @@ GSM_Test::NetworkInfo GSM_Test::detectCarrierNetwork() {
     if (end == -1) end = response.length();
     
     String regInfo = response.substring(start, end);
-    Serial.println("GSM_Test: Registration info: " + regInfo);
+    LOG_D(LOG_GSM, "Registration info: %s", regInfo);
     
     // Parse registration status (format: +CREG: 0,1)
     int commaPos = regInfo.indexOf(",");
@@ -483,7 +602,7 @@ GSM_Test::NetworkInfo GSM_Test::detectCarrierNetwork() {
   }
   
   // Get cell information (Location Area Code and Cell ID)
-  Serial.println("GSM_Test: Getting cell information...");
+  LOG_I(LOG_GSM, "Getting cell information...");
   response = sendATCommand("AT+CREG=2");  // Enable extended registration info
   
   delay(1000);  // Wait for registration update
@@ -496,7 +615,7 @@ GSM_Test::NetworkInfo GSM_Test::detectCarrierNetwork() {
     if (end == -1) end = response.length();
     
     String cellInfo = response.substring(start, end);
-    Serial.println("GSM_Test: Cell info: " + cellInfo);
+    LOG_D(LOG_GSM, "Cell info: %s", cellInfo);
     
     // Parse LAC and Cell ID (format: +CREG: 2,1,"1234","5678")
     int firstQuote = cellInfo.indexOf("\"");
@@ -514,7 +633,7 @@ GSM_Test::NetworkInfo GSM_Test::detectCarrierNetwork() {
   }
   
   // Get MCC and MNC information
-  Serial.println("GSM_Test: Getting MCC/MNC information...");
+  LOG_I(LOG_GSM, "Getting MCC/MNC information...");
   response = sendATCommand("AT+COPS=3,0");  // Set operator name format
   
   delay(500);
@@ -535,7 +654,7 @@ GSM_Test::NetworkInfo GSM_Test::detectCarrierNetwork() {
       if (end == -1) end = response.length();
       
       String numericInfo = response.substring(start, end);
-      Serial.println("GSM_Test: Numeric info: " + numericInfo);
+      LOG_D(LOG_GSM, "Numeric info: %s", numericInfo);
       
       // Parse MCC and MNC (format: +COPS: 0,2,"12345",2)
       int quoteStart = numericInfo.indexOf("\"");
@@ -548,10 +667,13 @@ GSM_Test::NetworkInfo GSM_Test::detectCarrierNetwork() {
         }
       }
     }
+
+    // The format setting sticks: back to names for the next AT+COPS?
+    sendATCommand("AT+COPS=3,0");
   }
   
   // Determine network mode
-  Serial.println("GSM_Test: Determining network mode...");
+  LOG_I(LOG_GSM, "Determining network mode...");
   response = sendATCommand("AT+QNWINFO");
   
   if (response.indexOf("+QNWINFO:") >= 0) {
@@ -560,13 +682,14 @@ GSM_Test::NetworkInfo GSM_Test::detectCarrierNetwork() {
     if (end == -1) end = response.length();
     
     String nwInfo = response.substring(start, end);
-    Serial.println("GSM_Test: Network mode info: " + nwInfo);
+    LOG_D(LOG_GSM, "Network mode info: %s", nwInfo);
     
     // Parse network mode
+    // Format: +QNWINFO: "<mode>",...; anything else leaves the mode unknown
+    int colon = nwInfo.indexOf(":");
     int commaPos = nwInfo.indexOf(",");
-    if (commaPos > 0) {
-      String modeStr = nwInfo.substring(nwInfo.indexOf(":") + 1, commaPos);
-      networkInfo.networkMode = modeStr;
+    if (colon >= 0 && commaPos > colon) {
+      networkInfo.networkMode = nwInfo.substring(colon + 1, commaPos);
     }
   } else {
     // Fallback: try to determine from CREG response
@@ -576,17 +699,12 @@ GSM_Test::NetworkInfo GSM_Test::detectCarrierNetwork() {
   }
   
   // Print summary
-  Serial.println("GSM_Test: === Network Information Summary ===");
-  Serial.println("GSM_Test: Carrier: " + networkInfo.carrierName);
-  Serial.println("GSM_Test: MCC: " + networkInfo.mcc);
-  Serial.println("GSM_Test: MNC: " + networkInfo.mnc);
-  Serial.println("GSM_Test: Signal Strength: " + String(networkInfo.signalStrength) + " dBm");
-  Serial.println("GSM_Test: Signal Quality: " + String(networkInfo.signalQuality) + "/31");
-  Serial.println("GSM_Test: Network Mode: " + networkInfo.networkMode);
-  Serial.println("GSM_Test: Registered: " + String(networkInfo.isRegistered ? "Yes" : "No"));
-  Serial.println("GSM_Test: LAC: " + networkInfo.locationAreaCode);
-  Serial.println("GSM_Test: Cell ID: " + networkInfo.cellId);
-  Serial.println("GSM_Test: ======================================");
+  // Two lines: one log entry holds Log_Ring::STR_BYTES of string arguments
+  LOG_I(LOG_GSM, "Network: %s", networkInfo.carrierName);
+  LOG_I(LOG_GSM, "MCC/MNC %s/%s, mode %s", networkInfo.mcc, networkInfo.mnc, networkInfo.networkMode);
+  LOG_I(LOG_GSM, "Signal: %d dBm, quality %d/31, %s", networkInfo.signalStrength,
+        networkInfo.signalQuality, networkInfo.isRegistered ? "registered" : "not registered");
+  LOG_I(LOG_GSM, "Cell: LAC %s, ID %s", networkInfo.locationAreaCode, networkInfo.cellId);
   
   return networkInfo;
 }
@@ -596,11 +714,11 @@ GSM_Test::NetworkInfo GSM_Test::detectCarrierNetwork() {
  * @return Signal strength in dBm (-113 to -51), or -999 if error
  */
 int GSM_Test::getSignalStrength() {
-  Serial.println("GSM_Test: Getting signal strength...");
+  LOG_I(LOG_GSM, "Getting signal strength...");
   
   // Check if SIM is ready first
   if (!checkSIM()) {
-    Serial.println("GSM_Test: ✗ Cannot get signal strength - SIM not ready");
+    LOG_W(LOG_GSM, "✗ Cannot get signal strength - SIM not ready");
     return -999;
   }
   
@@ -613,7 +731,7 @@ int GSM_Test::getSignalStrength() {
     if (end == -1) end = response.length();
     
     String signalInfo = response.substring(start, end);
-    Serial.println("GSM_Test: Signal info: " + signalInfo);
+    LOG_D(LOG_GSM, "Signal info: %s", signalInfo);
     
     // Parse signal strength (format: +CSQ: 20,99)
     int commaPos = signalInfo.indexOf(",");
@@ -624,18 +742,18 @@ int GSM_Test::getSignalStrength() {
       // Convert RSSI to dBm (0-31 scale to -113 to -51 dBm)
       if (rssi >= 0 && rssi <= 31) {
         int signalStrength = -113 + (rssi * 2);
-        Serial.println("GSM_Test: ✓ Signal strength: " + String(signalStrength) + " dBm (RSSI: " + String(rssi) + ")");
+        LOG_I(LOG_GSM, "✓ Signal strength: %d dBm (RSSI: %d)", signalStrength, rssi);
         return signalStrength;
       } else {
-        Serial.println("GSM_Test: ✗ Invalid RSSI value: " + String(rssi));
+        LOG_W(LOG_GSM, "✗ Invalid RSSI value: %d", rssi);
         return -999;
       }
     } else {
-      Serial.println("GSM_Test: ✗ Could not parse signal strength response");
+      LOG_W(LOG_GSM, "✗ Could not parse signal strength response");
       return -999;
     }
   } else {
-    Serial.println("GSM_Test: ✗ No signal strength response received");
+    LOG_W(LOG_GSM, "✗ No signal strength response received");
     return -999;
   }
 }
@@ -650,11 +768,11 @@ int GSM_Test::getSignalStrength() {
  * @return true if SMTP client initialized successfully, false otherwise
  */
 bool GSM_Test::initSMTP(const char* apn) {
-  Serial.println("GSM_Test: Initializing GSM SMTP client...");
+  LOG_I(LOG_GSM, "Initializing GSM SMTP client...");
   
   // Check if SIM is ready first
   if (!checkSIM()) {
-    Serial.println("GSM_Test: ✗ Cannot initialize SMTP - SIM not ready");
+    LOG_W(LOG_GSM, "✗ Cannot initialize SMTP - SIM not ready");
     return false;
   }
   
@@ -668,7 +786,7 @@ bool GSM_Test::initSMTP(const char* apn) {
   _smtpClient = new SMTP(_modemSerial, _rxPin, _txPin, _baudRate);
   
   if (!_smtpClient) {
-    Serial.println("GSM_Test: ✗ Failed to create SMTP client instance");
+    LOG_W(LOG_GSM, "✗ Failed to create SMTP client instance");
     return false;
   }
   
@@ -678,7 +796,7 @@ bool GSM_Test::initSMTP(const char* apn) {
   // Configure APN
   _smtpClient->setAPN(_apn.c_str());
   
-  Serial.println("GSM_Test: ✓ GSM SMTP client initialized with APN: " + _apn);
+  LOG_I(LOG_GSM, "✓ GSM SMTP client initialized with APN: %s", _apn);
   return true;
 }
 
@@ -693,10 +811,10 @@ bool GSM_Test::initSMTP(const char* apn) {
  */
 bool GSM_Test::configSMTP(const char* smtpHost, int smtpPort, const char* emailAccount, 
                           const char* appPassword, const char* senderName) {
-  Serial.println("GSM_Test: Configuring SMTP email settings...");
+  LOG_I(LOG_GSM, "Configuring SMTP email settings...");
   
   if (!_smtpClient) {
-    Serial.println("GSM_Test: ✗ SMTP client not initialized. Call initSMTP() first.");
+    LOG_W(LOG_GSM, "✗ SMTP client not initialized. Call initSMTP() first.");
     return false;
   }
   
@@ -709,17 +827,17 @@ bool GSM_Test::configSMTP(const char* smtpHost, int smtpPort, const char* emailA
   
   // Validate required fields
   if (_emailAccount.length() == 0 || _appPassword.length() == 0) {
-    Serial.println("GSM_Test: ✗ Email account and password required");
+    LOG_W(LOG_GSM, "✗ Email account and password required");
     return false;
   }
   
   // Configure SMTP client
   _smtpClient->setAuth(_emailAccount.c_str(), _appPassword.c_str());
   
-  Serial.println("GSM_Test: ✓ SMTP configuration completed:");
-  Serial.println("GSM_Test:   Host: " + _smtpHost + ":" + String(_smtpPort));
-  Serial.println("GSM_Test:   Account: " + _emailAccount);
-  Serial.println("GSM_Test:   Sender: " + _senderName);
+  LOG_I(LOG_GSM, "✓ SMTP configuration completed:");
+  LOG_I(LOG_GSM, "  Host: %s:%d", _smtpHost, _smtpPort);
+  LOG_I(LOG_GSM, "  Account: %s", _emailAccount);
+  LOG_I(LOG_GSM, "  Sender: %s", _senderName);
   
   return true;
 }
@@ -734,22 +852,22 @@ bool GSM_Test::configSMTP(const char* smtpHost, int smtpPort, const char* emailA
  */
 bool GSM_Test::sendEmailViaGSM(const String& toEmail, const String& toName, 
                               const String& subject, const String& body) {
-  Serial.println("GSM_Test: Sending email via GSM SMTP...");
+  LOG_I(LOG_GSM, "Sending email via GSM SMTP...");
   
   // Check if SMTP client is initialized and configured
   if (!_smtpClient) {
-    Serial.println("GSM_Test: ✗ SMTP client not initialized");
+    LOG_W(LOG_GSM, "✗ SMTP client not initialized");
     return false;
   }
   
   if (_emailAccount.length() == 0 || _appPassword.length() == 0) {
-    Serial.println("GSM_Test: ✗ SMTP not configured. Call configSMTP() first.");
+    LOG_W(LOG_GSM, "✗ SMTP not configured. Call configSMTP() first.");
     return false;
   }
   
   // Verify network registration
   if (!checkSIM()) {
-    Serial.println("GSM_Test: ✗ Cannot send email - SIM not ready");
+    LOG_W(LOG_GSM, "✗ Cannot send email - SIM not ready");
     return false;
   }
   
@@ -760,21 +878,20 @@ bool GSM_Test::sendEmailViaGSM(const String& toEmail, const String& toName,
   _smtpClient->setBody(body);
   
   // Log email details
-  Serial.println("GSM_Test: Email details:");
-  Serial.println("GSM_Test:   To: " + toEmail + (toName.length() ? " (" + toName + ")" : ""));
-  Serial.println("GSM_Test:   From: " + _emailAccount + " (" + _senderName + ")");
-  Serial.println("GSM_Test:   Subject: " + subject);
-  Serial.println("GSM_Test:   Body: " + body.substring(0, min(50, (int)body.length())) + 
-                 (body.length() > 50 ? "..." : ""));
+  LOG_I(LOG_GSM, "Email details:");
+  LOG_I(LOG_GSM, "  To: %s %s", toEmail, toName);
+  LOG_I(LOG_GSM, "  From: %s (%s)", _emailAccount, _senderName);
+  LOG_I(LOG_GSM, "  Subject: %s", subject);
+  LOG_I(LOG_GSM, "  Body: %s (%u bytes)", body, body.length());  // Truncated in the ring
   
   // Attempt to send email
-  Serial.println("GSM_Test: Attempting to send email...");
+  LOG_I(LOG_GSM, "Attempting to send email...");
   bool success = _smtpClient->sendEmail();
   
   if (success) {
-    Serial.println("GSM_Test: ✓ Email sent successfully via GSM");
+    LOG_I(LOG_GSM, "✓ Email sent successfully via GSM");
   } else {
-    Serial.println("GSM_Test: ✗ Email failed to send via GSM");
+    LOG_W(LOG_GSM, "✗ Email failed to send via GSM");
   }
   
   return success;
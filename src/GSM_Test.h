@@ -36,13 +36,26 @@
  * GSM_Test gsm(Serial2, 16, 17, 115200);
  * 
  * void setup() {
- *   gsm.begin();
- *   if (gsm.checkSIM()) {
- *     Serial.println("SIM card ready");
+ *   gsm.begin();             // Returns immediately
+ * }
+ *
+ * void loop() {
+ *   gsm.loop();              // Advances the bring-up
+ *   if (gsm.isReady() && gsm.checkSIM()) {
  *     gsm.sendSMS("+1234567890", "Hello from ESP32!");
  *   }
  * }
  * @endcode
+ *
+ * @section bringup Modem Bring-up
+ * begin() only opens the serial port. loop() then polls "AT" every
+ * AT_POLL_MS until the modem answers OK (instead of sleeping a fixed time)
+ * and applies the one-time settings: ATE0 (echo off), AT+CMEE=2 (verbose
+ * errors), AT+CREG=2 (LAC/cell id in +CREG), AT+COPS=3,0 (long operator
+ * names) and reads AT+CPIN?. isReady() turns true afterwards; until then
+ * the blocking AT methods must not be used. A modem that does not answer
+ * within INIT_TIMEOUT_MS is reported as not responding and probed every
+ * AT_RETRY_MS.
  * 
  * @section at_commands AT Commands Used
  * - AT+CPIN? - Check SIM card status
@@ -108,11 +121,49 @@ public:
    * This method initializes the serial communication with the GSM modem.
    * It should be called once in the setup() function after constructing the GSM_Test object.
    * 
-   * @note This method includes a 2-second delay to allow the modem to initialize.
-   * The method will print initialization information to the Serial monitor.
+   * @note Returns immediately; call loop() until isReady() before using the
+   * AT command methods.
    */
   void begin();
   
+  // ============================================================================
+  // ASYNCHRONOUS BRING-UP
+  // ============================================================================
+  
+  /**
+   * @brief Modem bring-up states
+   */
+  enum InitState {
+    INIT_OFF,          // begin() not called
+    INIT_PROBING,      // Polling AT until the modem answers
+    INIT_CONFIGURING,  // Sending the one-time settings
+    INIT_READY,        // Modem usable
+    INIT_NO_RESPONSE   // No answer within INIT_TIMEOUT_MS (still probing, slower)
+  };
+  
+  static const uint32_t AT_POLL_MS = 500;        // AT probe interval while booting
+  static const uint32_t AT_RETRY_MS = 5000;      // Probe interval after the timeout
+  static const uint32_t INIT_TIMEOUT_MS = 30000; // Give up fast probing after this
+  static const uint32_t CMD_TIMEOUT_MS = 2000;   // Per settings command
+  
+  /**
+   * @brief Advance the bring-up (call from loop(), never blocks)
+   */
+  void loop();
+  
+  bool isReady() const { return _initState == INIT_READY; }
+  InitState initState() const { return _initState; }
+  static const char* initStateName(InitState state);
+  
+  uint32_t initMs() const { return _readyAt ? _readyAt - _initStart : 0; }  // begin() to ready
+  uint32_t initProbes() const { return _probes; }    // AT polls sent
+  bool simReady() const { return _simReady; }        // From AT+CPIN? during bring-up
+  
+  // Blocking AT command statistics (sendATCommand())
+  uint32_t atCommands() const { return _atCommands; }
+  uint32_t atFailures() const { return _atFailures; }  // ERROR or no response
+  uint32_t atBusyMs() const { return _atBusyMs; }      // Time spent waiting for responses
+  
   // ============================================================================
   // SIM CARD OPERATIONS
   // ============================================================================
@@ -330,6 +381,33 @@ private:
   String _appPassword;           // App-specific password
   String _senderName;            // Sender display name
   
+  // Bring-up state (see loop())
+  InitState _initState;
+  uint8_t _initStep;             // Index into the settings command list
+  uint32_t _initStart;           // millis() at begin()
+  uint32_t _probeStart;          // Start of the current AT probing round
+  uint32_t _readyAt;             // millis() when ready (0 = not yet)
+  uint32_t _lastSend;            // millis() of the last command sent
+  uint32_t _probes;
+  bool _simReady;
+  char _line[64];                // Partial response line
+  uint8_t _lineLen;
+  
+  uint32_t _atCommands;
+  uint32_t _atFailures;
+  uint32_t _atBusyMs;
+  
+  /**
+   * @brief Read one complete response line without blocking
+   * @return true if _line holds a complete, non-empty line
+   */
+  bool readLine();
+  
+  /**
+   * @brief Send the current settings command (or finish the bring-up)
+   */
+  void sendInitStep();
+  
   /**
    * @brief Wait for a specific response from the modem
    * @param expectedResponse The exact response string to wait for
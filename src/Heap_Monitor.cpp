@@ -0,0 +1,175 @@
+/**
+ * @file Heap_Monitor.cpp
+ * @brief Implementation of the per-subsystem heap monitor
+ */
+
+#include "Heap_Monitor.h"
+#include <esp_heap_caps.h>
+
+Heap_Monitor heapMonitor;
+
+// ============================================================================
+// ALLOCATION WRAPPERS
+// ============================================================================
+// Linked in place of malloc/calloc/realloc with -Wl,--wrap=<name>. They
+// pass the call through unchanged and only count it.
+
+#ifdef HEAP_MONITOR_WRAP
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+  void* p = __real_malloc(size);
+  if (p) heapMonitor.onAlloc(size);
+  return p;
+}
+
+void* __wrap_calloc(size_t n, size_t size) {
+  void* p = __real_calloc(n, size);
+  if (p) heapMonitor.onAlloc(n * size);
+  return p;
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+  void* p = __real_realloc(ptr, size);
+  if (p && size) heapMonitor.onAlloc(size);
+  return p;
+}
+}
+
+bool Heap_Monitor::wrapped() { return true; }
+#else
+bool Heap_Monitor::wrapped() { return false; }
+#endif
+
+// ============================================================================
+// SCOPES
+// ============================================================================
+
+Heap_Monitor::Heap_Monitor()
+  : _depth(0), _overflow(0), _owner(nullptr), _foreignAllocs(0), _lowWaterChecks(0), _next(0), _count(0) {
+  memset(_tags, 0, sizeof(_tags));
+  memset(_stack, 0, sizeof(_stack));
+  memset(_ring, 0, sizeof(_ring));
+}
+
+void Heap_Monitor::begin() {
+  _owner = xTaskGetCurrentTaskHandle();
+  sample();
+}
+
+void Heap_Monitor::enter(HeapTag tag) {
+  if (_depth == MAX_DEPTH) {
+    _overflow++;
+    return;
+  }
+  Frame& f = _stack[_depth++];
+  f.tag = tag;
+  f.startFree = freeBytes();
+  f.lowFree = f.startFree;
+  f.childNet = 0;
+  f.unchecked = 0;
+  _tags[tag].runs++;
+}
+
+void Heap_Monitor::exit() {
+  if (_overflow) {
+    _overflow--;
+    return;
+  }
+  if (!_depth) return;
+
+  Frame& f = _stack[--_depth];
+  uint32_t endFree = freeBytes();
+  if (endFree < f.lowFree) f.lowFree = endFree;
+
+  int32_t net = (int32_t)f.startFree - (int32_t)endFree;
+  TagStats& t = _tags[f.tag];
+  t.current += net - f.childNet;   // Nested scopes were booked to their own tag
+  if (t.current > t.peak) t.peak = t.current;
+  uint32_t transient = f.startFree - f.lowFree;
+  if (transient > t.peakRun) t.peakRun = transient;
+
+  if (_depth) {
+    Frame& parent = _stack[_depth - 1];
+    parent.childNet += net;
+    if (f.lowFree < parent.lowFree) parent.lowFree = f.lowFree;
+  }
+}
+
+void Heap_Monitor::onAlloc(size_t bytes) {
+  if (!_owner) return;  // Before begin() (static constructors)
+  if (xTaskGetCurrentTaskHandle() != _owner) {
+    _foreignAllocs++;   // Approximate: several tasks may race here
+    return;
+  }
+  TagStats& t = _tags[_depth ? _stack[_depth - 1].tag : (uint8_t)HEAP_OTHER];
+  t.allocs++;
+  t.allocBytes += bytes;
+  if (!_depth) return;
+
+  // heap_caps_get_free_size() walks every registered heap region,
+  // so small allocations (String growth) only check every Nth time
+  Frame& f = _stack[_depth - 1];
+  if (bytes < LOW_WATER_BYTES && ++f.unchecked < LOW_WATER_EVERY) return;
+  f.unchecked = 0;
+  _lowWaterChecks++;
+  uint32_t now = freeBytes();
+  if (now < f.lowFree) f.lowFree = now;
+}
+
+const char* Heap_Monitor::tagName(uint8_t i) {
+  switch (i) {
+    case HEAP_HTTP:   return "http";
+    case HEAP_JSON:   return "json";
+    case HEAP_MODEM:  return "modem";
+    case HEAP_SMTP:   return "smtp";
+    case HEAP_CONFIG: return "config";
+    case HEAP_SCAN:   return "scan";
+    case HEAP_OTHER:  return "other";
+    default:          return "?";
+  }
+}
+
+// ============================================================================
+// TREND
+// ============================================================================
+
+void Heap_Monitor::sample() {
+  Packed& p = _ring[_next];
+  p.ms = millis();
+  p.free = freeBytes() >> 4;
+  p.largest = largestBlock() >> 4;
+  p.minFree = minFreeBytes() >> 4;
+  _next = (_next + 1) % HISTORY;
+  if (_count < HISTORY) _count++;
+}
+
+Heap_Monitor::Sample Heap_Monitor::history(uint16_t i) const {
+  const Packed& p = _ring[(_next + HISTORY - _count + i) % HISTORY];
+  Sample s;
+  s.ms = p.ms;
+  s.free = (uint32_t)p.free << 4;
+  s.largest = (uint32_t)p.largest << 4;
+  s.minFree = (uint32_t)p.minFree << 4;
+  return s;
+}
+
+uint32_t Heap_Monitor::freeBytes() {
+  return heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+}
+
+uint32_t Heap_Monitor::largestBlock() {
+  return heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+}
+
+uint32_t Heap_Monitor::minFreeBytes() {
+  return heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+}
+
+uint32_t Heap_Monitor::fragmentationPct(uint32_t free, uint32_t largest) {
+  // Share of the free heap that cannot be handed out as one block
+  return free ? 100 - (uint32_t)((uint64_t)largest * 100 / free) : 0;
+}
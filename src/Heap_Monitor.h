@@ -0,0 +1,174 @@
+/**
+ * @file Heap_Monitor.h
+ * @brief Per-subsystem heap accounting and fragmentation trend
+ * @version 1.0.0
+ *
+ * @details
+ * Code that allocates on behalf of a subsystem runs inside a Heap_Scope
+ * with that subsystem's tag (HTTP handling, JSON building, modem, SMTP,
+ * config, WiFi scan). For every tag the monitor keeps:
+ * - runs:        scopes entered
+ * - allocs:      malloc/calloc/realloc calls (and so new / String growth)
+ *                made by the loop task inside the scope, and bytes requested
+ * - current:     free heap at entry minus free heap at exit, summed over
+ *                the tag's scopes (nested scopes excluded); negative when a
+ *                scope freed memory allocated elsewhere
+ * - peak:        highest 'current' seen
+ * - peakRun:     largest transient use inside one scope (free heap at entry
+ *                minus the lowest free heap seen before it exited)
+ *
+ * The byte figures are approximate: they are free-heap deltas, not a sum of
+ * the scope's own blocks, so whatever other tasks allocate or free while a
+ * scope is open lands in them too. peakRun also only sees the low point at
+ * the checks: free heap is read after allocations of LOW_WATER_BYTES or
+ * more and after every LOW_WATER_EVERY-th smaller one, not after each call
+ * (lowWaterChecks() counts the reads).
+ *
+ * Allocation counts need the linker to route malloc/calloc/realloc through
+ * this module (-Wl,--wrap=... with -D HEAP_MONITOR_WRAP). Only the
+ * esp32dev-heapdiag environment in platformio.ini sets them, so production
+ * builds carry no hook on every allocation. The wrappers only count and
+ * never change the block, so memory allocated or freed by code that
+ * bypasses them (ESP-IDF heap_caps_* callers) stays valid. Without the
+ * flag the counts stay 0 and current/peak still work; peakRun then only
+ * sees the free heap at scope exit, since the low-water reads happen in
+ * the wrappers. Allocations from other tasks (WiFi, lwIP,
+ * AsyncUDP) are counted separately and not attributed, but the bytes they
+ * take while a scope is open do land in that scope's free-heap delta.
+ *
+ * Independently of tags, sample() records free heap, largest free block
+ * and minimum-ever free heap every SAMPLE_MS into a HISTORY-entry ring
+ * (24 h), so fragmentation can be followed over a day of traffic.
+ *
+ * Usage:
+ *   heapMonitor.begin();                          // From the loop task
+ *   { Heap_Scope scope(HEAP_SMTP); smtp.send(...); }
+ *   scheduler.every("heap", Heap_Monitor::SAMPLE_MS, []() { heapMonitor.sample(); });
+ */
+
+#ifndef HEAP_MONITOR_H
+#define HEAP_MONITOR_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Subsystem tags (names in Heap_Monitor::tagName())
+ */
+enum HeapTag {
+  HEAP_HTTP,      // Request handling (server.handleClient())
+  HEAP_JSON,      // Building/parsing JSON documents
+  HEAP_MODEM,     // GSM bring-up, AT traffic, uplink over GSM
+  HEAP_SMTP,      // Email over GSM
+  HEAP_CONFIG,    // Settings load/save
+  HEAP_SCAN,      // WiFi scan results and roaming
+  HEAP_OTHER,     // Loop task allocations outside any scope
+  HEAP_TAG_COUNT
+};
+
+class Heap_Monitor {
+public:
+  static const uint8_t MAX_DEPTH = 4;            // Nested scopes
+  static const uint32_t SAMPLE_MS = 300000;      // Trend period (5 min)
+  static const uint16_t HISTORY = 288;           // Trend samples (24 h)
+  static const uint32_t LOW_WATER_BYTES = 256;   // Always check after these
+  static const uint8_t LOW_WATER_EVERY = 16;     // Else every Nth allocation
+
+  struct TagStats {
+    uint32_t runs;
+    uint32_t allocs;
+    uint32_t allocBytes;    // Requested, not net
+    int32_t current;
+    int32_t peak;
+    uint32_t peakRun;
+  };
+
+  /**
+   * @brief One trend sample (sizes in bytes)
+   */
+  struct Sample {
+    uint32_t ms;
+    uint32_t free;
+    uint32_t largest;
+    uint32_t minFree;
+  };
+
+  Heap_Monitor();
+
+  /**
+   * @brief Bind allocation counting to the calling (loop) task and take the
+   *        first trend sample
+   */
+  void begin();
+
+  void enter(HeapTag tag);
+  void exit();
+
+  /**
+   * @brief Called by the malloc wrappers after every successful allocation
+   */
+  void onAlloc(size_t bytes);
+
+  /**
+   * @brief Record a trend sample (scheduler job)
+   */
+  void sample();
+
+  const TagStats& tag(uint8_t i) const { return _tags[i]; }
+  static const char* tagName(uint8_t i);
+  uint32_t foreignAllocs() const { return _foreignAllocs; }  // Other tasks
+  uint32_t lowWaterChecks() const { return _lowWaterChecks; }  // Free heap reads in onAlloc()
+  static bool wrapped();                                     // Counting linked in
+
+  // Trend, oldest first
+  uint16_t sampleCount() const { return _count; }
+  Sample history(uint16_t i) const;
+
+  // Live values
+  static uint32_t freeBytes();
+  static uint32_t largestBlock();
+  static uint32_t minFreeBytes();
+  static uint32_t fragmentationPct(uint32_t free, uint32_t largest);
+
+private:
+  struct Frame {
+    uint8_t tag;
+    uint32_t startFree;
+    uint32_t lowFree;
+    int32_t childNet;     // Net bytes of nested scopes
+    uint8_t unchecked;    // Small allocations since the last low-water check
+  };
+
+  TagStats _tags[HEAP_TAG_COUNT];
+  Frame _stack[MAX_DEPTH];
+  uint8_t _depth;
+  uint8_t _overflow;       // Scopes entered beyond MAX_DEPTH (not tracked)
+  void* _owner;            // Loop task handle
+  uint32_t _foreignAllocs;
+  uint32_t _lowWaterChecks;
+
+  // Trend samples in 16-byte units: 12 bytes each, ~3.4 KB for the day
+  struct Packed {
+    uint32_t ms;
+    uint16_t free;
+    uint16_t largest;
+    uint16_t minFree;
+  };
+  Packed _ring[HISTORY];
+  uint16_t _next;
+  uint16_t _count;
+};
+
+extern Heap_Monitor heapMonitor;
+
+/**
+ * @brief Attributes allocations in the enclosing block to a subsystem
+ */
+class Heap_Scope {
+public:
+  explicit Heap_Scope(HeapTag tag) { heapMonitor.enter(tag); }
+  ~Heap_Scope() { heapMonitor.exit(); }
+  Heap_Scope(const Heap_Scope&) = delete;
+  Heap_Scope& operator=(const Heap_Scope&) = delete;
+};
+
+#endif // HEAP_MONITOR_H
@@ -0,0 +1,174 @@
+/**
+ * @file Job_Scheduler.cpp
+ * @brief Implementation of the cooperative timer-wheel scheduler
+ */
+
+#include "Job_Scheduler.h"
+
+static inline uint32_t nowTick() {
+  return millis() / Job_Scheduler::TICK_MS;
+}
+
+// Ticks compare with wrap-around like millis()
+static inline bool tickReached(uint32_t due, uint32_t now) {
+  return (int32_t)(now - due) >= 0;
+}
+
+Job_Scheduler::Job_Scheduler()
+  : _hook(nullptr), _count(0), _tick(0), _passes(0), _passUs(0), _lastPassUs(0), _maxPassUs(0),
+    _timedRuns(0), _slotsScanned(0) {
+  for (uint8_t i = 0; i < WHEEL_SLOTS; i++) _wheel[i] = INVALID_JOB;
+}
+
+int8_t Job_Scheduler::poll(const char* name, JobFn fn, uint32_t budgetUs) {
+  return add(name, KIND_POLL, 0, 0, fn, budgetUs);
+}
+
+int8_t Job_Scheduler::every(const char* name, uint32_t periodMs, JobFn fn, uint32_t budgetUs) {
+  return add(name, KIND_PERIODIC, periodMs < TICK_MS ? TICK_MS : periodMs, periodMs, fn, budgetUs);
+}
+
+int8_t Job_Scheduler::after(const char* name, uint32_t delayMs, JobFn fn, uint32_t budgetUs) {
+  return add(name, KIND_ONESHOT, 0, delayMs, fn, budgetUs);
+}
+
+int8_t Job_Scheduler::add(const char* name, Kind kind, uint32_t periodMs, uint32_t delayMs,
+                          JobFn fn, uint32_t budgetUs) {
+  if (!fn) return INVALID_JOB;
+
+  // Reuse the slot of a finished one-shot with the same name, else a new one
+  int8_t id = INVALID_JOB;
+  for (uint8_t i = 0; i < _count; i++) {
+    if (!_jobs[i].active && _jobs[i].kind == KIND_ONESHOT && strcmp(_jobs[i].name, name) == 0) {
+      id = i;
+      break;
+    }
+  }
+  if (id == INVALID_JOB) {
+    if (_count >= MAX_JOBS) {
+      Serial.printf("⚠ Scheduler full, job %s not registered\n", name);
+      return INVALID_JOB;
+    }
+    id = _count++;
+    memset(&_jobs[id], 0, sizeof(Job));
+  }
+  if (!_passes) _tick = nowTick();  // Registered from setup(): start the wheel now
+
+  Job& j = _jobs[id];
+  j.name = name;
+  j.fn = fn;
+  j.kind = kind;
+  j.active = true;
+  j.next = INVALID_JOB;
+  j.periodMs = periodMs;
+  j.budgetUs = budgetUs;
+  if (kind != KIND_POLL) {
+    // At least one tick ahead: the current tick's bucket has already been visited
+    uint32_t ticks = (delayMs + TICK_MS - 1) / TICK_MS;
+    j.dueTick = nowTick() + (ticks ? ticks : 1);
+    insert(id);
+  }
+  return id;
+}
+
+void Job_Scheduler::insert(int8_t id) {
+  uint8_t slot = _jobs[id].dueTick & (WHEEL_SLOTS - 1);
+  _jobs[id].next = _wheel[slot];
+  _wheel[slot] = id;
+}
+
+void Job_Scheduler::unlink(int8_t id) {
+  uint8_t slot = _jobs[id].dueTick & (WHEEL_SLOTS - 1);
+  int8_t* link = &_wheel[slot];
+  while (*link != INVALID_JOB) {
+    if (*link == id) {
+      *link = _jobs[id].next;
+      _jobs[id].next = INVALID_JOB;
+      return;
+    }
+    link = &_jobs[*link].next;
+  }
+}
+
+void Job_Scheduler::cancel(int8_t id) {
+  if (id < 0 || id >= _count || !_jobs[id].active) return;
+  if (_jobs[id].kind != KIND_POLL) unlink(id);
+  _jobs[id].active = false;
+}
+
+void Job_Scheduler::run(Job& j) {
+  if (_hook) _hook(j, false, 0);
+  uint32_t t0 = micros();
+  j.fn();
+  uint32_t us = micros() - t0;
+  if (_hook) _hook(j, true, us);
+
+  j.runs++;
+  j.totalUs += us;
+  j.lastUs = us;
+  if (us > j.budgetUs) {
+    j.overruns++;
+    if (us > j.maxUs) {
+      Serial.printf("⚠ Job %s overran its budget: %u us (budget %u us)\n", j.name, us, j.budgetUs);
+    }
+  }
+  if (us > j.maxUs) j.maxUs = us;
+}
+
+void Job_Scheduler::loop() {
+  uint32_t t0 = micros();
+
+  for (uint8_t i = 0; i < _count; i++) {
+    if (_jobs[i].active && _jobs[i].kind == KIND_POLL) run(_jobs[i]);
+  }
+
+  // Visit every bucket whose tick has passed since the last pass; after a
+  // long stall one full turn covers all buckets
+  uint32_t now = nowTick();
+  uint32_t steps = now - _tick;
+  if (steps > WHEEL_SLOTS) steps = WHEEL_SLOTS;
+
+  for (uint32_t s = 1; s <= steps; s++) {
+    uint8_t slot = (_tick + s) & (WHEEL_SLOTS - 1);
+    _slotsScanned++;
+
+    int8_t id = _wheel[slot];
+    while (id != INVALID_JOB) {
+      Job& j = _jobs[id];
+      int8_t next = j.next;
+      if (j.active && tickReached(j.dueTick, now)) {
+        unlink(id);
+        uint32_t lateMs = (now - j.dueTick) * TICK_MS;
+        if (lateMs > j.maxLateMs) j.maxLateMs = lateMs;
+
+        if (j.kind == KIND_PERIODIC) {
+          // Next deadline one period on; skip periods missed during a stall
+          uint32_t period = j.periodMs / TICK_MS;
+          j.dueTick += period;
+          if (tickReached(j.dueTick, now)) j.dueTick = now + period;
+          insert(id);
+        } else {
+          j.active = false;
+        }
+        _timedRuns++;
+        run(j);  // May register or cancel jobs; the bucket walk uses 'next'
+      }
+      id = next;
+    }
+  }
+  _tick = now;
+
+  _lastPassUs = micros() - t0;
+  _passUs += _lastPassUs;
+  _passes++;
+  if (_lastPassUs > _maxPassUs) _maxPassUs = _lastPassUs;
+}
+
+const char* Job_Scheduler::kindName(uint8_t kind) {
+  switch (kind) {
+    case KIND_POLL:     return "poll";
+    case KIND_PERIODIC: return "periodic";
+    case KIND_ONESHOT:  return "oneshot";
+    default:            return "unknown";
+  }
+}
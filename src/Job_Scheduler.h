@@ -0,0 +1,157 @@
+/**
+ * @file Job_Scheduler.h
+ * @brief Cooperative timer-wheel scheduler with per-job runtime accounting
+ * @version 1.0.0
+ *
+ * @details
+ * Subsystems register their loop work as jobs instead of keeping their own
+ * millis() timers in loop(); loop() then only calls scheduler.loop().
+ *
+ * Job kinds:
+ * - poll():  runs on every loop() pass (HTTP server, connection state
+ *            machines that read serial/sockets).
+ * - every(): periodic, runs when its deadline has passed; the next
+ *            deadline is one period later (missed periods are skipped, not
+ *            run back to back).
+ * - after(): one-shot; the slot is freed after it has run.
+ *
+ * Timed jobs sit in a hashed timer wheel of WHEEL_SLOTS buckets of TICK_MS
+ * each (singly linked through the job table), so a loop() pass only looks
+ * at the buckets whose tick has passed instead of every job. Deadlines
+ * further out than one wheel turn stay in their bucket until their tick
+ * comes round.
+ *
+ * Accounting: every run is timed with micros(). A run longer than the
+ * job's budget counts as an overrun (logged whenever it sets a new
+ * maximum); lateness is how far past its deadline a timed job started.
+ * The scheduler is not preemptive: an overrunning job delays everything
+ * behind it, which is what the overrun counters are there to show.
+ *
+ * setRunHook() lets a monitor see which job is running (see Stall_Monitor).
+ *
+ * Usage:
+ *   Job_Scheduler scheduler;
+ *   scheduler.poll("http", []() { server.handleClient(); }, 20000);
+ *   scheduler.every("status", 30000, printStatus, 5000);
+ *   scheduler.after("drd", DRD_TIMEOUT, []() { drd.loop(); });
+ *   // in loop():
+ *   scheduler.loop();
+ */
+
+#ifndef JOB_SCHEDULER_H
+#define JOB_SCHEDULER_H
+
+#include <Arduino.h>
+
+class Job_Scheduler {
+public:
+  typedef void (*JobFn)();
+
+  static const uint8_t MAX_JOBS = 24;
+  static const uint8_t WHEEL_SLOTS = 64;          // Power of two
+  static const uint32_t TICK_MS = 10;             // Wheel resolution (one turn = 640 ms)
+  static const uint32_t DEFAULT_BUDGET_US = 10000;
+  static const int8_t INVALID_JOB = -1;
+
+  /**
+   * @brief How a job is triggered
+   */
+  enum Kind {
+    KIND_POLL,       // Every loop() pass
+    KIND_PERIODIC,   // Every periodMs
+    KIND_ONESHOT     // Once, after a delay
+  };
+
+  /**
+   * @brief Registration and runtime statistics of one job
+   */
+  struct Job {
+    const char* name;     // Static string
+    JobFn fn;
+    uint8_t kind;         // Kind
+    bool active;
+    int8_t next;          // Next job in the same wheel bucket (INVALID_JOB = end)
+    uint32_t periodMs;    // KIND_PERIODIC only
+    uint32_t budgetUs;
+    uint32_t dueTick;     // Deadline in wheel ticks (timed jobs)
+    uint32_t runs;
+    uint32_t overruns;    // Runs longer than budgetUs
+    uint64_t totalUs;
+    uint32_t lastUs;
+    uint32_t maxUs;
+    uint32_t maxLateMs;   // Worst start delay past the deadline
+  };
+
+  /**
+   * @brief Called before (finished = false) and after every job run
+   */
+  typedef void (*RunHook)(const Job& job, bool finished, uint32_t us);
+
+  Job_Scheduler();
+
+  /**
+   * @brief Register a job run on every loop() pass
+   * @return Job id, or INVALID_JOB if the table is full
+   */
+  int8_t poll(const char* name, JobFn fn, uint32_t budgetUs = DEFAULT_BUDGET_US);
+
+  /**
+   * @brief Register a periodic job (first run one period from now)
+   */
+  int8_t every(const char* name, uint32_t periodMs, JobFn fn, uint32_t budgetUs = DEFAULT_BUDGET_US);
+
+  /**
+   * @brief Register a one-shot job run once delayMs from now
+   */
+  int8_t after(const char* name, uint32_t delayMs, JobFn fn, uint32_t budgetUs = DEFAULT_BUDGET_US);
+
+  /**
+   * @brief Remove a job before it runs (again)
+   */
+  void cancel(int8_t id);
+
+  /**
+   * @brief Observe job runs (e.g. stall attribution)
+   */
+  void setRunHook(RunHook hook) { _hook = hook; }
+
+  /**
+   * @brief Run poll jobs and all timed jobs whose deadline has passed
+   */
+  void loop();
+
+  // Job table (includes finished one-shots, which keep their statistics)
+  uint8_t jobCount() const { return _count; }
+  const Job& job(uint8_t i) const { return _jobs[i]; }
+  static const char* kindName(uint8_t kind);
+
+  // loop() pass statistics
+  uint32_t passes() const { return _passes; }
+  uint32_t lastPassUs() const { return _lastPassUs; }
+  uint32_t maxPassUs() const { return _maxPassUs; }
+  uint32_t avgPassUs() const { return _passes ? (uint32_t)(_passUs / _passes) : 0; }
+  uint32_t timedRuns() const { return _timedRuns; }      // Timed jobs run
+  uint32_t slotsScanned() const { return _slotsScanned; } // Wheel buckets visited
+
+private:
+  int8_t add(const char* name, Kind kind, uint32_t periodMs, uint32_t delayMs,
+             JobFn fn, uint32_t budgetUs);
+  void insert(int8_t id);
+  void unlink(int8_t id);
+  void run(Job& j);
+
+  RunHook _hook;
+  Job _jobs[MAX_JOBS];
+  uint8_t _count;
+  int8_t _wheel[WHEEL_SLOTS];   // Head of each bucket
+  uint32_t _tick;               // Last tick processed
+
+  uint32_t _passes;
+  uint64_t _passUs;
+  uint32_t _lastPassUs;
+  uint32_t _maxPassUs;
+  uint32_t _timedRuns;
+  uint32_t _slotsScanned;
+};
+
+#endif // JOB_SCHEDULER_H
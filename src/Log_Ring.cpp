@@ -0,0 +1,168 @@
+/**
+ * @file Log_Ring.cpp
+ * @brief Implementation of the binary log ring
+ */
+
+#include "Log_Ring.h"
+
+Log_Ring logRing;
+
+Log_Ring::Log_Ring()
+  : _head(0), _tail(0), _dropped(0), _drained(0), _torn(0), _collisions(0) {
+  memset((void*)_ring, 0, sizeof(_ring));
+  for (Entry& e : _ring) e.seq = UINT32_MAX;  // Free: 0 would read as a writer mid-entry
+}
+
+void Log_Ring::begin() {
+  // Core 0, just above idle: formatting and UART waits never delay loop()
+  xTaskCreatePinnedToCore(drainTask, "logdrain", 3072, this, tskIDLE_PRIORITY + 1, nullptr, 0);
+}
+
+void Log_Ring::drainTask(void* arg) {
+  Log_Ring* ring = (Log_Ring*)arg;
+  for (;;) {
+    ring->drain(Serial);
+    vTaskDelay(pdMS_TO_TICKS(DRAIN_MS));
+  }
+}
+
+// ============================================================================
+// WRITING
+// ============================================================================
+
+Log_Ring::Entry* Log_Ring::claim(uint8_t level, uint8_t module, const char* fmt, uint32_t& index) {
+  index = _head.fetch_add(1, std::memory_order_acq_rel);
+  Entry* e = &_ring[index & (CAPACITY - 1)];
+  // Readers skip the slot until publish(); 0 already means a writer that
+  // CAPACITY entries ago has not finished, and two writers would mix
+  uint32_t seq = e->seq;
+  if (seq == 0 || !__atomic_compare_exchange_n((uint32_t*)&e->seq, &seq, 0, false,
+                                               __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+    _collisions.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  std::atomic_thread_fence(std::memory_order_release);
+  e->ms = millis();
+  e->fmt = fmt;
+  e->level = level;
+  e->module = module;
+  e->strMask = 0;
+  return e;
+}
+
+void Log_Ring::publish(Entry* e, uint32_t index) {
+  std::atomic_thread_fence(std::memory_order_release);
+  e->seq = index + 1;
+}
+
+uint32_t Log_Ring::copyString(Entry* e, uint8_t n, uint8_t& used, const char* s) {
+  uint32_t offset = used < STR_BYTES ? used : STR_BYTES - 1;
+  size_t room = STR_BYTES - offset;
+  size_t len = s ? strnlen(s, room) : 0;
+  if (len == room) {
+    // Keep room - 1 bytes, minus the start of a character cut in two
+    len = room - 1;
+    while (len > 0 && ((uint8_t)s[len] & 0xC0) == 0x80) len--;
+    e->strMask |= 1 << (n + TRUNC_SHIFT);
+  }
+  memcpy(e->str + offset, s ? s : "", len);
+  e->str[offset + len] = '\0';
+  used = offset + len + 1;
+  e->strMask |= 1 << n;
+  return offset;
+}
+
+// ============================================================================
+// READING
+// ============================================================================
+
+uint32_t Log_Ring::oldest() const {
+  uint32_t h = head();
+  return h > CAPACITY ? h - CAPACITY : 0;
+}
+
+bool Log_Ring::read(uint32_t index, Entry& out) const {
+  const Entry* e = &_ring[index & (CAPACITY - 1)];
+  if (e->seq != index + 1) return false;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  memcpy((void*)&out, (const void*)e, sizeof(Entry));
+  std::atomic_thread_fence(std::memory_order_acquire);
+  // A writer that claimed the slot during the copy has changed seq
+  if (e->seq != index + 1 || out.seq != index + 1) {
+    _torn.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+size_t Log_Ring::format(const Entry& e, char* buf, size_t len) {
+  // Every argument is one 32-bit word; string offsets become pointers
+  uintptr_t w[MAX_ARGS] = {0, 0, 0, 0};
+  char cut[MAX_ARGS][STR_BYTES + 3];
+  for (uint8_t i = 0; i < e.nargs && i < MAX_ARGS; i++) {
+    if (!(e.strMask & (1 << i))) {
+      w[i] = (uintptr_t)e.args[i];
+    } else if (e.strMask & (1 << (i + TRUNC_SHIFT))) {
+      snprintf(cut[i], sizeof(cut[i]), "%s\xE2\x80\xA6", e.str + e.args[i]);  // "…"
+      w[i] = (uintptr_t)cut[i];
+    } else {
+      w[i] = (uintptr_t)(e.str + e.args[i]);
+    }
+  }
+  int n = snprintf(buf, len, e.fmt, w[0], w[1], w[2], w[3]);
+  return n < 0 ? 0 : ((size_t)n < len ? n : len - 1);
+}
+
+size_t Log_Ring::drain(Print& out, size_t max) {
+  uint32_t h = head();
+  if (h - _tail > CAPACITY) {
+    _dropped += h - _tail - CAPACITY;
+    _tail = h - CAPACITY;
+  }
+
+  size_t n = 0;
+  char msg[160];
+  Entry e;
+  while (_tail != h && n < max) {
+    if (!read(_tail, e)) {
+      // Still being written: retry next time; otherwise lapped by writers
+      if (_ring[_tail & (CAPACITY - 1)].seq == 0) break;
+      _dropped++;
+      _tail++;
+      continue;
+    }
+    format(e, msg, sizeof(msg));
+    out.printf("[%6lu.%03lu] %c %-6s %s\n", (unsigned long)(e.ms / 1000), (unsigned long)(e.ms % 1000),
+               levelChar(e.level), moduleName(e.module), msg);
+    _tail++;
+    _drained++;
+    n++;
+  }
+  return n;
+}
+
+const char* Log_Ring::moduleName(uint8_t module) {
+  switch (module) {
+    case LOG_MAIN:   return "main";
+    case LOG_GSM:    return "gsm";
+    case LOG_WIFI:   return "wifi";
+    case LOG_UPLINK: return "uplink";
+    case LOG_DNS:    return "dns";
+    case LOG_CONFIG: return "config";
+    case LOG_FS:     return "fs";
+    case LOG_SMTP:   return "smtp";
+    case LOG_SENSOR: return "sensor";
+    case LOG_ALERT:  return "alert";
+    default:         return "?";
+  }
+}
+
+char Log_Ring::levelChar(uint8_t level) {
+  switch (level) {
+    case LOG_LEVEL_ERROR: return 'E';
+    case LOG_LEVEL_WARN:  return 'W';
+    case LOG_LEVEL_INFO:  return 'I';
+    case LOG_LEVEL_DEBUG: return 'D';
+    default:              return '?';
+  }
+}
@@ -0,0 +1,204 @@
+/**
+ * @file Log_Ring.h
+ * @brief Binary log ring with deferred formatting and compile-time levels
+ * @version 1.0.0
+ *
+ * @details
+ * LOG_E/W/I/D(module, fmt, ...) record the raw call instead of a formatted
+ * line: timestamp, level, module id, the format string pointer (the
+ * literal stays in flash and doubles as the format id) and up to MAX_ARGS
+ * 32-bit argument words. String arguments (const char*, String) are copied
+ * into a small per-entry area, because the caller's buffer is gone by the
+ * time the line is formatted; together they get STR_BYTES. A string that
+ * does not fit is cut at a UTF-8 character boundary and flagged, and
+ * format() ends it with "…". Floats are not supported (format them as
+ * fixed point).
+ *
+ * A log call costs a slot claim, a few stores and the string copies: no
+ * heap, no vsnprintf and no waiting for the UART. Formatting happens only
+ * when a low-priority task drains the ring to Serial, or when /api/logs
+ * reads it.
+ *
+ * Lock-free ring:
+ * - Writers claim a slot with an atomic increment of the head, so any task
+ *   may log. The slot's sequence number is swapped to 0 while it is written
+ *   and set to index + 1 when complete. A writer that finds the slot still
+ *   at 0 (it lapped a writer that is stalled mid-entry) gives up its entry
+ *   and counts a collision, so a slot never has two writers.
+ * - Readers copy a slot and accept it only if the sequence number matched
+ *   before and after the copy; a copy that changed underneath counts as
+ *   torn. When writers lap a reader, the oldest entries are dropped and
+ *   counted.
+ *
+ * Levels below LOG_LEVEL (build flag, default LOG_LEVEL_INFO) compile to
+ * nothing, arguments included.
+ *
+ * Usage:
+ *   logRing.begin();                                // Starts the drain task
+ *   LOG_I(LOG_GSM, "Signal %d dBm on %s", dbm, carrier);
+ *   LOG_D(LOG_GSM, "Response: %s", response);       // Compiled out by default
+ */
+
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <type_traits>
+
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+/**
+ * @brief Module ids (names in Log_Ring::moduleName())
+ */
+enum LogModule {
+  LOG_MAIN,
+  LOG_GSM,
+  LOG_WIFI,
+  LOG_UPLINK,
+  LOG_DNS,
+  LOG_CONFIG,
+  LOG_FS,
+  LOG_SMTP,
+  LOG_SENSOR,
+  LOG_ALERT,
+  LOG_MODULE_COUNT
+};
+
+class Log_Ring {
+public:
+  static const uint16_t CAPACITY = 128;   // Entries (power of two), 64 bytes each
+  static const uint8_t MAX_ARGS = 4;
+  static const uint8_t STR_BYTES = 32;    // Copied string arguments per entry
+  static const uint8_t TRUNC_SHIFT = 4;   // strMask bit n + 4: string arg n was cut
+  static const uint32_t DRAIN_MS = 20;    // Drain task period
+
+  /**
+   * @brief One recorded call (64 bytes)
+   */
+  struct Entry {
+    volatile uint32_t seq;     // Index + 1 when complete, 0 while being written, ~0 unused
+    uint32_t ms;               // millis() at the call
+    const char* fmt;           // Format string (flash)
+    uint32_t args[MAX_ARGS];   // Argument words; string args are offsets into str
+    uint8_t level;
+    uint8_t module;
+    uint8_t nargs;
+    uint8_t strMask;           // Bit n: args[n] is a string offset; bit n + 4: it was cut
+    char str[STR_BYTES];
+  };
+
+  Log_Ring();
+
+  /**
+   * @brief Start the drain task (Serial output)
+   */
+  void begin();
+
+  /**
+   * @brief Record a call (used through the LOG_x macros)
+   */
+  template <typename... Args>
+  void write(uint8_t level, uint8_t module, const char* fmt, const Args&... args) {
+    static_assert(sizeof...(Args) <= MAX_ARGS, "too many log arguments");
+    uint32_t index;
+    Entry* e = claim(level, module, fmt, index);
+    if (!e) return;
+    uint8_t n = 0, used = 0;
+    int expand[] = { 0, (e->args[n] = word(e, n, used, args), n++, 0)... };
+    (void)expand;
+    (void)used;                // Only read by string arguments
+    e->nargs = n;
+    publish(e, index);
+  }
+
+  /**
+   * @brief Format the oldest undrained entries to a Print
+   * @return Entries written
+   */
+  size_t drain(Print& out, size_t max = CAPACITY);
+
+  /**
+   * @brief Copy a consistent snapshot of entry 'index'
+   * @return false if it was overwritten or is still being written, or
+   *         changed while being copied (torn)
+   */
+  bool read(uint32_t index, Entry& out) const;
+
+  /**
+   * @brief Format an entry's message (without timestamp/level/module)
+   */
+  static size_t format(const Entry& e, char* buf, size_t len);
+
+  uint32_t head() const { return _head.load(std::memory_order_acquire); }  // Next index
+  uint32_t oldest() const;
+  uint32_t dropped() const { return _dropped; }   // Overwritten before drained
+  uint32_t drained() const { return _drained; }
+  uint32_t torn() const { return _torn.load(std::memory_order_relaxed); }              // Copies rejected by read()
+  uint32_t collisions() const { return _collisions.load(std::memory_order_relaxed); }  // Writes given up
+
+  static const char* moduleName(uint8_t module);
+  static char levelChar(uint8_t level);
+
+private:
+  Entry* claim(uint8_t level, uint8_t module, const char* fmt, uint32_t& index);
+  void publish(Entry* e, uint32_t index);
+  static uint32_t copyString(Entry* e, uint8_t n, uint8_t& used, const char* s);
+
+  template <typename T>
+  static typename std::enable_if<(std::is_integral<T>::value || std::is_enum<T>::value) && sizeof(T) <= 4, uint32_t>::type
+  word(Entry*, uint8_t, uint8_t&, const T& v) { return (uint32_t)v; }
+  // 64-bit integers would be cut to 32 bits: log (uint32_t) parts instead
+  template <typename T>
+  static typename std::enable_if<std::is_integral<T>::value && (sizeof(T) > 4), uint32_t>::type
+  word(Entry*, uint8_t, uint8_t&, const T&) = delete;
+  static uint32_t word(Entry* e, uint8_t n, uint8_t& used, const char* s) { return copyString(e, n, used, s); }
+  static uint32_t word(Entry* e, uint8_t n, uint8_t& used, const String& s) { return copyString(e, n, used, s.c_str()); }
+  static uint32_t word(Entry*, uint8_t, uint8_t&, double) = delete;  // Format floats as fixed point
+
+  static void drainTask(void* arg);
+
+  Entry _ring[CAPACITY];
+  std::atomic<uint32_t> _head;
+  uint32_t _tail;        // Next entry to drain (drain task only)
+  uint32_t _dropped;
+  uint32_t _drained;
+  mutable std::atomic<uint32_t> _torn;
+  std::atomic<uint32_t> _collisions;
+};
+
+extern Log_Ring logRing;
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(mod, fmt, ...) logRing.write(LOG_LEVEL_ERROR, mod, fmt, ##__VA_ARGS__)
+#else
+#define LOG_E(mod, fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(mod, fmt, ...) logRing.write(LOG_LEVEL_WARN, mod, fmt, ##__VA_ARGS__)
+#else
+#define LOG_W(mod, fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(mod, fmt, ...) logRing.write(LOG_LEVEL_INFO, mod, fmt, ##__VA_ARGS__)
+#else
+#define LOG_I(mod, fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(mod, fmt, ...) logRing.write(LOG_LEVEL_DEBUG, mod, fmt, ##__VA_ARGS__)
+#else
+#define LOG_D(mod, fmt, ...) do {} while (0)
+#endif
+
+#endif // LOG_RING_H
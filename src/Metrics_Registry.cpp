@@ -0,0 +1,231 @@
+/**
+ * @file Metrics_Registry.cpp
+ * @brief Implementation of the Prometheus metrics registry
+ */
+
+#include "Metrics_Registry.h"
+
+// Constant-initialised, so metrics constructed during static init can link in
+Metric* Metrics_Registry::s_head = nullptr;
+Metric* Metrics_Registry::s_tail = nullptr;
+
+// Request duration buckets: 1, 5, 10, 50, 100, 500 ms, 1 s, 5 s
+static const uint32_t ROUTE_BOUNDS_US[Metric_RouteTable::BUCKETS] = {
+  1000, 5000, 10000, 50000, 100000, 500000, 1000000, 5000000
+};
+
+/**
+ * @brief Print wrapper counting the bytes written
+ */
+class CountingPrint : public Print {
+public:
+  CountingPrint(Print& out) : _out(out), _bytes(0) {}
+  size_t write(uint8_t c) override { _bytes++; return _out.write(c); }
+  size_t write(const uint8_t* data, size_t size) override {
+    _bytes += size;
+    return _out.write(data, size);
+  }
+  size_t bytes() const { return _bytes; }
+
+private:
+  Print& _out;
+  size_t _bytes;
+};
+
+// ============================================================================
+// METRIC BASE
+// ============================================================================
+
+Metric::Metric(const char* name, const char* help, const char* type)
+  : _name(name), _help(help), _type(type), _next(nullptr) {
+  Metrics_Registry::add(this);
+}
+
+void Metric::header(Print& out) const {
+  out.printf("# HELP %s %s\n# TYPE %s %s\n", _name, _help, _name, _type);
+}
+
+void Metric::value(Print& out, double v) {
+  // Integers (counts, bytes, dBm) without a fractional part
+  if (v > -2147483648.0 && v < 2147483647.0 && v == (double)(int32_t)v) out.print((int32_t)v);
+  else out.print(v, 6);
+}
+
+// ============================================================================
+// COUNTER / GAUGE
+// ============================================================================
+
+Metric_Counter::Metric_Counter(const char* name, const char* help, Sampler sampler)
+  : Metric(name, help, "counter"), _value(0), _sampler(sampler) {
+}
+
+void Metric_Counter::render(Print& out) const {
+  header(out);
+  out.print(_name);
+  out.print(' ');
+  if (_sampler) value(out, _sampler());
+  else out.print(get());
+  out.print('\n');
+}
+
+Metric_Gauge::Metric_Gauge(const char* name, const char* help, Sampler sampler)
+  : Metric(name, help, "gauge"), _value(0), _sampler(sampler) {
+}
+
+void Metric_Gauge::render(Print& out) const {
+  header(out);
+  out.print(_name);
+  out.print(' ');
+  if (_sampler) value(out, _sampler());
+  else out.print(_value.load(std::memory_order_relaxed));
+  out.print('\n');
+}
+
+// ============================================================================
+// HISTOGRAM
+// ============================================================================
+
+Metric_Histogram::Metric_Histogram(const char* name, const char* help,
+                                   const uint32_t* boundsUs, uint8_t count)
+  : Metric(name, help, "histogram"), _bounds(boundsUs),
+    _count(count > MAX_BUCKETS ? MAX_BUCKETS : count), _sumUs(0), _total(0) {
+  memset(_buckets, 0, sizeof(_buckets));
+}
+
+void Metric_Histogram::observe(uint32_t us) {
+  for (uint8_t i = 0; i < _count; i++) {
+    if (us <= _bounds[i]) {
+      _buckets[i]++;
+      break;
+    }
+  }
+  _sumUs += us;
+  _total++;
+}
+
+void Metric_Histogram::render(Print& out) const {
+  header(out);
+  renderSeries(out, _name, nullptr, _bounds, _count, _buckets, _sumUs, _total);
+}
+
+void Metric_Histogram::renderSeries(Print& out, const char* name, const char* labels,
+                                    const uint32_t* boundsUs, uint8_t count,
+                                    const uint32_t* buckets, uint64_t sumUs, uint32_t total) {
+  // Labels go in front of "le"; the comma is only needed when there are some
+  const char* l = labels ? labels : "";
+  const char* sep = labels ? "," : "";
+
+  uint32_t cumulative = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    cumulative += buckets[i];
+    out.printf("%s_bucket{%s%sle=\"%g\"} %u\n", name, l, sep, boundsUs[i] / 1e6, cumulative);
+  }
+  out.printf("%s_bucket{%s%sle=\"+Inf\"} %u\n", name, l, sep, total);
+  if (labels) {
+    out.printf("%s_sum{%s} %.6f\n%s_count{%s} %u\n", name, l, sumUs / 1e6, name, l, total);
+  } else {
+    out.printf("%s_sum %.6f\n%s_count %u\n", name, sumUs / 1e6, name, total);
+  }
+}
+
+// ============================================================================
+// ROUTE TABLE
+// ============================================================================
+
+const char* const Metric_RouteTable::NOT_FOUND = "not_found";
+
+Metric_RouteTable::Metric_RouteTable(const char* requestsName, const char* durationName)
+  : Metric(requestsName, "HTTP requests handled, by route", "counter"),
+    _durationName(durationName), _used(0) {
+  memset(_routes, 0, sizeof(_routes));
+  strcpy(_routes[MAX_ROUTES].route, "other");
+  add(NOT_FOUND);
+}
+
+uint8_t Metric_RouteTable::indexOf(const char* route) const {
+  uint8_t i = 0;
+  while (i < _used && strcmp(_routes[i].route, route) != 0) i++;
+  return i;
+}
+
+bool Metric_RouteTable::add(const char* route) {
+  if (indexOf(route) < _used) return true;
+  if (_used >= MAX_ROUTES || strlen(route) >= ROUTE_LEN) return false;
+  for (const char* c = route; *c; c++) {
+    if (*c == '"' || *c == '\\' || *c < ' ') return false;  // Not a valid label value
+  }
+  strcpy(_routes[_used++].route, route);
+  return true;
+}
+
+const char* Metric_RouteTable::label(const char* uri) const {
+  uint8_t i = indexOf(uri);
+  return i < _used ? _routes[i].route : NOT_FOUND;
+}
+
+void Metric_RouteTable::observe(const char* route, uint32_t us) {
+  uint8_t i = indexOf(route);
+  Route* r = &_routes[i < _used ? i : MAX_ROUTES];
+  r->requests++;
+  r->sumUs += us;
+  for (uint8_t i = 0; i < BUCKETS; i++) {
+    if (us <= ROUTE_BOUNDS_US[i]) {
+      r->buckets[i]++;
+      break;
+    }
+  }
+}
+
+void Metric_RouteTable::render(Print& out) const {
+  const Route* other = &_routes[MAX_ROUTES];
+  char labels[ROUTE_LEN + 10];
+
+  // Routes show up once they have served a request
+  header(out);
+  for (uint8_t i = 0; i <= _used; i++) {
+    const Route* r = i < _used ? &_routes[i] : other;
+    if (r->requests) out.printf("%s{route=\"%s\"} %u\n", _name, r->route, r->requests);
+  }
+
+  out.printf("# HELP %s HTTP request handling time, by route\n# TYPE %s histogram\n",
+             _durationName, _durationName);
+  for (uint8_t i = 0; i <= _used; i++) {
+    const Route* r = i < _used ? &_routes[i] : other;
+    if (!r->requests) continue;
+    snprintf(labels, sizeof(labels), "route=\"%s\"", r->route);
+    Metric_Histogram::renderSeries(out, _durationName, labels, ROUTE_BOUNDS_US, BUCKETS,
+                                   r->buckets, r->sumUs, r->requests);
+  }
+}
+
+// ============================================================================
+// REGISTRY
+// ============================================================================
+
+Metrics_Registry::Metrics_Registry()
+  : _lastUs(0), _maxUs(0), _lastBytes(0), _renders(0) {
+}
+
+void Metrics_Registry::add(Metric* m) {
+  if (s_tail) s_tail->_next = m;
+  else s_head = m;
+  s_tail = m;
+}
+
+uint8_t Metrics_Registry::metricCount() const {
+  uint8_t n = 0;
+  for (Metric* m = s_head; m; m = m->next()) n++;
+  return n;
+}
+
+size_t Metrics_Registry::render(Print& out) {
+  uint32_t t0 = micros();
+  CountingPrint counted(out);
+  for (Metric* m = s_head; m; m = m->next()) m->render(counted);
+
+  _lastUs = micros() - t0;
+  if (_lastUs > _maxUs) _maxUs = _lastUs;
+  _lastBytes = counted.bytes();
+  _renders++;
+  return _lastBytes;
+}
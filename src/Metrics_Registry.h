@@ -0,0 +1,200 @@
+/**
+ * @file Metrics_Registry.h
+ * @brief Statically registered counters, gauges and histograms rendered in
+ *        Prometheus text format
+ * @version 1.0.0
+ *
+ * @details
+ * Metrics are global objects; their constructors link them into one
+ * intrusive list, so there is no registration call and no allocation.
+ * Values are plain words updated without locks: counters are
+ * std::atomic (safe to bump from the AsyncUDP/WiFi tasks), histograms and
+ * the route table are only written from the loop task that also renders
+ * them.
+ *
+ * Gauges and counters can also take a sampler function that is called at
+ * render time (heap, RSSI, counters owned by other modules), so nothing
+ * has to be pushed into the registry on the hot path.
+ *
+ * Rendering writes straight to a Print (a chunked HTTP response), one
+ * metric at a time. The output size is bounded because every metric is
+ * fixed at compile time and the route table holds the paths registered at
+ * boot (at most MAX_ROUTES series); the time
+ * and bytes of the last render are kept and exported as metrics as well.
+ *
+ * Usage:
+ *   Metric_Counter smsSent("panel_sms_sent_total", "SMS sent");
+ *   Metric_Gauge freeHeap("panel_heap_free_bytes", "Free heap",
+ *                         []() -> double { return ESP.getFreeHeap(); });
+ *   smsSent.inc();
+ *   metrics.render(chunkedResponse);   // GET /metrics
+ */
+
+#ifndef METRICS_REGISTRY_H
+#define METRICS_REGISTRY_H
+
+#include <Arduino.h>
+#include <atomic>
+
+class Metric {
+public:
+  typedef double (*Sampler)();
+
+  Metric(const char* name, const char* help, const char* type);
+  virtual ~Metric() {}
+
+  /**
+   * @brief Write the # HELP / # TYPE lines and all samples
+   */
+  virtual void render(Print& out) const = 0;
+
+  const char* name() const { return _name; }
+  Metric* next() const { return _next; }
+
+protected:
+  void header(Print& out) const;
+  static void value(Print& out, double v);
+
+  const char* _name;
+  const char* _help;
+  const char* _type;
+
+private:
+  Metric* _next;
+  friend class Metrics_Registry;
+};
+
+/**
+ * @brief Monotonic counter (own value or sampled from another module)
+ */
+class Metric_Counter : public Metric {
+public:
+  Metric_Counter(const char* name, const char* help, Sampler sampler = nullptr);
+  void inc(uint32_t n = 1) { _value.fetch_add(n, std::memory_order_relaxed); }
+  uint32_t get() const { return _value.load(std::memory_order_relaxed); }
+  void render(Print& out) const override;
+
+private:
+  std::atomic<uint32_t> _value;
+  Sampler _sampler;
+};
+
+/**
+ * @brief Value that goes up and down (own value or sampled)
+ */
+class Metric_Gauge : public Metric {
+public:
+  Metric_Gauge(const char* name, const char* help, Sampler sampler = nullptr);
+  void set(int32_t v) { _value.store(v, std::memory_order_relaxed); }
+  void render(Print& out) const override;
+
+private:
+  std::atomic<int32_t> _value;
+  Sampler _sampler;
+};
+
+/**
+ * @brief Fixed-bucket duration histogram (microsecond bounds, seconds on output)
+ */
+class Metric_Histogram : public Metric {
+public:
+  static const uint8_t MAX_BUCKETS = 10;
+
+  Metric_Histogram(const char* name, const char* help, const uint32_t* boundsUs, uint8_t count);
+  void observe(uint32_t us);
+  void render(Print& out) const override;
+
+  /**
+   * @brief Write the bucket/sum/count samples of one series
+   */
+  static void renderSeries(Print& out, const char* name, const char* labels,
+                           const uint32_t* boundsUs, uint8_t count,
+                           const uint32_t* buckets, uint64_t sumUs, uint32_t total);
+
+private:
+  const uint32_t* _bounds;
+  uint8_t _count;
+  uint32_t _buckets[MAX_BUCKETS];   // Non-cumulative; +Inf is _total
+  uint64_t _sumUs;
+  uint32_t _total;
+};
+
+/**
+ * @brief Per-route request counter and latency histogram
+ *
+ * Routes are the paths registered with the web server (add() at boot), so
+ * the label set is fixed before the first request. Requests for anything
+ * else are counted under route="not_found"; a path that did not fit the
+ * table is counted under route="other".
+ */
+class Metric_RouteTable : public Metric {
+public:
+  static const uint8_t MAX_ROUTES = 64;   // main.cpp registers 59 paths
+  static const uint8_t ROUTE_LEN = 32;
+  static const uint8_t BUCKETS = 8;
+  static const char* const NOT_FOUND;     // "not_found"
+
+  Metric_RouteTable(const char* requestsName, const char* durationName);
+
+  /**
+   * @brief Register a route label (repeated paths share one slot)
+   * @return false if the table is full or the path is not a valid label
+   */
+  bool add(const char* route);
+
+  /**
+   * @brief Label of a request URI: the registered path or NOT_FOUND
+   */
+  const char* label(const char* uri) const;
+
+  void observe(const char* route, uint32_t us);
+  void render(Print& out) const override;
+  uint8_t routeCount() const { return _used; }
+
+private:
+  struct Route {
+    char route[ROUTE_LEN];
+    uint32_t requests;
+    uint32_t buckets[BUCKETS];
+    uint64_t sumUs;
+  };
+
+  uint8_t indexOf(const char* route) const;   // _used if not registered
+
+  const char* _durationName;
+  Route _routes[MAX_ROUTES + 1];   // Last entry is "other"
+  uint8_t _used;
+};
+
+/**
+ * @brief Render entry point and render-cost statistics
+ */
+class Metrics_Registry {
+public:
+  Metrics_Registry();
+
+  /**
+   * @brief Render all registered metrics in Prometheus text format
+   * @return Bytes written
+   */
+  size_t render(Print& out);
+
+  uint8_t metricCount() const;
+  uint32_t lastRenderUs() const { return _lastUs; }
+  uint32_t maxRenderUs() const { return _maxUs; }
+  size_t lastRenderBytes() const { return _lastBytes; }
+  uint32_t renders() const { return _renders; }
+
+private:
+  static void add(Metric* m);
+  static Metric* s_head;
+  static Metric* s_tail;
+  friend class Metric;
+
+  uint32_t _lastUs;
+  uint32_t _maxUs;
+  size_t _lastBytes;
+  uint32_t _renders;
+};
+
+#endif // METRICS_REGISTRY_H
@@ -117,6 +117,10 @@ void SMTP::tearDownPDP() {
   ATAcceptAny("AT+NETCLOSE", okTokens, sizeof(okTokens)/sizeof(okTokens[0]), 10000);
 }
 
+void SMTP::releasePDP() {
+  if (!_keepPDP) tearDownPDP();
+}
+
 // ---------------- SSL/TLS ----------------
 bool SMTP::cchStart() {
   for (int attempt=0; attempt<MAX_RETRIES; attempt++) {
@@ -246,18 +250,18 @@ bool SMTP::sendEmail() {
   if (!bringUpPDP()) { Serial.println(" PDP failed"); return false; }
 
   Serial.println(" Starting SSL/TLS...");
-  if (!cchStart()) { Serial.println("SSL failed"); tearDownPDP(); return false; }
+  if (!cchStart()) { Serial.println("SSL failed"); releasePDP(); return false; }
 
   Serial.println(" Opening SMTP connection...");
   if (!cchOpen("smtp.gmail.com", 465, LINK_ID)) {
-    Serial.println(" SMTP connect failed"); cchStop(); tearDownPDP(); return false;
+    Serial.println(" SMTP connect failed"); cchStop(); releasePDP(); return false;
   }
 
   Serial.println(" Sending SMTP session...");
   bool ok = smtpSession(LINK_ID);
   cchClose(LINK_ID);
   cchStop();
-  tearDownPDP();
+  releasePDP();
 
   if (ok) Serial.println(" Email sent successfully!");
   else Serial.println(" Email send failed!");
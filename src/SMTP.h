@@ -10,6 +10,7 @@
      - setFromName("Name")
      - setSubject("Subject")
      - setBody("Body text")
+     - setKeepPDP(true) → leave the PDP context open (shared uplink)
      - sendEmail()      → handles TLS + SMTP session
      - bridge(Serial)   → passthrough for debugging
 --------------------------------------------------------------------------- */
@@ -34,6 +35,7 @@ public:
   void setFromName(const char* name);
   void setSubject(const String& subject);
   void setBody(const String& body);
+  void setKeepPDP(bool keep) { _keepPDP = keep; }
 
   bool sendEmail();           // main function
   void bridge(Stream& usb);   // passthrough mode
@@ -43,6 +45,7 @@ private:
   int _rxPin, _txPin;
   long _baud;
   String _apn, _gmail, _appPass, _to, _toName, _fromName, _subject, _body;
+  bool _keepPDP = false;  // PDP owned by someone else (uplink failover)
 
   // Internal helpers
   bool AT(const String& cmd, const String& expect="OK", uint32_t ms=10000);
@@ -52,6 +55,7 @@ private:
 
   bool bringUpPDP();
   void tearDownPDP();
+  void releasePDP();
   bool cchStart();
   bool cchOpen(const char* host, uint16_t port, int link=0);
   bool cchSendRaw(int link, const uint8_t* data, size_t len);
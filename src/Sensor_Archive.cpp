@@ -0,0 +1,304 @@
+/**
+ * @file Sensor_Archive.cpp
+ * @brief Implementation of the flash sensor history log
+ */
+
+#include "Sensor_Archive.h"
+#include "Log_Ring.h"
+
+/**
+ * @brief Slot 0 of every sector
+ */
+struct SectorHeader {
+  uint32_t magic;
+  uint32_t seq;
+};
+
+// Read buffer for queries and recovery (loop task only)
+static Sensor_History::Block s_block;
+
+Sensor_Archive::Sensor_Archive()
+  : _part(nullptr), _sectors(0), _sector(0), _slot(1), _seq(0), _blocks(0), _oldestMs(0),
+    _newestMs(0), _recoveryUs(0), _lastWriteUs(0), _maxWriteUs(0), _crcErrors(0),
+    _bench(BENCH_IDLE), _benchDone(false), _benchTarget(0), _benchStartMs(0) {
+  memset(_index, 0, sizeof(_index));
+  memset(&_live, 0, sizeof(_live));
+  memset(&_benchCounters, 0, sizeof(_benchCounters));
+  memset(&_benchBlock, 0, sizeof(_benchBlock));
+  memset(&_result, 0, sizeof(_result));
+}
+
+bool Sensor_Archive::begin(const char* label) {
+  _part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+  if (!_part) {
+    LOG_W(LOG_SENSOR, "No '%s' partition, history is not persisted", label);
+    return false;
+  }
+  _sectors = min((uint32_t)MAX_SECTORS, _part->size / SECTOR_BYTES);
+
+  uint32_t t0 = micros();
+  recover();
+  _recoveryUs = micros() - t0;
+
+  LOG_I(LOG_SENSOR, "Archive: %u/%u blocks in %u sectors, recovered in %u us",
+        (unsigned)_blocks, (unsigned)capacityBlocks(), _sectors, (unsigned)_recoveryUs);
+  return true;
+}
+
+// ============================================================================
+// RECOVERY
+// ============================================================================
+
+void Sensor_Archive::recover() {
+  // Headers and first block start of every sector: two small reads each
+  uint16_t newest = 0;
+  uint16_t valid = 0;
+  _seq = 0;
+  for (uint16_t s = 0; s < _sectors; s++) {
+    SectorHeader h;
+    _index[s].seq = 0;
+    _index[s].startMs = EMPTY_MS;
+    if (esp_partition_read(_part, offset(s, 0), &h, sizeof(h)) != ESP_OK || h.magic != MAGIC) continue;
+    _index[s].seq = h.seq;
+    esp_partition_read(_part, offset(s, 1), &_index[s].startMs, sizeof(uint64_t));
+    valid++;
+    if (h.seq > _seq) {
+      _seq = h.seq;
+      newest = s;
+    }
+  }
+
+  _blocks = 0;
+  _oldestMs = _newestMs = 0;
+  if (!valid) {
+    _sector = _sectors - 1;
+    _slot = SLOTS;                     // First write opens sector 0
+    return;
+  }
+
+  // Only the newest sector can be partly written: find its first erased slot
+  // Block headers only (startMs and spanMs lead the block)
+  _sector = newest;
+  _slot = 1;
+  while (_slot < SLOTS) {
+    esp_partition_read(_part, offset(_sector, _slot), &s_block, Sensor_History::HEADER_BYTES);
+    if (s_block.startMs == EMPTY_MS) break;
+    _newestMs = s_block.endMs();
+    _slot++;
+  }
+  if (_slot == 1) {
+    // Header written but no block yet: the newest data ends the previous sector
+    uint16_t prev = (_sector + _sectors - 1) % _sectors;
+    if (_index[prev].seq) {
+      esp_partition_read(_part, offset(prev, SLOTS - 1), &s_block, Sensor_History::HEADER_BYTES);
+      if (s_block.startMs != EMPTY_MS) _newestMs = s_block.endMs();
+    }
+  }
+
+  // Every other sector with a header was filled before the log moved on
+  for (uint16_t s = 0; s < _sectors; s++) {
+    if (s != _sector && _index[s].seq && _index[s].startMs != EMPTY_MS) _blocks += SLOTS - 1;
+  }
+  _blocks += _slot - 1;
+  uint16_t oldest = oldestSector();
+  _oldestMs = _index[oldest].startMs == EMPTY_MS ? 0 : _index[oldest].startMs;
+}
+
+uint16_t Sensor_Archive::oldestSector() const {
+  for (uint16_t i = 1; i <= _sectors; i++) {
+    uint16_t s = (_sector + i) % _sectors;
+    if (_index[s].seq && _index[s].startMs != EMPTY_MS) return s;
+  }
+  return _sector;
+}
+
+// ============================================================================
+// WRITES
+// ============================================================================
+
+bool Sensor_Archive::openSector(uint16_t s, Counters& c) {
+  uint32_t t0 = micros();
+  uint32_t dropped = _index[s].seq && _index[s].startMs != EMPTY_MS ? SLOTS - 1 : 0;
+  _index[s].seq = 0;
+  _index[s].startMs = EMPTY_MS;
+  if (esp_partition_erase_range(_part, offset(s, 0), SECTOR_BYTES) != ESP_OK) return false;
+  c.erases++;
+  c.eraseUs += micros() - t0;
+  _blocks -= min(dropped, _blocks);
+
+  SectorHeader h = { MAGIC, _seq + 1 };
+  if (esp_partition_write(_part, offset(s, 0), &h, sizeof(h)) != ESP_OK) return false;
+  c.programmed += sizeof(h);
+  _seq = h.seq;
+  _index[s].seq = h.seq;
+  _sector = s;
+  _slot = 1;
+  return true;
+}
+
+bool Sensor_Archive::append(Sensor_History::Block& b, Counters& c) {
+  if (_slot >= SLOTS && !openSector((_sector + 1) % _sectors, c)) {
+    c.failures++;
+    return false;
+  }
+
+  b.crc = Sensor_History::crc16(b);
+  uint32_t t0 = micros();
+  if (esp_partition_write(_part, offset(_sector, _slot), &b, sizeof(b)) != ESP_OK) {
+    c.failures++;
+    _slot++;                           // Skip the slot; queries reject it by CRC
+    return false;
+  }
+  uint32_t us = micros() - t0;
+  c.writeUs += us;
+  c.written++;
+  c.programmed += sizeof(b);
+  c.payload += Sensor_History::payloadBytes(b);
+
+  if (_slot == 1) _index[_sector].startMs = b.startMs;
+  _slot++;
+  _blocks++;
+  _newestMs = b.endMs();
+  uint16_t oldest = oldestSector();
+  _oldestMs = _index[oldest].startMs;
+
+  if (&c == &_live) {
+    _lastWriteUs = us;
+    if (us > _maxWriteUs) _maxWriteUs = us;
+  }
+  return true;
+}
+
+bool Sensor_Archive::write(Sensor_History::Block& b) {
+  if (!_part || _bench != BENCH_IDLE) return false;
+  return append(b, _live);
+}
+
+// ============================================================================
+// QUERIES
+// ============================================================================
+
+size_t Sensor_Archive::forEach(uint64_t from, uint64_t to, Sensor_History::PointFn fn, void* ctx) const {
+  if (isEmpty()) return 0;
+  return scan(from, to, fn, ctx);
+}
+
+size_t Sensor_Archive::scan(uint64_t from, uint64_t to, Sensor_History::PointFn fn, void* ctx) const {
+  size_t decoded = 0;
+  if (!_blocks || from > to) return 0;
+
+  uint16_t s = oldestSector();
+  for (uint16_t n = 0; n < _sectors; n++, s = (s + 1) % _sectors) {
+    if (!_index[s].seq || _index[s].startMs == EMPTY_MS) continue;
+    bool last = s == _sector;
+    if (_index[s].startMs > to) break;
+
+    // Skip the sector if the next one starts before the range
+    if (!last) {
+      uint16_t next = (s + 1) % _sectors;
+      if (_index[next].seq && _index[next].startMs != EMPTY_MS && _index[next].startMs <= from) continue;
+    }
+
+    uint8_t end = last ? _slot : SLOTS;
+    for (uint8_t slot = 1; slot < end; slot++) {
+      if (esp_partition_read(_part, offset(s, slot), &s_block, sizeof(s_block)) != ESP_OK) continue;
+      if (s_block.startMs == EMPTY_MS) break;
+      if (Sensor_History::crc16(s_block) != s_block.crc) {
+        _crcErrors++;
+        continue;
+      }
+      if (s_block.endMs() < from) continue;
+      if (s_block.startMs > to) return decoded;
+      if (!Sensor_History::decodeBlock(s_block, from, to, fn, ctx, decoded)) return decoded;
+    }
+    if (last) break;
+  }
+  return decoded;
+}
+
+// ============================================================================
+// BENCHMARK
+// ============================================================================
+
+bool Sensor_Archive::startBenchmark(const Sensor_History::Block& sample, uint8_t fillPct, bool discard) {
+  // The benchmark erases the partition (BENCH_ERASE); stored history only if asked to
+  if (!_part || _bench != BENCH_IDLE || (_blocks && !discard) || sample.count == 0) return false;
+  _benchBlock = sample;
+  memset(&_benchCounters, 0, sizeof(_benchCounters));
+  memset(&_result, 0, sizeof(_result));
+  _result.fillPct = constrain(fillPct, (uint8_t)1, (uint8_t)99);
+  _benchTarget = capacityBlocks() * _result.fillPct / 100;
+  _benchDone = false;
+  _sector = 0;                         // Erase position
+  _bench = BENCH_ERASE;
+  LOG_I(LOG_SENSOR, "Archive benchmark: fill to %u%% (%u blocks)", _result.fillPct, (unsigned)_benchTarget);
+  return true;
+}
+
+static void countPoint(const Sensor_History::Point&, void*) {}
+
+void Sensor_Archive::loop() {
+  switch (_bench) {
+    case BENCH_IDLE:
+      return;
+
+    case BENCH_ERASE:
+    case BENCH_CLEANUP:
+      // One sector per call (an erase takes ~40 ms)
+      esp_partition_erase_range(_part, offset(_sector, 0), SECTOR_BYTES);
+      _index[_sector].seq = 0;
+      _index[_sector].startMs = EMPTY_MS;
+      if (++_sector < _sectors) return;
+      recover();
+      if (_bench == BENCH_CLEANUP) {
+        _bench = BENCH_IDLE;
+        _benchDone = true;
+        LOG_I(LOG_SENSOR, "Archive benchmark done: WA x%u/100, recovery %u us, 1 h query %u us",
+              (unsigned)(_result.writeAmplification * 100), (unsigned)_result.recoveryUs,
+              (unsigned)_result.queryHourUs);
+      } else {
+        _benchStartMs = millis();
+        _bench = BENCH_FILL;
+      }
+      return;
+
+    case BENCH_FILL: {
+      // One sector of copies; timestamps continue at the sample's own rate
+      uint32_t gap = _benchBlock.count > 1 ? _benchBlock.spanMs / (_benchBlock.count - 1) : 1000;
+      for (uint8_t i = 0; i < SLOTS - 1 && _benchCounters.written < _benchTarget; i++) {
+        _benchBlock.startMs = _blocks ? _newestMs + gap : gap;
+        if (!append(_benchBlock, _benchCounters)) break;
+      }
+      if (_benchCounters.written >= _benchTarget || _benchCounters.failures > 16) {
+        _result.fillMs = millis() - _benchStartMs;
+        _bench = BENCH_MEASURE;
+      }
+      return;
+    }
+
+    case BENCH_MEASURE: {
+      const Counters& c = _benchCounters;
+      _result.blocks = c.written;
+      _result.avgWriteUs = c.written ? c.writeUs / c.written : 0;
+      _result.avgEraseUs = c.erases ? c.eraseUs / c.erases : 0;
+      _result.writeAmplification = c.amplification();
+
+      uint32_t t0 = micros();
+      recover();
+      _result.recoveryUs = micros() - t0;
+
+      uint64_t to = _newestMs;
+      t0 = micros();
+      scan(to > 3600000 ? to - 3600000 : 0, to, countPoint, nullptr);
+      _result.queryHourUs = micros() - t0;
+
+      t0 = micros();
+      _result.querySamples = scan(0, UINT64_MAX, countPoint, nullptr);
+      _result.queryAllUs = micros() - t0;
+
+      _sector = 0;
+      _bench = BENCH_CLEANUP;
+      return;
+    }
+  }
+}
@@ -0,0 +1,204 @@
+/**
+ * @file Sensor_Archive.h
+ * @brief Log-structured flash store for sealed sensor history blocks
+ * @version 1.0.0
+ *
+ * @details
+ * Sealed Sensor_History blocks are appended to a raw data partition
+ * ("history" in partitions.csv), bypassing the filesystem:
+ *
+ * - Layout: the partition is a circular log of 4 KB sectors. Slot 0 of a
+ *   sector holds a header {magic, sequence number}, slots 1-15 hold one
+ *   256-byte block each, written in order into erased flash.
+ * - Wear levelling: sectors are used strictly round-robin, and a sector is
+ *   erased only when the log wraps into it (dropping its oldest blocks),
+ *   so every sector sees the same number of erase cycles.
+ * - Index: RAM keeps {sequence, first block start} per sector (16 bytes
+ *   per sector, 2 KB for 512 KB). Queries seek by sector and read only the
+ *   blocks overlapping the requested range.
+ * - Recovery: begin() reads each sector header and first block start, picks
+ *   the highest sequence number as the write position and scans only that
+ *   sector for its first erased slot. A block torn by a power cut fails its
+ *   CRC and is skipped by queries; a sector whose header was never written
+ *   is treated as free and erased again.
+ *
+ * Benchmark:
+ *   startBenchmark() refuses while the archive holds blocks unless told to
+ *   discard them. It erases the archive, fills it to a given level with
+ *   copies of a real block (one sector per loop() call, so the web server
+ *   keeps running), measures write amplification, recovery time and query
+ *   latency, then erases it again. write() is refused meanwhile; Sensor_History keeps
+ *   those blocks pending in RAM and writes them once the benchmark ends.
+ *
+ * Usage:
+ *   Sensor_Archive archive;
+ *   archive.begin();
+ *   history.setArchive(&archive);
+ *   history.setTimeBase(archive.newestMs() + period);
+ *   // in loop():
+ *   archive.loop();
+ */
+
+#ifndef SENSOR_ARCHIVE_H
+#define SENSOR_ARCHIVE_H
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include "Sensor_History.h"
+
+class Sensor_Archive {
+public:
+  static const uint32_t SECTOR_BYTES = 4096;
+  static const uint8_t SLOTS = SECTOR_BYTES / Sensor_History::BLOCK_BYTES;  // Slot 0 is the header
+  static const uint16_t MAX_SECTORS = 256;         // 1 MB
+  static const uint32_t MAGIC = 0x53485332;        // "SHS2": 64-bit block timestamps
+
+  /**
+   * @brief Results of the last benchmark
+   */
+  struct BenchResult {
+    uint8_t fillPct;
+    uint32_t blocks;             // Blocks written
+    uint32_t fillMs;             // Wall time of the fill (erases included)
+    uint32_t avgWriteUs;         // Per block, erases excluded
+    uint32_t avgEraseUs;
+    float writeAmplification;    // Bytes programmed / payload bytes
+    uint32_t recoveryUs;         // begin() scan at this fill level
+    uint32_t queryHourUs;        // Newest hour, all samples decoded
+    uint32_t queryAllUs;         // Whole archive
+    uint32_t querySamples;       // Decoded by the whole-archive query
+  };
+
+  Sensor_Archive();
+
+  /**
+   * @brief Find the partition and recover the write position
+   * @return false if there is no partition (persistence disabled)
+   */
+  bool begin(const char* label = "history");
+
+  /**
+   * @brief Append a sealed block (sets its crc)
+   * @return false if not ready or a benchmark is running
+   */
+  bool write(Sensor_History::Block& b);
+
+  /**
+   * @brief Decode every archived sample in [from, to], oldest first
+   * @return Samples decoded
+   */
+  size_t forEach(uint64_t from, uint64_t to, Sensor_History::PointFn fn, void* ctx) const;
+
+  /**
+   * @brief Start the fill-level benchmark (runs from loop())
+   * @param sample Block copied into the archive with shifted timestamps
+   * @param discard Erase stored history too (one sector per loop())
+   * @return false if not ready, already running, or the archive is not
+   *         empty and discard is false
+   */
+  bool startBenchmark(const Sensor_History::Block& sample, uint8_t fillPct = 80, bool discard = false);
+
+  /**
+   * @brief Advance a running benchmark
+   */
+  void loop();
+
+  bool isReady() const { return _part != nullptr; }
+  bool isEmpty() const { return !_part || _bench != BENCH_IDLE || _blocks == 0; }
+  uint64_t oldestMs() const { return isEmpty() ? 0 : _oldestMs; }
+  uint64_t newestMs() const { return isEmpty() ? 0 : _newestMs; }
+
+  // Layout
+  uint16_t sectors() const { return _sectors; }
+  uint32_t capacityBlocks() const { return (uint32_t)_sectors * (SLOTS - 1); }
+  uint32_t storedBlocks() const { return _blocks; }
+  uint8_t fillPct() const { return capacityBlocks() ? _blocks * 100 / capacityBlocks() : 0; }
+  uint32_t partitionBytes() const { return _part ? _part->size : 0; }
+  uint32_t partitionOffset() const { return _part ? _part->address : 0; }
+
+  // Statistics (benchmark writes are not counted)
+  uint32_t recoveryUs() const { return _recoveryUs; }
+  uint32_t blocksWritten() const { return _live.written; }
+  uint32_t writeFailures() const { return _live.failures; }
+  uint32_t erases() const { return _live.erases; }
+  uint32_t crcErrors() const { return _crcErrors; }
+  uint32_t lastWriteUs() const { return _lastWriteUs; }
+  uint32_t maxWriteUs() const { return _maxWriteUs; }
+  float writeAmplification() const { return _live.amplification(); }
+
+  // Benchmark state
+  bool benchRunning() const { return _bench != BENCH_IDLE; }
+  bool benchDone() const { return _benchDone; }
+  const BenchResult& benchResult() const { return _result; }
+
+private:
+  enum BenchState {
+    BENCH_IDLE,
+    BENCH_ERASE,     // Clearing the archive, one sector per loop()
+    BENCH_FILL,      // Writing one sector of blocks per loop()
+    BENCH_MEASURE,   // Recovery + query timings
+    BENCH_CLEANUP    // Clearing the synthetic blocks
+  };
+
+  /**
+   * @brief Per-sector index entry
+   */
+  struct Sector {
+    uint32_t seq;          // 0 = free (no valid header)
+    uint64_t startMs;      // First block, EMPTY_MS if none yet
+  };
+
+  /**
+   * @brief Write counters (live writes and the benchmark keep separate ones)
+   */
+  struct Counters {
+    uint32_t written;
+    uint32_t failures;
+    uint32_t erases;
+    uint32_t eraseUs;      // Sums
+    uint32_t writeUs;
+    uint64_t programmed;   // Bytes written to flash (blocks + headers)
+    uint64_t payload;      // Header + used bit stream of the blocks
+
+    float amplification() const { return payload ? (float)programmed / payload : 0; }
+  };
+
+  static const uint64_t EMPTY_MS = UINT64_MAX;   // Erased flash
+
+  void recover();
+  bool append(Sensor_History::Block& b, Counters& c);
+  bool openSector(uint16_t s, Counters& c);
+  size_t scan(uint64_t from, uint64_t to, Sensor_History::PointFn fn, void* ctx) const;
+  uint16_t oldestSector() const;
+  uint32_t offset(uint16_t sector, uint8_t slot) const {
+    return (uint32_t)sector * SECTOR_BYTES + (uint32_t)slot * Sensor_History::BLOCK_BYTES;
+  }
+
+  const esp_partition_t* _part;
+  Sector _index[MAX_SECTORS];
+  uint16_t _sectors;
+  uint16_t _sector;        // Sector being written
+  uint8_t _slot;           // Next free slot in it
+  uint32_t _seq;           // Sequence number of _sector
+  uint32_t _blocks;        // Blocks currently stored
+  uint64_t _oldestMs;
+  uint64_t _newestMs;
+
+  // Statistics
+  uint32_t _recoveryUs;
+  Counters _live;
+  Counters _benchCounters;
+  uint32_t _lastWriteUs;
+  uint32_t _maxWriteUs;
+  mutable uint32_t _crcErrors;
+
+  // Benchmark
+  BenchState _bench;
+  bool _benchDone;
+  uint32_t _benchTarget;   // Blocks to write
+  uint32_t _benchStartMs;
+  Sensor_History::Block _benchBlock;
+  BenchResult _result;
+};
+
+#endif // SENSOR_ARCHIVE_H
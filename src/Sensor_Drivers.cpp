@@ -0,0 +1,109 @@
+/**
+ * @file Sensor_Drivers.cpp
+ * @brief Implementation of the sensor drivers
+ */
+
+#include "Sensor_Drivers.h"
+
+// ============================================================================
+// SHT3x
+// ============================================================================
+
+#define SHT3X_SOFT_RESET      0x30A2
+#define SHT3X_MEASURE_HIGH    0x2400   // Single shot, high repeatability, no clock stretching
+#define SHT3X_MEASURE_MS      16       // Max conversion time 15.5 ms
+
+Sensor_SHT3x::Sensor_SHT3x(TwoWire& wire, uint8_t address)
+  : _wire(wire), _address(address) {
+}
+
+bool Sensor_SHT3x::command(uint16_t cmd) {
+  _wire.beginTransmission(_address);
+  _wire.write((uint8_t)(cmd >> 8));
+  _wire.write((uint8_t)(cmd & 0xFF));
+  return _wire.endTransmission() == 0;
+}
+
+bool Sensor_SHT3x::begin() {
+  if (!command(SHT3X_SOFT_RESET)) return false;
+  delay(2);
+  return true;
+}
+
+bool Sensor_SHT3x::read(float* values) {
+  if (!command(SHT3X_MEASURE_HIGH)) return false;
+  delay(SHT3X_MEASURE_MS);
+
+  uint8_t buf[6];
+  if (_wire.requestFrom(_address, (uint8_t)6) != 6) return false;
+  for (uint8_t i = 0; i < 6; i++) buf[i] = _wire.read();
+  if (crc8(buf, 2) != buf[2] || crc8(buf + 3, 2) != buf[5]) return false;
+
+  uint16_t rawT = (buf[0] << 8) | buf[1];
+  uint16_t rawH = (buf[3] << 8) | buf[4];
+  values[SENSOR_TEMPERATURE] = -45.0f + 175.0f * rawT / 65535.0f;
+  values[SENSOR_HUMIDITY] = 100.0f * rawH / 65535.0f;
+  return true;
+}
+
+uint8_t Sensor_SHT3x::crc8(const uint8_t* data, size_t len) {
+  // Polynomial 0x31, init 0xFF (datasheet section 4.12)
+  uint8_t crc = 0xFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (uint8_t b = 0; b < 8; b++) crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : crc << 1;
+  }
+  return crc;
+}
+
+// ============================================================================
+// BH1750
+// ============================================================================
+
+#define BH1750_POWER_ON         0x01
+#define BH1750_CONTINUOUS_HIGH  0x10   // 1 lx resolution, 120 ms per conversion
+
+Sensor_BH1750::Sensor_BH1750(TwoWire& wire, uint8_t address)
+  : _wire(wire), _address(address) {
+}
+
+bool Sensor_BH1750::command(uint8_t cmd) {
+  _wire.beginTransmission(_address);
+  _wire.write(cmd);
+  return _wire.endTransmission() == 0;
+}
+
+bool Sensor_BH1750::begin() {
+  // Continuous mode: every read returns the latest finished conversion
+  return command(BH1750_POWER_ON) && command(BH1750_CONTINUOUS_HIGH);
+}
+
+bool Sensor_BH1750::read(float* values) {
+  if (_wire.requestFrom(_address, (uint8_t)2) != 2) return false;
+  uint16_t raw = _wire.read() << 8;
+  raw |= _wire.read();
+  values[SENSOR_LIGHT] = raw / 1.2f;
+  return true;
+}
+
+// ============================================================================
+// SIMULATOR
+// ============================================================================
+
+Sensor_Simulator::Sensor_Simulator()
+  : _temperature(22.5f), _humidity(65.0f), _light(850.0f) {
+}
+
+bool Sensor_Simulator::read(float* values) {
+  // Temperature: 18-32°C, ±0.2°C per reading
+  _temperature = constrain(_temperature + random(-20, 21) / 100.0f, 18.0f, 32.0f);
+  // Humidity: 30-90%, ±0.3% per reading
+  _humidity = constrain(_humidity + random(-30, 31) / 100.0f, 30.0f, 90.0f);
+  // Light: 0-2000 lx, ±20 lx per reading
+  _light = constrain(_light + random(-200, 201) / 10.0f, 0.0f, 2000.0f);
+
+  values[SENSOR_TEMPERATURE] = _temperature;
+  values[SENSOR_HUMIDITY] = _humidity;
+  values[SENSOR_LIGHT] = _light;
+  return true;
+}
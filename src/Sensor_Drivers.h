@@ -0,0 +1,116 @@
+/**
+ * @file Sensor_Drivers.h
+ * @brief Sensor driver interface and the SHT3x, BH1750 and simulator drivers
+ * @version 1.0.0
+ *
+ * @details
+ * A driver reads one physical device and fills the channels it provides
+ * (temperature, humidity, light). Drivers are only called from the
+ * sampling task of Sensor_Pipeline, so they may block on the bus for the
+ * duration of a conversion.
+ *
+ * - Sensor_SHT3x:     temperature + humidity, I2C 0x44/0x45, single-shot
+ *                     high repeatability (~15 ms), CRC checked
+ * - Sensor_BH1750:    light, I2C 0x23/0x5C, continuous high resolution
+ * - Sensor_Simulator: random walk with the ranges of the old dashboard
+ *                     simulator; no hardware, used when no sensor answers
+ *                     or in builds with -D SENSOR_SIMULATOR
+ *
+ * Usage:
+ *   Sensor_SHT3x sht(Wire);
+ *   float v[SENSOR_CHANNELS];
+ *   if (sht.begin() && sht.read(v)) { ... v[SENSOR_TEMPERATURE] ... }
+ */
+
+#ifndef SENSOR_DRIVERS_H
+#define SENSOR_DRIVERS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+/**
+ * @brief Measured quantities (names in Sensor_Pipeline::channelName())
+ */
+enum SensorChannel {
+  SENSOR_TEMPERATURE,   // °C
+  SENSOR_HUMIDITY,      // %RH
+  SENSOR_LIGHT,         // lx
+  SENSOR_CHANNELS
+};
+
+#define SENSOR_BIT(ch) (1 << (ch))
+
+class Sensor_Driver {
+public:
+  virtual ~Sensor_Driver() {}
+
+  virtual const char* name() const = 0;
+
+  /**
+   * @brief Channels this driver fills (SENSOR_BIT mask)
+   */
+  virtual uint8_t channels() const = 0;
+
+  /**
+   * @brief Probe and configure the device
+   * @return false if it does not answer
+   */
+  virtual bool begin() = 0;
+
+  /**
+   * @brief Take one reading
+   * @param values Indexed by SensorChannel; only this driver's channels are written
+   * @return false on a bus or CRC error
+   */
+  virtual bool read(float* values) = 0;
+};
+
+class Sensor_SHT3x : public Sensor_Driver {
+public:
+  explicit Sensor_SHT3x(TwoWire& wire, uint8_t address = 0x44);
+  const char* name() const override { return "sht3x"; }
+  uint8_t channels() const override { return SENSOR_BIT(SENSOR_TEMPERATURE) | SENSOR_BIT(SENSOR_HUMIDITY); }
+  bool begin() override;
+  bool read(float* values) override;
+
+  static uint8_t crc8(const uint8_t* data, size_t len);
+
+private:
+  bool command(uint16_t cmd);
+
+  TwoWire& _wire;
+  uint8_t _address;
+};
+
+class Sensor_BH1750 : public Sensor_Driver {
+public:
+  explicit Sensor_BH1750(TwoWire& wire, uint8_t address = 0x23);
+  const char* name() const override { return "bh1750"; }
+  uint8_t channels() const override { return SENSOR_BIT(SENSOR_LIGHT); }
+  bool begin() override;
+  bool read(float* values) override;
+
+private:
+  bool command(uint8_t cmd);
+
+  TwoWire& _wire;
+  uint8_t _address;
+};
+
+class Sensor_Simulator : public Sensor_Driver {
+public:
+  Sensor_Simulator();
+  const char* name() const override { return "simulator"; }
+  uint8_t channels() const override {
+    return SENSOR_BIT(SENSOR_TEMPERATURE) | SENSOR_BIT(SENSOR_HUMIDITY) | SENSOR_BIT(SENSOR_LIGHT);
+  }
+  bool begin() override { return true; }
+  bool read(float* values) override;
+
+private:
+  float _temperature;
+  float _humidity;
+  float _light;
+};
+
+#endif // SENSOR_DRIVERS_H
@@ -0,0 +1,386 @@
+/**
+ * @file Sensor_History.cpp
+ * @brief Implementation of the compressed sensor time series
+ */
+
+#include "Sensor_History.h"
+#include "Sensor_Archive.h"
+#include <esp_system.h>
+
+static_assert(sizeof(Sensor_History::Block) == Sensor_History::BLOCK_BYTES, "block layout");
+
+// Fixed-point steps per unit: 0.1 °C, 0.1 %RH, 1 lx
+static const int32_t SCALE[SENSOR_CHANNELS] = { 10, 10, 1 };
+
+/**
+ * @brief Variable-length code: prefix of 1s ending in 0, then a payload
+ * The first class (a single 0 bit) is the zero value.
+ */
+struct VarCode {
+  uint8_t payloadBits[4];   // For prefixes 10, 110, 1110, 1111
+};
+
+static const VarCode TS_CODE = { { 3, 9, 13, 32 } };
+static const VarCode VALUE_CODE = { { 4, 8, 16, 32 } };
+
+// Instance flushed by the shutdown handler (esp_restart() takes no context)
+static Sensor_History* s_flushOnRestart = nullptr;
+
+static void flushBeforeRestart() {
+  if (s_flushOnRestart) s_flushOnRestart->flush();
+}
+
+static inline uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static inline int32_t unzigzag(uint32_t z) { return (int32_t)(z >> 1) ^ -(int32_t)(z & 1); }
+
+/**
+ * @brief Prefix class (0-3) for a zigzag value, or -1 for the zero code
+ */
+static int8_t codeClass(const VarCode& code, uint32_t z) {
+  if (z == 0) return -1;
+  for (int8_t c = 0; c < 3; c++) {
+    if (z < (1UL << code.payloadBits[c])) return c;
+  }
+  return 3;
+}
+
+static uint8_t codeBits(const VarCode& code, uint32_t z) {
+  int8_t c = codeClass(code, z);
+  if (c < 0) return 1;
+  return (c < 3 ? c + 2 : 4) + code.payloadBits[c];
+}
+
+// ============================================================================
+// BIT STREAM
+// ============================================================================
+
+class BitWriter {
+public:
+  BitWriter(uint8_t* data, uint16_t& bits) : _data(data), _bits(bits) {}
+
+  void write(uint32_t value, uint8_t n) {
+    while (n--) {
+      uint16_t byte = _bits >> 3;
+      uint8_t mask = 0x80 >> (_bits & 7);
+      if ((value >> n) & 1) _data[byte] |= mask;
+      else _data[byte] &= ~mask;
+      _bits++;
+    }
+  }
+
+  void writeCode(const VarCode& code, uint32_t z) {
+    int8_t c = codeClass(code, z);
+    if (c < 0) {
+      write(0, 1);
+      return;
+    }
+    // Prefixes 10, 110, 1110, 1111
+    if (c < 3) write(((1UL << (c + 2)) - 1) ^ 1, c + 2);
+    else write(0xF, 4);
+    write(z, code.payloadBits[c]);
+  }
+
+private:
+  uint8_t* _data;
+  uint16_t& _bits;
+};
+
+class BitReader {
+public:
+  BitReader(const uint8_t* data) : _data(data), _pos(0) {}
+
+  uint32_t read(uint8_t n) {
+    uint32_t v = 0;
+    while (n--) {
+      v = (v << 1) | ((_data[_pos >> 3] >> (7 - (_pos & 7))) & 1);
+      _pos++;
+    }
+    return v;
+  }
+
+  uint32_t readCode(const VarCode& code) {
+    uint8_t ones = 0;
+    while (ones < 4 && read(1)) ones++;
+    if (ones == 0) return 0;
+    return read(code.payloadBits[ones - 1]);
+  }
+
+private:
+  const uint8_t* _data;
+  uint16_t _pos;
+};
+
+// ============================================================================
+// APPEND
+// ============================================================================
+
+Sensor_History::Sensor_History()
+  : _head(0), _used(0), _samples(0), _dropped(0), _sealed(false), _unarchived(0),
+    _archiveFailures(0), _archiveLost(0), _archive(nullptr), _baseMs(0), _prevMs(0), _prevDelta(0) {
+  memset(_blocks, 0, sizeof(_blocks));
+  memset(_prev, 0, sizeof(_prev));
+}
+
+float Sensor_History::scale(uint8_t ch) {
+  return ch < SENSOR_CHANNELS ? (float)SCALE[ch] : 1.0f;
+}
+
+void Sensor_History::openBlock(uint64_t ms, uint8_t valid, const int32_t* q) {
+  if (_used) {
+    if (_archive && !_sealed) _unarchived++;
+    _head = (_head + 1) % BLOCK_COUNT;
+  }
+  _sealed = false;
+  if (_used == BLOCK_COUNT) {
+    _samples -= _blocks[_head].count;   // Oldest block is overwritten
+    _dropped++;
+    if (_unarchived == BLOCK_COUNT) {   // ... before it ever reached flash
+      _unarchived--;
+      _archiveLost++;
+    }
+  } else {
+    _used++;
+  }
+
+  Block& b = _blocks[_head];
+  memset(&b, 0, sizeof(b));
+  b.startMs = ms;
+  b.valid = valid;
+  b.count = 1;
+  memcpy(b.first, q, sizeof(b.first));
+
+  _prevMs = b.startMs;
+  _prevDelta = 0;
+  memcpy(_prev, q, sizeof(_prev));
+  _samples++;
+
+  archivePending();
+}
+
+void Sensor_History::archivePending() {
+  if (!_archive) return;
+  // Oldest first. A refused write (benchmark running, flash error) leaves
+  // the block pending in RAM and is retried at the next seal.
+  uint16_t last = _sealed ? _head : (_head + BLOCK_COUNT - 1) % BLOCK_COUNT;
+  while (_unarchived) {
+    Block& b = _blocks[(last + 1 + BLOCK_COUNT - _unarchived) % BLOCK_COUNT];
+    if (!_archive->write(b)) {
+      _archiveFailures++;
+      return;
+    }
+    _unarchived--;
+  }
+}
+
+void Sensor_History::append(const Sensor_Sample& s) {
+  uint64_t ms = toHistoryMs(s.ms);
+  int32_t q[SENSOR_CHANNELS];
+  for (uint8_t c = 0; c < SENSOR_CHANNELS; c++) {
+    q[c] = (s.valid & SENSOR_BIT(c)) ? lroundf(s.value[c] * SCALE[c]) : 0;
+  }
+
+  Block* b = _used ? &_blocks[_head] : nullptr;
+  // The span (and so every delta) must stay within int32
+  if (!b || _sealed || b->valid != s.valid || b->count == 0xFFFF || ms < _prevMs ||
+      ms - b->startMs >= 0x80000000ULL) {
+    openBlock(ms, s.valid, q);
+    return;
+  }
+
+  int32_t delta = (int32_t)(ms - _prevMs);
+  uint32_t zts = zigzag(delta - _prevDelta);
+  uint32_t zv[SENSOR_CHANNELS];
+  uint16_t need = codeBits(TS_CODE, zts);
+  for (uint8_t c = 0; c < SENSOR_CHANNELS; c++) {
+    zv[c] = zigzag(q[c] - _prev[c]);
+    if (s.valid & SENSOR_BIT(c)) need += codeBits(VALUE_CODE, zv[c]);
+  }
+  if (b->bits + need > DATA_BYTES * 8) {
+    openBlock(ms, s.valid, q);
+    return;
+  }
+
+  BitWriter w(b->data, b->bits);
+  w.writeCode(TS_CODE, zts);
+  for (uint8_t c = 0; c < SENSOR_CHANNELS; c++) {
+    if (s.valid & SENSOR_BIT(c)) w.writeCode(VALUE_CODE, zv[c]);
+  }
+  b->count++;
+  b->spanMs = (uint32_t)(ms - b->startMs);
+  _prevMs = ms;
+  _prevDelta = delta;
+  memcpy(_prev, q, sizeof(_prev));
+  _samples++;
+}
+
+void Sensor_History::setArchive(Sensor_Archive* archive) {
+  _archive = archive;
+  if (!s_flushOnRestart) {
+    s_flushOnRestart = this;
+    esp_register_shutdown_handler(flushBeforeRestart);
+  }
+}
+
+void Sensor_History::flush() {
+  if (!_archive || !_used || _sealed) return;
+  _sealed = true;                      // The next sample opens a new block
+  _unarchived++;
+  archivePending();
+}
+
+uint16_t Sensor_History::crc16(const Block& b) {
+  // CRC-16/CCITT-FALSE over the whole block with the crc field as zero
+  Block copy = b;
+  copy.crc = 0;
+  const uint8_t* p = (const uint8_t*)&copy;
+  uint16_t crc = 0xFFFF;
+  for (uint16_t i = 0; i < BLOCK_BYTES; i++) {
+    crc ^= (uint16_t)p[i] << 8;
+    for (uint8_t k = 0; k < 8; k++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+// ============================================================================
+// QUERIES
+// ============================================================================
+
+const Sensor_History::Block& Sensor_History::blockAt(uint16_t i) const {
+  return _blocks[(_head + BLOCK_COUNT - (_used - 1) + i) % BLOCK_COUNT];
+}
+
+uint64_t Sensor_History::ramOldestMs() const { return _used ? blockAt(0).startMs : 0; }
+
+uint64_t Sensor_History::oldestMs() const {
+  if (_archive && !_archive->isEmpty()) return _archive->oldestMs();
+  return ramOldestMs();
+}
+
+uint64_t Sensor_History::newestMs() const {
+  if (_used) return _blocks[_head].endMs();
+  return _archive ? _archive->newestMs() : 0;
+}
+
+bool Sensor_History::isEmpty() const {
+  return _used == 0 && (!_archive || _archive->isEmpty());
+}
+
+const Sensor_History::Block* Sensor_History::lastSealed() const {
+  if (_sealed) return &_blocks[_head];
+  return _used > 1 ? &blockAt(_used - 2) : nullptr;
+}
+
+uint32_t Sensor_History::payloadBytes() const {
+  uint32_t n = 0;
+  for (uint16_t i = 0; i < _used; i++) n += payloadBytes(blockAt(i));
+  return n;
+}
+
+bool Sensor_History::decodeBlock(const Block& b, uint64_t from, uint64_t to, PointFn fn, void* ctx,
+                                 size_t& decoded) {
+  Point p;
+  p.samples = 1;
+  p.valid = b.valid;
+
+  int32_t v[SENSOR_CHANNELS];
+  memcpy(v, b.first, sizeof(v));
+  uint64_t ms = b.startMs;
+  int32_t delta = 0;
+  BitReader r(b.data);
+
+  for (uint16_t n = 0; n < b.count; n++) {
+    if (n) {
+      delta += unzigzag(r.readCode(TS_CODE));
+      ms += delta;
+      for (uint8_t c = 0; c < SENSOR_CHANNELS; c++) {
+        if (b.valid & SENSOR_BIT(c)) v[c] += unzigzag(r.readCode(VALUE_CODE));
+      }
+    }
+    decoded++;
+    if (ms < from) continue;
+    if (ms > to) return false;
+    p.ms = ms;
+    for (uint8_t c = 0; c < SENSOR_CHANNELS; c++) p.value[c] = (float)v[c] / SCALE[c];
+    fn(p, ctx);
+  }
+  return true;
+}
+
+size_t Sensor_History::forEach(uint64_t from, uint64_t to, PointFn fn, void* ctx) const {
+  size_t decoded = 0;
+
+  // Anything older than RAM comes from flash
+  uint64_t ramFrom = _used ? blockAt(0).startMs : UINT64_MAX;
+  if (_archive && from < ramFrom) {
+    decoded += _archive->forEach(from, to < ramFrom ? to : ramFrom - 1, fn, ctx);
+  }
+
+  for (uint16_t i = 0; i < _used; i++) {
+    const Block& b = blockAt(i);
+    if (b.endMs() < from) continue;
+    if (b.startMs > to) break;
+    if (!decodeBlock(b, from, to, fn, ctx, decoded)) break;
+  }
+  return decoded;
+}
+
+/**
+ * @brief Running sums of the current downsampling bucket
+ */
+struct Bucket {
+  Sensor_History::PointFn fn;
+  void* ctx;
+  uint64_t from;
+  uint32_t step;
+  uint64_t start;
+  uint32_t samples;                    // A day of 1 Hz samples is 86400
+  uint32_t counts[SENSOR_CHANNELS];
+  float sums[SENSOR_CHANNELS];
+
+  void flush() {
+    if (!samples) return;
+    Sensor_History::Point p;
+    p.ms = start;
+    p.valid = 0;
+    p.samples = samples;
+    for (uint8_t c = 0; c < SENSOR_CHANNELS; c++) {
+      p.value[c] = counts[c] ? sums[c] / counts[c] : 0;
+      if (counts[c]) p.valid |= SENSOR_BIT(c);
+    }
+    fn(p, ctx);
+    samples = 0;
+    memset(counts, 0, sizeof(counts));
+    memset(sums, 0, sizeof(sums));
+  }
+
+  static void add(const Sensor_History::Point& p, void* arg) {
+    Bucket* b = (Bucket*)arg;
+    uint64_t start = b->from + (p.ms - b->from) / b->step * b->step;
+    if (start != b->start) {
+      b->flush();
+      b->start = start;
+    }
+    b->samples++;
+    for (uint8_t c = 0; c < SENSOR_CHANNELS; c++) {
+      if (p.valid & SENSOR_BIT(c)) {
+        b->sums[c] += p.value[c];
+        b->counts[c]++;
+      }
+    }
+  }
+};
+
+size_t Sensor_History::downsample(uint64_t from, uint64_t to, uint32_t step, PointFn fn, void* ctx) const {
+  if (step <= 1) return forEach(from, to, fn, ctx);
+
+  Bucket bucket;
+  memset(&bucket, 0, sizeof(bucket));
+  bucket.fn = fn;
+  bucket.ctx = ctx;
+  bucket.from = from;
+  bucket.step = step;
+  bucket.start = from;
+  size_t decoded = forEach(from, to, Bucket::add, &bucket);
+  bucket.flush();
+  return decoded;
+}
@@ -0,0 +1,198 @@
+/**
+ * @file Sensor_History.h
+ * @brief Compressed in-RAM time series of sensor samples
+ * @version 1.0.0
+ *
+ * @details
+ * Samples are packed into fixed-size BLOCK_BYTES blocks held in a ring of
+ * BLOCK_COUNT; when the ring is full the oldest block is dropped. Each
+ * block stores its first sample in the header and the rest as a bit
+ * stream, Gorilla-style:
+ *
+ * - Timestamps: delta of delta (ms). A steady 1 Hz rate costs 1 bit.
+ *     0                    dod == 0
+ *     10   + 3 bits        zigzag(dod) < 8
+ *     110  + 9 bits        < 512
+ *     1110 + 13 bits       < 8192
+ *     1111 + 32 bits       anything else
+ * - Values: fixed point (SCALE per channel: 0.1 °C, 0.1 %RH, 1 lx), delta
+ *   to the previous sample, zigzag encoded. An unchanged value costs 1 bit.
+ *     0                    delta == 0
+ *     10   + 4 bits        zigzag(delta) < 16
+ *     110  + 8 bits        < 256
+ *     1110 + 16 bits       < 65536
+ *     1111 + 32 bits       anything else
+ *   Fixed-point deltas replace Gorilla's float XOR: the sensors produce
+ *   small integer steps, which XOR of IEEE floats would not exploit.
+ *
+ * A block also records which channels its samples carry; a change of
+ * available channels starts a new block.
+ *
+ * Queries decode only blocks overlapping [from, to] (block headers carry
+ * the first and last timestamp) and downsample on the fly into step-wide
+ * buckets holding the mean of each channel. Appends and queries both run
+ * on the loop task, so there is no locking.
+ *
+ * With an archive attached (Sensor_Archive), every block is written to
+ * flash when it is sealed, and queries read from the archive anything
+ * older than the oldest block still in RAM.
+ *
+ * Timestamps are history time: 64-bit ms, the uptime at acquisition plus
+ * a time base set at boot just past the newest archived sample, so the
+ * axis keeps increasing across resets (time spent powered off is not
+ * counted) and never wraps. Sample stamps are 32-bit millis(); they are
+ * widened against the 64-bit uptime, which is exact for samples younger
+ * than 49 days. Block headers store the first sample as 64 bits and the
+ * block's span as 32; a block is sealed before its span reaches 2^31 ms.
+ *
+ * Usage:
+ *   history.append(sample);                          // Every sample
+ *   history.downsample(from, to, 60000, emit, ctx);  // 1 min means
+ */
+
+#ifndef SENSOR_HISTORY_H
+#define SENSOR_HISTORY_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "Sensor_Pipeline.h"
+
+class Sensor_Archive;
+
+class Sensor_History {
+public:
+  static const uint16_t BLOCK_BYTES = 256;
+  static const uint16_t BLOCK_COUNT = 128;        // 32 KB
+  static const uint16_t HEADER_BYTES = 32;
+  static const uint16_t DATA_BYTES = BLOCK_BYTES - HEADER_BYTES;
+  static const uint8_t RAW_SAMPLE_BYTES = 16;     // ms + three floats, for the ratio
+
+  /**
+   * @brief One block (first sample in the header, the rest bit-packed)
+   */
+  struct Block {
+    uint64_t startMs;                  // First sample
+    uint32_t spanMs;                   // Last sample - first sample
+    int32_t first[SENSOR_CHANNELS];    // First sample, fixed point
+    uint16_t count;                    // Samples in the block
+    uint16_t bits;                     // Bits used in data
+    uint8_t valid;                     // Channels carried (SENSOR_BIT mask)
+    uint8_t reserved;
+    uint16_t crc;                      // Set when archived
+    uint8_t data[DATA_BYTES];
+
+    uint64_t endMs() const { return startMs + spanMs; }
+  };
+
+  /**
+   * @brief Decoded sample or downsampled bucket
+   */
+  struct Point {
+    uint64_t ms;                       // Sample time, or bucket start
+    uint8_t valid;
+    uint32_t samples;                  // Samples averaged (1 for raw points)
+    float value[SENSOR_CHANNELS];
+  };
+
+  typedef void (*PointFn)(const Point& p, void* ctx);
+
+  Sensor_History();
+
+  /**
+   * @brief Write sealed blocks to flash and read older data from it
+   * Also registers the shutdown handler that flushes before a restart.
+   */
+  void setArchive(Sensor_Archive* archive);
+
+  /**
+   * @brief Offset added to sample times (history time = millis() + base)
+   */
+  void setTimeBase(uint64_t baseMs) { _baseMs = baseMs; }
+  uint64_t timeBase() const { return _baseMs; }
+  uint64_t now() const { return uptimeMs() + _baseMs; }
+
+  /**
+   * @brief History time of a millis() stamp taken within the last 49 days
+   */
+  uint64_t toHistoryMs(uint32_t ms) const {
+    uint64_t up = uptimeMs();
+    return _baseMs + up - (uint32_t)((uint32_t)up - ms);
+  }
+  static uint64_t uptimeMs() { return (uint64_t)esp_timer_get_time() / 1000; }
+
+  void append(const Sensor_Sample& s);
+
+  /**
+   * @brief Seal the open block into the archive (before a restart)
+   */
+  void flush();
+
+  /**
+   * @brief Decode every sample in [from, to], oldest first
+   * @return Samples decoded (including skipped ones in overlapping blocks)
+   */
+  size_t forEach(uint64_t from, uint64_t to, PointFn fn, void* ctx) const;
+
+  /**
+   * @brief Mean of each channel per step-wide bucket starting at 'from'
+   *        (empty buckets are skipped)
+   * @return Samples decoded
+   */
+  size_t downsample(uint64_t from, uint64_t to, uint32_t step, PointFn fn, void* ctx) const;
+
+  /**
+   * @brief Decode the samples of one block that fall in [from, to]
+   * @param decoded Incremented for every sample decoded
+   * @return false once a sample after 'to' was reached
+   */
+  static bool decodeBlock(const Block& b, uint64_t from, uint64_t to, PointFn fn, void* ctx,
+                          size_t& decoded);
+
+  /**
+   * @brief CRC-16/CCITT of a block (crc field excluded)
+   */
+  static uint16_t crc16(const Block& b);
+
+  /**
+   * @brief Bytes that carry data (header + used bit stream)
+   */
+  static uint16_t payloadBytes(const Block& b) { return HEADER_BYTES + (b.bits + 7) / 8; }
+
+  bool isEmpty() const;                           // RAM and archive
+  uint64_t oldestMs() const;                      // RAM and archive
+  uint64_t newestMs() const;
+  uint64_t ramOldestMs() const;
+  uint32_t sampleCount() const { return _samples; }    // In RAM
+  uint16_t blocksUsed() const { return _used; }
+  uint32_t blocksDropped() const { return _dropped; }
+  uint16_t blocksPending() const { return _unarchived; }         // Sealed, not yet in flash
+  uint32_t archiveFailures() const { return _archiveFailures; }  // Refused writes (retried)
+  uint32_t archiveLost() const { return _archiveLost; }          // Dropped before archived
+  uint32_t payloadBytes() const;                  // RAM blocks
+  const Block* lastSealed() const;                // Newest complete block in RAM
+  static float scale(uint8_t ch);
+
+private:
+  const Block& blockAt(uint16_t i) const;         // i = 0 is the oldest
+  void openBlock(uint64_t ms, uint8_t valid, const int32_t* q);
+  void archivePending();
+
+  Block _blocks[BLOCK_COUNT];
+  uint16_t _head;                      // Block being filled
+  uint16_t _used;
+  uint32_t _samples;
+  uint32_t _dropped;
+  bool _sealed;                        // Open block sealed by flush()
+  uint16_t _unarchived;                // Newest sealed blocks not yet written to the archive
+  uint32_t _archiveFailures;
+  uint32_t _archiveLost;
+  Sensor_Archive* _archive;
+  uint64_t _baseMs;
+
+  // Encoder state of the open block
+  uint64_t _prevMs;
+  int32_t _prevDelta;
+  int32_t _prev[SENSOR_CHANNELS];
+};
+
+#endif // SENSOR_HISTORY_H
@@ -0,0 +1,134 @@
+/**
+ * @file Sensor_Pipeline.cpp
+ * @brief Implementation of the sensor sampling pipeline
+ */
+
+#include "Sensor_Pipeline.h"
+#include "Log_Ring.h"
+
+Sensor_Pipeline::Sensor_Pipeline()
+  : _driverCount(0), _fallback(nullptr), _simulated(false), _periodMs(DEFAULT_PERIOD_MS),
+    _version(0), _qHead(0), _qTail(0), _samples(0), _readErrors(0), _queueDropped(0),
+    _lastReadUs(0), _maxReadUs(0), _nextWakeUs(0), _lastJitterUs(0), _maxJitterUs(0),
+    _sumJitterUs(0) {
+  memset(_drivers, 0, sizeof(_drivers));
+  memset(_present, 0, sizeof(_present));
+  memset(&_latest, 0, sizeof(_latest));
+  memset(_queue, 0, sizeof(_queue));
+}
+
+bool Sensor_Pipeline::addDriver(Sensor_Driver* driver) {
+  if (_driverCount >= MAX_DRIVERS) return false;
+  _drivers[_driverCount++] = driver;
+  return true;
+}
+
+void Sensor_Pipeline::begin(uint32_t periodMs) {
+  _periodMs = periodMs;
+
+  uint8_t found = 0;
+  for (uint8_t i = 0; i < _driverCount; i++) {
+    _present[i] = _drivers[i]->begin();
+    if (_present[i]) found++;
+    LOG_I(LOG_SENSOR, "%s: %s", _drivers[i]->name(), _present[i] ? "found" : "not found");
+  }
+  if (!found && _fallback && _fallback->begin()) {
+    _simulated = true;
+    LOG_W(LOG_SENSOR, "No sensor answered, using %s", _fallback->name());
+  }
+
+  // Core 0 with the WiFi stack; above the log drain so the rate holds
+  xTaskCreatePinnedToCore(task, "sensors", 3072, this, tskIDLE_PRIORITY + 2, nullptr, 0);
+}
+
+const char* Sensor_Pipeline::channelName(uint8_t ch) {
+  switch (ch) {
+    case SENSOR_TEMPERATURE: return "temperature";
+    case SENSOR_HUMIDITY:    return "humidity";
+    case SENSOR_LIGHT:       return "light";
+    default:                 return "?";
+  }
+}
+
+// ============================================================================
+// SAMPLING TASK
+// ============================================================================
+
+void Sensor_Pipeline::task(void* arg) {
+  Sensor_Pipeline* p = (Sensor_Pipeline*)arg;
+  TickType_t wake = xTaskGetTickCount();
+  for (;;) {
+    p->acquire();
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(p->_periodMs));
+  }
+}
+
+void Sensor_Pipeline::acquire() {
+  uint32_t startUs = micros();
+  if (_samples) {
+    int32_t late = (int32_t)(startUs - _nextWakeUs);
+    _lastJitterUs = late < 0 ? -late : late;
+    if (_lastJitterUs > _maxJitterUs) _maxJitterUs = _lastJitterUs;
+    _sumJitterUs += _lastJitterUs;
+    _nextWakeUs += _periodMs * 1000;
+  } else {
+    _nextWakeUs = startUs + _periodMs * 1000;
+  }
+
+  Sensor_Sample s;
+  memset(&s, 0, sizeof(s));
+  s.seq = _samples + 1;
+  s.ms = millis();
+  for (uint8_t i = 0; i < _driverCount; i++) {
+    if (!_present[i]) continue;
+    if (_drivers[i]->read(s.value)) s.valid |= _drivers[i]->channels();
+    else _readErrors++;
+  }
+  if (_simulated && _fallback->read(s.value)) s.valid |= _fallback->channels();
+
+  _lastReadUs = micros() - startUs;
+  if (_lastReadUs > _maxReadUs) _maxReadUs = _lastReadUs;
+  _samples++;
+  publish(s);
+}
+
+void Sensor_Pipeline::publish(const Sensor_Sample& s) {
+  // Latest slot: odd version while writing
+  uint32_t v = _version.load(std::memory_order_relaxed);
+  _version.store(v + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy((void*)&_latest, &s, sizeof(s));
+  _version.store(v + 2, std::memory_order_release);
+
+  // Queue for the loop task
+  uint32_t head = _qHead.load(std::memory_order_relaxed);
+  if (head - _qTail.load(std::memory_order_acquire) >= QUEUE_LEN) {
+    _queueDropped++;
+    return;
+  }
+  _queue[head & (QUEUE_LEN - 1)] = s;
+  _qHead.store(head + 1, std::memory_order_release);
+}
+
+// ============================================================================
+// READERS
+// ============================================================================
+
+bool Sensor_Pipeline::latest(Sensor_Sample& out) const {
+  for (;;) {
+    uint32_t v1 = _version.load(std::memory_order_acquire);
+    if (v1 == 0) return false;      // Nothing published yet
+    if (v1 & 1) continue;           // Write in progress (well under a microsecond)
+    memcpy(&out, (const void*)&_latest, sizeof(out));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (_version.load(std::memory_order_relaxed) == v1) return true;
+  }
+}
+
+bool Sensor_Pipeline::pop(Sensor_Sample& out) {
+  uint32_t tail = _qTail.load(std::memory_order_relaxed);
+  if (tail == _qHead.load(std::memory_order_acquire)) return false;
+  out = _queue[tail & (QUEUE_LEN - 1)];
+  _qTail.store(tail + 1, std::memory_order_release);
+  return true;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file Sensor_Pipeline.h
+ * @brief Fixed-rate sensor sampling task with a lock-free latest-value slot
+ * @version 1.0.0
+ *
+ * @details
+ * A FreeRTOS task on core 0 wakes every period (vTaskDelayUntil, so the
+ * rate does not drift with read time), reads every present driver and
+ * publishes one timestamped Sensor_Sample:
+ *
+ * - Latest slot: a sequence lock. The task makes the version odd, writes
+ *   the sample and makes it even again; readers copy the slot and retry
+ *   if the version was odd or changed. HTTP handlers never block on the
+ *   bus or on a mutex, and the task never waits for a reader.
+ * - Queue: a single-producer/single-consumer ring of QUEUE_LEN samples
+ *   drained by the loop task with pop(), so consumers that keep state
+ *   (history, statistics, alerts) run on the loop task and see every
+ *   sample even when loop() was blocked for several periods. Samples are
+ *   dropped and counted only if the ring is full.
+ *
+ * Drivers present at begin() are used; when none answers, the fallback
+ * driver (the simulator) takes over and simulated() reports it.
+ *
+ * Measured by the task: read duration per sample and wake-up jitter
+ * (actual wake time minus the scheduled one).
+ *
+ * Usage:
+ *   pipeline.addDriver(&sht3x);
+ *   pipeline.addDriver(&bh1750);
+ *   pipeline.setFallback(&simulator);
+ *   pipeline.begin(1000);
+ *   Sensor_Sample s;
+ *   if (pipeline.latest(s)) { ... }          // Any task
+ *   while (pipeline.pop(s)) { ... }          // Loop task only
+ */
+
+#ifndef SENSOR_PIPELINE_H
+#define SENSOR_PIPELINE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "Sensor_Drivers.h"
+
+/**
+ * @brief One acquisition of all channels
+ */
+struct Sensor_Sample {
+  uint32_t seq;                    // 1-based sample number
+  uint32_t ms;                     // millis() when the read started
+  uint8_t valid;                   // SENSOR_BIT mask of channels read successfully
+  float value[SENSOR_CHANNELS];
+
+  bool has(uint8_t ch) const { return valid & SENSOR_BIT(ch); }
+};
+
+class Sensor_Pipeline {
+public:
+  static const uint8_t MAX_DRIVERS = 4;
+  static const uint8_t QUEUE_LEN = 16;             // Power of two; 16 s at 1 Hz
+  static const uint32_t DEFAULT_PERIOD_MS = 1000;
+
+  Sensor_Pipeline();
+
+  /**
+   * @brief Register a driver (before begin())
+   */
+  bool addDriver(Sensor_Driver* driver);
+
+  /**
+   * @brief Driver used when none of the registered ones answers
+   */
+  void setFallback(Sensor_Driver* driver) { _fallback = driver; }
+
+  /**
+   * @brief Probe the drivers and start the sampling task
+   */
+  void begin(uint32_t periodMs = DEFAULT_PERIOD_MS);
+
+  /**
+   * @brief Copy the most recent sample (any task, never blocks)
+   * @return false before the first sample
+   */
+  bool latest(Sensor_Sample& out) const;
+
+  /**
+   * @brief Take the oldest queued sample (loop task only)
+   */
+  bool pop(Sensor_Sample& out);
+
+  // Drivers
+  uint8_t driverCount() const { return _driverCount; }
+  const Sensor_Driver* driver(uint8_t i) const { return _drivers[i]; }
+  bool driverPresent(uint8_t i) const { return _present[i]; }
+  bool simulated() const { return _simulated; }
+  static const char* channelName(uint8_t ch);
+
+  // Task statistics
+  uint32_t periodMs() const { return _periodMs; }
+  uint32_t samples() const { return _samples; }
+  uint32_t readErrors() const { return _readErrors; }
+  uint32_t queueDropped() const { return _queueDropped; }
+  uint32_t lastReadUs() const { return _lastReadUs; }
+  uint32_t maxReadUs() const { return _maxReadUs; }
+  uint32_t lastJitterUs() const { return _lastJitterUs; }
+  uint32_t maxJitterUs() const { return _maxJitterUs; }
+  uint32_t avgJitterUs() const { return _samples > 1 ? (uint32_t)(_sumJitterUs / (_samples - 1)) : 0; }
+
+private:
+  static void task(void* arg);
+  void acquire();
+  void publish(const Sensor_Sample& s);
+
+  Sensor_Driver* _drivers[MAX_DRIVERS];
+  bool _present[MAX_DRIVERS];
+  uint8_t _driverCount;
+  Sensor_Driver* _fallback;
+  bool _simulated;
+  uint32_t _periodMs;
+
+  // Latest slot (sequence lock, single writer)
+  std::atomic<uint32_t> _version;
+  Sensor_Sample _latest;
+
+  // Loop task queue (single producer, single consumer)
+  Sensor_Sample _queue[QUEUE_LEN];
+  std::atomic<uint32_t> _qHead;    // Written by the task
+  std::atomic<uint32_t> _qTail;    // Written by pop()
+
+  // Written by the task only
+  uint32_t _samples;
+  uint32_t _readErrors;
+  uint32_t _queueDropped;
+  uint32_t _lastReadUs;
+  uint32_t _maxReadUs;
+  uint32_t _nextWakeUs;            // Scheduled wake-up of the next sample
+  uint32_t _lastJitterUs;
+  uint32_t _maxJitterUs;
+  uint64_t _sumJitterUs;
+};
+
+#endif // SENSOR_PIPELINE_H
@@ -0,0 +1,295 @@
+/**
+ * @file Sensor_Stats.cpp
+ * @brief Implementation of the rolling sensor statistics
+ */
+
+#include "Sensor_Stats.h"
+#include "Sensor_History.h"
+#include <algorithm>
+#include <math.h>
+
+/**
+ * @brief Bucket layout of one window
+ */
+struct WindowSpec {
+  const char* name;
+  uint32_t bucketMs;
+  uint8_t buckets;       // Multiple of SLICES
+  uint8_t first;         // Index of its first bucket in _buckets
+};
+
+static const WindowSpec WINDOWS[Sensor_Stats::WINDOW_COUNT] = {
+  { "1m",  5000,    12, 0 },     // 5 s buckets
+  { "1h",  90000,   40, 12 },    // 90 s buckets
+  { "24h", 1800000, 48, 52 },    // 30 min buckets
+};
+
+static_assert(12 + 40 + 48 == Sensor_Stats::TOTAL_BUCKETS, "bucket layout");
+
+static const uint16_t SKETCH_MAX = 0xFFFF;
+
+Sensor_Stats::Sensor_Stats()
+  : _started(false), _samples(0), _firstMs(0), _newestMs(0), _addCycles(0), _maxAddCycles(0) {
+  memset(_buckets, 0, sizeof(_buckets));
+  memset(_totals, 0, sizeof(_totals));
+  memset(_sketch, 0, sizeof(_sketch));
+  memset(_head, 0, sizeof(_head));
+}
+
+const char* Sensor_Stats::windowName(Window w) { return WINDOWS[w].name; }
+uint32_t Sensor_Stats::windowMs(Window w) { return WINDOWS[w].bucketMs * WINDOWS[w].buckets; }
+uint32_t Sensor_Stats::bucketMs(Window w) { return WINDOWS[w].bucketMs; }
+
+Sensor_Stats::Bucket& Sensor_Stats::bucketAt(uint8_t w, uint32_t bucket, uint8_t ch) {
+  return _buckets[WINDOWS[w].first + bucket % WINDOWS[w].buckets][ch];
+}
+
+const Sensor_Stats::Bucket& Sensor_Stats::bucketAt(uint8_t w, uint32_t bucket, uint8_t ch) const {
+  return _buckets[WINDOWS[w].first + bucket % WINDOWS[w].buckets][ch];
+}
+
+// ============================================================================
+// SKETCH BINS
+// ============================================================================
+// Fixed point in, as stored by Sensor_History: 0.1 °C, 0.1 %RH, 1 lx
+
+uint8_t Sensor_Stats::binOf(uint8_t ch, int32_t q) {
+  int32_t bin;
+  switch (ch) {
+    case SENSOR_TEMPERATURE: bin = (q + 200) * BINS / 800; break;   // -20..60 °C
+    case SENSOR_HUMIDITY:    bin = q * BINS / 1000; break;          // 0..100 %
+    default:                 bin = q > 0 ? (int32_t)(log2f(q + 1.0f) * 8) : 0; break;  // 8 per octave
+  }
+  return bin < 0 ? 0 : bin >= BINS ? BINS - 1 : bin;
+}
+
+float Sensor_Stats::binLow(uint8_t ch, uint8_t bin) {
+  switch (ch) {
+    case SENSOR_TEMPERATURE: return -20.0f + bin * 80.0f / BINS;
+    case SENSOR_HUMIDITY:    return bin * 100.0f / BINS;
+    default:                 return exp2f(bin / 8.0f) - 1.0f;
+  }
+}
+
+// ============================================================================
+// UPDATE
+// ============================================================================
+
+void Sensor_Stats::advance(uint8_t w, uint32_t bucket) {
+  const WindowSpec& spec = WINDOWS[w];
+  uint32_t sliceBuckets = spec.buckets / SLICES;
+
+  if (bucket - _head[w] >= spec.buckets) {
+    // Gap longer than the window: start over
+    memset(&_buckets[spec.first], 0, sizeof(_buckets[0]) * spec.buckets);
+    memset(_totals[w], 0, sizeof(_totals[w]));
+    memset(_sketch[w], 0, sizeof(_sketch[w]));
+    _head[w] = bucket;
+    return;
+  }
+
+  while (_head[w] != bucket) {
+    _head[w]++;
+    // The bucket entered is the one that left the window
+    for (uint8_t ch = 0; ch < SENSOR_CHANNELS; ch++) {
+      Bucket& b = bucketAt(w, _head[w], ch);
+      Totals& t = _totals[w][ch];
+      t.count -= b.count;
+      t.sum -= b.sum;
+      t.sumSq -= b.sumSq;
+      memset(&b, 0, sizeof(b));
+      if (_head[w] % sliceBuckets == 0) {
+        memset(_sketch[w][ch][(_head[w] / sliceBuckets) % SLICES], 0, sizeof(_sketch[0][0][0]));
+      }
+    }
+  }
+}
+
+void Sensor_Stats::add(const Sensor_Sample& s, uint64_t ms) {
+  uint32_t c0 = ESP.getCycleCount();
+
+  for (uint8_t w = 0; w < WINDOW_COUNT; w++) {
+    uint32_t bucket = (uint32_t)(ms / WINDOWS[w].bucketMs);
+    if (!_started) _head[w] = bucket;
+    else if (bucket > _head[w]) advance(w, bucket);
+    // An older timestamp (should not happen) lands in the current bucket
+  }
+  if (!_started) _firstMs = ms;
+  _started = true;
+  _newestMs = ms;
+
+  for (uint8_t ch = 0; ch < SENSOR_CHANNELS; ch++) {
+    if (!s.has(ch)) continue;
+    int32_t q = lroundf(s.value[ch] * Sensor_History::scale(ch));
+    uint8_t bin = binOf(ch, q);
+
+    for (uint8_t w = 0; w < WINDOW_COUNT; w++) {
+      Bucket& b = bucketAt(w, _head[w], ch);
+      if (!b.count || q < b.min) b.min = q;
+      if (!b.count || q > b.max) b.max = q;
+      b.count++;
+      b.sum += q;
+      b.sumSq += (int64_t)q * q;
+
+      Totals& t = _totals[w][ch];
+      t.count++;
+      t.sum += q;
+      t.sumSq += (int64_t)q * q;
+
+      uint16_t& n = _sketch[w][ch][(_head[w] / (WINDOWS[w].buckets / SLICES)) % SLICES][bin];
+      if (n < SKETCH_MAX) n++;
+    }
+  }
+  _samples++;
+
+  uint32_t cycles = ESP.getCycleCount() - c0;
+  _addCycles += cycles;
+  if (cycles > _maxAddCycles) _maxAddCycles = cycles;
+}
+
+// ============================================================================
+// QUERIES
+// ============================================================================
+
+bool Sensor_Stats::summary(Window w, uint8_t ch, Summary& out) const {
+  memset(&out, 0, sizeof(out));
+  const Totals& t = _totals[w][ch];
+  if (!_started || !t.count) return false;
+
+  const WindowSpec& spec = WINDOWS[w];
+  int32_t lo = INT32_MAX, hi = INT32_MIN;
+  for (uint8_t i = 0; i < spec.buckets; i++) {
+    const Bucket& b = _buckets[spec.first + i][ch];
+    if (!b.count) continue;
+    if (b.min < lo) lo = b.min;
+    if (b.max > hi) hi = b.max;
+  }
+
+  float scale = Sensor_History::scale(ch);
+  double mean = (double)t.sum / t.count;
+  double var = ((double)t.sumSq - mean * t.sum) / t.count;
+  out.count = t.count;
+  out.min = lo / scale;
+  out.max = hi / scale;
+  out.mean = mean / scale;
+  out.stddev = var > 0 ? sqrt(var) / scale : 0;
+  uint32_t first = _head[w] >= spec.buckets - 1u ? _head[w] - (spec.buckets - 1) : 0;
+  out.fromMs = max(_firstMs, (uint64_t)first * spec.bucketMs);
+  return true;
+}
+
+uint64_t Sensor_Stats::sketchFromMs(Window w) const {
+  const WindowSpec& spec = WINDOWS[w];
+  uint32_t sliceBuckets = spec.buckets / SLICES;
+  uint32_t slice = _head[w] / sliceBuckets;
+  uint32_t first = slice >= SLICES - 1u ? (slice - (SLICES - 1)) * sliceBuckets : 0;
+  return max(_firstMs, (uint64_t)first * spec.bucketMs);
+}
+
+float Sensor_Stats::percentile(Window w, uint8_t ch, float q) const {
+  uint32_t bins[BINS];
+  uint32_t total = 0;
+  for (uint8_t b = 0; b < BINS; b++) {
+    bins[b] = 0;
+    for (uint8_t s = 0; s < SLICES; s++) bins[b] += _sketch[w][ch][s][b];
+    total += bins[b];
+  }
+  if (!total) return NAN;
+
+  // Same rank as the exact definition: q * (n - 1), interpolated in the bin
+  float rank = constrain(q, 0.0f, 1.0f) * (total - 1);
+  uint32_t below = 0;
+  uint8_t b = 0;
+  while (b < BINS - 1 && below + bins[b] <= rank) below += bins[b++];
+  float lo = binLow(ch, b);
+  float hi = b < BINS - 1 ? binLow(ch, b + 1) : lo;
+  float v = lo + (hi - lo) * fminf(1.0f, (rank - below + 0.5f) / bins[b]);
+
+  // The end bins collect clamped values; the bucket min/max are exact
+  Summary s;
+  if (summary(w, ch, s)) v = constrain(v, s.min, s.max);
+  return v;
+}
+
+// ============================================================================
+// VERIFICATION
+// ============================================================================
+
+/**
+ * @brief Exact values of one channel decoded from the history
+ */
+struct ExactPass {
+  uint8_t ch;
+  float scale;
+  int32_t* values;
+  uint16_t n;
+  bool overflow;
+  uint32_t count;
+  int64_t sum;
+  int64_t sumSq;
+  int32_t min;
+  int32_t max;
+
+  static void point(const Sensor_History::Point& p, void* arg) {
+    ExactPass* e = (ExactPass*)arg;
+    if (!(p.valid & SENSOR_BIT(e->ch))) return;
+    int32_t q = lroundf(p.value[e->ch] * e->scale);
+    if (!e->count || q < e->min) e->min = q;
+    if (!e->count || q > e->max) e->max = q;
+    e->count++;
+    e->sum += q;
+    e->sumSq += (int64_t)q * q;
+    if (e->n < Sensor_Stats::VERIFY_MAX) e->values[e->n++] = q;
+    else e->overflow = true;
+  }
+};
+
+bool Sensor_Stats::verify(Window w, uint8_t ch, const Sensor_History& history, Check& out) const {
+  memset(&out, 0, sizeof(out));
+  Summary s;
+  if (!summary(w, ch, s) || s.count > VERIFY_MAX) return false;
+  if (history.oldestMs() > s.fromMs) return false;
+
+  int32_t* values = (int32_t*)malloc(VERIFY_MAX * sizeof(int32_t));
+  if (!values) return false;
+
+  // Moments over the bucket span, percentiles over the sketch span
+  ExactPass e;
+  memset(&e, 0, sizeof(e));
+  e.ch = ch;
+  e.scale = Sensor_History::scale(ch);
+  e.values = values;
+  history.forEach(s.fromMs, _newestMs, ExactPass::point, &e);
+
+  ExactPass p = e;
+  p.values = values;
+  p.n = 0;
+  p.count = 0;
+  p.overflow = false;
+  history.forEach(sketchFromMs(w), _newestMs, ExactPass::point, &p);
+
+  bool ok = e.count && p.n && !p.overflow;
+  if (ok) {
+    double mean = (double)e.sum / e.count;
+    double var = ((double)e.sumSq - mean * e.sum) / e.count;
+    out.count = e.count;
+    out.countError = (int32_t)s.count - (int32_t)e.count;
+    out.meanError = s.mean - mean / e.scale;
+    out.stddevError = s.stddev - (var > 0 ? sqrt(var) : 0) / e.scale;
+    out.minError = s.min - e.min / e.scale;
+    out.maxError = s.max - e.max / e.scale;
+
+    std::sort(values, values + p.n);
+    static const float Q[3] = { 0.5f, 0.9f, 0.99f };
+    for (uint8_t i = 0; i < 3; i++) {
+      float rank = Q[i] * (p.n - 1);
+      uint16_t k = (uint16_t)rank;
+      float frac = rank - k;
+      float v = k + 1 < p.n ? values[k] + (values[k + 1] - values[k]) * frac : values[k];
+      out.pExact[i] = v / e.scale;
+      out.pSketch[i] = percentile(w, ch, Q[i]);
+    }
+  }
+  free(values);
+  return ok;
+}
@@ -0,0 +1,165 @@
+/**
+ * @file Sensor_Stats.h
+ * @brief Rolling per-channel statistics over 1 min / 1 h / 24 h windows
+ * @version 1.0.0
+ *
+ * @details
+ * Every sample updates, for each window and channel, in O(1):
+ *
+ * - Buckets: the window is a ring of BUCKETS sub-intervals, each holding
+ *   count, sum, sum of squares, min and max of the fixed-point values (the
+ *   same 0.1 °C / 0.1 %RH / 1 lx steps as Sensor_History). When time moves
+ *   into a new bucket the oldest one is subtracted from the window totals
+ *   and cleared. Integer sums make the subtraction exact, so the running
+ *   mean and variance never drift. Min/max are the min/max of the buckets,
+ *   computed when queried. The window slides in whole buckets, so it spans
+ *   between (BUCKETS - 1) and BUCKETS bucket lengths.
+ * - Percentile sketch: a 128-bin histogram per quarter window (SLICES),
+ *   cleared when its quarter comes round again. Bins are linear for
+ *   temperature (-20..60 °C) and humidity (0..100 %) and logarithmic for
+ *   light (8 per octave, 1..65536 lx); values outside are clamped into the
+ *   end bins. Percentiles interpolate within a bin, so the error is at
+ *   most half a bin (0.3 °C, 0.4 %RH, 4.5 % of the lux value). The sketch
+ *   covers three to four quarters of the window.
+ *
+ * Memory is fixed (about 16 KB, all static) whatever the sample rate.
+ * Samples are added on the loop task, like the history, so queries there
+ * need no locking.
+ *
+ * Usage:
+ *   stats.add(sample, historyMs);                    // Every sample
+ *   Sensor_Stats::Summary s;
+ *   stats.summary(Sensor_Stats::WINDOW_1H, SENSOR_TEMPERATURE, s);
+ *   float p90 = stats.percentile(Sensor_Stats::WINDOW_1H, SENSOR_TEMPERATURE, 0.9f);
+ */
+
+#ifndef SENSOR_STATS_H
+#define SENSOR_STATS_H
+
+#include <Arduino.h>
+#include "Sensor_Pipeline.h"
+
+class Sensor_History;
+
+class Sensor_Stats {
+public:
+  enum Window {
+    WINDOW_1M,
+    WINDOW_1H,
+    WINDOW_24H,
+    WINDOW_COUNT
+  };
+
+  static const uint8_t TOTAL_BUCKETS = 100;   // 12 + 40 + 48 (see WINDOWS in the .cpp)
+  static const uint8_t SLICES = 4;           // Sketch granularity (quarter windows)
+  static const uint8_t BINS = 128;
+  static const uint16_t VERIFY_MAX = 4096;   // Samples per channel for verify()
+
+  /**
+   * @brief Moments of one channel over a window
+   */
+  struct Summary {
+    uint32_t count;
+    float min;
+    float max;
+    float mean;
+    float stddev;          // Population standard deviation
+    uint64_t fromMs;       // Start of the oldest bucket in the window
+  };
+
+  /**
+   * @brief Sketch and moments against values decoded from the history
+   */
+  struct Check {
+    uint32_t count;        // Exact samples in the bucket span
+    int32_t countError;
+    float meanError;       // Moments over the bucket span
+    float stddevError;
+    float minError;
+    float maxError;
+    float pExact[3];       // p50, p90, p99
+    float pSketch[3];
+  };
+
+  Sensor_Stats();
+
+  /**
+   * @brief Add one sample
+   * @param ms Sample time on the history axis (so verify() can compare)
+   */
+  void add(const Sensor_Sample& s, uint64_t ms);
+
+  /**
+   * @brief Moments of a channel over a window
+   * @return false if the window holds no value of the channel
+   */
+  bool summary(Window w, uint8_t ch, Summary& out) const;
+
+  /**
+   * @brief Approximate q-quantile (0..1) from the sketch (NAN if empty)
+   */
+  float percentile(Window w, uint8_t ch, float q) const;
+
+  /**
+   * @brief Start of the span the percentile sketch covers
+   */
+  uint64_t sketchFromMs(Window w) const;
+
+  /**
+   * @brief Compare against exact values decoded from the history
+   * @return false if the window holds no data, more than VERIFY_MAX
+   *         samples or the history does not cover it
+   */
+  bool verify(Window w, uint8_t ch, const Sensor_History& history, Check& out) const;
+
+  static const char* windowName(Window w);
+  static uint32_t windowMs(Window w);
+  static uint32_t bucketMs(Window w);
+
+  // Update cost
+  uint32_t samples() const { return _samples; }
+  uint64_t newestMs() const { return _newestMs; }
+  uint32_t avgAddCycles() const { return _samples ? (uint32_t)(_addCycles / _samples) : 0; }
+  uint32_t maxAddCycles() const { return _maxAddCycles; }
+
+private:
+  /**
+   * @brief One bucket of one channel
+   */
+  struct Bucket {
+    int32_t min;
+    int32_t max;
+    uint32_t count;
+    int32_t sum;
+    int64_t sumSq;
+  };
+
+  /**
+   * @brief Running totals of one channel over its window
+   */
+  struct Totals {
+    uint32_t count;
+    int64_t sum;
+    int64_t sumSq;
+  };
+
+  void advance(uint8_t w, uint32_t bucket);
+  Bucket& bucketAt(uint8_t w, uint32_t bucket, uint8_t ch);
+  const Bucket& bucketAt(uint8_t w, uint32_t bucket, uint8_t ch) const;
+  static uint8_t binOf(uint8_t ch, int32_t q);
+  static float binLow(uint8_t ch, uint8_t bin);
+
+  Bucket _buckets[TOTAL_BUCKETS][SENSOR_CHANNELS];
+  Totals _totals[WINDOW_COUNT][SENSOR_CHANNELS];
+  uint16_t _sketch[WINDOW_COUNT][SENSOR_CHANNELS][SLICES][BINS];
+  uint32_t _head[WINDOW_COUNT];             // Absolute number of the current bucket
+  bool _started;
+
+  uint32_t _samples;
+  uint64_t _firstMs;
+  uint64_t _newestMs;
+  uint64_t _addCycles;
+  uint32_t _maxAddCycles;
+};
+
+#endif // SENSOR_STATS_H
@@ -0,0 +1,192 @@
+/**
+ * @file Stall_Monitor.cpp
+ * @brief Implementation of the loop() stall detector
+ */
+
+#include "Stall_Monitor.h"
+#include <esp_system.h>
+#include <esp_task_wdt.h>
+
+static const uint32_t CONTEXT_MAGIC = 0x4C415453;  // "STAL"
+
+/**
+ * @brief Running job mirrored into RTC memory for the next boot
+ */
+struct StallContext {
+  uint32_t magic;
+  uint32_t uptimeMs;
+  char job[Stall_Monitor::NAME_LEN];
+  char route[Stall_Monitor::ROUTE_LEN];
+  uint32_t checksum;
+};
+
+// Not cleared at reset; validated with magic + checksum
+RTC_NOINIT_ATTR static StallContext s_context;
+
+// Filled by the TWDT interrupt, picked up by iterationEnd()
+static volatile uint32_t s_wdtFires = 0;
+static volatile uint32_t s_wdtAtMs = 0;
+static char s_wdtJob[Stall_Monitor::NAME_LEN];
+static char s_wdtRoute[Stall_Monitor::ROUTE_LEN];
+
+/**
+ * @brief Task watchdog expiry hook (weak in ESP-IDF, runs in the TWDT ISR)
+ *
+ * The watchdog is initialised without panic, so this is the only trace of
+ * an expiry. Copies the context byte by byte; nothing here may touch flash.
+ */
+extern "C" void IRAM_ATTR esp_task_wdt_isr_user_handler(void) {
+  for (size_t i = 0; i < Stall_Monitor::NAME_LEN; i++) s_wdtJob[i] = s_context.job[i];
+  for (size_t i = 0; i < Stall_Monitor::ROUTE_LEN; i++) s_wdtRoute[i] = s_context.route[i];
+  s_wdtJob[Stall_Monitor::NAME_LEN - 1] = '\0';
+  s_wdtRoute[Stall_Monitor::ROUTE_LEN - 1] = '\0';
+  s_wdtAtMs = millis();
+  s_wdtFires = s_wdtFires + 1;
+}
+
+static uint32_t checksum(const StallContext& c) {
+  const uint32_t* w = (const uint32_t*)&c;
+  size_t n = offsetof(StallContext, checksum) / sizeof(uint32_t);
+  uint32_t sum = 0x9E3779B9;
+  for (size_t i = 0; i < n; i++) sum = (sum ^ w[i]) * 16777619u;
+  return sum;
+}
+
+static void copyName(char* dst, const char* src, size_t len) {
+  strncpy(dst, src ? src : "", len - 1);
+  dst[len - 1] = '\0';
+}
+
+Stall_Monitor::Stall_Monitor()
+  : _watchdog(false), _pauses(0), _pauseCount(0), _iterStartUs(0), _iterStartMs(0), _iterations(0), _stalls(0), _lastUs(0),
+    _maxUs(0), _worstJobUs(0), _topCount(0) {
+  memset(_histogram, 0, sizeof(_histogram));
+  _worstJob[0] = _worstRoute[0] = _route[0] = '\0';
+  memset(&_report, 0, sizeof(_report));
+  memset(&_wdt, 0, sizeof(_wdt));
+}
+
+void Stall_Monitor::begin(bool watchdog) {
+  uint32_t reason = (uint32_t)esp_reset_reason();
+  bool abnormal = reason == ESP_RST_TASK_WDT || reason == ESP_RST_INT_WDT ||
+                  reason == ESP_RST_WDT || reason == ESP_RST_PANIC;
+
+  if (abnormal && s_context.magic == CONTEXT_MAGIC && s_context.checksum == checksum(s_context)) {
+    _report.valid = true;
+    _report.resetReason = reason;
+    _report.uptimeMs = s_context.uptimeMs;
+    copyName(_report.job, s_context.job, NAME_LEN);
+    copyName(_report.route, s_context.route, ROUTE_LEN);
+    Serial.printf("⚠ Previous boot reset while running %s %s (uptime %u ms)\n",
+                  _report.job, _report.route, _report.uptimeMs);
+  }
+  memset(&s_context, 0, sizeof(s_context));
+
+  if (watchdog) {
+    // Re-configures the already running task watchdog: longer timeout, report only
+    _watchdog = esp_task_wdt_init(WDT_TIMEOUT_S, false) == ESP_OK &&
+                esp_task_wdt_add(NULL) == ESP_OK;
+    if (!_watchdog) Serial.println("⚠ Task watchdog not available for the loop task");
+  }
+}
+
+void Stall_Monitor::iterationStart() {
+  _iterStartUs = micros();
+  _iterStartMs = millis();
+  _worstJobUs = 0;
+  _worstJob[0] = _worstRoute[0] = '\0';
+}
+
+void Stall_Monitor::pauseWatchdog() {
+  if (_pauses++ == 0 && _watchdog) esp_task_wdt_delete(NULL);
+  _pauseCount++;
+}
+
+void Stall_Monitor::resumeWatchdog() {
+  if (_pauses == 0 || --_pauses > 0 || !_watchdog) return;
+  esp_task_wdt_add(NULL);
+  esp_task_wdt_reset();
+}
+
+void Stall_Monitor::iterationEnd() {
+  if (_watchdog) esp_task_wdt_reset();
+
+  // Fed just now, so the ISR cannot update the report while it is copied
+  if (s_wdtFires != _wdt.count) {
+    _wdt.count = s_wdtFires;
+    _wdt.atMs = s_wdtAtMs;
+    copyName(_wdt.job, s_wdtJob, NAME_LEN);
+    copyName(_wdt.route, s_wdtRoute, ROUTE_LEN);
+    Serial.printf("⚠ Task watchdog expired at %u ms in %s %s\n", _wdt.atMs, _wdt.job, _wdt.route);
+  }
+
+  uint32_t us = micros() - _iterStartUs;
+  _iterations++;
+  _lastUs = us;
+  if (us > _maxUs) _maxUs = us;
+
+  uint32_t ms = us / 1000;
+  uint8_t b = ms < 1 ? 0 : ms < 10 ? 1 : ms < 50 ? 2 : ms < 250 ? 3 : ms < 1000 ? 4 : 5;
+  _histogram[b]++;
+
+  if (us >= STALL_US) {
+    _stalls++;
+    record();
+  }
+}
+
+void Stall_Monitor::record() {
+  // Insert into the top list (sorted, longest first) if long enough
+  uint8_t pos = _topCount;
+  while (pos > 0 && _top[pos - 1].us < _lastUs) pos--;
+  if (pos >= TOP_N) return;
+
+  uint8_t last = _topCount < TOP_N ? _topCount : TOP_N - 1;
+  for (uint8_t i = last; i > pos; i--) _top[i] = _top[i - 1];
+  if (_topCount < TOP_N) _topCount++;
+
+  Stall& s = _top[pos];
+  s.atMs = _iterStartMs;
+  s.us = _lastUs;
+  s.jobUs = _worstJobUs;
+  copyName(s.job, _worstJob[0] ? _worstJob : "loop", NAME_LEN);
+  copyName(s.route, _worstRoute, ROUTE_LEN);
+
+  Serial.printf("⚠ Loop stall: %u ms in %s %s\n", _lastUs / 1000, s.job, s.route);
+}
+
+void Stall_Monitor::jobStart(const char* name) {
+  _route[0] = '\0';
+
+  // Cheap enough for every job run; read back by begin() after a watchdog reset
+  s_context.magic = CONTEXT_MAGIC;
+  s_context.uptimeMs = millis();
+  copyName(s_context.job, name, NAME_LEN);
+  s_context.route[0] = '\0';
+  s_context.checksum = checksum(s_context);
+}
+
+void Stall_Monitor::jobEnd(const char* name, uint32_t us) {
+  if (us > _worstJobUs) {
+    _worstJobUs = us;
+    copyName(_worstJob, name, NAME_LEN);
+    copyName(_worstRoute, _route, ROUTE_LEN);
+  }
+}
+
+void Stall_Monitor::setRoute(const char* uri) {
+  copyName(_route, uri, ROUTE_LEN);
+  copyName(s_context.route, uri, ROUTE_LEN);
+  s_context.checksum = checksum(s_context);
+}
+
+const char* Stall_Monitor::bucketName(uint8_t i) {
+  switch (i) {
+    case 0:  return "lt1ms";
+    case 1:  return "lt10ms";
+    case 2:  return "lt50ms";
+    case 3:  return "lt250ms";
+    case 4:  return "lt1s";
+    default: return "ge1s";
+  }
+}
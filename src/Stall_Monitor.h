@@ -0,0 +1,170 @@
+/**
+ * @file Stall_Monitor.h
+ * @brief loop() stall detector, blocking-call attribution and task watchdog
+ * @version 1.0.0
+ *
+ * @details
+ * Measures every loop() iteration and attributes long ones to the
+ * scheduler job (and, for the HTTP job, the route) that ran longest in
+ * that iteration. Iterations of STALL_US or more are stalls; the TOP_N
+ * worst are kept with the uptime at which they started.
+ *
+ * Attribution:
+ * - jobStart()/jobEnd() are called by the scheduler's run hook.
+ * - setRoute() is called with the route label before the route handler
+ *   runs, so a handler blocking in delay() or a modem read is named.
+ *
+ * Task watchdog (report-only):
+ *   begin() subscribes the loop task to the ESP32 task watchdog with
+ *   WDT_TIMEOUT_S and iterationEnd() feeds it. Expiry does not reset the
+ *   chip: the TWDT interrupt copies the running job and route into a
+ *   watchdog report, which iterationEnd() logs once the loop moves again.
+ *   Calls that legitimately block longer than the timeout (an SMTP session
+ *   over the modem takes up to ~90 s) hold a Pause, which unsubscribes the
+ *   loop task for their duration.
+ *
+ *   The running job and route are also mirrored into RTC_NOINIT memory at
+ *   every job start, so after a panic or interrupt-watchdog reset the next
+ *   boot reports what was running instead of resetting without a trace.
+ *
+ * Usage:
+ *   Stall_Monitor stalls;
+ *   stalls.begin(true);
+ *   // in loop():
+ *   stalls.iterationStart();
+ *   scheduler.loop();
+ *   stalls.iterationEnd();
+ *   // around a call that may block for minutes:
+ *   { Stall_Monitor::Pause pause(stalls); smtp.sendEmail(); }
+ */
+
+#ifndef STALL_MONITOR_H
+#define STALL_MONITOR_H
+
+#include <Arduino.h>
+
+class Stall_Monitor {
+public:
+  static const uint8_t TOP_N = 8;                 // Worst stalls kept
+  static const uint32_t STALL_US = 50000;         // Iteration counted as a stall (50 ms)
+  static const uint32_t WDT_TIMEOUT_S = 30;       // Report-only; longer calls hold a Pause
+  static const uint8_t HISTOGRAM_BUCKETS = 6;     // <1, <10, <50, <250, <1000, >=1000 ms
+  static const size_t NAME_LEN = 16;
+  static const size_t ROUTE_LEN = 40;
+
+  /**
+   * @brief One long loop() iteration
+   */
+  struct Stall {
+    uint32_t atMs;            // Uptime when the iteration started
+    uint32_t us;              // Iteration duration
+    uint32_t jobUs;           // Time spent in the job it is attributed to
+    char job[NAME_LEN];       // Longest-running job of the iteration
+    char route[ROUTE_LEN];    // Request URI if the job handled one
+  };
+
+  /**
+   * @brief What was running when the previous boot ended abnormally
+   */
+  struct ResetReport {
+    bool valid;
+    uint32_t resetReason;     // esp_reset_reason() of this boot
+    uint32_t uptimeMs;        // Previous boot's uptime when the job started
+    char job[NAME_LEN];
+    char route[ROUTE_LEN];
+  };
+
+  /**
+   * @brief Time the watchdog has fired without the loop being fed
+   */
+  struct WatchdogReport {
+    uint32_t count;           // Expiries since boot
+    uint32_t atMs;            // Uptime of the last expiry
+    char job[NAME_LEN];       // Job running at the last expiry
+    char route[ROUTE_LEN];
+  };
+
+  /**
+   * @brief Scoped watchdog exemption for a known long blocking call (nestable)
+   */
+  class Pause {
+  public:
+    explicit Pause(Stall_Monitor& monitor) : _monitor(monitor) { _monitor.pauseWatchdog(); }
+    ~Pause() { _monitor.resumeWatchdog(); }
+  private:
+    Pause(const Pause&);
+    Pause& operator=(const Pause&);
+    Stall_Monitor& _monitor;
+  };
+
+  Stall_Monitor();
+
+  /**
+   * @brief Read the previous boot's context and arm the task watchdog
+   * @param watchdog Subscribe the calling (loop) task to the task watchdog
+   */
+  void begin(bool watchdog);
+
+  void iterationStart();
+  void iterationEnd();
+
+  /**
+   * @brief Scheduler run hook: a job starts / has finished
+   */
+  void jobStart(const char* name);
+  void jobEnd(const char* name, uint32_t us);
+
+  /**
+   * @brief Name the route the running job is handling
+   */
+  void setRoute(const char* uri);
+  const char* route() const { return _route; }  // Route of the running job ("" if none)
+
+  // Iteration statistics
+  uint32_t iterations() const { return _iterations; }
+  uint32_t stallCount() const { return _stalls; }
+  uint32_t maxIterationUs() const { return _maxUs; }
+  uint32_t lastIterationUs() const { return _lastUs; }
+  uint32_t bucket(uint8_t i) const { return _histogram[i]; }
+  static const char* bucketName(uint8_t i);
+
+  // Worst stalls, longest first
+  uint8_t topCount() const { return _topCount; }
+  const Stall& top(uint8_t i) const { return _top[i]; }
+
+  // Watchdog
+  void pauseWatchdog();
+  void resumeWatchdog();
+  bool watchdogEnabled() const { return _watchdog; }
+  bool watchdogPaused() const { return _pauses > 0; }
+  uint32_t watchdogPauses() const { return _pauseCount; }
+  const WatchdogReport& watchdogReport() const { return _wdt; }
+  const ResetReport& resetReport() const { return _report; }
+
+private:
+  void record();
+
+  bool _watchdog;
+  uint8_t _pauses;              // Nesting depth of active Pauses
+  uint32_t _pauseCount;
+  WatchdogReport _wdt;
+  uint32_t _iterStartUs;
+  uint32_t _iterStartMs;
+  uint32_t _iterations;
+  uint32_t _stalls;
+  uint32_t _lastUs;
+  uint32_t _maxUs;
+  uint32_t _histogram[HISTOGRAM_BUCKETS];
+
+  // Longest job of the current iteration
+  uint32_t _worstJobUs;
+  char _worstJob[NAME_LEN];
+  char _worstRoute[ROUTE_LEN];
+  char _route[ROUTE_LEN];       // Route of the running job
+
+  Stall _top[TOP_N];
+  uint8_t _topCount;
+  ResetReport _report;
+};
+
+#endif // STALL_MONITOR_H
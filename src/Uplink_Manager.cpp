@@ -0,0 +1,461 @@
+/**
+ * @file Uplink_Manager.cpp
+ * @brief Implementation of the WiFi/GSM uplink failover manager
+ */
+
+#include "Uplink_Manager.h"
+#include <WiFiClientSecure.h>
+#include <lwip/sockets.h>
+
+#define CRLF "\r\n"
+
+static const uint8_t PROBE_IP[4] = { 8, 8, 8, 8 };  // Public resolver, answers TCP/53
+static const int GSM_LINK_ID = 1;                    // SMTP uses link 0
+
+Uplink_Manager::Uplink_Manager(HardwareSerial& modem)
+  : _modem(modem), _gsmEnabled(false), _staConfigured(false), _portHolds(0),
+    _active(LINK_NONE), _linkSince(0), _timeOn(), _wifiDownAt(0),
+    _failovers(0), _failbacks(0), _lastFailoverMs(0), _maxFailoverMs(0),
+    _wifiHealthy(false), _wifiWasHealthy(false), _wifiAssociated(false), _probeSock(-1), _probeStart(0),
+    _lastProbeDone(0), _lastRtt(-1), _failStreak(0), _okStreak(0), _probeFailures(0),
+    _gsmState(GSM_OFF), _gsmStateAt(0), _gsmLastCheck(0),
+    _bytes(), _sendFailures(0) {
+}
+
+void Uplink_Manager::begin(const String& apn, bool gsmEnabled) {
+  _apn = apn;
+  _gsmEnabled = gsmEnabled;
+  _linkSince = millis();
+  _wifiDownAt = _linkSince;  // Boot counts as "no uplink yet"
+  _rx.reserve(128);
+}
+
+void Uplink_Manager::setStaConfigured(bool configured) {
+  _staConfigured = configured;
+  if (!configured) _wifiWasHealthy = false;
+}
+
+void Uplink_Manager::loop() {
+  unsigned long now = millis();
+  pollWifi(now);
+  if (_gsmEnabled && !_portHolds) pollGsm(now);
+  selectLink(now);
+}
+
+void Uplink_Manager::acquirePort() {
+  if (_portHolds++ == 0) _rx = "";
+}
+
+void Uplink_Manager::releasePort() {
+  if (_portHolds == 0 || --_portHolds > 0) return;
+  // Replies to our last command (or an unsolicited PDP drop) may have been
+  // consumed by the lock holder, which may also have opened or closed the
+  // PDP itself: ask the modem instead of trusting the state we had
+  if (_gsmEnabled && _gsmState != GSM_OFF && _gsmState != GSM_BACKOFF) {
+    gsmCommand("AT+NETOPEN?", GSM_CHECKING, millis());
+  }
+}
+
+// ============================================================================
+// WIFI HEALTH PROBE
+// ============================================================================
+
+void Uplink_Manager::pollWifi(unsigned long now) {
+  bool associated = (WiFi.status() == WL_CONNECTED);
+
+  if (!associated) {
+    if (_wifiAssociated || _wifiHealthy) {
+      Serial.println(" Uplink: WiFi link lost");
+      if (!_wifiDownAt) _wifiDownAt = now;
+    }
+    _wifiAssociated = false;
+    _wifiHealthy = false;
+    _okStreak = 0;
+    closeProbe();
+    return;
+  }
+
+  if (!_wifiAssociated) {
+    // Just (re)associated: probe right away instead of waiting a period
+    _wifiAssociated = true;
+    _lastProbeDone = 0;
+  }
+
+  if (_probeSock >= 0) {
+    fd_set wfds;
+    FD_ZERO(&wfds);
+    FD_SET(_probeSock, &wfds);
+    struct timeval tv = { 0, 0 };
+    if (select(_probeSock + 1, nullptr, &wfds, nullptr, &tv) > 0) {
+      int err = 0;
+      socklen_t len = sizeof(err);
+      getsockopt(_probeSock, SOL_SOCKET, SO_ERROR, &err, &len);
+      finishProbe(err == 0, now);
+    } else if (now - _probeStart > PROBE_TIMEOUT) {
+      finishProbe(false, now);
+    }
+    return;
+  }
+
+  unsigned long interval = _wifiHealthy ? PROBE_INTERVAL : PROBE_INTERVAL_DOWN;
+  if (_lastProbeDone == 0 || now - _lastProbeDone >= interval) {
+    startProbe(now);
+  }
+}
+
+void Uplink_Manager::startProbe(unsigned long now) {
+  _probeStart = now;
+
+  int s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (s < 0) {
+    finishProbe(false, now);
+    return;
+  }
+  fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(PROBE_PORT);
+  memcpy(&addr.sin_addr.s_addr, PROBE_IP, 4);
+
+  _probeSock = s;
+  if (connect(s, (struct sockaddr*)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS) {
+    finishProbe(false, now);
+  }
+}
+
+void Uplink_Manager::closeProbe() {
+  if (_probeSock >= 0) {
+    close(_probeSock);
+    _probeSock = -1;
+  }
+}
+
+void Uplink_Manager::finishProbe(bool ok, unsigned long now) {
+  closeProbe();
+  _lastProbeDone = now;
+
+  if (ok) {
+    _lastRtt = now - _probeStart;
+    _failStreak = 0;
+    if (_okStreak < 255) _okStreak++;
+
+    // Leaving GSM needs a stable WiFi; otherwise one good probe is enough
+    uint8_t needed = (_active == LINK_GSM) ? FAILBACK_PROBES : 1;
+    if (!_wifiHealthy && _okStreak >= needed) {
+      _wifiHealthy = true;
+      _wifiWasHealthy = _staConfigured;
+      _wifiDownAt = 0;
+      Serial.printf(" Uplink: WiFi healthy (probe %ld ms)\n", _lastRtt);
+    }
+  } else {
+    _lastRtt = -1;
+    _okStreak = 0;
+    _probeFailures++;
+    if (_failStreak < 255) _failStreak++;
+
+    if (_wifiHealthy) {
+      if (_failStreak == 1) _wifiDownAt = _probeStart;
+      if (_failStreak >= FAIL_THRESHOLD) {
+        _wifiHealthy = false;
+        Serial.println(" Uplink: WiFi associated but unreachable");
+      }
+    }
+  }
+}
+
+// ============================================================================
+// GSM PDP STATE MACHINE
+// ============================================================================
+
+void Uplink_Manager::gsmSetState(GsmState state, unsigned long now) {
+  _gsmState = state;
+  _gsmStateAt = now;
+}
+
+void Uplink_Manager::gsmCommand(const char* cmd, GsmState next, unsigned long now) {
+  while (_modem.available()) _modem.read();  // Drop stale output
+  _rx = "";
+  _modem.print(cmd);
+  _modem.print(CRLF);
+  gsmSetState(next, now);
+}
+
+void Uplink_Manager::pollGsm(unsigned long now) {
+  // Collect complete response lines
+  while (_modem.available()) {
+    char c = _modem.read();
+    if (c == '\n') {
+      _rx.trim();
+      if (_rx.length()) gsmLine(_rx, now);
+      _rx = "";
+    } else if (c != '\r' && _rx.length() < 128) {
+      _rx += c;
+    }
+  }
+
+  // Only a configured STA that worked before and has now failed warrants
+  // the PDP; without STA there is no failover, just an idle modem
+  bool wanted = _staConfigured && _wifiWasHealthy && !_wifiHealthy;
+
+  switch (_gsmState) {
+    case GSM_OFF:
+      if (wanted) {
+        Serial.println(" Uplink: opening GSM data connection");
+        if (_apn.length()) {
+          String cmd = "AT+CGDCONT=1,\"IP\",\"" + _apn + "\"";
+          gsmCommand(cmd.c_str(), GSM_CONFIG, now);
+        } else {
+          gsmCommand("AT+NETOPEN", GSM_OPENING, now);
+        }
+      }
+      break;
+
+    case GSM_CONFIG:
+      // OK/ERROR handled in gsmLine(); an unanswered CGDCONT is not fatal
+      if (now - _gsmStateAt > GSM_CMD_TIMEOUT) gsmCommand("AT+NETOPEN", GSM_OPENING, now);
+      break;
+
+    case GSM_OPENING:
+      if (now - _gsmStateAt > GSM_OPEN_TIMEOUT) {
+        Serial.println(" Uplink: AT+NETOPEN timed out");
+        gsmSetState(GSM_BACKOFF, now);
+      }
+      break;
+
+    case GSM_UP:
+      if (!wanted) {
+        gsmCommand("AT+NETCLOSE", GSM_CLOSING, now);
+      } else if (now - _gsmLastCheck >= GSM_PROBE_INTERVAL) {
+        _gsmLastCheck = now;
+        gsmCommand("AT+NETOPEN?", GSM_CHECKING, now);
+      }
+      break;
+
+    case GSM_CHECKING:
+      if (now - _gsmStateAt > GSM_CMD_TIMEOUT) {
+        Serial.println(" Uplink: GSM check unanswered");
+        gsmSetState(GSM_OFF, now);
+      }
+      break;
+
+    case GSM_CLOSING:
+      if (now - _gsmStateAt > GSM_CMD_TIMEOUT) gsmSetState(GSM_OFF, now);
+      break;
+
+    case GSM_BACKOFF:
+      if (now - _gsmStateAt > GSM_RETRY_DELAY) gsmSetState(GSM_OFF, now);
+      break;
+  }
+}
+
+void Uplink_Manager::gsmLine(const String& line, unsigned long now) {
+  // Unsolicited: PDP dropped by the network
+  if (line.indexOf("NETWORK CLOSED UNEXPECTEDLY") >= 0 && _gsmState == GSM_UP) {
+    Serial.println(" Uplink: GSM data connection dropped");
+    gsmSetState(GSM_OFF, now);
+    return;
+  }
+
+  switch (_gsmState) {
+    case GSM_CONFIG:
+      if (line == "OK" || line.indexOf("ERROR") >= 0) gsmCommand("AT+NETOPEN", GSM_OPENING, now);
+      break;
+
+    case GSM_OPENING:
+      // +NETOPEN: <err> (0 = success); "already opened" counts as success
+      if (line.startsWith("+NETOPEN:")) {
+        if (line.endsWith(" 0")) {
+          _gsmLastCheck = now;
+          gsmSetState(GSM_UP, now);
+          Serial.printf(" Uplink: GSM data up in %lu ms\n", now - _gsmStateAt);
+        } else {
+          Serial.printf(" Uplink: GSM open failed (%s)\n", line.c_str());
+          gsmSetState(GSM_BACKOFF, now);
+        }
+      } else if (line.indexOf("already opened") >= 0) {
+        _gsmLastCheck = now;
+        gsmSetState(GSM_UP, now);
+      }
+      break;
+
+    case GSM_CHECKING:
+      // +NETOPEN: <state> (1 = opened)
+      if (line.startsWith("+NETOPEN:")) {
+        if (line.endsWith(" 1")) {
+          gsmSetState(GSM_UP, now);
+        } else {
+          Serial.println(" Uplink: GSM data connection closed");
+          gsmSetState(GSM_OFF, now);
+        }
+      }
+      break;
+
+    case GSM_CLOSING:
+      if (line.startsWith("+NETCLOSE") || line.indexOf("ERROR") >= 0) gsmSetState(GSM_OFF, now);
+      break;
+
+    default:
+      break;
+  }
+}
+
+// ============================================================================
+// LINK SELECTION
+// ============================================================================
+
+void Uplink_Manager::selectLink(unsigned long now) {
+  Link want = LINK_NONE;
+  if (_wifiHealthy) {
+    want = LINK_WIFI;
+  } else if (_gsmEnabled && (_gsmState == GSM_UP || _gsmState == GSM_CHECKING)) {
+    want = LINK_GSM;
+  }
+  if (want != _active) switchTo(want, now);
+}
+
+void Uplink_Manager::switchTo(Link link, unsigned long now) {
+  _timeOn[_active] += now - _linkSince;
+  Link prev = _active;
+  _active = link;
+  _linkSince = now;
+
+  if (link == LINK_GSM) {
+    unsigned long took = _wifiDownAt ? now - _wifiDownAt : 0;
+    _failovers++;
+    _lastFailoverMs = took;
+    if (took > _maxFailoverMs) _maxFailoverMs = took;
+    Serial.printf(" Uplink: failover to GSM in %lu ms\n", took);
+  } else if (link == LINK_WIFI && prev == LINK_GSM) {
+    _failbacks++;
+    Serial.println(" Uplink: failback to WiFi");
+  } else {
+    Serial.printf(" Uplink: %s -> %s\n", linkName(prev), linkName(link));
+  }
+}
+
+unsigned long Uplink_Manager::timeOnLinkMs(Link link) const {
+  unsigned long t = _timeOn[link];
+  if (link == _active) t += millis() - _linkSince;
+  return t;
+}
+
+// ============================================================================
+// SEND
+// ============================================================================
+
+template <class C>
+static size_t connectAndWrite(C& client, const char* host, uint16_t port,
+                              const uint8_t* data, size_t len, int32_t timeout) {
+  if (!client.connect(host, port, timeout)) return 0;
+  size_t written = client.write(data, len);
+  client.flush();
+  client.stop();
+  return written;
+}
+
+bool Uplink_Manager::send(const char* host, uint16_t port, const uint8_t* data, size_t len, bool tls) {
+  Link link = _active;
+  bool ok = false;
+
+  if (link == LINK_WIFI) {
+    ok = sendWifi(host, port, data, len, tls);
+    if (!ok) _lastProbeDone = 0;  // Re-check WiFi on the next loop()
+  } else if (link == LINK_GSM) {
+    PortLock lock(*this);
+    ok = sendGsm(host, port, data, len, tls);
+  }
+
+  if (ok) {
+    _bytes[link] += len;
+  } else {
+    _sendFailures++;
+    Serial.printf(" Uplink: send to %s:%u failed (%s)\n", host, port, linkName(link));
+  }
+  return ok;
+}
+
+bool Uplink_Manager::sendWifi(const char* host, uint16_t port, const uint8_t* data, size_t len, bool tls) {
+  if (tls) {
+    WiFiClientSecure client;
+    client.setInsecure();  // Same trust model as the modem TLS stack (authmode 0)
+    return connectAndWrite(client, host, port, data, len, SEND_TIMEOUT) == len;
+  }
+  WiFiClient client;
+  return connectAndWrite(client, host, port, data, len, SEND_TIMEOUT) == len;
+}
+
+bool Uplink_Manager::waitFor(const char* expect, const char* fail, uint32_t ms) {
+  String buf;
+  uint32_t t0 = millis();
+  while (millis() - t0 < ms) {
+    while (_modem.available()) {
+      buf += (char)_modem.read();
+      if (buf.indexOf(expect) >= 0) return true;
+      if (fail && buf.indexOf(fail) >= 0) return false;
+    }
+    yield();
+  }
+  return false;
+}
+
+bool Uplink_Manager::at(const String& cmd, const char* expect, uint32_t ms) {
+  while (_modem.available()) _modem.read();
+  _modem.print(cmd);
+  _modem.print(CRLF);
+  return waitFor(expect, "ERROR", ms);
+}
+
+bool Uplink_Manager::sendGsm(const char* host, uint16_t port, const uint8_t* data, size_t len, bool tls) {
+  // Called with the port held: loop() is not reading Serial2 meanwhile
+  String link(GSM_LINK_ID);
+  bool ok = false;
+
+  if (tls) {
+    at("AT+CSSLCFG=\"sslversion\",0,3", "OK", GSM_CMD_TIMEOUT);
+    at("AT+CSSLCFG=\"authmode\",0,0", "OK", GSM_CMD_TIMEOUT);
+    at("AT+CCHSTART", "OK", GSM_CMD_TIMEOUT);
+    if (at("AT+CCHOPEN=" + link + ",\"" + host + "\"," + port, ("+CCHOPEN: " + link + ",0").c_str(), SEND_TIMEOUT) &&
+        at("AT+CCHSEND=" + link + "," + String((unsigned)len), ">", SEND_TIMEOUT)) {
+      _modem.write(data, len);
+      ok = waitFor("OK", "ERROR", SEND_TIMEOUT);
+    }
+    at("AT+CCHCLOSE=" + link, "OK", GSM_CMD_TIMEOUT);
+    at("AT+CCHSTOP", "OK", GSM_CMD_TIMEOUT);
+  } else {
+    if (at("AT+CIPOPEN=" + link + ",\"TCP\",\"" + host + "\"," + port, ("+CIPOPEN: " + link + ",0").c_str(), SEND_TIMEOUT) &&
+        at("AT+CIPSEND=" + link + "," + String((unsigned)len), ">", SEND_TIMEOUT)) {
+      _modem.write(data, len);
+      ok = waitFor("+CIPSEND:", "ERROR", SEND_TIMEOUT);
+    }
+    at("AT+CIPCLOSE=" + link, "+CIPCLOSE", GSM_CMD_TIMEOUT);
+  }
+  return ok;
+}
+
+// ============================================================================
+// NAMES
+// ============================================================================
+
+const char* Uplink_Manager::linkName(Link link) {
+  switch (link) {
+    case LINK_NONE: return "none";
+    case LINK_WIFI: return "wifi";
+    case LINK_GSM:  return "gsm";
+  }
+  return "unknown";
+}
+
+const char* Uplink_Manager::gsmStateName(GsmState state) {
+  switch (state) {
+    case GSM_OFF:      return "off";
+    case GSM_CONFIG:   return "config";
+    case GSM_OPENING:  return "opening";
+    case GSM_UP:       return "up";
+    case GSM_CHECKING: return "checking";
+    case GSM_CLOSING:  return "closing";
+    case GSM_BACKOFF:  return "backoff";
+  }
+  return "unknown";
+}
@@ -0,0 +1,236 @@
+/**
+ * @file Uplink_Manager.h
+ * @brief WiFi STA / GSM PDP uplink selection with health probes and failover
+ * @version 1.0.0
+ *
+ * @details
+ * Keeps track of which link upstream traffic should use and gives
+ * notification/telemetry code a single send() call that works on either
+ * link (alert "post" notifications use it). GSM email goes out through
+ * SMTP (modem CCH stack), which reads activeLink() to decide whether the
+ * PDP must stay up.
+ *
+ * WiFi health:
+ * - Link loss (WiFi.status() != WL_CONNECTED) marks WiFi down at once.
+ * - While associated, a non-blocking TCP connect to PROBE_IP:PROBE_PORT is
+ *   started every PROBE_INTERVAL and polled from loop(); FAIL_THRESHOLD
+ *   failed probes in a row mark WiFi down (associated but no internet).
+ *
+ * GSM link:
+ * - Opened only while a configured STA that has been healthy before is
+ *   down (AT+CGDCONT, AT+NETOPEN), checked every GSM_PROBE_INTERVAL with
+ *   AT+NETOPEN? and closed again on failback. A device without STA, or
+ *   whose STA never came up, does not hold a PDP open.
+ * - Modem responses are read line by line from loop(). Serial2 is shared
+ *   with the blocking AT code in GSM_Test, SMTP and send() on the GSM
+ *   path, which hold a PortLock
+ *   for the exchange; loop() leaves the port alone meanwhile and re-checks
+ *   the PDP state with AT+NETOPEN? once the lock is released.
+ *
+ * Failback to WiFi needs FAILBACK_PROBES successful probes in a row so a
+ * flapping AP does not bounce traffic between links.
+ *
+ * Metrics: failover/failback counts, failover time (WiFi declared down
+ * until GSM carries traffic), time spent on each link and bytes sent.
+ *
+ * Usage:
+ *   Uplink_Manager uplink(Serial2);
+ *   uplink.begin("internet", true);
+ *   // in loop():
+ *   uplink.loop();
+ *   // anywhere in the loop task:
+ *   uplink.send("example.com", 80, data, len);
+ *   // around a blocking AT exchange:
+ *   { Uplink_Manager::PortLock lock(uplink); gsmModem.sendSMS(to, text); }
+ */
+
+#ifndef UPLINK_MANAGER_H
+#define UPLINK_MANAGER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+class Uplink_Manager {
+public:
+  /**
+   * @brief Link carrying upstream traffic
+   */
+  enum Link {
+    LINK_NONE,
+    LINK_WIFI,
+    LINK_GSM
+  };
+
+  /**
+   * @brief GSM data connection states
+   */
+  enum GsmState {
+    GSM_OFF,        // PDP closed (WiFi is healthy or GSM disabled)
+    GSM_CONFIG,     // AT+CGDCONT sent
+    GSM_OPENING,    // AT+NETOPEN sent, waiting for +NETOPEN
+    GSM_UP,         // PDP open
+    GSM_CHECKING,   // AT+NETOPEN? sent while up
+    GSM_CLOSING,    // AT+NETCLOSE sent
+    GSM_BACKOFF     // Open failed, waiting before retry
+  };
+
+  static const uint16_t PROBE_PORT = 53;                  // TCP DNS on PROBE_IP
+  static const unsigned long PROBE_INTERVAL = 10000;      // WiFi probe period while healthy (ms)
+  static const unsigned long PROBE_INTERVAL_DOWN = 3000;  // WiFi probe period while down (ms)
+  static const unsigned long PROBE_TIMEOUT = 3000;        // TCP connect timeout (ms)
+  static const uint8_t FAIL_THRESHOLD = 2;                // Failed probes before WiFi is down
+  static const uint8_t FAILBACK_PROBES = 3;               // Good probes before leaving GSM
+  static const unsigned long GSM_PROBE_INTERVAL = 30000;  // AT+NETOPEN? period while up (ms)
+  static const unsigned long GSM_CMD_TIMEOUT = 3000;      // Short AT command timeout (ms)
+  static const unsigned long GSM_OPEN_TIMEOUT = 30000;    // AT+NETOPEN timeout (ms)
+  static const unsigned long GSM_RETRY_DELAY = 15000;     // Backoff after a failed open (ms)
+  static const unsigned long SEND_TIMEOUT = 10000;        // Connect/send timeout in send() (ms)
+
+  /**
+   * @brief Scoped ownership of the modem port for a blocking AT exchange
+   */
+  class PortLock {
+  public:
+    explicit PortLock(Uplink_Manager& uplink) : _uplink(uplink) { _uplink.acquirePort(); }
+    ~PortLock() { _uplink.releasePort(); }
+  private:
+    PortLock(const PortLock&);
+    PortLock& operator=(const PortLock&);
+    Uplink_Manager& _uplink;
+  };
+
+  Uplink_Manager(HardwareSerial& modem);
+
+  /**
+   * @brief Configure APN and whether GSM may be used as fallback
+   * @param apn Access Point Name (empty = modem default)
+   * @param gsmEnabled false keeps the manager WiFi-only (e.g. email mode)
+   */
+  void begin(const String& apn, bool gsmEnabled);
+
+  /**
+   * @brief Update the APN used for the next PDP open
+   */
+  void setApn(const String& apn) { _apn = apn; }
+
+  /**
+   * @brief Allow GSM fallback (e.g. once the modem bring-up has finished)
+   */
+  void setGsmEnabled(bool enabled) { _gsmEnabled = enabled; }
+
+  /**
+   * @brief Tell the manager whether STA credentials are configured
+   *
+   * Failover needs a configured STA that has been healthy at least once;
+   * clearing the credentials also forgets that it was.
+   */
+  void setStaConfigured(bool configured);
+
+  /**
+   * @brief Take / give back Serial2 (nestable); prefer PortLock
+   */
+  void acquirePort();
+  void releasePort();
+  bool portHeld() const { return _portHolds > 0; }
+
+  /**
+   * @brief Run probes, GSM state machine and link selection; never blocks
+   */
+  void loop();
+
+  /**
+   * @brief Send bytes upstream over the active link
+   * @param host Server hostname or IP
+   * @param port Server port
+   * @param data Bytes to send
+   * @param len Number of bytes
+   * @param tls Use TLS (WiFiClientSecure / modem CCH stack)
+   * @return true if the server accepted all bytes
+   *
+   * Opens a connection, writes the payload and closes it; replies are not
+   * read. Returns false without blocking when no link is up. Blocks for up
+   * to a few SEND_TIMEOUTs otherwise, so call it from a scheduler job.
+   */
+  bool send(const char* host, uint16_t port, const uint8_t* data, size_t len, bool tls = false);
+
+  // State
+  Link activeLink() const { return _active; }
+  GsmState gsmState() const { return _gsmState; }
+  bool isUp() const { return _active != LINK_NONE; }
+  bool wifiHealthy() const { return _wifiHealthy; }
+  unsigned long activeSinceMs() const { return millis() - _linkSince; }
+  long lastProbeRttMs() const { return _lastRtt; }            // -1 if last probe failed
+  unsigned long lastProbeAgoMs() const { return _lastProbeDone ? millis() - _lastProbeDone : 0; }
+
+  // Metrics
+  uint32_t failoverCount() const { return _failovers; }
+  uint32_t failbackCount() const { return _failbacks; }
+  unsigned long lastFailoverMs() const { return _lastFailoverMs; }
+  unsigned long maxFailoverMs() const { return _maxFailoverMs; }
+  unsigned long timeOnLinkMs(Link link) const;
+  uint32_t probeFailures() const { return _probeFailures; }
+  uint32_t bytesSent(Link link) const { return _bytes[link]; }
+  uint32_t sendFailures() const { return _sendFailures; }
+
+  static const char* linkName(Link link);
+  static const char* gsmStateName(GsmState state);
+
+private:
+  void pollWifi(unsigned long now);
+  void startProbe(unsigned long now);
+  void finishProbe(bool ok, unsigned long now);
+  void closeProbe();
+
+  void pollGsm(unsigned long now);
+  void gsmCommand(const char* cmd, GsmState next, unsigned long now);
+  void gsmLine(const String& line, unsigned long now);
+  void gsmSetState(GsmState state, unsigned long now);
+
+  void selectLink(unsigned long now);
+  void switchTo(Link link, unsigned long now);
+
+  bool sendWifi(const char* host, uint16_t port, const uint8_t* data, size_t len, bool tls);
+  bool sendGsm(const char* host, uint16_t port, const uint8_t* data, size_t len, bool tls);
+  bool at(const String& cmd, const char* expect, uint32_t ms);
+  bool waitFor(const char* expect, const char* fail, uint32_t ms);
+
+  HardwareSerial& _modem;
+  String _apn;
+  bool _gsmEnabled;
+  bool _staConfigured;
+  uint8_t _portHolds;             // Nested PortLocks held by blocking AT code
+
+  // Link selection
+  Link _active;
+  unsigned long _linkSince;
+  unsigned long _timeOn[3];
+  unsigned long _wifiDownAt;      // When WiFi trouble was first seen (0 = healthy)
+  uint32_t _failovers;
+  uint32_t _failbacks;
+  unsigned long _lastFailoverMs;
+  unsigned long _maxFailoverMs;
+
+  // WiFi probe
+  bool _wifiHealthy;
+  bool _wifiWasHealthy;           // STA has reached the internet since configured
+  bool _wifiAssociated;
+  int _probeSock;
+  unsigned long _probeStart;
+  unsigned long _lastProbeDone;
+  long _lastRtt;
+  uint8_t _failStreak;
+  uint8_t _okStreak;
+  uint32_t _probeFailures;
+
+  // GSM state machine
+  GsmState _gsmState;
+  unsigned long _gsmStateAt;
+  unsigned long _gsmLastCheck;
+  String _rx;
+
+  // Traffic
+  uint32_t _bytes[3];
+  uint32_t _sendFailures;
+};
+
+#endif // UPLINK_MANAGER_H
@@ -0,0 +1,297 @@
+/**
+ * @file WiFi_Manager.cpp
+ * @brief Implementation of the event-driven WiFi station connection manager
+ *
+ * @details
+ * WiFi events arrive on the ESP32 event task, so the handler only latches
+ * flags and the disconnect reason. All state transitions, WiFi.begin()
+ * calls and callbacks happen from loop() on the Arduino task.
+ */
+
+#include "WiFi_Manager.h"
+
+WiFi_Manager::WiFi_Manager()
+  : _gotIp(false), _disconnected(false), _eventReason(0),
+    _phase(PHASE_IDLE), _attempt(0), _maxAttempts(MAX_ATTEMPTS), _hints(), _hasHints(false),
+    _fastAttempt(false), _fastConnected(false), _staticIp(false),
+    _roaming(false), _leavePending(false), _stopAfterDisconnect(false), _connectedAt(0), _lastReason(0),
+    _requestStart(0), _phaseStart(0), _requestEnd(0),
+    _lastLoop(0), _maxLoopGap(0), _handlerUs(0), _onConnected(nullptr) {
+}
+
+void WiFi_Manager::begin() {
+  WiFi.onEvent([this](WiFiEvent_t event, WiFiEventInfo_t info) {
+    handleEvent(event, info);
+  });
+}
+
+void WiFi_Manager::handleEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
+  switch (event) {
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+      _gotIp = true;
+      break;
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+      _eventReason = info.wifi_sta_disconnected.reason;
+      _disconnected = true;
+      break;
+    default:
+      break;
+  }
+}
+
+bool WiFi_Manager::requestConnect(const String& ssid, const String& pass, const ConnectHints* hints,
+                                  bool keepLink) {
+  if (isBusy()) return false;
+
+  _ssid = ssid;
+  _pass = pass;
+  _attempt = 0;
+  _hasHints = (hints != nullptr && hints->channel > 0);
+  if (_hasHints) _hints = *hints;
+  // A lease cached for one network must not carry over to the next one
+  if (!_hasHints || !_hints.ip) useDhcp();
+  _maxAttempts = MAX_ATTEMPTS + (_hasHints ? 1 : 0);  // Fast try doesn't eat a full attempt
+  _fastAttempt = false;
+  _fastConnected = false;
+  _roaming = false;
+  _leavePending = false;
+  _stopAfterDisconnect = false;
+  _lastReason = 0;
+  _requestStart = millis();
+  _requestEnd = 0;
+  _lastLoop = _requestStart;
+  _maxLoopGap = 0;
+  _gotIp = false;
+  _disconnected = false;
+
+  Serial.printf("🔌 Connect requested: %s\n", ssid.c_str());
+
+  if (WiFi.status() == WL_CONNECTED && !keepLink) {
+    // Drop the current link first; the DISCONNECTED event moves us on
+    WiFi.disconnect();
+    _phase = PHASE_DISCONNECTING;
+    _phaseStart = millis();
+  } else {
+    startAttempt();
+  }
+  return true;
+}
+
+bool WiFi_Manager::requestDisconnect() {
+  bool busy = isBusy();
+  if (!busy && WiFi.status() != WL_CONNECTED) return false;
+
+  if (!busy) {
+    _ssid = WiFi.SSID();
+    _requestStart = millis();
+    _lastLoop = _requestStart;
+    _maxLoopGap = 0;
+  }
+  Serial.printf("🔌 Disconnect requested%s: %s\n", busy ? " (connect cancelled)" : "", _ssid.c_str());
+
+  // Stops the driver's own retries too; the DISCONNECTED event moves us on
+  _fastAttempt = false;
+  _roaming = false;
+  _leavePending = false;
+  _stopAfterDisconnect = true;
+  _lastReason = 0;
+  _requestEnd = 0;
+  _gotIp = false;
+  _disconnected = false;
+  WiFi.disconnect();
+  useDhcp();
+  _phase = PHASE_DISCONNECTING;
+  _phaseStart = millis();
+  return true;
+}
+
+void WiFi_Manager::startAttempt() {
+  _attempt++;
+  _gotIp = false;
+  _disconnected = false;
+  _phase = PHASE_CONNECTING;
+  _phaseStart = millis();
+
+  if (_hasHints) {
+    // One fast try: known AP and channel, previous lease if we have one
+    _hasHints = false;
+    _fastAttempt = true;
+    // Re-pinning while associated makes the driver leave the current AP
+    // first; that ASSOC_LEAVE is ours, not a verdict on the new BSSID
+    _roaming = (WiFi.status() == WL_CONNECTED);
+    _leavePending = _roaming;
+    if (_hints.ip) {
+      WiFi.config(IPAddress(_hints.ip), IPAddress(_hints.gateway),
+                  IPAddress(_hints.mask), IPAddress(_hints.dns));
+      _staticIp = true;
+    }
+    Serial.printf(" Fast connect attempt: %s ch %ld%s\n", formatBssid(_hints.bssid).c_str(),
+                  (long)_hints.channel, _hints.ip ? " (cached IP)" : "");
+    WiFi.begin(_ssid.c_str(), _pass.c_str(), _hints.channel, _hints.bssid);
+    return;
+  }
+
+  if (_fastAttempt) {
+    // Fast path failed; return to DHCP and a full scan
+    _fastAttempt = false;
+    _roaming = false;
+    _leavePending = false;
+    useDhcp();
+    WiFi.disconnect();
+  }
+
+  Serial.printf(" Connection attempt %u/%u\n", _attempt, _maxAttempts);
+  WiFi.begin(_ssid.c_str(), _pass.c_str());
+}
+
+void WiFi_Manager::useDhcp() {
+  if (!_staticIp) return;
+  WiFi.config(IPAddress(0, 0, 0, 0), IPAddress(0, 0, 0, 0), IPAddress(0, 0, 0, 0));
+  _staticIp = false;
+}
+
+void WiFi_Manager::finish(Phase result) {
+  _phase = result;
+  _requestEnd = millis();
+
+  if (result == PHASE_DISCONNECTED) {
+    _fastConnected = false;
+    Serial.printf(" Disconnected from %s in %lu ms\n", _ssid.c_str(), _requestEnd - _requestStart);
+  } else if (result == PHASE_CONNECTED) {
+    _fastConnected = _fastAttempt;
+    _connectedAt = _requestEnd;
+    Serial.printf(" Connected to %s in %lu ms (%s, %lu ms since boot)\n", _ssid.c_str(),
+                  _requestEnd - _requestStart, _fastConnected ? "fast path" : "full scan",
+                  _connectedAt);
+    Serial.printf("   IP: %s\n", WiFi.localIP().toString().c_str());
+    Serial.printf("   RSSI: %d dBm\n", WiFi.RSSI());
+    if (_onConnected) _onConnected(_ssid, _pass);
+  } else {
+    _fastConnected = false;
+    Serial.printf(" Failed to connect to %s (%s)\n", _ssid.c_str(), reasonName(_lastReason));
+    // Stop the driver from retrying with the rejected credentials
+    WiFi.disconnect();
+  }
+
+  // Credentials are no longer needed in RAM once handed off
+  _pass = "";
+}
+
+void WiFi_Manager::loop() {
+  unsigned long now = millis();
+
+  if (isBusy()) {
+    unsigned long gap = now - _lastLoop;
+    if (gap > _maxLoopGap) _maxLoopGap = gap;
+  }
+  _lastLoop = now;
+
+  switch (_phase) {
+    case PHASE_DISCONNECTING:
+      if (_disconnected || WiFi.status() != WL_CONNECTED ||
+          now - _phaseStart > DISCONNECT_TIMEOUT) {
+        if (_stopAfterDisconnect) finish(PHASE_DISCONNECTED);
+        else startAttempt();
+      }
+      break;
+
+    case PHASE_CONNECTING:
+      if (_gotIp) {
+        finish(PHASE_CONNECTED);
+        break;
+      }
+
+      if (_disconnected) {
+        _disconnected = false;
+        uint8_t reason = _eventReason;
+        if (_leavePending && reason == WIFI_REASON_ASSOC_LEAVE) {
+          _leavePending = false;
+          break;
+        }
+        _lastReason = reason;
+
+        // Wrong password will not improve with retries. On the pinned
+        // fast/roam attempt the same reasons usually mean a stale or weak
+        // cached BSSID, so that one still falls back to a full scan below
+        if (!_fastAttempt &&
+            (_lastReason == WIFI_REASON_AUTH_FAIL ||
+             _lastReason == WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT ||
+             _lastReason == WIFI_REASON_HANDSHAKE_TIMEOUT)) {
+          finish(PHASE_FAILED);
+          break;
+        }
+      }
+
+      if (now - _phaseStart > attemptTimeout() ||
+          (_lastReason != 0 && now - _phaseStart > RETRY_BACKOFF)) {
+        if (_attempt >= _maxAttempts) {
+          finish(PHASE_FAILED);
+        } else {
+          _lastReason = 0;
+          startAttempt();
+        }
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+unsigned long WiFi_Manager::attemptTimeout() const {
+  if (!_fastAttempt) return ATTEMPT_TIMEOUT;
+  return _roaming ? ROAM_ATTEMPT_TIMEOUT : FAST_ATTEMPT_TIMEOUT;
+}
+
+unsigned long WiFi_Manager::elapsedMs() const {
+  if (_phase == PHASE_IDLE) return 0;
+  unsigned long end = isBusy() ? millis() : _requestEnd;
+  return end - _requestStart;
+}
+
+const char* WiFi_Manager::phaseName(Phase phase) {
+  switch (phase) {
+    case PHASE_IDLE:          return "idle";
+    case PHASE_DISCONNECTING: return "disconnecting";
+    case PHASE_CONNECTING:    return "connecting";
+    case PHASE_CONNECTED:     return "connected";
+    case PHASE_FAILED:        return "failed";
+    case PHASE_DISCONNECTED:  return "disconnected";
+  }
+  return "unknown";
+}
+
+const char* WiFi_Manager::reasonName(uint8_t reason) {
+  switch (reason) {
+    case 0:                                  return "none";
+    case WIFI_REASON_AUTH_EXPIRE:            return "auth_expire";
+    case WIFI_REASON_ASSOC_LEAVE:            return "assoc_leave";
+    case WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT: return "wrong_password";
+    case WIFI_REASON_BEACON_TIMEOUT:         return "beacon_timeout";
+    case WIFI_REASON_NO_AP_FOUND:            return "no_ap_found";
+    case WIFI_REASON_AUTH_FAIL:              return "auth_fail";
+    case WIFI_REASON_ASSOC_FAIL:             return "assoc_fail";
+    case WIFI_REASON_HANDSHAKE_TIMEOUT:      return "handshake_timeout";
+    case WIFI_REASON_CONNECTION_FAIL:        return "connection_fail";
+    default:                                 return "other";
+  }
+}
+
+bool WiFi_Manager::parseBssid(const char* str, uint8_t out[6]) {
+  unsigned int b[6];
+  if (sscanf(str, "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != 6) {
+    return false;
+  }
+  for (int i = 0; i < 6; i++) {
+    if (b[i] > 0xFF) return false;
+    out[i] = (uint8_t)b[i];
+  }
+  return true;
+}
+
+String WiFi_Manager::formatBssid(const uint8_t bssid[6]) {
+  char buf[18];
+  snprintf(buf, sizeof(buf), "%02X:%02X:%02X:%02X:%02X:%02X",
+           bssid[0], bssid[1], bssid[2], bssid[3], bssid[4], bssid[5]);
+  return String(buf);
+}
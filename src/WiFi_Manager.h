@@ -0,0 +1,192 @@
+/**
+ * @file WiFi_Manager.h
+ * @brief Event-driven WiFi station connection manager
+ * @version 1.0.0
+ *
+ * @details
+ * Replaces the blocking connect loop that used to live inside the
+ * /api/wifi/connect handler. A connect request only records the target
+ * network and returns; the actual WiFi.begin() / retry / timeout handling
+ * is driven from loop() using the events delivered by WiFi.onEvent().
+ *
+ * When connect hints (last good BSSID/channel and optionally the previous
+ * IP lease) are supplied, the first attempt skips the full channel scan
+ * and DHCP. If that fast attempt fails for any reason, handshake and auth
+ * failures included, the manager falls back to a plain WiFi.begin() with
+ * DHCP; only a full-scan attempt ends the request early on those.
+ *
+ * requestDisconnect() drops the link through the same machine: it also
+ * cancels a connect still in progress, so a late GOT_IP can no longer
+ * reach the connected callback and re-save the network.
+ *
+ * Connection phases:
+ * - IDLE          No connect request in progress
+ * - DISCONNECTING Dropping the current STA link (before switching networks,
+ *                 or for requestDisconnect())
+ * - CONNECTING    WiFi.begin() issued, waiting for GOT_IP
+ * - CONNECTED     Got an IP address, credentials handed to the callback
+ * - FAILED        All attempts exhausted (see lastReason())
+ * - DISCONNECTED  Link dropped on request; any connect in flight cancelled
+ *
+ * Usage:
+ *   WiFi_Manager wifiMgr;
+ *   wifiMgr.begin();
+ *   wifiMgr.onConnected(saveCredentials);
+ *   wifiMgr.requestConnect("MyNetwork", "password");
+ *   // in loop():
+ *   wifiMgr.loop();
+ */
+
+#ifndef WIFI_MANAGER_H
+#define WIFI_MANAGER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+class WiFi_Manager {
+public:
+  /**
+   * @brief Connection state machine phases
+   */
+  enum Phase {
+    PHASE_IDLE,
+    PHASE_DISCONNECTING,
+    PHASE_CONNECTING,
+    PHASE_CONNECTED,
+    PHASE_FAILED,
+    PHASE_DISCONNECTED
+  };
+
+  /**
+   * @brief Callback invoked once a requested connection obtains an IP
+   * @param ssid Network SSID that was connected
+   * @param pass Password used for the connection
+   */
+  typedef void (*ConnectedCallback)(const String& ssid, const String& pass);
+
+  /**
+   * @brief Optional hints for the fast reconnect path
+   * Addresses are stored as uint32_t; 0 means "not set" (use DHCP).
+   */
+  struct ConnectHints {
+    uint8_t bssid[6];
+    int32_t channel;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t mask;
+    uint32_t dns;
+  };
+
+  static const uint8_t MAX_ATTEMPTS = 3;                 // WiFi.begin() attempts per request
+  static const unsigned long ATTEMPT_TIMEOUT = 10000;    // Per-attempt timeout (ms)
+  static const unsigned long FAST_ATTEMPT_TIMEOUT = 4000; // Fast-path attempt timeout (ms)
+  static const unsigned long ROAM_ATTEMPT_TIMEOUT = 6000; // Pinned attempt while associated (ms)
+  static const unsigned long DISCONNECT_TIMEOUT = 1000;  // Max wait for old link to drop (ms)
+  static const unsigned long RETRY_BACKOFF = 500;        // Pause between attempts (ms)
+
+  WiFi_Manager();
+
+  /**
+   * @brief Register the WiFi event handler
+   * Call once in setup() after WiFi.mode() has been set.
+   */
+  void begin();
+
+  /**
+   * @brief Drive the connection state machine
+   * Call on every loop() iteration; never blocks.
+   */
+  void loop();
+
+  /**
+   * @brief Start connecting to a network
+   * @param ssid Network SSID
+   * @param pass Network password (empty for open networks)
+   * @param hints Cached BSSID/channel/lease for a fast first attempt (optional)
+   * @param keepLink Skip the explicit disconnect (used for roaming between APs)
+   * @return false if another connect request is still in progress
+   */
+  bool requestConnect(const String& ssid, const String& pass, const ConnectHints* hints = nullptr,
+                      bool keepLink = false);
+
+  /**
+   * @brief Drop the STA link, cancelling a connect request in progress
+   * Returns at once; the phase reaches DISCONNECTED from loop().
+   * @return false if neither connected nor connecting
+   */
+  bool requestDisconnect();
+
+  /**
+   * @brief Set the callback used to persist credentials on success
+   */
+  void onConnected(ConnectedCallback cb) { _onConnected = cb; }
+
+  /**
+   * @brief Record how long the HTTP handler that started a request took
+   * @param us Handler duration in microseconds
+   */
+  void setRequestHandlerTime(uint32_t us) { _handlerUs = us; }
+
+  // Status accessors (used by /api/wifi/connect/status)
+  Phase phase() const { return _phase; }
+  bool isBusy() const { return _phase == PHASE_DISCONNECTING || _phase == PHASE_CONNECTING; }
+  uint8_t attempt() const { return _attempt; }
+  uint8_t maxAttempts() const { return _maxAttempts; }
+  bool usedFastPath() const { return _fastConnected; }
+  unsigned long connectedAtMs() const { return _connectedAt; }
+  uint8_t lastReason() const { return _lastReason; }
+  const String& targetSsid() const { return _ssid; }
+  uint32_t handlerUs() const { return _handlerUs; }
+  unsigned long elapsedMs() const;
+  unsigned long maxLoopGapMs() const { return _maxLoopGap; }
+
+  static const char* phaseName(Phase phase);
+  static const char* reasonName(uint8_t reason);
+
+  /**
+   * @brief Parse "AA:BB:CC:DD:EE:FF" into 6 bytes
+   * @return true if the string was a valid BSSID
+   */
+  static bool parseBssid(const char* str, uint8_t out[6]);
+
+  /**
+   * @brief Format 6 BSSID bytes as "AA:BB:CC:DD:EE:FF"
+   */
+  static String formatBssid(const uint8_t bssid[6]);
+
+private:
+  void handleEvent(WiFiEvent_t event, WiFiEventInfo_t info);
+  void startAttempt();
+  void finish(Phase result);
+  void useDhcp();                 // Drop a cached static lease, if one is applied
+  unsigned long attemptTimeout() const;
+
+  volatile bool _gotIp;           // Set from the WiFi event task
+  volatile bool _disconnected;    // Set from the WiFi event task
+  volatile uint8_t _eventReason;  // Last disconnect reason from the event task
+
+  Phase _phase;
+  String _ssid;
+  String _pass;
+  uint8_t _attempt;
+  uint8_t _maxAttempts;
+  ConnectHints _hints;
+  bool _hasHints;                 // Fast path still pending for this request
+  bool _fastAttempt;              // Current attempt uses the hints
+  bool _fastConnected;            // Last success came through the fast path
+  bool _staticIp;                 // WiFi.config() holds a cached lease
+  bool _roaming;                  // Fast attempt started while still associated
+  bool _leavePending;             // Our own ASSOC_LEAVE has not been reported yet
+  bool _stopAfterDisconnect;      // DISCONNECTING ends the request (requestDisconnect())
+  unsigned long _connectedAt;     // millis() since boot of the last success
+  uint8_t _lastReason;
+  unsigned long _requestStart;    // millis() when the request was accepted
+  unsigned long _phaseStart;      // millis() when the current phase began
+  unsigned long _requestEnd;      // millis() when the request finished
+  unsigned long _lastLoop;        // millis() of the previous loop() call
+  unsigned long _maxLoopGap;      // Largest loop() gap seen during the request
+  uint32_t _handlerUs;
+  ConnectedCallback _onConnected;
+};
+
+#endif // WIFI_MANAGER_H
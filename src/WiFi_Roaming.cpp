@@ -0,0 +1,263 @@
+/**
+ * @file WiFi_Roaming.cpp
+ * @brief Implementation of the STA roaming policy and RSSI history
+ */
+
+#include "WiFi_Roaming.h"
+
+WiFi_Roaming* WiFi_Roaming::_instance = nullptr;
+
+WiFi_Roaming::WiFi_Roaming(WiFi_Manager& mgr, WiFi_ScanCache& scan)
+  : _mgr(mgr), _scan(scan), _profiles(nullptr), _enabled(true),
+    _history(), _historyCount(0), _events(), _eventHead(0), _eventCount(0), _roamPending(false),
+    _wasConnected(false), _outageStart(0), _disconnectedTotal(0), _longestOutage(0),
+    _disconnectCount(0), _roamCount(0), _roamFailures(0),
+    _lastSample(0), _lastBgScan(0), _lastRoam(0), _lastReconnect(0), _reconnectCursor(0) {
+}
+
+void WiFi_Roaming::begin(const WiFiProfileList& profiles) {
+  _profiles = &profiles;
+  _instance = this;
+  _scan.setObserver(onScanEntry);
+  _outageStart = millis();
+}
+
+uint32_t WiFi_Roaming::ssidHash(const char* ssid) {
+  uint32_t h = 2166136261u;
+  while (*ssid) {
+    h ^= (uint8_t)*ssid++;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+void WiFi_Roaming::onScanEntry(const char* ssid, const uint8_t* bssid, int32_t rssi, int32_t channel) {
+  if (!_instance) return;
+  uint32_t hash = ssidHash(ssid);
+  if (_instance->profileForHash(hash) < 0) return;  // Only remember saved networks
+  _instance->record(bssid, hash, rssi, channel);
+}
+
+int WiFi_Roaming::profileForHash(uint32_t hash) const {
+  if (!_profiles) return -1;
+  for (size_t i = 0; i < _profiles->count; i++) {
+    if (ssidHash(_profiles->items[i].ssid) == hash) return i;
+  }
+  return -1;
+}
+
+WiFi_Roaming::BssidHistory* WiFi_Roaming::findHistory(const uint8_t* bssid) {
+  for (size_t i = 0; i < _historyCount; i++) {
+    if (memcmp(_history[i].bssid, bssid, 6) == 0) return &_history[i];
+  }
+  return nullptr;
+}
+
+void WiFi_Roaming::record(const uint8_t* bssid, uint32_t hash, int32_t rssi, int32_t channel) {
+  BssidHistory* h = findHistory(bssid);
+
+  if (!h) {
+    if (_historyCount < MAX_BSSIDS) {
+      h = &_history[_historyCount++];
+    } else {
+      // Evict the BSSID we have not heard from for longest
+      h = &_history[0];
+      for (size_t i = 1; i < _historyCount; i++) {
+        if (_history[i].lastSeen < h->lastSeen) h = &_history[i];
+      }
+    }
+    memset(h, 0, sizeof(*h));
+    memcpy(h->bssid, bssid, 6);
+  }
+
+  h->ssidHash = hash;
+  h->channel = channel;
+  h->samples[h->head] = constrain(rssi, -127, 0);
+  h->head = (h->head + 1) % HISTORY_LEN;
+  if (h->count < HISTORY_LEN) h->count++;
+  h->lastSeen = millis();
+}
+
+int WiFi_Roaming::averageRssi(const BssidHistory& h) const {
+  if (!h.count) return -127;
+  int sum = 0;
+  for (size_t i = 0; i < h.count; i++) sum += h.samples[i];
+  return sum / (int)h.count;
+}
+
+const WiFi_Roaming::BssidHistory* WiFi_Roaming::bestForProfile(int profile) const {
+  if (!_profiles || profile < 0) return nullptr;
+  uint32_t hash = ssidHash(_profiles->items[profile].ssid);
+  unsigned long now = millis();
+
+  const BssidHistory* best = nullptr;
+  for (size_t i = 0; i < _historyCount; i++) {
+    const BssidHistory& h = _history[i];
+    if (h.ssidHash != hash || now - h.lastSeen > CANDIDATE_MAX_AGE) continue;
+    if (!best || averageRssi(h) > averageRssi(*best)) best = &h;
+  }
+  return best;
+}
+
+bool WiFi_Roaming::hintsFor(const char* ssid, WiFi_Manager::ConnectHints& hints) const {
+  if (!_profiles) return false;
+  const BssidHistory* h = bestForProfile(_profiles->find(ssid));
+  if (!h) return false;
+  memset(&hints, 0, sizeof(hints));
+  memcpy(hints.bssid, h->bssid, 6);
+  hints.channel = h->channel;
+  return true;
+}
+
+void WiFi_Roaming::loop() {
+  if (!_profiles) return;
+  unsigned long now = millis();
+  bool connected = (WiFi.status() == WL_CONNECTED);
+
+  trackLink(connected, now);
+
+  if (_roamPending && !_mgr.isBusy()) {
+    finishRoam(_mgr.phase() == WiFi_Manager::PHASE_CONNECTED, now);
+  }
+
+  if (connected && now - _lastSample >= SAMPLE_INTERVAL) {
+    _lastSample = now;
+    String ssid = WiFi.SSID();
+    uint32_t hash = ssidHash(ssid.c_str());
+    if (profileForHash(hash) >= 0) record(WiFi.BSSID(), hash, WiFi.RSSI(), WiFi.channel());
+  }
+
+  if (!_enabled || _mgr.isBusy()) return;
+
+  if (connected) {
+    evaluateRoam(now);
+  } else {
+    evaluateReconnect(now);
+  }
+}
+
+void WiFi_Roaming::trackLink(bool connected, unsigned long now) {
+  if (connected == _wasConnected) return;
+  _wasConnected = connected;
+
+  if (connected) {
+    unsigned long outage = now - _outageStart;
+    _disconnectedTotal += outage;
+    if (outage > _longestOutage) _longestOutage = outage;
+    _reconnectCursor = 0;
+  } else {
+    _disconnectCount++;
+    _outageStart = now;
+  }
+}
+
+unsigned long WiFi_Roaming::currentOutageMs() const {
+  return _wasConnected ? 0 : millis() - _outageStart;
+}
+
+unsigned long WiFi_Roaming::disconnectedMs() const {
+  return _disconnectedTotal + currentOutageMs();
+}
+
+void WiFi_Roaming::evaluateRoam(unsigned long now) {
+  const uint8_t* cur = WiFi.BSSID();
+  BssidHistory* curHist = findHistory(cur);
+  if (!curHist || curHist->count < 2) return;
+
+  int curAvg = averageRssi(*curHist);
+  if (curAvg >= ROAM_TRIGGER_RSSI) return;
+
+  // Weak link: refresh neighbour RSSI in the background
+  if (!_scan.isScanning() && (_lastBgScan == 0 || now - _lastBgScan >= BG_SCAN_INTERVAL)) {
+    _lastBgScan = now;
+    _scan.start(true);
+    return;
+  }
+
+  if (_lastRoam != 0 && now - _lastRoam < MIN_DWELL) return;
+
+  const BssidHistory* best = nullptr;
+  int bestProfile = -1;
+  for (size_t i = 0; i < _historyCount; i++) {
+    const BssidHistory& h = _history[i];
+    if (&h == curHist || now - h.lastSeen > CANDIDATE_MAX_AGE) continue;
+    int profile = profileForHash(h.ssidHash);
+    if (profile < 0 || averageRssi(h) < curAvg + ROAM_HYSTERESIS) continue;
+
+    if (!best ||
+        _profiles->items[profile].priority > _profiles->items[bestProfile].priority ||
+        (_profiles->items[profile].priority == _profiles->items[bestProfile].priority &&
+         averageRssi(h) > averageRssi(*best))) {
+      best = &h;
+      bestProfile = profile;
+    }
+  }
+  if (!best) return;
+
+  const WiFiProfile& p = _profiles->items[bestProfile];
+  WiFi_Manager::ConnectHints hints;
+  memset(&hints, 0, sizeof(hints));
+  memcpy(hints.bssid, best->bssid, 6);
+  hints.channel = best->channel;
+
+  Serial.printf(" Roaming %s (%d dBm) -> %s %s (%d dBm)\n",
+                WiFi_Manager::formatBssid(cur).c_str(), curAvg, p.ssid,
+                WiFi_Manager::formatBssid(best->bssid).c_str(), averageRssi(*best));
+
+  RoamEvent& e = _events[_eventHead];
+  memset(&e, 0, sizeof(e));
+  e.at = now;
+  memcpy(e.from, cur, 6);
+  memcpy(e.to, best->bssid, 6);
+  e.fromRssi = curAvg;
+  e.toRssi = averageRssi(*best);
+
+  if (_mgr.requestConnect(p.ssid, p.pass, &hints, true)) {
+    _roamPending = true;
+    _lastRoam = now;
+  }
+}
+
+void WiFi_Roaming::finishRoam(bool ok, unsigned long now) {
+  RoamEvent& e = _events[_eventHead];
+  e.ok = ok;
+  e.durationMs = now - e.at;
+  _eventHead = (_eventHead + 1) % ROAM_EVENT_COUNT;
+  if (_eventCount < ROAM_EVENT_COUNT) _eventCount++;
+  _roamPending = false;
+
+  if (ok) _roamCount++;
+  else _roamFailures++;
+}
+
+const WiFi_Roaming::RoamEvent& WiFi_Roaming::event(size_t i) const {
+  return _events[(_eventHead + ROAM_EVENT_COUNT - 1 - i) % ROAM_EVENT_COUNT];
+}
+
+void WiFi_Roaming::evaluateReconnect(unsigned long now) {
+  if (!_profiles->count || now - _lastReconnect < RECONNECT_DELAY) return;
+  _lastReconnect = now;
+
+  // Rank profiles: recently seen ones by RSSI, then by priority
+  size_t order[WIFI_MAX_PROFILES];
+  int score[WIFI_MAX_PROFILES];
+  size_t n = _profiles->count;
+  for (size_t i = 0; i < n; i++) {
+    const BssidHistory* h = bestForProfile(i);
+    order[i] = i;
+    score[i] = (h ? averageRssi(*h) : -200) + 10 * _profiles->items[i].priority;
+  }
+  for (size_t i = 1; i < n; i++) {
+    for (size_t j = i; j > 0 && score[order[j]] > score[order[j - 1]]; j--) {
+      size_t t = order[j]; order[j] = order[j - 1]; order[j - 1] = t;
+    }
+  }
+
+  const WiFiProfile& p = _profiles->items[order[_reconnectCursor % n]];
+  _reconnectCursor++;
+
+  WiFi_Manager::ConnectHints hints;
+  bool haveHints = hintsFor(p.ssid, hints);
+  Serial.printf(" Reconnecting to saved network %s\n", p.ssid);
+  _mgr.requestConnect(p.ssid, p.pass, haveHints ? &hints : nullptr);
+}
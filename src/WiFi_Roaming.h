@@ -0,0 +1,224 @@
+/**
+ * @file WiFi_Roaming.h
+ * @brief Saved STA profiles, per-BSSID RSSI history and roaming policy
+ * @version 1.0.0
+ *
+ * @details
+ * WiFiProfileList holds up to WIFI_MAX_PROFILES saved networks with a
+ * priority (higher wins). WiFi_Roaming builds on WiFi_Manager and
+ * WiFi_ScanCache:
+ *
+ * - Samples the RSSI of the connected BSSID every SAMPLE_INTERVAL and
+ *   records every BSSID of a known SSID seen in scan results.
+ * - While the link is weak (average below ROAM_TRIGGER_RSSI) it runs a
+ *   background scan at most every BG_SCAN_INTERVAL.
+ * - Roams to a known BSSID that is at least ROAM_HYSTERESIS dB stronger
+ *   by issuing a BSSID/channel-pinned WiFi.begin() without an explicit
+ *   disconnect or full scan. MIN_DWELL limits roam frequency.
+ * - When the link is lost, reconnects to the best profile (recent RSSI,
+ *   then priority) using cached BSSID/channel hints.
+ *
+ * Disconnected time, outage counts and the last ROAM_EVENT_COUNT roam
+ * events are kept for /api/wifi/roaming.
+ */
+
+#ifndef WIFI_ROAMING_H
+#define WIFI_ROAMING_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "WiFi_Manager.h"
+#include "WiFi_ScanCache.h"
+
+#define WIFI_MAX_PROFILES 5
+
+/**
+ * @brief One saved STA network (fixed buffers, stored as-is in the config record)
+ */
+struct WiFiProfile {
+  char ssid[33];
+  char pass[64];
+  uint8_t priority;  // Higher is preferred
+};
+
+/**
+ * @brief Fixed-size list of saved STA networks
+ */
+struct WiFiProfileList {
+  WiFiProfile items[WIFI_MAX_PROFILES];
+  uint8_t count;
+
+  WiFiProfileList() { clear(); }
+
+  void clear() {
+    memset(items, 0, sizeof(items));
+    count = 0;
+  }
+
+  /**
+   * @brief Find a profile by SSID
+   * @return Index or -1 if not found
+   */
+  int find(const char* ssid) const {
+    for (size_t i = 0; i < count; i++) {
+      if (strcmp(items[i].ssid, ssid) == 0) return i;
+    }
+    return -1;
+  }
+
+  /**
+   * @brief Add or update a profile
+   * @return false if the list is full or the SSID/password do not fit
+   */
+  bool upsert(const char* ssid, const char* pass, uint8_t priority) {
+    if (!*ssid || strlen(ssid) >= sizeof(items[0].ssid) || strlen(pass) >= sizeof(items[0].pass)) {
+      return false;
+    }
+    int i = find(ssid);
+    if (i < 0) {
+      if (count >= WIFI_MAX_PROFILES) return false;
+      i = count++;
+    }
+    strcpy(items[i].ssid, ssid);
+    strcpy(items[i].pass, pass);
+    items[i].priority = priority;
+    return true;
+  }
+
+  /**
+   * @brief Remove a profile by SSID
+   * @return true if a profile was removed
+   */
+  bool remove(const char* ssid) {
+    int i = find(ssid);
+    if (i < 0) return false;
+    for (size_t j = i; j + 1 < count; j++) items[j] = items[j + 1];
+    count--;
+    memset(&items[count], 0, sizeof(items[count]));
+    return true;
+  }
+};
+
+class WiFi_Roaming {
+public:
+  static const size_t MAX_BSSIDS = 16;                 // Tracked BSSIDs of known SSIDs
+  static const size_t HISTORY_LEN = 8;                 // RSSI samples kept per BSSID
+  static const size_t ROAM_EVENT_COUNT = 8;            // Roam events kept
+  static const unsigned long SAMPLE_INTERVAL = 5000;   // Connected RSSI sampling (ms)
+  static const unsigned long BG_SCAN_INTERVAL = 60000; // Min gap between background scans (ms)
+  static const unsigned long CANDIDATE_MAX_AGE = 90000;// Ignore BSSIDs not seen for this long (ms)
+  static const unsigned long MIN_DWELL = 60000;        // Min time between roams (ms)
+  static const unsigned long RECONNECT_DELAY = 10000;  // Gap between reconnect attempts (ms)
+  static const int ROAM_TRIGGER_RSSI = -70;            // Start looking below this (dBm)
+  static const int ROAM_HYSTERESIS = 8;                // Candidate must be this much stronger (dB)
+
+  /**
+   * @brief RSSI history of one BSSID belonging to a saved SSID
+   */
+  struct BssidHistory {
+    uint8_t bssid[6];
+    uint32_t ssidHash;            // FNV-1a of the SSID (profile lookups)
+    uint8_t channel;
+    int8_t samples[HISTORY_LEN];  // Ring buffer of RSSI samples (dBm)
+    uint8_t head;
+    uint8_t count;
+    unsigned long lastSeen;       // millis() of the newest sample
+  };
+
+  /**
+   * @brief One roam (or roam attempt)
+   */
+  struct RoamEvent {
+    unsigned long at;             // millis() when the roam started
+    uint8_t from[6];
+    uint8_t to[6];
+    int8_t fromRssi;
+    int8_t toRssi;
+    uint32_t durationMs;          // Time until connected/failed
+    bool ok;
+  };
+
+  WiFi_Roaming(WiFi_Manager& mgr, WiFi_ScanCache& scan);
+
+  /**
+   * @brief Attach the saved profile list and hook into scan results
+   */
+  void begin(const WiFiProfileList& profiles);
+
+  /**
+   * @brief Run sampling, roaming and reconnect policy; never blocks
+   */
+  void loop();
+
+  /**
+   * @brief Enable/disable automatic roaming and reconnects
+   * Disabled after a user disconnect, re-enabled on the next connect.
+   */
+  void setEnabled(bool enabled) { _enabled = enabled; }
+  bool isEnabled() const { return _enabled; }
+
+  /**
+   * @brief Best known BSSID/channel for a profile
+   * @return true if hints were filled from recent history
+   */
+  bool hintsFor(const char* ssid, WiFi_Manager::ConnectHints& hints) const;
+
+  // Metrics
+  unsigned long disconnectedMs() const;      // Total time without STA link since boot
+  unsigned long currentOutageMs() const;     // 0 while connected
+  unsigned long longestOutageMs() const { return _longestOutage; }
+  uint32_t disconnectCount() const { return _disconnectCount; }
+  uint32_t roamCount() const { return _roamCount; }
+  uint32_t roamFailures() const { return _roamFailures; }
+
+  size_t historyCount() const { return _historyCount; }
+  const BssidHistory& history(size_t i) const { return _history[i]; }
+  int averageRssi(const BssidHistory& h) const;
+
+  size_t eventCount() const { return _eventCount; }
+  const RoamEvent& event(size_t i) const;    // 0 = newest
+
+  static uint32_t ssidHash(const char* ssid);
+
+private:
+  static void onScanEntry(const char* ssid, const uint8_t* bssid, int32_t rssi, int32_t channel);
+  void record(const uint8_t* bssid, uint32_t hash, int32_t rssi, int32_t channel);
+  int profileForHash(uint32_t hash) const;
+  BssidHistory* findHistory(const uint8_t* bssid);
+  const BssidHistory* bestForProfile(int profile) const;
+  void trackLink(bool connected, unsigned long now);
+  void evaluateRoam(unsigned long now);
+  void evaluateReconnect(unsigned long now);
+  void finishRoam(bool ok, unsigned long now);
+
+  static WiFi_Roaming* _instance;  // For the scan observer trampoline
+
+  WiFi_Manager& _mgr;
+  WiFi_ScanCache& _scan;
+  const WiFiProfileList* _profiles;
+  bool _enabled;
+
+  BssidHistory _history[MAX_BSSIDS];
+  size_t _historyCount;
+
+  RoamEvent _events[ROAM_EVENT_COUNT];
+  size_t _eventHead;
+  size_t _eventCount;
+  bool _roamPending;
+
+  bool _wasConnected;
+  unsigned long _outageStart;
+  unsigned long _disconnectedTotal;
+  unsigned long _longestOutage;
+  uint32_t _disconnectCount;
+  uint32_t _roamCount;
+  uint32_t _roamFailures;
+
+  unsigned long _lastSample;
+  unsigned long _lastBgScan;
+  unsigned long _lastRoam;
+  unsigned long _lastReconnect;
+  size_t _reconnectCursor;
+};
+
+#endif // WIFI_ROAMING_H
@@ -0,0 +1,150 @@
+/**
+ * @file WiFi_ScanCache.cpp
+ * @brief Implementation of the fixed-size WiFi scan result cache
+ */
+
+#include "WiFi_ScanCache.h"
+
+WiFi_ScanCache::WiFi_ScanCache()
+  : _count(0), _rawCount(0), _hiddenCount(0), _droppedCount(0),
+    _scanning(false), _hasResults(false), _startedAt(0), _completedAt(0), _durationMs(0),
+    _observer(nullptr) {
+}
+
+WiFi_ScanCache::StartResult WiFi_ScanCache::start(bool force) {
+  if (_scanning) return SCAN_BUSY;
+  if (!force && isFresh()) return SCAN_CACHED;
+
+  int n = WiFi.scanNetworks(true);  // true = async scan
+  if (n == WIFI_SCAN_FAILED) return SCAN_FAILED;
+
+  _scanning = true;
+  _startedAt = millis();
+  return SCAN_STARTED;
+}
+
+void WiFi_ScanCache::poll() {
+  int n = WiFi.scanComplete();
+  if (n == WIFI_SCAN_RUNNING) return;
+
+  if (n == WIFI_SCAN_FAILED) {
+    // -2 is also returned when no scan was ever started
+    if (_scanning) {
+      Serial.println(" WiFi scan failed");
+      _scanning = false;
+    }
+    return;
+  }
+
+  _count = 0;
+  _rawCount = n;
+  _hiddenCount = 0;
+  _droppedCount = 0;
+
+  for (int i = 0; i < n; i++) {
+    String ssid = WiFi.SSID(i);
+    if (!ssid.length()) {
+      _hiddenCount++;
+      continue;
+    }
+    if (_observer) _observer(ssid.c_str(), WiFi.BSSID(i), WiFi.RSSI(i), WiFi.channel(i));
+    insert(ssid.c_str(), WiFi.BSSID(i), WiFi.RSSI(i), WiFi.channel(i), WiFi.encryptionType(i));
+  }
+
+  // Free the driver's result list
+  WiFi.scanDelete();
+
+  _scanning = false;
+  _hasResults = true;
+  _completedAt = millis();
+  _durationMs = _completedAt - _startedAt;
+
+  Serial.printf(" Found %d networks (%u unique, %u hidden, %u dropped) in %lu ms\n",
+                n, (unsigned)_count, _hiddenCount, _droppedCount, _durationMs);
+}
+
+void WiFi_ScanCache::insert(const char* ssid, const uint8_t* bssid, int32_t rssi, int32_t channel, uint8_t auth) {
+  size_t i = 0;
+  while (i < _count && strcmp(_records[i].ssid, ssid) != 0) i++;
+
+  if (i < _count) {
+    // Same SSID from another BSSID; keep the strongest
+    Record& r = _records[i];
+    if (r.apCount < 255) r.apCount++;
+    if (rssi <= r.rssi) return;
+    memcpy(r.bssid, bssid, 6);
+    r.rssi = rssi;
+    r.channel = channel;
+    r.auth = auth;
+  } else {
+    if (_count == MAX_RECORDS) {
+      _droppedCount++;
+      if (rssi <= _records[_count - 1].rssi) return;
+      i = _count - 1;  // Replace the weakest
+    } else {
+      i = _count++;
+    }
+    Record& r = _records[i];
+    strncpy(r.ssid, ssid, sizeof(r.ssid) - 1);
+    r.ssid[sizeof(r.ssid) - 1] = '\0';
+    memcpy(r.bssid, bssid, 6);
+    r.rssi = rssi;
+    r.channel = channel;
+    r.auth = auth;
+    r.apCount = 1;
+  }
+
+  // Keep sorted by RSSI (strongest first)
+  while (i > 0 && _records[i - 1].rssi < _records[i].rssi) {
+    Record tmp = _records[i - 1];
+    _records[i - 1] = _records[i];
+    _records[i] = tmp;
+    i--;
+  }
+}
+
+size_t WiFi_ScanCache::recordToJson(size_t i, char* buf, size_t len) const {
+  if (i >= _count || len < 8) return 0;
+  const Record& r = _records[i];
+
+  // SSIDs are arbitrary bytes; escape quotes, backslashes and control chars
+  char ssid[33 * 6 + 1];
+  size_t o = 0;
+  for (const char* p = r.ssid; *p; p++) {
+    unsigned char c = *p;
+    if (c == '"' || c == '\\') {
+      ssid[o++] = '\\';
+      ssid[o++] = c;
+    } else if (c < 0x20) {
+      o += snprintf(ssid + o, sizeof(ssid) - o, "\\u%04x", c);
+    } else {
+      ssid[o++] = c;
+    }
+  }
+  ssid[o] = '\0';
+
+  const char* strength = (r.rssi >= -60) ? "strong" : (r.rssi >= -75) ? "medium" : "weak";
+  bool open = (r.auth == WIFI_AUTH_OPEN);
+
+  int n = snprintf(buf, len,
+    "{\"ssid\":\"%s\",\"bssid\":\"%02X:%02X:%02X:%02X:%02X:%02X\",\"rssi\":%d,\"channel\":%u,"
+    "\"encryption\":\"%s\",\"auth\":%d,\"authMode\":\"%s\",\"strength\":\"%s\",\"apCount\":%u}",
+    ssid, r.bssid[0], r.bssid[1], r.bssid[2], r.bssid[3], r.bssid[4], r.bssid[5],
+    r.rssi, r.channel, open ? "Open" : "Secure", open ? 0 : 1, authName(r.auth), strength, r.apCount);
+
+  return (n > 0 && (size_t)n < len) ? (size_t)n : 0;
+}
+
+const char* WiFi_ScanCache::authName(uint8_t auth) {
+  switch (auth) {
+    case WIFI_AUTH_OPEN:            return "open";
+    case WIFI_AUTH_WEP:             return "wep";
+    case WIFI_AUTH_WPA_PSK:         return "wpa";
+    case WIFI_AUTH_WPA2_PSK:        return "wpa2";
+    case WIFI_AUTH_WPA_WPA2_PSK:    return "wpa/wpa2";
+    case WIFI_AUTH_WPA2_ENTERPRISE: return "wpa2-enterprise";
+    case WIFI_AUTH_WPA3_PSK:        return "wpa3";
+    case WIFI_AUTH_WPA2_WPA3_PSK:   return "wpa2/wpa3";
+    default:                        return "other";
+  }
+}
@@ -0,0 +1,119 @@
+/**
+ * @file WiFi_ScanCache.h
+ * @brief Fixed-size WiFi scan result cache with TTL
+ * @version 1.0.0
+ *
+ * @details
+ * Keeps the results of the last asynchronous WiFi scan in a static array
+ * of compact records instead of a serialized JSON String. Records are
+ * deduplicated by SSID (the strongest BSSID wins, apCount counts the rest),
+ * hidden networks are skipped and the array is kept sorted by RSSI.
+ *
+ * Results carry their age so callers can decide whether a rescan is
+ * needed; start() reuses the cache while it is younger than TTL_MS.
+ *
+ * Usage:
+ *   WiFi_ScanCache scanCache;
+ *   scanCache.start(false);   // from /api/wifi/scan
+ *   scanCache.poll();         // in loop()
+ *   for (size_t i = 0; i < scanCache.count(); i++) { ... scanCache.record(i) ... }
+ */
+
+#ifndef WIFI_SCAN_CACHE_H
+#define WIFI_SCAN_CACHE_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+class WiFi_ScanCache {
+public:
+  /**
+   * @brief One deduplicated network (42 bytes)
+   */
+  struct Record {
+    char ssid[33];       // Null-terminated SSID (max 32 chars)
+    uint8_t bssid[6];    // Strongest BSSID seen for this SSID
+    int8_t rssi;         // RSSI of that BSSID (dBm)
+    uint8_t channel;     // Channel of that BSSID
+    uint8_t auth;        // wifi_auth_mode_t
+    uint8_t apCount;     // Number of BSSIDs advertising this SSID
+  };
+
+  /**
+   * @brief Result of start()
+   */
+  enum StartResult {
+    SCAN_STARTED,   // New asynchronous scan running
+    SCAN_CACHED,    // Cached results are still fresh, no scan started
+    SCAN_BUSY,      // A scan is already running
+    SCAN_FAILED     // Driver refused to start a scan
+  };
+
+  static const size_t MAX_RECORDS = 64;        // Distinct SSIDs kept per scan
+  static const unsigned long TTL_MS = 30000;   // Results considered fresh for 30 s
+  static const size_t RECORD_JSON_MAX = 400;   // Worst-case recordToJson() output
+
+  /**
+   * @brief Called for every raw scan entry before deduplication
+   */
+  typedef void (*EntryObserver)(const char* ssid, const uint8_t* bssid, int32_t rssi, int32_t channel);
+
+  WiFi_ScanCache();
+
+  /**
+   * @brief Register an observer that sees every BSSID of a completed scan
+   */
+  void setObserver(EntryObserver observer) { _observer = observer; }
+
+  /**
+   * @brief Start an asynchronous scan unless fresh results exist
+   * @param force Always start a new scan
+   */
+  StartResult start(bool force);
+
+  /**
+   * @brief Collect results once the driver reports completion
+   * Call on every loop() iteration.
+   */
+  void poll();
+
+  bool isScanning() const { return _scanning; }
+  bool hasResults() const { return _hasResults; }
+  bool isFresh() const { return _hasResults && ageMs() < TTL_MS; }
+  unsigned long ageMs() const { return _hasResults ? millis() - _completedAt : 0; }
+
+  size_t count() const { return _count; }
+  const Record& record(size_t i) const { return _records[i]; }
+  uint16_t rawCount() const { return _rawCount; }       // APs reported by the driver
+  uint16_t hiddenCount() const { return _hiddenCount; } // Entries without SSID
+  uint16_t droppedCount() const { return _droppedCount; } // SSIDs beyond MAX_RECORDS
+  unsigned long durationMs() const { return _durationMs; }
+
+  /**
+   * @brief Write one record as a JSON object into buf
+   * @return Number of characters written (0 if it did not fit)
+   *
+   * RECORD_JSON_MAX fits any record, even a 32-byte SSID that escapes
+   * every byte as \u00XX.
+   */
+  size_t recordToJson(size_t i, char* buf, size_t len) const;
+
+  static const char* authName(uint8_t auth);
+
+private:
+  void insert(const char* ssid, const uint8_t* bssid, int32_t rssi, int32_t channel, uint8_t auth);
+
+  Record _records[MAX_RECORDS];
+  size_t _count;
+  uint16_t _rawCount;
+  uint16_t _hiddenCount;
+  uint16_t _droppedCount;
+  bool _scanning;
+  bool _hasResults;
+  unsigned long _startedAt;
+  unsigned long _completedAt;
+  unsigned long _durationMs;
+  EntryObserver _observer;
+};
+
+#endif // WIFI_SCAN_CACHE_H
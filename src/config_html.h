@@ -617,6 +617,8 @@ async function loadEmailConfig() {
     document.getElementById('smtpPort').value = d.smtpPort || 465;
     document.getElementById('emailAccountInput').value = d.emailAccount || '';
     document.getElementById('senderName').value = d.senderName || 'ESP32 Dashboard';
+    // Password is masked as "[SET]"; posting it back keeps the stored one
+    document.getElementById('emailPassword').value = d.emailPassword || '';
     if (d.emailAccount) {
       document.getElementById('smtpServer').textContent = d.smtpHost || '—';
       document.getElementById('emailAccount').textContent = d.emailAccount || '—';
@@ -799,7 +801,7 @@ async function saveAp() {
       return;
     }
     
-    if (apPass && apPass.length < 8) {
+    if (apPass && apPass !== '[SET]' && apPass.length < 8) {
       showMessage('apMessage', 'Password must be at least 8 characters or empty', 'error');
       return;
     }
@@ -813,7 +815,7 @@ async function saveAp() {
       showMessage('apMessage', result.message, 'success');
       document.getElementById('apLastSaved').textContent = new Date().toLocaleString();
     } else {
-      showMessage('apMessage', result.message || 'Failed to save AP configuration', 'error');
+      showMessage('apMessage', result.error || result.message || 'Failed to save AP configuration', 'error');
     }
   } catch (error) {
     showMessage('apMessage', 'Save failed: ' + error.message, 'error');
@@ -881,7 +883,7 @@ function updateApSecurityHint() {
   const apPass = document.getElementById('apPass').value;
   const secState = document.getElementById('apSecState');
   
-  if (apPass && apPass.length >= 8) {
+  if (apPass === '[SET]' || (apPass && apPass.length >= 8)) {
     secState.textContent = 'WPA2 Protected';
     secState.className = 'status-connected';
   } else if (apPass && apPass.length > 0) {
@@ -958,11 +958,11 @@ async function scanWifi() {
   try {
     console.log('Starting WiFi scan...');
     
-    // Start async scan
+    // Start async scan (server may answer with fresh cached results)
     const scanStart = await apiGet('/api/wifi/scan');
     console.log('Scan started:', scanStart);
     
-    if (scanStart.status !== 'scanning') {
+    if (scanStart.status !== 'scanning' && scanStart.status !== 'cached') {
       throw new Error('Failed to start scan: ' + JSON.stringify(scanStart));
     }
     
@@ -971,10 +971,17 @@ async function scanWifi() {
     let scanResult = null;
     
     while (attempts < 20) { // Wait up to 10 seconds (20 * 500ms)
-      await new Promise(resolve => setTimeout(resolve, 500));
+      if (scanStart.status === 'scanning') {
+        await new Promise(resolve => setTimeout(resolve, 500));
+      }
       
       try {
-        scanResult = await apiGet('/api/wifi/scan/results');
+        const r = await apiGet('/api/wifi/scan/results');
+        if (r.status === 'scanning') {
+          attempts++;
+          continue;
+        }
+        scanResult = r;
         console.log('Scan results:', scanResult);
         break;
       } catch (e) {
@@ -987,13 +994,13 @@ async function scanWifi() {
       throw new Error('Scan timed out or failed');
     }
     
-    if (!Array.isArray(scanResult)) {
+    if (!Array.isArray(scanResult.networks)) {
       console.error('Invalid scan response:', scanResult);
       throw new Error('Invalid scan response: ' + JSON.stringify(scanResult));
     }
     
     const best = {}; 
-    scanResult.forEach(n => { 
+    scanResult.networks.forEach(n => { 
       if (!n.ssid) return; 
       if (!best[n.ssid] || (n.rssi > best[n.ssid].rssi)) best[n.ssid] = n; 
     });
@@ -1072,12 +1079,31 @@ async function connectNetwork() {
   connectBtn.disabled = true;
   
   try {
-    const resp = await apiPost('/api/wifi/connect', { 
+    const start = await apiPost('/api/wifi/connect', { 
       ssid: selectedNetworkData.ssid, 
       password: wifiPass.value 
     });
+    if (!start.success) {
+      throw new Error(start.error || 'Failed to start connection');
+    }
+    
+    // Connection runs in the background; poll progress
+    let resp = null;
+    for (let i = 0; i < 70; i++) { // Up to ~35 seconds (70 * 500ms)
+      await new Promise(resolve => setTimeout(resolve, 500));
+      try {
+        const st = await apiGet('/api/wifi/connect/status');
+        connectBtn.textContent = `Connecting... (${st.attempt}/${st.maxAttempts})`;
+        if (st.phase === 'connected' || st.phase === 'failed' || st.phase === 'disconnected') { resp = st; break; }
+      } catch (e) {
+        // AP client may briefly drop while the radio changes channel
+        console.log('Connect status poll failed:', e.message);
+      }
+    }
     
-    if (resp.success) {
+    if (!resp) {
+      showMessage('wifiMessage', 'Connection status unknown - check status panel', 'warning');
+    } else if (resp.phase === 'connected') {
       showMessage('wifiMessage', `Successfully connected to ${resp.ssid}`, 'success');
       // Clear the form after successful connection
       document.getElementById('networkSelect').value = '';
@@ -1087,8 +1113,10 @@ async function connectNetwork() {
       selectedNetworkData = null;
       // Refresh status to show new connection
       setTimeout(() => refreshStatus(), 2000);
+    } else if (resp.phase === 'disconnected') {
+      showMessage('wifiMessage', 'Connection cancelled', 'warning');
     } else {
-      showMessage('wifiMessage', 'Connection failed: ' + (resp.error || 'Unknown error'), 'error');
+      showMessage('wifiMessage', 'Connection failed: ' + (resp.reasonText || 'Unknown error'), 'error');
     }
   } catch(e) {
     showMessage('wifiMessage', 'Connect failed: ' + e.message, 'error');
@@ -1107,6 +1135,12 @@ async function disconnectNetwork() {
   disconnectBtn.disabled = true;
   try {
     await apiPost('/api/wifi/disconnect', {});
+    // The link is dropped in the background; wait for it (about 1 s at most)
+    for (let i = 0; i < 10; i++) {
+      const st = await apiGet('/api/wifi/connect/status').catch(() => null);
+      if (st && st.phase !== 'disconnecting') break;
+      await new Promise(resolve => setTimeout(resolve, 300));
+    }
     showMessage('wifiMessage', 'Disconnected from WiFi network', 'success');
   } catch (e) {
     showMessage('wifiMessage', 'Disconnect failed: ' + e.message, 'error');
@@ -1319,7 +1353,8 @@ async function loadEmailConfig() {
     document.getElementById('smtpPort').value = d.smtpPort || 465;
     document.getElementById('emailAccountInput').value = d.emailAccount || '';
     document.getElementById('senderName').value = d.senderName || 'ESP32 Dashboard';
-    // Note: Password is not returned for security
+    // Password is masked as "[SET]"; posting it back keeps the stored one
+    document.getElementById('emailPassword').value = d.emailPassword || '';
     
     // Update status display
     if (d.emailAccount) {
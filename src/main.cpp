@@ -15,12 +15,34 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <WebServer.h>
-#include <DNSServer.h>
-#include <SPIFFS.h>
+#include <AsyncUDP.h>
+#include <LittleFS.h>
 #include <ArduinoJson.h>
+#include <Wire.h>
+#include <nvs.h>
+#include <new>
 #include "GSM_Test.h"
 #include "SMTP.h"
 #include "DRD_Manager.h"
+#include "WiFi_Manager.h"
+#include "WiFi_ScanCache.h"
+#include "WiFi_Roaming.h"
+#include "Uplink_Manager.h"
+#include "Captive_DNS.h"
+#include "Config_Store.h"
+#include "Config_Schema.h"
+#include "FS_Manager.h"
+#include "Boot_Timeline.h"
+#include "Job_Scheduler.h"
+#include "Stall_Monitor.h"
+#include "Metrics_Registry.h"
+#include "Log_Ring.h"
+#include "Heap_Monitor.h"
+#include "Sensor_Pipeline.h"
+#include "Sensor_History.h"
+#include "Sensor_Archive.h"
+#include "Sensor_Stats.h"
+#include "Alert_Engine.h"
 #include "dashboard_html.h"  // Main dashboard
 #include "config_html.h"     // Email config dashboard
 
@@ -29,6 +51,11 @@
 // ============================================================================
 #define DNS_PORT 53
 #define DRD_TIMEOUT 3000  // 3 seconds for double reset detection
+#define DRD_MAX_RESETS 2  // Resets in a row counted (one mode per count)
+#define BOOT_BUDGET_MS 8000  // Reset to portal ready; logged and reported when exceeded
+#define I2C_SDA 21           // Sensor bus
+#define I2C_SCL 22
+#define SENSOR_PERIOD_MS 1000  // Sampling rate of the sensor task
 
 // ============================================================================
 // SYSTEM INFORMATION
@@ -55,367 +82,673 @@ DashboardMode currentMode = MODE_MAIN;
 // ============================================================================
 // INSTANCES
 // ============================================================================
-DNSServer dnsServer;              // DNS server for captive portal
-WebServer server(80);             // HTTP web server on port 80
-DRD_Manager drd(DRD_TIMEOUT);     // Double reset detector
+extern Metric_RouteTable httpRoutes;
+
+/**
+ * @brief WebServer that registers each path as a metrics route label
+ * Requests are labelled with the path they matched, so any URI a client
+ * makes up lands in route="not_found" instead of taking a slot.
+ */
+class Routed_WebServer : public WebServer {
+public:
+  using WebServer::WebServer;
+
+  template <typename... Args>
+  void on(const char* uri, Args&&... args) {
+    if (!httpRoutes.add(uri)) LOG_W(LOG_MAIN, "Route table full, %s counted as other", uri);
+    WebServer::on(uri, std::forward<Args>(args)...);
+  }
+};
+
+Captive_DNS captiveDns;           // DNS server for captive portal (AsyncUDP task)
+Routed_WebServer server(80);      // HTTP web server on port 80
+DRD_Manager drd(DRD_TIMEOUT, DRD_MAX_RESETS);  // Double reset detector
+WiFi_Manager wifiMgr;             // Non-blocking STA connection manager
+Boot_Timeline bootTimeline;       // Boot phase timestamps (RTC memory)
 
 // GSM instances
 GSM_Test gsmModem(Serial2, 16, 17, 115200);  // GSM modem on Serial2 (RX=16, TX=17)
 SMTP smtp(Serial2, 16, 17, 115200);          // SMTP client for GSM email
+Uplink_Manager uplink(Serial2);              // WiFi/GSM upstream failover
+Job_Scheduler scheduler;                     // Runs all loop() work
+Stall_Monitor stalls;                        // Long loop() iterations, task watchdog
+Metrics_Registry metrics;                    // Prometheus /metrics
+int8_t httpJob = Job_Scheduler::INVALID_JOB; // Scheduler id of the HTTP job
+bool uplinkGsmEnabled = false;               // Set once the modem bring-up is done
 
 
 
 // ============================================================================
-// CONFIGURATION FILES
+// CONFIGURATION STORAGE
 // ============================================================================
+Config_Store configStore;         // Binary settings record in NVS
+FS_Manager storage;               // LittleFS data partition (atomic writes)
+
+// Legacy JSON files, only read once to migrate into configStore
 static const char* WIFI_FILE = "/wifi.json";
 static const char* GSM_FILE = "/gsm.json";
 static const char* USER_FILE = "/user.json";
 static const char* EMAIL_FILE = "/email.json";
-static const char* DEFAULT_AP_SSID = "Config panel";
-static const char* DEFAULT_AP_PASS = "12345678";
+#define DEFAULT_AP_SSID "Config panel"
+#define DEFAULT_AP_PASS "12345678"
 
 // ============================================================================
 // WIFI SCAN CACHE
 // ============================================================================
-String lastScanJson;
-bool lastScanAvailable = false;
+WiFi_ScanCache scanCache;         // Deduplicated results of the last scan
+WiFi_Roaming roaming(wifiMgr, scanCache);  // Saved-network roaming policy
+
+// ============================================================================
+// CONFIGURATION STRUCTURES
+// ============================================================================
+// Each structure lists its fields once (kind, name, size, default, lo, hi,
+// flags); see Config_Schema.h. The schema drives JSON load/save, validation
+// and the binary record, so adding a setting is a one-line change.
+
+bool saveConfig();  // Queues all configuration structures for one deferred record write
 
 /**
- * @brief Process WiFi scan results and cache them
+ * @brief Read a legacy JSON file through a structure's schema (migration only)
+ * A file that does not parse or validate is renamed to <path>.bad, so its
+ * settings are kept for inspection and it is not retried on every boot.
+ * @return true if the file existed and was applied
  */
-void processWiFiScanResults() {
-  int n = WiFi.scanComplete();
-  if (n == WIFI_SCAN_FAILED) {
-    Serial.println(" WiFi scan failed");
-    lastScanAvailable = false;
-    return;
-  }
-  
-  if (n == 0) {
-    Serial.println(" No networks found");
-    lastScanJson = "[]";
-    lastScanAvailable = true;
-    return;
-  }
-  
-  Serial.printf(" Found %d networks\n", n);
-  
-  DynamicJsonDocument doc(2048);
-  JsonArray networks = doc.to<JsonArray>();
-  
-  for (int i = 0; i < n; i++) {
-    JsonObject network = networks.createNestedObject();
-    network["ssid"] = WiFi.SSID(i);
-    network["rssi"] = WiFi.RSSI(i);
-    network["encryption"] = (WiFi.encryptionType(i) == WIFI_AUTH_OPEN) ? "Open" : "Secure";
-    network["auth"] = (WiFi.encryptionType(i) == WIFI_AUTH_OPEN) ? 0 : 1;
-    
-    // Add signal strength description
-    int rssi = WiFi.RSSI(i);
-    if (rssi >= -60) network["strength"] = "strong";
-    else if (rssi >= -75) network["strength"] = "medium";
-    else network["strength"] = "weak";
+static bool loadLegacyFile(const char* path, const ConfigSchema& schema, void* obj,
+                           DynamicJsonDocument& doc) {
+  if (!storage.fs().exists(path)) return false;
+  File f = storage.fs().open(path, "r");
+  if (!f) return false;
+  DeserializationError e = deserializeJson(doc, f);
+  f.close();
+
+  char err[64];
+  if (e) {
+    snprintf(err, sizeof(err), "%s", e.c_str());
+  } else if (cfgFromJson(schema, obj, doc.as<JsonObjectConst>(), false, err, sizeof(err))) {
+    return true;
   }
-  
-  serializeJson(doc, lastScanJson);
-  lastScanAvailable = true;
-  
-  // Clean up scan results
-  WiFi.scanDelete();
+  String bad = String(path) + ".bad";
+  storage.fs().rename(path, bad.c_str());
+  Serial.printf(" Legacy %s not imported (%s), kept as %s\n", path, err, bad.c_str());
+  return false;
 }
 
-// ============================================================================
-// CONFIGURATION STRUCTURES
-// ============================================================================
-
 /**
  * @brief WiFi Configuration Structure
  * Stores both Access Point and Station mode settings
  */
+#define WIFI_CONFIG_FIELDS(X) \
+  X(STR,  apSsid,         33, DEFAULT_AP_SSID, 0, 0,  CFG_REQUIRED)                 /* Access Point SSID */ \
+  X(STR,  apPass,         64, DEFAULT_AP_PASS, 8, 0,  CFG_SECRET)                   /* Access Point password */ \
+  X(STR,  staSsid,        33, "",              0, 0,  CFG_INTERNAL)                 /* Station mode SSID */ \
+  X(STR,  staPass,        64, "",              0, 0,  CFG_INTERNAL | CFG_SECRET)    /* Station mode password */ \
+  X(BOOL, staAutoConnect,  0, true,            0, 0,  CFG_INTERNAL)                 /* Cleared by /api/wifi/disconnect */ \
+  X(BLOB, profiles, WiFiProfileList, 0,        0, 0,  CFG_INTERNAL | CFG_SECRET)    /* Saved STA networks */ \
+  X(STR,  staBssid,       18, "",              0, 0,  CFG_INTERNAL)                 /* Last good AP BSSID */ \
+  X(INT,  staChannel,      0, 0,               0, 14, CFG_INTERNAL)                 /* Last good channel (0 = unknown) */ \
+  X(BOOL, staReuseIp,      0, false,           0, 0,  0)                            /* Re-apply last lease on boot */ \
+  X(STR,  staIp,          16, "",              0, 0,  CFG_INTERNAL)                 /* Last DHCP lease */ \
+  X(STR,  staGateway,     16, "",              0, 0,  CFG_INTERNAL) \
+  X(STR,  staMask,        16, "",              0, 0,  CFG_INTERNAL) \
+  X(STR,  staDns,         16, "",              0, 0,  CFG_INTERNAL)
+
 struct WifiConfig {
-  String staSsid;  // Station mode SSID (client mode)
-  String staPass;  // Station mode password
-  String apSsid;   // Access Point SSID
-  String apPass;   // Access Point password
+  WIFI_CONFIG_FIELDS(CFG_DECLARE)
+
+  static const ConfigSchema& schema();
 
   /**
-   * @brief Load WiFi configuration from SPIFFS
+   * @brief Load legacy wifi.json from the filesystem (migration only)
    * @return true if loaded successfully, false otherwise
    */
-  bool load() {
-    if (!SPIFFS.exists(WIFI_FILE)) return false;
-    File f = SPIFFS.open(WIFI_FILE, "r");
-    if (!f) return false;
-    DynamicJsonDocument doc(1024);
-    if (deserializeJson(doc, f)) { f.close(); return false; }
-    f.close();
-    staSsid = doc["staSsid"] | "";
-    staPass = doc["staPass"] | "";
-    apSsid = doc["apSsid"] | DEFAULT_AP_SSID;
-    apPass = doc["apPass"] | DEFAULT_AP_PASS;
+  bool loadLegacy() {
+    DynamicJsonDocument doc(2048);
+    if (!loadLegacyFile(WIFI_FILE, schema(), this, doc)) return false;
+
+    profiles.clear();
+    JsonArray list = doc["profiles"];
+    for (JsonObject p : list) {
+      profiles.upsert(p["ssid"] | "", p["pass"] | "", p["priority"] | 0);
+    }
+    // Files from before profiles existed only have staSsid
+    if (!profiles.count && staSsid[0]) {
+      profiles.upsert(staSsid, staPass, 0);
+    }
     return true;
   }
 
   /**
-   * @brief Save WiFi configuration to SPIFFS
+   * @brief Save WiFi configuration (whole settings record)
    * @return true if saved successfully, false otherwise
    */
-  bool save() const {
-    DynamicJsonDocument doc(1024);
-    doc["staSsid"] = staSsid;
-    doc["staPass"] = staPass;
-    doc["apSsid"] = apSsid.length() ? apSsid : DEFAULT_AP_SSID;
-    doc["apPass"] = apPass.length() ? apPass : DEFAULT_AP_PASS;
-    File f = SPIFFS.open(WIFI_FILE, "w");
-    if (!f) return false;
-    serializeJson(doc, f);
-    f.close();
+  bool save() const { return saveConfig(); }
+
+  /**
+   * @brief Forget the fast reconnect cache (BSSID, channel, lease)
+   */
+  void clearFastConnect() {
+    staBssid[0] = '\0';
+    staChannel = 0;
+    staIp[0] = '\0';
+    staGateway[0] = '\0';
+    staMask[0] = '\0';
+    staDns[0] = '\0';
+  }
+
+  /**
+   * @brief Build fast reconnect hints from the cached values
+   * @param hints Output hints structure
+   * @return true if a usable BSSID/channel pair is cached
+   */
+  bool fastConnectHints(WiFi_Manager::ConnectHints& hints) const {
+    memset(&hints, 0, sizeof(hints));
+    if (staChannel <= 0 || !WiFi_Manager::parseBssid(staBssid, hints.bssid)) return false;
+    hints.channel = staChannel;
+
+    IPAddress ip, gw, mask, dns;
+    if (staReuseIp && ip.fromString(staIp) && gw.fromString(staGateway) && mask.fromString(staMask)) {
+      if (!dns.fromString(staDns)) dns = gw;
+      hints.ip = (uint32_t)ip;
+      hints.gateway = (uint32_t)gw;
+      hints.mask = (uint32_t)mask;
+      hints.dns = (uint32_t)dns;
+    }
     return true;
   }
 } wifiCfg;
 
+CFG_DEFINE_SCHEMA(WifiConfig, WIFI_CONFIG_FIELDS)
+
 /**
  * @brief GSM Configuration Structure
  * Stores carrier and APN settings for GSM connectivity
  */
+#define GSM_CONFIG_FIELDS(X) \
+  X(STR, carrierName, 33, "", 0, 0, 0)           /* Network carrier name (e.g., "Dialog", "Mobitel") */ \
+  X(STR, apn,         64, "", 0, 0, 0)           /* Access Point Name for data connection */ \
+  X(STR, apnUser,     33, "", 0, 0, 0)           /* APN username (if required) */ \
+  X(STR, apnPass,     33, "", 0, 0, CFG_SECRET)  /* APN password (if required) */
+
 struct GsmConfig {
-  String carrierName;  // Network carrier name (e.g., "Dialog", "Mobitel")
-  String apn;          // Access Point Name for data connection
-  String apnUser;      // APN username (if required)
-  String apnPass;      // APN password (if required)
+  GSM_CONFIG_FIELDS(CFG_DECLARE)
+
+  static const ConfigSchema& schema();
 
   /**
-   * @brief Load GSM configuration from SPIFFS
+   * @brief Load legacy gsm.json from the filesystem (migration only)
    * @return true if loaded successfully, false otherwise
    */
-  bool load() {
-    if (!SPIFFS.exists(GSM_FILE)) return false;
-    File f = SPIFFS.open(GSM_FILE, "r");
-    if (!f) return false;
+  bool loadLegacy() {
     DynamicJsonDocument doc(1024);
-    if (deserializeJson(doc, f)) { f.close(); return false; }
-    f.close();
-    carrierName = doc["carrierName"] | "";
-    apn = doc["apn"] | "";
-    apnUser = doc["apnUser"] | "";
-    apnPass = doc["apnPass"] | "";
-    return true;
+    return loadLegacyFile(GSM_FILE, schema(), this, doc);
   }
 
   /**
-   * @brief Save GSM configuration to SPIFFS
+   * @brief Save GSM configuration (whole settings record)
    * @return true if saved successfully, false otherwise
    */
-  bool save() const {
-    DynamicJsonDocument doc(1024);
-    doc["carrierName"] = carrierName;
-    doc["apn"] = apn;
-    doc["apnUser"] = apnUser;
-    doc["apnPass"] = apnPass;
-    File f = SPIFFS.open(GSM_FILE, "w");
-    if (!f) return false;
-    serializeJson(doc, f);
-    f.close();
-    return true;
-  }
+  bool save() const { return saveConfig(); }
 } gsmCfg;
 
+CFG_DEFINE_SCHEMA(GsmConfig, GSM_CONFIG_FIELDS)
+
 /**
  * @brief User Profile Configuration Structure
  * Stores user information for the dashboard
  */
+#define USER_CONFIG_FIELDS(X) \
+  X(STR, name,  64, "", 0, 0, 0)  /* User's full name */ \
+  X(STR, email, 64, "", 0, 0, 0)  /* User's email address */ \
+  X(STR, phone, 24, "", 0, 0, 0)  /* User's phone number */
+
 struct UserConfig {
-  String name;   // User's full name
-  String email;  // User's email address
-  String phone;  // User's phone number
+  USER_CONFIG_FIELDS(CFG_DECLARE)
+
+  static const ConfigSchema& schema();
 
   /**
-   * @brief Load user configuration from SPIFFS
+   * @brief Load legacy user.json from the filesystem (migration only)
    * @return true if loaded successfully, false otherwise
    */
-  bool load() {
-    if (!SPIFFS.exists(USER_FILE)) return false;
-    File f = SPIFFS.open(USER_FILE, "r");
-    if (!f) return false;
+  bool loadLegacy() {
     DynamicJsonDocument doc(1024);
-    if (deserializeJson(doc, f)) { f.close(); return false; }
-    f.close();
-    name = doc["name"] | "";
-    email = doc["email"] | "";
-    phone = doc["phone"] | "";
-    return true;
+    return loadLegacyFile(USER_FILE, schema(), this, doc);
   }
 
   /**
-   * @brief Save user configuration to SPIFFS
+   * @brief Save user configuration (whole settings record)
    * @return true if saved successfully, false otherwise
    */
-  bool save() const {
-    DynamicJsonDocument doc(1024);
-    doc["name"] = name;
-    doc["email"] = email;
-    doc["phone"] = phone;
-    File f = SPIFFS.open(USER_FILE, "w");
-    if (!f) return false;
-    serializeJson(doc, f);
-    f.close();
-    return true;
-  }
+  bool save() const { return saveConfig(); }
 } userCfg;
 
+CFG_DEFINE_SCHEMA(UserConfig, USER_CONFIG_FIELDS)
+
 /**
  * @brief Email Configuration Structure
  * Stores SMTP settings for email functionality
  */
+#define EMAIL_CONFIG_FIELDS(X) \
+  X(STR, smtpHost,      64, "smtp.gmail.com", 0, 0,     CFG_REQUIRED)  /* SMTP server hostname */ \
+  X(INT, smtpPort,       0, 465,              1, 65535, 0)             /* SMTP server port (465 for SSL) */ \
+  X(STR, emailAccount,  64, "",               0, 0,     0)             /* Email account for authentication */ \
+  X(STR, emailPassword, 64, "",               0, 0,     CFG_SECRET)    /* App password for authentication */ \
+  X(STR, senderName,    64, "ESP32 Device",   0, 0,     0)             /* Display name for sender */
+
 struct EmailConfig {
-  String smtpHost = "smtp.gmail.com";  // SMTP server hostname
-  int smtpPort = 465;                   // SMTP server port (465 for SSL)
-  String emailAccount = "";             // Email account for authentication
-  String emailPassword = "";            // App password for authentication
-  String senderName = "ESP32 Device";   // Display name for sender
+  EMAIL_CONFIG_FIELDS(CFG_DECLARE)
+
+  static const ConfigSchema& schema();
 
   /**
-   * @brief Load email configuration from SPIFFS
+   * @brief Load legacy email.json from the filesystem (migration only)
    * @return true if loaded successfully, false otherwise
    */
-  bool load() {
-    if (!SPIFFS.exists(EMAIL_FILE)) return false;
-    File f = SPIFFS.open(EMAIL_FILE, "r");
-    if (!f) return false;
+  bool loadLegacy() {
     DynamicJsonDocument doc(1024);
-    if (deserializeJson(doc, f)) { f.close(); return false; }
-    f.close();
-    smtpHost = doc["smtpHost"] | smtpHost;
-    smtpPort = doc["smtpPort"] | smtpPort;
-    emailAccount = doc["emailAccount"] | emailAccount;
-    emailPassword = doc["emailPassword"] | emailPassword;
-    senderName = doc["senderName"] | senderName;
-    return true;
+    return loadLegacyFile(EMAIL_FILE, schema(), this, doc);
   }
 
   /**
-   * @brief Save email configuration to SPIFFS
+   * @brief Save email configuration (whole settings record)
    * @return true if saved successfully, false otherwise
    */
-  bool save() const {
-    DynamicJsonDocument doc(1024);
-    doc["smtpHost"] = smtpHost;
-    doc["smtpPort"] = smtpPort;
-    doc["emailAccount"] = emailAccount;
-    doc["emailPassword"] = emailPassword;
-    doc["senderName"] = senderName;
-    File f = SPIFFS.open(EMAIL_FILE, "w");
-    if (!f) return false;
-    serializeJson(doc, f);
-    f.close();
-    return true;
-  }
+  bool save() const { return saveConfig(); }
 
   /**
    * @brief Check if email configuration is valid
    * @return true if all required fields are filled, false otherwise
    */
   bool isValid() const {
-    return smtpHost.length() > 0 && emailAccount.length() > 0 && emailPassword.length() > 0;
+    return smtpHost[0] && emailAccount[0] && emailPassword[0];
   }
 } emailCfg;
 
-// ============================================================================
-// SENSOR DATA
-// ============================================================================
+CFG_DEFINE_SCHEMA(EmailConfig, EMAIL_CONFIG_FIELDS)
+
 /**
- * @brief Sensor Data Structure
- * Generates realistic fake sensor readings for environmental monitoring
+ * @brief Sensor Alert Configuration Structure
+ * Alert rules (syntax in Alert_Engine.h) and where notifications go
  */
-struct SensorData {
-  float temperature = 22.5;    // Temperature in Celsius
-  float humidity = 65.0;        // Humidity percentage
-  float light = 850.0;          // Light level in lux
-  unsigned long lastUpdate = 0;
-  const unsigned long UPDATE_INTERVAL = 3000; // Update every 3 seconds
-  
+#define ALERT_CONFIG_FIELDS(X) \
+  X(BOOL, enabled,   0, false, 0, 0,     0)  /* Evaluate the rules on every sample */ \
+  X(STR,  smsTo,    24, "",    0, 0,     0)  /* Phone number for "sms" rules */ \
+  X(STR,  emailTo,  64, "",    0, 0,     0)  /* Recipient for "email" rules */ \
+  X(STR,  postTo,   96, "",    0, 0,     0)  /* host[:port][/path] for "post" rules */ \
+  X(INT,  cooldown,  0, 900,   0, 86400, 0)  /* Seconds between notifications of one rule */ \
+  X(STR,  rules,  1024, "",    0, 0,     0)  /* One rule per line or ';' */
+
+struct AlertConfig {
+  ALERT_CONFIG_FIELDS(CFG_DECLARE)
+
+  static const ConfigSchema& schema();
+
   /**
-   * @brief Update sensor readings with realistic variations
+   * @brief Save alert configuration (whole settings record)
+   * @return true if saved successfully, false otherwise
    */
-  void update() {
-    if (millis() - lastUpdate > UPDATE_INTERVAL) {
-      // Temperature: varies between 18-32°C with gradual changes
-      temperature += (random(-20, 21) / 100.0); // ±0.2°C change
-      temperature = constrain(temperature, 18.0, 32.0);
-      
-      // Humidity: varies between 30-90% with gradual changes
-      humidity += (random(-30, 31) / 100.0); // ±0.3% change
-      humidity = constrain(humidity, 30.0, 90.0);
-      
-      // Light: varies between 0-2000 lux with more dramatic changes
-      light += (random(-200, 201) / 10.0); // ±20 lux change
-      light = constrain(light, 0.0, 2000.0);
-      
-      lastUpdate = millis();
-      
-      Serial.printf(" Sensor Update: %.1f°C, %.1f%%, %.0f lx\n", 
-                    temperature, humidity, light);
+  bool save() const { return saveConfig(); }
+} alertCfg;
+
+CFG_DEFINE_SCHEMA(AlertConfig, ALERT_CONFIG_FIELDS)
+
+/**
+ * @brief Binary-store bookkeeping for /api/config/store
+ */
+struct ConfigLoadInfo {
+  Config_Store::LoadResult result = Config_Store::LOAD_EMPTY;
+  bool migrated = false;         // Legacy JSON files imported this boot
+  uint32_t legacyLoadUs = 0;     // Time spent parsing the JSON files
+  uint16_t payloadBytes = 0;     // Encoded size of the current settings
+} configLoadInfo;
+
+/**
+ * @brief Request-side cost of the /api/save handlers (the flash write happens later in loop())
+ */
+struct ConfigSaveLatency {
+  uint32_t requests = 0;
+  uint32_t lastUs = 0;
+  uint32_t maxUs = 0;
+  
+  void note(uint32_t startUs) {
+    lastUs = micros() - startUs;
+    if (lastUs > maxUs) maxUs = lastUs;
+    requests++;
+  }
+} configSaveLatency;
+
+// Payload buffer for loadConfig()
+static uint8_t configPayload[CONFIG_RECORD_MAX];
+
+/**
+ * @brief Encode all configuration structures into one record payload
+ * Called by configStore when a deferred write is due.
+ * @return Payload length, 0 if it does not fit
+ */
+size_t encodeConfig(uint8_t* buf, size_t cap) {
+  size_t len = 0, n;
+  if (!(n = cfgEncode(WifiConfig::schema(), &wifiCfg, buf + len, cap - len))) return 0;
+  len += n;
+  if (!(n = cfgEncode(GsmConfig::schema(), &gsmCfg, buf + len, cap - len))) return 0;
+  len += n;
+  if (!(n = cfgEncode(UserConfig::schema(), &userCfg, buf + len, cap - len))) return 0;
+  len += n;
+  if (!(n = cfgEncode(EmailConfig::schema(), &emailCfg, buf + len, cap - len))) return 0;
+  len += n;
+  if (!(n = cfgEncode(AlertConfig::schema(), &alertCfg, buf + len, cap - len))) return 0;
+  len += n;
+  configLoadInfo.payloadBytes = len;
+  return len;
+}
+
+/**
+ * @brief Mark the settings as changed
+ * The record is written by configStore.loop() once changes settle, so
+ * several saves in a row cost one flash write.
+ * @return Always true (write errors are reported by the store)
+ */
+bool saveConfig() {
+  configStore.markDirty();
+  return true;
+}
+
+/**
+ * @brief Apply a schema version 1 record (fixed ConfigRecordV1 layout)
+ * @return false if the payload does not have the v1 size
+ */
+static bool applyRecordV1(const uint8_t* buf, size_t len) {
+  static ConfigRecordV1 r;
+  if (len != sizeof(r)) return false;
+  memcpy(&r, buf, sizeof(r));
+
+  cfgSet(wifiCfg.staSsid, r.wifi.staSsid);
+  cfgSet(wifiCfg.staPass, r.wifi.staPass);
+  cfgSet(wifiCfg.apSsid, r.wifi.apSsid[0] ? r.wifi.apSsid : DEFAULT_AP_SSID);
+  cfgSet(wifiCfg.apPass, r.wifi.apPass[0] ? r.wifi.apPass : DEFAULT_AP_PASS);
+  wifiCfg.staAutoConnect = r.wifi.staAutoConnect;
+  wifiCfg.profiles.clear();
+  for (size_t i = 0; i < r.wifi.profileCount && i < WIFI_MAX_PROFILES; i++) {
+    wifiCfg.profiles.upsert(r.wifi.profiles[i].ssid, r.wifi.profiles[i].pass, r.wifi.profiles[i].priority);
+  }
+  static const uint8_t noBssid[6] = { 0 };
+  cfgSet(wifiCfg.staBssid, memcmp(r.wifi.staBssid, noBssid, 6) ? WiFi_Manager::formatBssid(r.wifi.staBssid).c_str() : "");
+  wifiCfg.staChannel = r.wifi.staChannel;
+  wifiCfg.staReuseIp = r.wifi.staReuseIp;
+  cfgSet(wifiCfg.staIp, r.wifi.staIp ? IPAddress(r.wifi.staIp).toString().c_str() : "");
+  cfgSet(wifiCfg.staGateway, r.wifi.staGateway ? IPAddress(r.wifi.staGateway).toString().c_str() : "");
+  cfgSet(wifiCfg.staMask, r.wifi.staMask ? IPAddress(r.wifi.staMask).toString().c_str() : "");
+  cfgSet(wifiCfg.staDns, r.wifi.staDns ? IPAddress(r.wifi.staDns).toString().c_str() : "");
+
+  cfgSet(gsmCfg.carrierName, r.gsm.carrierName);
+  cfgSet(gsmCfg.apn, r.gsm.apn);
+  cfgSet(gsmCfg.apnUser, r.gsm.apnUser);
+  cfgSet(gsmCfg.apnPass, r.gsm.apnPass);
+
+  cfgSet(userCfg.name, r.user.name);
+  cfgSet(userCfg.email, r.user.email);
+  cfgSet(userCfg.phone, r.user.phone);
+
+  cfgSet(emailCfg.smtpHost, r.email.smtpHost);
+  emailCfg.smtpPort = r.email.smtpPort;
+  cfgSet(emailCfg.emailAccount, r.email.emailAccount);
+  cfgSet(emailCfg.emailPassword, r.email.emailPassword);
+  cfgSet(emailCfg.senderName, r.email.senderName);
+  return true;
+}
+
+/**
+ * @brief Load all configuration structures at boot
+ * Reads the NVS record in one go; on first boot after the update the
+ * legacy JSON files are imported, written as a record and removed.
+ */
+void loadConfig() {
+  Heap_Scope scope(HEAP_CONFIG);
+  size_t len = 0;
+  configLoadInfo.result = configStore.load(configPayload, sizeof(configPayload), len);
+  
+  if (configLoadInfo.result == Config_Store::LOAD_OK) {
+    if (configStore.storedVersion() == 1) {
+      if (applyRecordV1(configPayload, len)) {
+        Serial.println(" Config record upgraded from schema v1");
+        saveConfig();
+        configStore.flush();
+      }
+    } else {
+      // Sections missing from the record keep their struct defaults
+      cfgDecode(WifiConfig::schema(), &wifiCfg, configPayload, len);
+      cfgDecode(GsmConfig::schema(), &gsmCfg, configPayload, len);
+      cfgDecode(UserConfig::schema(), &userCfg, configPayload, len);
+      cfgDecode(EmailConfig::schema(), &emailCfg, configPayload, len);
+      cfgDecode(AlertConfig::schema(), &alertCfg, configPayload, len);
+      configLoadInfo.payloadBytes = len;
     }
+    Serial.printf(" Config loaded from NVS in %u us\n", configStore.lastLoadUs());
+    return;
   }
   
-  /**
-   * @brief Get current sensor readings as JSON
-   * @return JSON string with current sensor values
-   */
-  String toJson() {
-    DynamicJsonDocument doc(256);
-    doc["temperature"] = round(temperature * 10) / 10.0; // Round to 1 decimal
-    doc["humidity"] = round(humidity * 10) / 10.0;       // Round to 1 decimal
-    doc["light"] = round(light);                         // Round to whole number
-    doc["timestamp"] = millis();
-    
-    String out;
-    serializeJson(doc, out);
-    return out;
+  // No usable record: import the legacy JSON files once
+  uint32_t t0 = micros();
+  bool wifi = wifiCfg.loadLegacy();
+  bool gsm = gsmCfg.loadLegacy();
+  bool user = userCfg.loadLegacy();
+  bool email = emailCfg.loadLegacy();
+  configLoadInfo.legacyLoadUs = micros() - t0;
+  
+  if (!wifi && !gsm && !user && !email) return;  // Fresh device, defaults apply
+  
+  // Write now: the imported files are deleted right after
+  saveConfig();
+  if (configStore.flush()) {
+    configLoadInfo.migrated = true;
+    if (wifi) storage.fs().remove(WIFI_FILE);
+    if (gsm) storage.fs().remove(GSM_FILE);
+    if (user) storage.fs().remove(USER_FILE);
+    if (email) storage.fs().remove(EMAIL_FILE);
+    Serial.printf(" Migrated JSON config to NVS (JSON load %u us, record %u bytes)\n",
+                  configLoadInfo.legacyLoadUs, (unsigned)configStore.recordSize());
   }
-} sensorData;
+}
 
-// ----------------------------------------------------------------------------
-// SENSOR TEST SAMPLING (10 quick samples without continuous updates)
-// ----------------------------------------------------------------------------
+// ============================================================================
+// SENSOR DATA
+// ============================================================================
+// Drivers are probed at boot; with no sensor on the bus (or with
+// -D SENSOR_SIMULATOR) the simulator feeds the pipeline instead.
+Sensor_SHT3x sht3x(Wire);                    // Temperature + humidity (0x44)
+Sensor_BH1750 bh1750(Wire);                  // Light (0x23)
+Sensor_Simulator sensorSimulator;            // Random walk, no hardware
+Sensor_Pipeline sensors;                     // Sampling task + latest slot
+Sensor_History sensorHistory;                // Compressed samples (32 KB ring)
+Sensor_Archive sensorArchive;                // Sealed blocks in the "history" partition
+Sensor_Stats sensorStats;                    // Rolling 1 min / 1 h / 24 h aggregates
+Alert_Engine alerts;                         // Compiled alertCfg.rules
 
 /**
- * @brief Build JSON array with a fixed number of simulated sensor samples
- * Generates samples immediately without waiting for UPDATE_INTERVAL.
+ * @brief Consume one sample on the loop task (every sample, in order)
  */
-String buildSensorTestSamplesJson(size_t sampleCount) {
-  // Use local copies to avoid mutating the live sensor state while sampling
-  float t = sensorData.temperature;
-  float h = sensorData.humidity;
-  float l = sensorData.light;
-
-  DynamicJsonDocument doc(1024);
-  JsonArray arr = doc.to<JsonArray>();
-
-  for (size_t i = 0; i < sampleCount; i++) {
-    // Apply same variation model as live updates, but faster and locally
-    t += (random(-20, 21) / 100.0f);
-    t = constrain(t, 18.0f, 32.0f);
+void onSensorSample(const Sensor_Sample& s) {
+  sensorHistory.append(s);
+  sensorStats.add(s, sensorHistory.toHistoryMs(s.ms));
+  if (alertCfg.enabled) alerts.evaluate(s);
+  LOG_D(LOG_SENSOR, "Sample %u: %d.%u C, %u %%, %u lx", s.seq, (int)s.value[SENSOR_TEMPERATURE],
+        (unsigned)(fabsf(s.value[SENSOR_TEMPERATURE]) * 10) % 10, (unsigned)s.value[SENSOR_HUMIDITY],
+        (unsigned)s.value[SENSOR_LIGHT]);
+}
 
-    h += (random(-30, 31) / 100.0f);
-    h = constrain(h, 30.0f, 90.0f);
+/**
+ * @brief Compile alertCfg into the alert engine
+ * @param err Receives the reason on failure (the previous rules stay active)
+ * @return true if the rules compiled
+ */
+bool applyAlertConfig(char* err, size_t errLen) {
+  if (!alerts.compile(alertCfg.rules, err, errLen)) return false;
+  alerts.setCooldown(alertCfg.cooldown * 1000UL);  // Only with rules that compiled
+  return true;
+}
 
-    l += (random(-200, 201) / 10.0f);
-    l = constrain(l, 0.0f, 2000.0f);
+/**
+ * @brief Drain the pipeline queue ("sensors" job)
+ */
+void pollSensors() {
+  Sensor_Sample s;
+  while (sensors.pop(s)) onSensorSample(s);
+}
 
-    JsonObject sample = arr.createNestedObject();
-    sample["temperature"] = round(t * 10) / 10.0; // 1dp
-    sample["humidity"] = round(h * 10) / 10.0;    // 1dp
-    sample["light"] = round(l);                   // integer
-    sample["index"] = (int)i;
+/**
+ * @brief Current readings as JSON (channels without a sensor are null)
+ * @return JSON string with the latest sample
+ */
+String buildSensorsJson() {
+  Sensor_Sample s;
+  DynamicJsonDocument doc(256);
+  if (sensors.latest(s)) {
+    if (s.has(SENSOR_TEMPERATURE)) doc["temperature"] = round(s.value[SENSOR_TEMPERATURE] * 10) / 10.0;  // 1 decimal
+    else doc["temperature"] = nullptr;
+    if (s.has(SENSOR_HUMIDITY)) doc["humidity"] = round(s.value[SENSOR_HUMIDITY] * 10) / 10.0;           // 1 decimal
+    else doc["humidity"] = nullptr;
+    if (s.has(SENSOR_LIGHT)) doc["light"] = round(s.value[SENSOR_LIGHT]);                                // Whole lux
+    else doc["light"] = nullptr;
+    doc["timestamp"] = s.ms;   // Uptime when the sample was taken
+    doc["seq"] = s.seq;
   }
-
+  doc["simulated"] = sensors.simulated();
+  
   String out;
   serializeJson(doc, out);
   return out;
 }
 
+// ----------------------------------------------------------------------------
+// SENSOR TEST SAMPLING (simulated samples without continuous updates)
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Random-walk test samples, generated in fixed point in batches
+ * Same step model as Sensor_Simulator (±0.2 °C, ±0.3 %RH, ±20 lx per
+ * sample) from one xorshift32 draw per sample; no floats, no division.
+ * The walk runs in 0.01 °C / 0.01 %RH / 0.1 lx, the output in the 0.1 °C /
+ * 0.1 %RH / 1 lx the dashboard shows. It is bounded only by what the
+ * drivers can report (SHT3x -45..130 °C and 0..100 %RH, BH1750
+ * 0..54612 lx), so it carries on from any real reading.
+ */
+struct TestSampleGen {
+  static const uint8_t BATCH = 32;
+  static const int32_t T_MIN = -4500, T_MAX = 13000;  // 0.01 °C
+  static const int32_t H_MIN = 0, H_MAX = 10000;      // 0.01 %RH
+  static const int32_t L_MIN = 0, L_MAX = 546120;     // 0.1 lx
+  
+  uint32_t rng;
+  int32_t t, h, l;
+  int16_t temp[BATCH];      // 0.1 °C
+  uint16_t hum[BATCH];      // 0.1 %RH
+  uint16_t light[BATCH];    // lx
+  
+  TestSampleGen(uint32_t seed, float t0, float h0, float l0)
+    : rng(seed ? seed : 1),
+      t(constrain(lroundf(t0 * 100), T_MIN, T_MAX)),
+      h(constrain(lroundf(h0 * 100), H_MIN, H_MAX)),
+      l(constrain(lroundf(l0 * 10), L_MIN, L_MAX)) {}
+  
+  void fill(uint8_t n) {
+    for (uint8_t i = 0; i < n; i++) {
+      rng ^= rng << 13;
+      rng ^= rng >> 17;
+      rng ^= rng << 5;
+      // Three uniform steps from 10 + 10 + 12 bits of the draw
+      t = constrain(t + (int32_t)(((rng & 0x3FF) * 41) >> 10) - 20, T_MIN, T_MAX);
+      h = constrain(h + (int32_t)((((rng >> 10) & 0x3FF) * 61) >> 10) - 30, H_MIN, H_MAX);
+      l = constrain(l + (int32_t)((((rng >> 20) & 0xFFF) * 401) >> 12) - 200, L_MIN, L_MAX);
+      temp[i] = (t + (t < 0 ? -5 : 5)) / 10;  // Round half away from zero
+      hum[i] = (h + 5) / 10;
+      light[i] = (l + 5) / 10;
+    }
+  }
+};
+
+/**
+ * @brief Append an unsigned number, optionally as tenths ("225" -> "22.5")
+ * @return End of the written text
+ */
+static char* putDecimal(char* p, uint32_t v, bool tenths) {
+  char tmp[12];
+  uint8_t n = 0;
+  do {
+    tmp[n++] = '0' + v % 10;
+    v /= 10;
+    if (tenths && n == 1) tmp[n++] = '.';
+  } while (v || (tenths && n < 3));
+  while (n) *p++ = tmp[--n];
+  return p;
+}
+
+/**
+ * @brief Last /api/sensors/test run
+ */
+struct SensorTestRun {
+  uint32_t count = 0;
+  bool csv = false;
+  uint32_t bytes = 0;
+  uint32_t us = 0;
+  uint32_t heapPeakBytes = 0;   // Free heap at the start minus the lowest seen
+} sensorTestRun;
+
+/**
+ * @brief Write simulated samples as a JSON array or CSV
+ * @param out Destination (chunked response or a counting sink)
+ * @param heapLow Receives the lowest free heap seen between batches
+ * @return Bytes written
+ */
+size_t writeSensorTestSamples(Print& out, uint32_t count, bool csv, uint32_t seed, uint32_t& heapLow) {
+  // Start from the latest reading; the live pipeline is not touched
+  Sensor_Sample last;
+  float t = 22.5f, h = 65.0f, l = 850.0f;
+  if (sensors.latest(last)) {
+    if (last.has(SENSOR_TEMPERATURE)) t = last.value[SENSOR_TEMPERATURE];
+    if (last.has(SENSOR_HUMIDITY)) h = last.value[SENSOR_HUMIDITY];
+    if (last.has(SENSOR_LIGHT)) l = last.value[SENSOR_LIGHT];
+  }
+  TestSampleGen gen(seed, t, h, l);
+  
+  size_t bytes = out.print(csv ? "index,temperature,humidity,light\n" : "[");
+  char line[80];
+  for (uint32_t i = 0; i < count; i += TestSampleGen::BATCH) {
+    uint8_t n = min((uint32_t)TestSampleGen::BATCH, count - i);
+    gen.fill(n);
+    for (uint8_t k = 0; k < n; k++) {
+      char* p = line;
+      if (csv) {
+        p = putDecimal(p, i + k, false);
+        *p++ = ',';
+        if (gen.temp[k] < 0) *p++ = '-';
+        p = putDecimal(p, abs(gen.temp[k]), true);
+        *p++ = ',';
+        p = putDecimal(p, gen.hum[k], true);
+        *p++ = ',';
+        p = putDecimal(p, gen.light[k], false);
+        *p++ = '\n';
+      } else {
+        if (i + k) *p++ = ',';
+        memcpy(p, "{\"temperature\":", 15);
+        p += 15;
+        if (gen.temp[k] < 0) *p++ = '-';
+        p = putDecimal(p, abs(gen.temp[k]), true);
+        memcpy(p, ",\"humidity\":", 12);
+        p = putDecimal(p + 12, gen.hum[k], true);
+        memcpy(p, ",\"light\":", 9);
+        p = putDecimal(p + 9, gen.light[k], false);
+        memcpy(p, ",\"index\":", 9);
+        p = putDecimal(p + 9, i + k, false);
+        *p++ = '}';
+      }
+      bytes += out.write((const uint8_t*)line, p - line);
+    }
+    uint32_t free = Heap_Monitor::freeBytes();
+    if (free < heapLow) heapLow = free;
+  }
+  if (!csv) bytes += out.print("]");
+  return bytes;
+}
+
 // ============================================================================
 // GSM CACHE
 // ============================================================================
@@ -423,13 +756,15 @@ String buildSensorTestSamplesJson(size_t sampleCount) {
  * @brief GSM Status Cache Structure
  * Caches GSM signal and network information to reduce modem queries
  * Updates every 5 minutes or on force refresh
+ * Text is copied into fixed buffers: the cache lives for the whole run,
+ * so a refresh never reallocates its fields on the heap
  */
 struct GSMCache {
   int signalStrength = 0;               // Signal strength in dBm
   int signalQuality = 99;               // Signal quality (0-31 scale)
-  String grade = "Unknown";             // Signal grade (Excellent/Good/Fair/Poor)
-  String carrierName = "Unknown";       // Network carrier name
-  String networkMode = "Unknown";       // Network mode (GSM/LTE/etc)
+  char grade[10] = "Unknown";           // Signal grade (Excellent/Good/Fair/Poor)
+  char carrierName[33] = "Unknown";     // Network carrier name
+  char networkMode[16] = "Unknown";     // Network mode (GSM/LTE/etc)
   bool isRegistered = false;            // Network registration status
   unsigned long lastUpdate = 0;         // Timestamp of last update
   const unsigned long UPDATE_INTERVAL = 300000; // 5 minutes cache duration
@@ -449,6 +784,7 @@ struct GSMCache {
    */
   void updateSignal(bool forceRefresh = false) {
     if (needsUpdate(forceRefresh)) {
+      Uplink_Manager::PortLock lock(uplink);
       signalStrength = gsmModem.getSignalStrength();
       if (signalStrength != 0) {
         // Convert dBm to CSQ scale (0-31)
@@ -457,10 +793,10 @@ struct GSMCache {
         if (signalQuality > 31) signalQuality = 31;
         
         // Determine signal grade
-        if (signalQuality >= 20) grade = "Excellent";
-        else if (signalQuality >= 15) grade = "Good";
-        else if (signalQuality >= 10) grade = "Fair";
-        else grade = "Poor";
+        if (signalQuality >= 20) cfgSet(grade, "Excellent");
+        else if (signalQuality >= 15) cfgSet(grade, "Good");
+        else if (signalQuality >= 10) cfgSet(grade, "Fair");
+        else cfgSet(grade, "Poor");
       }
       lastUpdate = millis();
     }
@@ -472,9 +808,11 @@ struct GSMCache {
    */
   void updateNetwork(bool forceRefresh = false) {
     if (needsUpdate(forceRefresh)) {
+      Uplink_Manager::PortLock lock(uplink);
+      Stall_Monitor::Pause pause(stalls);  // Six AT exchanges, up to ~30 s
       GSM_Test::NetworkInfo networkInfo = gsmModem.detectCarrierNetwork();
-      carrierName = networkInfo.carrierName;
-      networkMode = networkInfo.networkMode;
+      cfgSet(carrierName, networkInfo.carrierName.c_str());
+      cfgSet(networkMode, networkInfo.networkMode.c_str());
       isRegistered = networkInfo.isRegistered;
       lastUpdate = millis();
     }
@@ -528,6 +866,152 @@ void sendText(int code, const String& body, const String& ctype = "text/plain")
   server.send(code, ctype, body);
 }
 
+/**
+ * @brief Send a config structure as JSON (secrets masked, internal fields hidden)
+ */
+void sendConfigJson(const ConfigSchema& schema, const void* obj, size_t docSize = 1024) {
+  Heap_Scope scope(HEAP_JSON);
+  DynamicJsonDocument doc(docSize);
+  cfgToJson(schema, obj, doc.to<JsonObject>(), true);
+  String out;
+  serializeJson(doc, out);
+  sendJson(200, out);
+}
+
+/**
+ * @brief Validate the request body against a schema and apply it
+ * @return true if applied; otherwise a 400 response has been sent
+ */
+bool applyConfigJson(const ConfigSchema& schema, void* obj, size_t docSize = 1024) {
+  if (!server.hasArg("plain")) {
+    sendJson(400, "{\"success\":false,\"error\":\"No data\"}");
+    return false;
+  }
+  Heap_Scope scope(HEAP_JSON);
+  DynamicJsonDocument doc(docSize);
+  if (deserializeJson(doc, server.arg("plain")) || !doc.is<JsonObject>()) {
+    sendJson(400, "{\"success\":false,\"error\":\"Invalid JSON\"}");
+    return false;
+  }
+  char err[80];
+  if (!cfgFromJson(schema, obj, doc.as<JsonObjectConst>(), true, err, sizeof(err))) {
+    DynamicJsonDocument res(256);
+    res["success"] = false;
+    res["error"] = err;
+    String out;
+    serializeJson(res, out);
+    sendJson(400, out);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Answer 503 while the modem bring-up is still running
+ * @return true if the request was answered (caller returns)
+ */
+bool modemNotReady() {
+  if (currentMode != MODE_MAIN || gsmModem.isReady()) return false;
+  
+  DynamicJsonDocument doc(192);
+  doc["success"] = false;
+  doc["ok"] = false;
+  doc["status"] = GSM_Test::initStateName(gsmModem.initState());
+  doc["error"] = "Modem is initialising, try again shortly";
+  String out;
+  serializeJson(doc, out);
+  server.sendHeader("Retry-After", "2");
+  sendJson(503, out);
+  return true;
+}
+
+/**
+ * @brief Chunked HTTP response writer
+ * Buffers small writes and forwards them with sendContent() so large
+ * responses can be streamed without building them in a String first.
+ */
+class ChunkedResponse : public Print {
+public:
+  /**
+   * @brief Send headers and switch the response to chunked mode
+   * @param code HTTP status code
+   * @param ctype Content type
+   */
+  void begin(int code, const char* ctype) {
+    _len = 0;
+    addCORS();
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(code, ctype, "");
+  }
+
+  size_t write(uint8_t c) override {
+    if (_len == sizeof(_buf)) flush();
+    _buf[_len++] = c;
+    return 1;
+  }
+
+  size_t write(const uint8_t* data, size_t size) override {
+    for (size_t done = 0; done < size;) {
+      if (_len == sizeof(_buf)) flush();
+      size_t n = min(size - done, sizeof(_buf) - _len);
+      memcpy(_buf + _len, data + done, n);
+      _len += n;
+      done += n;
+    }
+    return size;
+  }
+
+  void flush() override {
+    if (_len) server.sendContent((const char*)_buf, _len);
+    _len = 0;
+  }
+
+  /**
+   * @brief Flush remaining data and terminate the chunked response
+   */
+  void end() {
+    flush();
+    server.sendContent("");
+  }
+
+private:
+  uint8_t _buf[512];
+  size_t _len = 0;
+};
+
+// Samples per /api/sensors/test response or /stats bench run: bounds the
+// time one request keeps loop() busy (~350 KB JSON)
+static const uint32_t SENSOR_TEST_MAX = 5000;
+
+/**
+ * @brief GET /api/sensors/test?count=10&format=json|csv&seed=<n>
+ * Streams count simulated samples (default 10, at most SENSOR_TEST_MAX)
+ * starting from the latest reading. Memory use does not depend on count.
+ */
+void handleSensorTest() {
+  uint32_t count = server.hasArg("count") ? strtoul(server.arg("count").c_str(), nullptr, 10) : 10;
+  bool csv = server.arg("format") == "csv";
+  uint32_t seed = server.hasArg("seed") ? strtoul(server.arg("seed").c_str(), nullptr, 10) : esp_random();
+  if (count < 1 || count > SENSOR_TEST_MAX) {
+    sendJson(400, "{\"success\":false,\"error\":\"count must be 1-5000\"}");
+    return;
+  }
+  
+  uint32_t t0 = micros();
+  uint32_t heapStart = Heap_Monitor::freeBytes();
+  uint32_t heapLow = heapStart;
+  ChunkedResponse out;
+  out.begin(200, csv ? "text/csv" : "application/json");
+  size_t bytes = writeSensorTestSamples(out, count, csv, seed, heapLow);
+  out.end();
+  
+  sensorTestRun.count = count;
+  sensorTestRun.csv = csv;
+  sensorTestRun.bytes = bytes;
+  sensorTestRun.us = micros() - t0;
+  sensorTestRun.heapPeakBytes = heapStart - heapLow;
+}
+
 // ============================================================================
 // WIFI MANAGEMENT
 // ============================================================================
@@ -553,7 +1037,7 @@ void startAP(const String& ssid, const String& pass) {
     WiFi.softAP(DEFAULT_AP_SSID, DEFAULT_AP_PASS);  // Fallback to default
   }
   delay(500);
-  dnsServer.start(DNS_PORT, "*", WiFi.softAPIP());  // Start DNS server for captive portal
+  captiveDns.start(DNS_PORT, WiFi.softAPIP());  // Start DNS server for captive portal
 }
 
 /**
@@ -563,7 +1047,60 @@ void startAP(const String& ssid, const String& pass) {
  */
 void connectSTA(const String& ssid, const String& pass) {
   if (!ssid.length()) return;
-  WiFi.begin(ssid.c_str(), pass.c_str());
+  
+  // Try the cached BSSID/channel first when reconnecting to the saved network
+  WiFi_Manager::ConnectHints hints;
+  bool haveHints = (ssid == wifiCfg.staSsid) && wifiCfg.fastConnectHints(hints);
+  wifiMgr.requestConnect(ssid, pass, haveHints ? &hints : nullptr);
+}
+
+/**
+ * @brief Persist STA credentials once a requested connection succeeds
+ * Also refreshes the fast reconnect cache; only writes when something changed.
+ * @param ssid Network SSID that was connected
+ * @param pass Network password
+ */
+void onWifiConnected(const String& ssid, const String& pass) {
+  bootTimeline.mark(Boot_Timeline::PHASE_STA_CONNECTED);  // First connection only
+  
+  char bssid[18], ip[16], gateway[16], mask[16], dns[16];
+  cfgSet(bssid, WiFi_Manager::formatBssid(WiFi.BSSID()).c_str());
+  int channel = WiFi.channel();
+  cfgSet(ip, ipToStr(WiFi.localIP()).c_str());
+  cfgSet(gateway, ipToStr(WiFi.gatewayIP()).c_str());
+  cfgSet(mask, ipToStr(WiFi.subnetMask()).c_str());
+  cfgSet(dns, ipToStr(WiFi.dnsIP()).c_str());
+  
+  // Every successful network becomes (or stays) a saved profile
+  int idx = wifiCfg.profiles.find(ssid.c_str());
+  bool profileChanged = idx < 0 || strcmp(wifiCfg.profiles.items[idx].pass, pass.c_str()) != 0;
+  if (profileChanged) {
+    uint8_t priority = idx < 0 ? 0 : wifiCfg.profiles.items[idx].priority;
+    if (!wifiCfg.profiles.upsert(ssid.c_str(), pass.c_str(), priority)) {
+      Serial.println("⚠ Profile list full, network not saved as profile");
+      profileChanged = false;
+    }
+  }
+  roaming.setEnabled(true);
+  uplink.setStaConfigured(true);
+  
+  bool changed = profileChanged || !wifiCfg.staAutoConnect ||
+                 strcmp(wifiCfg.staSsid, ssid.c_str()) || strcmp(wifiCfg.staPass, pass.c_str()) ||
+                 strcmp(wifiCfg.staBssid, bssid) || wifiCfg.staChannel != channel ||
+                 strcmp(wifiCfg.staIp, ip) || strcmp(wifiCfg.staGateway, gateway) ||
+                 strcmp(wifiCfg.staMask, mask) || strcmp(wifiCfg.staDns, dns);
+  if (!changed) return;
+  
+  cfgSet(wifiCfg.staSsid, ssid.c_str());
+  cfgSet(wifiCfg.staPass, pass.c_str());
+  cfgSet(wifiCfg.staBssid, bssid);
+  wifiCfg.staChannel = channel;
+  cfgSet(wifiCfg.staIp, ip);
+  cfgSet(wifiCfg.staGateway, gateway);
+  cfgSet(wifiCfg.staMask, mask);
+  cfgSet(wifiCfg.staDns, dns);
+  wifiCfg.staAutoConnect = true;
+  wifiCfg.save();
 }
 
 /**
@@ -597,18 +1134,129 @@ bool sendEmailGSM(const String& toEmail, const String& subject, const String& co
     return false;
   }
 
+  // Serial2 is still owned by the modem bring-up
+  if (currentMode == MODE_MAIN && !gsmModem.isReady()) {
+    Serial.println("⚠ GSM modem still initialising");
+    return false;
+  }
+
   // Initialize and configure SMTP client
+  Heap_Scope scope(HEAP_SMTP);
   smtp.begin();
-  smtp.setAPN(gsmCfg.apn.length() ? gsmCfg.apn.c_str() : "internet");
-  smtp.setAuth(emailCfg.emailAccount.c_str(), emailCfg.emailPassword.c_str());
+  smtp.setAPN(gsmCfg.apn[0] ? gsmCfg.apn : "internet");
+  smtp.setAuth(emailCfg.emailAccount, emailCfg.emailPassword);
   smtp.setRecipient(toEmail.c_str());
-  smtp.setFromName(emailCfg.senderName.c_str());
+  smtp.setFromName(emailCfg.senderName);
   smtp.setSubject(subject);
   smtp.setBody(content);
+  // Leave the PDP up if the uplink manager is using it as fallback
+  smtp.setKeepPDP(uplink.activeLink() == Uplink_Manager::LINK_GSM);
 
+  // PDP bring-up, TLS open and the SMTP dialogue take up to ~90 s
+  Uplink_Manager::PortLock lock(uplink);
+  Stall_Monitor::Pause pause(stalls);
   return smtp.sendEmail();
 }
 
+// ============================================================================
+// SENSOR ALERTS
+// ============================================================================
+
+/**
+ * @brief Notifications sent for alert events
+ */
+struct AlertNotifyStats {
+  uint32_t sms = 0;
+  uint32_t smsFailed = 0;
+  uint32_t email = 0;
+  uint32_t emailFailed = 0;
+  uint32_t post = 0;
+  uint32_t postFailed = 0;
+} alertNotify;
+
+/**
+ * @brief POST an alert event as JSON to alertCfg.postTo over the uplink
+ * @return true if the whole request was written
+ *
+ * Goes over WiFi or the GSM PDP, whichever Uplink_Manager has active. The
+ * response is not read (fire and forget, like an SMS).
+ */
+bool postAlert(const Alert_Engine::Event& e, const char* rule, const char* text) {
+  // host[:port][/path]
+  char host[64];
+  const char* p = alertCfg.postTo;
+  size_t n = strcspn(p, ":/");
+  if (!n || n >= sizeof(host)) return false;
+  memcpy(host, p, n);
+  host[n] = '\0';
+  p += n;
+  uint16_t port = 80;
+  if (*p == ':') {
+    port = (uint16_t)strtoul(p + 1, (char**)&p, 10);
+    if (!port) return false;
+  }
+  const char* path = *p == '/' ? p : "/";
+
+  const Alert_Engine::Rule& r = alerts.rule(e.rule);
+  char body[320];
+  int len = snprintf(body, sizeof(body),
+                     "{\"rule\":%u,\"raised\":%s,\"condition\":\"%s\",\"channel\":\"%s\","
+                     "\"signal\":\"%s\",\"value\":%.2f,\"text\":\"%s\"}",
+                     e.rule + 1, e.raised ? "true" : "false", rule,
+                     Sensor_Pipeline::channelName(r.channel), Alert_Engine::signalName(r.signal),
+                     e.value, text);
+  if (len < 0 || len >= (int)sizeof(body)) return false;
+
+  char req[512];
+  int total = snprintf(req, sizeof(req),
+                       "POST %s HTTP/1.0\r\nHost: %s\r\nContent-Type: application/json\r\n"
+                       "Content-Length: %d\r\nConnection: close\r\n\r\n%s",
+                       path, host, len, body);
+  if (total < 0 || total >= (int)sizeof(req)) return false;
+  return uplink.send(host, port, (const uint8_t*)req, total);
+}
+
+/**
+ * @brief Send the notifications of the next queued alert event ("alerts" job)
+ * One event per run: an SMS or an SMTP session blocks for seconds.
+ */
+void pollAlerts() {
+  // Events wait in the queue while the modem bring-up owns Serial2
+  // (a post may have to go over the GSM PDP)
+  if (currentMode == MODE_MAIN && !gsmModem.isReady()) return;
+  Alert_Engine::Event e;
+  if (!alerts.pop(e)) return;
+  
+  const Alert_Engine::Rule& r = alerts.rule(e.rule);
+  char rule[64];
+  alerts.describe(e.rule, rule, sizeof(rule));
+  char text[160];
+  snprintf(text, sizeof(text), "Alert %s: %s (%s %s %.2f)", e.raised ? "RAISED" : "cleared", rule,
+           Sensor_Pipeline::channelName(r.channel), Alert_Engine::signalName(r.signal), e.value);
+  
+  if ((r.actions & ALERT_SMS) && alertCfg.smsTo[0]) {
+    Heap_Scope scope(HEAP_MODEM);
+    Uplink_Manager::PortLock lock(uplink);
+    Stall_Monitor::Pause pause(stalls);
+    bool ok = gsmModem.sendSMS(alertCfg.smsTo, text);
+    ok ? alertNotify.sms++ : alertNotify.smsFailed++;
+    if (!ok) LOG_W(LOG_ALERT, "Rule %u: SMS to %s failed", e.rule + 1, alertCfg.smsTo);
+  }
+  if ((r.actions & ALERT_EMAIL) && alertCfg.emailTo[0]) {
+    String subject = String("Sensor alert ") + (e.raised ? "raised: " : "cleared: ") +
+                     Sensor_Pipeline::channelName(r.channel);
+    bool ok = sendEmailGSM(alertCfg.emailTo, subject, text);
+    ok ? alertNotify.email++ : alertNotify.emailFailed++;
+    if (!ok) LOG_W(LOG_ALERT, "Rule %u: email to %s failed", e.rule + 1, alertCfg.emailTo);
+  }
+  if ((r.actions & ALERT_POST) && alertCfg.postTo[0]) {
+    Stall_Monitor::Pause pause(stalls);
+    bool ok = postAlert(e, rule, text);
+    ok ? alertNotify.post++ : alertNotify.postFailed++;
+    if (!ok) LOG_W(LOG_ALERT, "Rule %u: post to %s failed", e.rule + 1, alertCfg.postTo);
+  }
+}
+
 
 // ============================================================================
 // JSON BUILDERS
@@ -638,6 +1286,10 @@ String buildStatusJson() {
   sta["ip"] = staConnected ? ipToStr(WiFi.localIP()) : "0.0.0.0";
   sta["rssi"] = staConnected ? WiFi.RSSI() : 0;
   sta["hostname"] = WiFi.getHostname() ? WiFi.getHostname() : "";
+  if (staConnected) {
+    sta["fastPath"] = wifiMgr.usedFastPath();
+    sta["connectedAtMs"] = wifiMgr.connectedAtMs();  // Boot-to-STA-connected (ms)
+  }
 
   // Connection status message
   if (staConnected) {
@@ -650,6 +1302,16 @@ String buildStatusJson() {
     sta["statusClass"] = "status-disconnected";
   }
 
+  // Modem bring-up (main mode only)
+  if (currentMode == MODE_MAIN) {
+    JsonObject modem = doc.createNestedObject("modem");
+    modem["status"] = GSM_Test::initStateName(gsmModem.initState());
+    modem["ready"] = gsmModem.isReady();
+    modem["initMs"] = gsmModem.initMs();
+    modem["probes"] = gsmModem.initProbes();
+    modem["simReady"] = gsmModem.simReady();
+  }
+
   // Email configuration status
   JsonObject email = doc.createNestedObject("email");
   email["configured"] = emailCfg.isValid();
@@ -664,6 +1326,28 @@ String buildStatusJson() {
 // HTTP HANDLERS - COMMON
 // ============================================================================
 
+/**
+ * @brief Add one boot timeline to a JSON object
+ * Phases that were not reached are left out; deltaUs is the phase's
+ * duration as defined by Boot_Timeline::deltaUs().
+ */
+void addBootTimeline(JsonObject out, const Boot_Timeline::Record& r) {
+  out["bootCount"] = r.bootCount;
+  out["resetReason"] = Boot_Timeline::resetReasonName(r.resetReason);
+  out["setupStartUs"] = r.startUs;
+  out["readyMs"] = Boot_Timeline::readyMs(r);
+  out["overBudget"] = Boot_Timeline::overBudget(r, BOOT_BUDGET_MS);
+  
+  JsonArray phases = out.createNestedArray("phases");
+  for (int i = 0; i < Boot_Timeline::PHASE_COUNT; i++) {
+    if (!r.us[i]) continue;
+    JsonObject p = phases.createNestedObject();
+    p["name"] = Boot_Timeline::phaseName((Boot_Timeline::Phase)i);
+    p["us"] = r.us[i];
+    p["deltaUs"] = Boot_Timeline::deltaUs(r, (Boot_Timeline::Phase)i);
+  }
+}
+
 /**
  * @brief Handle root HTTP request
  * Serves appropriate dashboard based on current mode
@@ -689,6 +1373,8 @@ void handleOptions() {
  * @brief Handle 404 Not Found and captive portal detection
  */
 void handleNotFound() {
+  // Also reached by a registered path with another method
+  stalls.setRoute(Metric_RouteTable::NOT_FOUND);
   String host = server.hostHeader();
   
   // Check for captive portal detection requests
@@ -773,29 +1459,189 @@ void setupMainDashboardRoutes() {
    * Returns complete system status including WiFi and GSM information
    */
   server.on("/api/status", HTTP_GET, []() { 
+    Heap_Scope scope(HEAP_JSON);
     sendJson(200, buildStatusJson()); 
   });
   
-  // ============================================================================
-  // SENSORS ENDPOINT
-  // ============================================================================
-  
   /**
-   * GET /api/sensors
-   * Returns current sensor snapshot without mutating/simulating values
+   * GET /api/config/store
+   * Binary config record statistics (load time, writes per save, NVS usage)
    */
-  server.on("/api/sensors", HTTP_GET, []() {
-    sendJson(200, sensorData.toJson());
+  server.on("/api/config/store", HTTP_GET, []() {
+    DynamicJsonDocument doc(512);
+    doc["schemaVersion"] = CONFIG_SCHEMA_VERSION;
+    doc["storedVersion"] = configStore.storedVersion();
+    doc["recordBytes"] = configStore.recordSize();
+    doc["payloadBytes"] = configLoadInfo.payloadBytes;
+    doc["loadUs"] = configStore.lastLoadUs();
+    doc["migrated"] = configLoadInfo.migrated;
+    doc["legacyLoadUs"] = configLoadInfo.legacyLoadUs;
+    doc["saves"] = configStore.saveCount();
+    doc["writes"] = configStore.writeCount();
+    doc["bytesWritten"] = configStore.bytesWritten();
+    doc["lastSaveUs"] = configStore.lastSaveUs();
+    doc["changes"] = configStore.markCount();
+    doc["flushes"] = configStore.flushCount();
+    doc["pending"] = configStore.isDirty();
+    doc["pendingMs"] = configStore.dirtyAgeMs();
+    doc["debounceMs"] = (uint32_t)Config_Store::DEBOUNCE_MS;
+    
+    JsonObject handlers = doc.createNestedObject("saveHandlers");
+    handlers["requests"] = configSaveLatency.requests;
+    handlers["lastUs"] = configSaveLatency.lastUs;
+    handlers["maxUs"] = configSaveLatency.maxUs;
+    
+    nvs_stats_t stats;
+    if (nvs_get_stats(NULL, &stats) == ESP_OK) {
+      JsonObject nvs = doc.createNestedObject("nvs");
+      nvs["usedEntries"] = stats.used_entries;
+      nvs["freeEntries"] = stats.free_entries;
+      nvs["totalEntries"] = stats.total_entries;
+    }
+    
+    String out;
+    serializeJson(doc, out);
+    sendJson(200, out);
   });
-
+  
+  /**
+   * GET /api/fs
+   * LittleFS usage, boot mount/migration timings, atomic write statistics
+   * and the results of the last fill-level benchmark
+   */
+  server.on("/api/fs", HTTP_GET, []() {
+    DynamicJsonDocument doc(1536);
+    doc["type"] = "littlefs";
+    doc["mounted"] = storage.isMounted();
+    doc["totalBytes"] = storage.isMounted() ? storage.fs().totalBytes() : 0;
+    doc["usedBytes"] = storage.isMounted() ? storage.fs().usedBytes() : 0;
+    
+    JsonObject boot = doc.createNestedObject("boot");
+    boot["mountUs"] = storage.mountUs();
+    boot["formatted"] = storage.formatted();
+    boot["spiffsMountUs"] = storage.spiffsMountUs();
+    boot["migratedFiles"] = storage.migratedFiles();
+    boot["skippedFiles"] = storage.skippedFiles();
+    boot["migrationUs"] = storage.migrationUs();
+    
+    JsonObject writes = doc.createNestedObject("writes");
+    writes["atomic"] = storage.atomicWrites();
+    writes["failures"] = storage.writeFailures();
+    writes["lastUs"] = storage.lastWriteUs();
+    writes["maxUs"] = storage.maxWriteUs();
+    
+    JsonObject bench = doc.createNestedObject("benchmark");
+    bench["running"] = storage.benchRunning();
+    bench["writeBytes"] = storage.benchWriteSize();
+    JsonArray rows = bench.createNestedArray("levels");
+    for (uint8_t i = 0; i < storage.benchCount(); i++) {
+      const FS_Manager::BenchRow& r = storage.benchRow(i);
+      JsonObject o = rows.createNestedObject();
+      o["fillPct"] = r.fillPct;
+      o["mountUs"] = r.mountUs;
+      o["writeAvgUs"] = r.writeAvgUs;
+      o["writeMaxUs"] = r.writeMaxUs;
+      o["readAvgUs"] = r.readAvgUs;
+    }
+    
+    String out;
+    serializeJson(doc, out);
+    sendJson(200, out);
+  });
+  
   /**
-   * GET /api/sensors/test
-   * Returns 10 immediate sensor samples without relying on periodic updates
+   * POST /api/fs/benchmark?size=1024&iterations=10
+   * Start the fill-level benchmark; poll GET /api/fs for results
    */
-  server.on("/api/sensors/test", HTTP_GET, []() {
-    sendJson(200, buildSensorTestSamplesJson(10));
+  server.on("/api/fs/benchmark", HTTP_POST, []() {
+    size_t size = server.hasArg("size") ? server.arg("size").toInt() : 1024;
+    uint8_t iterations = server.hasArg("iterations") ? server.arg("iterations").toInt() : 10;
+    
+    if (!storage.startBenchmark(size, iterations)) {
+      sendJson(409, "{\"success\":false,\"error\":\"Filesystem not mounted or benchmark running\"}");
+      return;
+    }
+    sendJson(202, "{\"success\":true}");
+  });
+  
+  /**
+   * GET /api/dns
+   * Captive-portal DNS statistics
+   */
+  server.on("/api/dns", HTTP_GET, []() {
+    DynamicJsonDocument doc(256);
+    doc["portalIp"] = ipToStr(WiFi.softAPIP());
+    doc["queries"] = captiveDns.queries();
+    doc["answeredA"] = captiveDns.answeredA();
+    doc["answeredEmpty"] = captiveDns.answeredEmpty();
+    doc["dropped"] = captiveDns.dropped();
+    doc["avgHandleUs"] = captiveDns.avgHandleUs();
+    doc["maxHandleUs"] = captiveDns.maxHandleUs();
+    
+    String out;
+    serializeJson(doc, out);
+    sendJson(200, out);
+  });
+  
+  /**
+   * GET /api/uplink
+   * Active upstream link, probe state and failover metrics
+   */
+  server.on("/api/uplink", HTTP_GET, []() {
+    DynamicJsonDocument doc(1024);
+    doc["active"] = Uplink_Manager::linkName(uplink.activeLink());
+    doc["activeForMs"] = uplink.activeSinceMs();
+    
+    JsonObject wifi = doc.createNestedObject("wifi");
+    wifi["associated"] = (WiFi.status() == WL_CONNECTED);
+    wifi["healthy"] = uplink.wifiHealthy();
+    wifi["probeRttMs"] = uplink.lastProbeRttMs();
+    wifi["lastProbeAgoMs"] = uplink.lastProbeAgoMs();
+    wifi["probeFailures"] = uplink.probeFailures();
+    
+    JsonObject gsm = doc.createNestedObject("gsm");
+    gsm["state"] = Uplink_Manager::gsmStateName(uplink.gsmState());
+    
+    JsonObject metrics = doc.createNestedObject("metrics");
+    metrics["failovers"] = uplink.failoverCount();
+    metrics["failbacks"] = uplink.failbackCount();
+    metrics["lastFailoverMs"] = uplink.lastFailoverMs();
+    metrics["maxFailoverMs"] = uplink.maxFailoverMs();
+    metrics["sendFailures"] = uplink.sendFailures();
+    
+    JsonObject timeOn = metrics.createNestedObject("timeOnLinkMs");
+    timeOn["wifi"] = uplink.timeOnLinkMs(Uplink_Manager::LINK_WIFI);
+    timeOn["gsm"] = uplink.timeOnLinkMs(Uplink_Manager::LINK_GSM);
+    timeOn["none"] = uplink.timeOnLinkMs(Uplink_Manager::LINK_NONE);
+    
+    JsonObject bytes = metrics.createNestedObject("bytesSent");
+    bytes["wifi"] = uplink.bytesSent(Uplink_Manager::LINK_WIFI);
+    bytes["gsm"] = uplink.bytesSent(Uplink_Manager::LINK_GSM);
+    
+    String out;
+    serializeJson(doc, out);
+    sendJson(200, out);
   });
   
+  // ============================================================================
+  // SENSORS ENDPOINT
+  // ============================================================================
+  
+  /**
+   * GET /api/sensors
+   * Returns current sensor snapshot without mutating/simulating values
+   */
+  server.on("/api/sensors", HTTP_GET, []() {
+    sendJson(200, buildSensorsJson());
+  });
+
+  /**
+   * GET /api/sensors/test?count=10&format=json|csv&seed=<n>
+   * Returns immediate simulated samples without relying on periodic
+   * updates (streamed)
+   */
+  server.on("/api/sensors/test", HTTP_GET, handleSensorTest);
+  
   // ============================================================================
   // SYSTEM INFORMATION ENDPOINT
   // ============================================================================
@@ -830,6 +1676,7 @@ void setupMainDashboardRoutes() {
    * Optional: force=true to bypass cache
    */
   server.on("/api/gsm/signal", HTTP_GET, []() {
+    if (modemNotReady()) return;
     bool forceRefresh = server.hasArg("force") && server.arg("force") == "true";
     gsmCache.updateSignal(forceRefresh);
     
@@ -854,6 +1701,7 @@ void setupMainDashboardRoutes() {
    * Optional: force=true to bypass cache
    */
   server.on("/api/gsm/network", HTTP_GET, []() {
+    if (modemNotReady()) return;
     bool forceRefresh = server.hasArg("force") && server.arg("force") == "true";
     gsmCache.updateNetwork(forceRefresh);
     
@@ -878,6 +1726,7 @@ void setupMainDashboardRoutes() {
    * Call duration: 10 seconds (auto-hangup)
    */
   server.on("/api/gsm/call", HTTP_POST, []() {
+    if (modemNotReady()) return;
     if (!server.hasArg("plain")) { 
       sendText(400, "Invalid JSON"); 
       return; 
@@ -902,7 +1751,9 @@ void setupMainDashboardRoutes() {
     
     Serial.printf(" Making call to: %s\n", phoneNumber.c_str());
     
-    // Make the call
+    // Make the call; the uplink keeps off Serial2 until it is hung up
+    Uplink_Manager::PortLock lock(uplink);
+    Stall_Monitor::Pause pause(stalls);  // Dial, 10 s call and hang-up
     bool success = gsmModem.makeCall(phoneNumber);
     
     DynamicJsonDocument resp(256);
@@ -932,7 +1783,9 @@ void setupMainDashboardRoutes() {
    * Hang up active call
    */
   server.on("/api/gsm/call/hangup", HTTP_POST, []() {
+    if (modemNotReady()) return;
     Serial.println(" Hanging up call...");
+    Uplink_Manager::PortLock lock(uplink);
     bool success = gsmModem.hangupCall();
     
     DynamicJsonDocument resp(256);
@@ -958,6 +1811,7 @@ void setupMainDashboardRoutes() {
    * Request body: {"phoneNumber": "+94719792341", "message": "Test message"}
    */
   server.on("/api/gsm/sms", HTTP_POST, []() {
+    if (modemNotReady()) return;
     if (!server.hasArg("plain")) { 
       sendText(400, "Invalid JSON"); 
       return; 
@@ -998,6 +1852,8 @@ void setupMainDashboardRoutes() {
     Serial.printf("   Message: %s\n", message.c_str());
     
     // Send the SMS
+    Uplink_Manager::PortLock lock(uplink);
+    Stall_Monitor::Pause pause(stalls);
     bool success = gsmModem.sendSMS(phoneNumber, message);
     
     DynamicJsonDocument resp(256);
@@ -1024,21 +1880,25 @@ void setupMainDashboardRoutes() {
    * Returns array of networks with SSID, RSSI, and security info
    */
   server.on("/api/wifi/scan", HTTP_GET, []() {
-    Serial.println("🔍 Starting WiFi network scan...");
+    bool force = server.hasArg("force") && server.arg("force") == "true";
+    WiFi_ScanCache::StartResult result = scanCache.start(force);
     
-    // Start asynchronous WiFi scan
-    int n = WiFi.scanNetworks(true); // true = async scan
-    
-    if (n == WIFI_SCAN_FAILED) {
+    if (result == WiFi_ScanCache::SCAN_FAILED) {
       Serial.println(" Scan failed to start");
       sendJson(500, "{\"error\":\"Scan failed to start\"}");
       return;
     }
     
-    // Return scan started status
     DynamicJsonDocument doc(256);
-    doc["status"] = "scanning";
-    doc["message"] = "Scan started, use /api/wifi/scan/results to get results";
+    if (result == WiFi_ScanCache::SCAN_CACHED) {
+      doc["status"] = "cached";
+      doc["scanAge"] = scanCache.ageMs();
+      doc["message"] = "Recent results available, use force=true to rescan";
+    } else {
+      Serial.println("🔍 Starting WiFi network scan...");
+      doc["status"] = "scanning";
+      doc["message"] = "Scan started, use /api/wifi/scan/results to get results";
+    }
     
     String out;
     serializeJson(doc, out);
@@ -1046,18 +1906,49 @@ void setupMainDashboardRoutes() {
   });
   
   /**
-   * GET /api/wifi/scan/results
-   * Get the results of the last WiFi scan
+   * GET /api/wifi/scan/results?offset=0&limit=20
+   * Get the results of the last WiFi scan, strongest first
+   * Returns 202 while a scan is still running
    */
   server.on("/api/wifi/scan/results", HTTP_GET, []() {
-    Serial.println(" Getting WiFi scan results...");
+    if (scanCache.isScanning()) {
+      sendJson(202, "{\"status\":\"scanning\"}");
+      return;
+    }
     
-    if (!lastScanAvailable) {
+    if (!scanCache.hasResults()) {
       sendJson(404, "{\"error\":\"No scan results available\"}");
       return;
     }
     
-    server.send(200, "application/json", lastScanJson);
+    size_t total = scanCache.count();
+    size_t offset = server.hasArg("offset") ? server.arg("offset").toInt() : 0;
+    size_t limit = server.hasArg("limit") ? server.arg("limit").toInt() : total;
+    if (offset > total) offset = total;
+    if (limit > total - offset) limit = total - offset;
+    
+    // Stream one record at a time; no JSON document or String is built
+    ChunkedResponse resp;
+    resp.begin(200, "application/json");
+    resp.printf("{\"scanAge\":%lu,\"ttl\":%lu,\"stale\":%s,\"durationMs\":%lu,"
+                "\"total\":%u,\"raw\":%u,\"hidden\":%u,\"dropped\":%u,"
+                "\"offset\":%u,\"count\":%u,\"networks\":[",
+                scanCache.ageMs(), WiFi_ScanCache::TTL_MS, scanCache.isFresh() ? "false" : "true",
+                scanCache.durationMs(), (unsigned)total, scanCache.rawCount(),
+                scanCache.hiddenCount(), scanCache.droppedCount(),
+                (unsigned)offset, (unsigned)limit);
+    
+    char buf[WiFi_ScanCache::RECORD_JSON_MAX];
+    bool first = true;
+    for (size_t i = offset; i < offset + limit; i++) {
+      size_t n = scanCache.recordToJson(i, buf, sizeof(buf));
+      if (n == 0) continue;  // Separator only after a record formatted
+      if (!first) resp.write(',');
+      resp.write((const uint8_t*)buf, n);
+      first = false;
+    }
+    resp.print("]}");
+    resp.end();
   });
   
   /**
@@ -1090,83 +1981,104 @@ void setupMainDashboardRoutes() {
       return;
     }
     
-    Serial.printf("🔌 Connecting to: %s\n", ssid.c_str());
+    unsigned long handlerStart = micros();
     
-    // Disconnect from current network if connected
-    if (WiFi.status() == WL_CONNECTED) {
-      WiFi.disconnect();
-      delay(1000);
+    // Only record the request here; wifiMgr.loop() does the actual work
+    if (!wifiMgr.requestConnect(ssid, password)) {
+      DynamicJsonDocument resp(256);
+      resp["success"] = false;
+      resp["error"] = "Connection already in progress";
+      resp["ssid"] = wifiMgr.targetSsid();
+      String out;
+      serializeJson(resp, out);
+      sendJson(409, out);
+      return;
     }
     
-    // Connect to new network
-    WiFi.begin(ssid.c_str(), password.c_str());
-    
-    // Wait for connection with timeout
-    int attempts = 0;
-    const int maxAttempts = 20; // 20 seconds timeout
+    DynamicJsonDocument resp(256);
+    resp["success"] = true;
+    resp["status"] = WiFi_Manager::phaseName(wifiMgr.phase());
+    resp["ssid"] = ssid;
+    resp["message"] = "Connection started, use /api/wifi/connect/status to follow progress";
     
-    while (WiFi.status() != WL_CONNECTED && attempts < maxAttempts) {
-      delay(1000);
-      attempts++;
-      Serial.printf(" Connection attempt %d/%d\n", attempts, maxAttempts);
-    }
+    String out;
+    serializeJson(resp, out);
+    sendJson(202, out);
     
-    DynamicJsonDocument resp(512);
+    wifiMgr.setRequestHandlerTime(micros() - handlerStart);
+  });
+  
+  /**
+   * GET /api/wifi/connect/status
+   * Progress of the last connect request
+   * Phases: idle, disconnecting, connecting, connected, failed, disconnected
+   */
+  server.on("/api/wifi/connect/status", HTTP_GET, []() {
+    WiFi_Manager::Phase phase = wifiMgr.phase();
     
-    if (WiFi.status() == WL_CONNECTED) {
-      // Save WiFi configuration
-      wifiCfg.staSsid = ssid;
-      wifiCfg.staPass = password;
-      wifiCfg.save();
-      
-      resp["success"] = true;
-      resp["ssid"] = ssid;
-      resp["ip"] = ipToStr(WiFi.localIP());
-      resp["rssi"] = WiFi.RSSI();
-      resp["message"] = "Connected successfully";
-      
-      Serial.printf(" Connected to %s\n", ssid.c_str());
-      Serial.printf("   IP: %s\n", ipToStr(WiFi.localIP()).c_str());
-      Serial.printf("   RSSI: %d dBm\n", WiFi.RSSI());
-    } else {
-      resp["success"] = false;
-      resp["error"] = "Connection failed - check password or signal strength";
-      
-      Serial.printf(" Failed to connect to %s\n", ssid.c_str());
+    DynamicJsonDocument doc(512);
+    doc["phase"] = WiFi_Manager::phaseName(phase);
+    doc["ssid"] = wifiMgr.targetSsid();
+    doc["attempt"] = wifiMgr.attempt();
+    doc["maxAttempts"] = wifiMgr.maxAttempts();
+    doc["reason"] = wifiMgr.lastReason();
+    doc["reasonText"] = WiFi_Manager::reasonName(wifiMgr.lastReason());
+    doc["elapsedMs"] = wifiMgr.elapsedMs();
+    
+    if (phase == WiFi_Manager::PHASE_CONNECTED && WiFi.status() == WL_CONNECTED) {
+      doc["ip"] = ipToStr(WiFi.localIP());
+      doc["rssi"] = WiFi.RSSI();
+      doc["fastPath"] = wifiMgr.usedFastPath();
+      doc["connectedAtMs"] = wifiMgr.connectedAtMs();  // ms since boot
     }
     
+    // Handler latency and worst loop() gap while the connect was running
+    JsonObject timing = doc.createNestedObject("timing");
+    timing["handlerUs"] = wifiMgr.handlerUs();
+    timing["maxLoopGapMs"] = wifiMgr.maxLoopGapMs();
+    
     String out;
-    serializeJson(resp, out);
-    sendJson(resp["success"] ? 200 : 500, out);
+    serializeJson(doc, out);
+    sendJson(200, out);
   });
   
   /**
-   * POST /api/wifi/disconnect
-   * Disconnect from current WiFi network
+   * POST /api/wifi/disconnect?forget=true
+   * Disconnect from the current WiFi network (or cancel a connect in
+   * progress) and stop auto-reconnect. Returns at once; wifiMgr.loop()
+   * drops the link, poll /api/wifi/connect/status for "disconnected".
+   * Saved profiles are kept unless forget=true (removes that network)
    */
   server.on("/api/wifi/disconnect", HTTP_POST, []() {
     Serial.println("🔌 Disconnecting from WiFi...");
+    bool forget = server.hasArg("forget") && server.arg("forget") == "true";
+    
+    // Stop roaming/reconnects before dropping the link
+    roaming.setEnabled(false);
+    wifiCfg.staAutoConnect = false;
+    uplink.setStaConfigured(false);  // A deliberate disconnect is not an outage
     
-    if (WiFi.status() == WL_CONNECTED) {
-      String currentSSID = WiFi.SSID();
-      WiFi.disconnect();
-      delay(1000);
+    if (wifiMgr.requestDisconnect()) {
+      String currentSSID = wifiMgr.targetSsid();
       
-      // Clear saved WiFi configuration
-      wifiCfg.staSsid = "";
-      wifiCfg.staPass = "";
+      // Clear last-connected network; profiles stay for later use
+      wifiCfg.staSsid[0] = '\0';
+      wifiCfg.staPass[0] = '\0';
+      wifiCfg.clearFastConnect();
+      if (forget) wifiCfg.profiles.remove(currentSSID.c_str());
       wifiCfg.save();
       
       DynamicJsonDocument resp(256);
       resp["success"] = true;
-      resp["message"] = "Disconnected from " + currentSSID;
+      resp["message"] = "Disconnecting from " + currentSSID;
+      resp["status"] = WiFi_Manager::phaseName(wifiMgr.phase());
       
       String out;
       serializeJson(resp, out);
       sendJson(200, out);
-      
-      Serial.printf(" Disconnected from %s\n", currentSSID.c_str());
     } else {
+      wifiCfg.save();
+      
       DynamicJsonDocument resp(256);
       resp["success"] = false;
       resp["error"] = "Not connected to any network";
@@ -1178,6 +2090,135 @@ void setupMainDashboardRoutes() {
       Serial.println(" Not connected to any network");
     }
   });
+  
+  /**
+   * GET /api/wifi/profiles
+   * List saved STA networks (passwords are not returned)
+   */
+  server.on("/api/wifi/profiles", HTTP_GET, []() {
+    DynamicJsonDocument doc(1024);
+    doc["max"] = WIFI_MAX_PROFILES;
+    doc["autoConnect"] = wifiCfg.staAutoConnect;
+    JsonArray list = doc.createNestedArray("profiles");
+    for (size_t i = 0; i < wifiCfg.profiles.count; i++) {
+      const WiFiProfile& p = wifiCfg.profiles.items[i];
+      JsonObject o = list.createNestedObject();
+      o["ssid"] = p.ssid;
+      o["priority"] = p.priority;
+      o["hasPassword"] = p.pass[0] != '\0';
+    }
+    
+    String out;
+    serializeJson(doc, out);
+    sendJson(200, out);
+  });
+  
+  /**
+   * POST /api/wifi/profiles
+   * Add or update a saved network
+   * Request body: {"ssid": "...", "password": "...", "priority": 1}
+   * Password is kept if omitted for an existing profile
+   */
+  server.on("/api/wifi/profiles", HTTP_POST, []() {
+    if (!server.hasArg("plain")) { sendText(400, "Invalid JSON"); return; }
+    
+    DynamicJsonDocument doc(512);
+    if (deserializeJson(doc, server.arg("plain"))) { sendText(400, "Invalid JSON"); return; }
+    
+    const char* ssid = doc["ssid"] | "";
+    if (!*ssid || strlen(ssid) > 32) { sendText(400, "SSID must be 1-32 characters"); return; }
+    
+    int idx = wifiCfg.profiles.find(ssid);
+    const char* pass = idx >= 0 ? wifiCfg.profiles.items[idx].pass : "";
+    if (doc.containsKey("password")) pass = doc["password"] | "";
+    if (strlen(pass) > 63) { sendText(400, "Password too long (max 63 characters)"); return; }
+    uint8_t priority = doc["priority"] | (idx >= 0 ? wifiCfg.profiles.items[idx].priority : 0);
+    
+    if (!wifiCfg.profiles.upsert(ssid, pass, priority)) {
+      sendText(409, "Profile list full");
+      return;
+    }
+    
+    bool ok = wifiCfg.save();
+    DynamicJsonDocument resp(128);
+    resp["success"] = ok;
+    String out;
+    serializeJson(resp, out);
+    sendJson(ok ? 200 : 500, out);
+  });
+  
+  /**
+   * POST /api/wifi/profiles/delete
+   * Remove a saved network
+   * Request body: {"ssid": "..."}
+   */
+  server.on("/api/wifi/profiles/delete", HTTP_POST, []() {
+    if (!server.hasArg("plain")) { sendText(400, "Invalid JSON"); return; }
+    
+    DynamicJsonDocument doc(256);
+    if (deserializeJson(doc, server.arg("plain"))) { sendText(400, "Invalid JSON"); return; }
+    
+    const char* ssid = doc["ssid"] | "";
+    if (!wifiCfg.profiles.remove(ssid)) { sendText(404, "Profile not found"); return; }
+    
+    bool ok = wifiCfg.save();
+    DynamicJsonDocument resp(128);
+    resp["success"] = ok;
+    String out;
+    serializeJson(resp, out);
+    sendJson(ok ? 200 : 500, out);
+  });
+  
+  /**
+   * GET /api/wifi/roaming
+   * Roaming metrics, per-BSSID RSSI history and recent roam events
+   */
+  server.on("/api/wifi/roaming", HTTP_GET, []() {
+    DynamicJsonDocument doc(4096);
+    doc["enabled"] = roaming.isEnabled();
+    doc["connected"] = (WiFi.status() == WL_CONNECTED);
+    
+    JsonObject metrics = doc.createNestedObject("metrics");
+    metrics["uptimeMs"] = millis();
+    metrics["disconnectedMs"] = roaming.disconnectedMs();
+    metrics["currentOutageMs"] = roaming.currentOutageMs();
+    metrics["longestOutageMs"] = roaming.longestOutageMs();
+    metrics["disconnects"] = roaming.disconnectCount();
+    metrics["roams"] = roaming.roamCount();
+    metrics["roamFailures"] = roaming.roamFailures();
+    
+    JsonArray history = doc.createNestedArray("bssids");
+    for (size_t i = 0; i < roaming.historyCount(); i++) {
+      const WiFi_Roaming::BssidHistory& h = roaming.history(i);
+      JsonObject o = history.createNestedObject();
+      o["bssid"] = WiFi_Manager::formatBssid(h.bssid);
+      o["channel"] = h.channel;
+      o["avgRssi"] = roaming.averageRssi(h);
+      o["ageMs"] = millis() - h.lastSeen;
+      JsonArray samples = o.createNestedArray("samples");
+      for (size_t k = 0; k < h.count; k++) {
+        // Oldest to newest
+        samples.add(h.samples[(h.head + WiFi_Roaming::HISTORY_LEN - h.count + k) % WiFi_Roaming::HISTORY_LEN]);
+      }
+    }
+    
+    JsonArray events = doc.createNestedArray("events");
+    for (size_t i = 0; i < roaming.eventCount(); i++) {
+      const WiFi_Roaming::RoamEvent& e = roaming.event(i);
+      JsonObject o = events.createNestedObject();
+      o["agoMs"] = millis() - e.at;
+      o["from"] = WiFi_Manager::formatBssid(e.from);
+      o["to"] = WiFi_Manager::formatBssid(e.to);
+      o["fromRssi"] = e.fromRssi;
+      o["toRssi"] = e.toRssi;
+      o["durationMs"] = e.durationMs;
+      o["ok"] = e.ok;
+    }
+    
+    String out;
+    serializeJson(doc, out);
+    sendJson(200, out);
+  });
 
   // ============================================================================
   // USER CONFIGURATION ENDPOINTS
@@ -1188,14 +2229,7 @@ void setupMainDashboardRoutes() {
    * Load user profile configuration
    */
   server.on("/api/load/user", HTTP_GET, []() {
-    DynamicJsonDocument doc(1024);
-    doc["name"] = userCfg.name;
-    doc["email"] = userCfg.email;
-    doc["phone"] = userCfg.phone;
-    
-    String out;
-    serializeJson(doc, out);
-    sendJson(200, out);
+    sendConfigJson(UserConfig::schema(), &userCfg);
   });
   
   /**
@@ -1204,14 +2238,8 @@ void setupMainDashboardRoutes() {
    * Request body: {"name": "...", "email": "...", "phone": "..."}
    */
   server.on("/api/save/user", HTTP_POST, []() {
-    if (!server.hasArg("plain")) { sendText(400, "Invalid JSON"); return; }
-    
-    DynamicJsonDocument doc(1024);
-    if (deserializeJson(doc, server.arg("plain"))) { sendText(400, "Invalid JSON"); return; }
-    
-    userCfg.name = doc["name"] | "";
-    userCfg.email = doc["email"] | "";
-    userCfg.phone = doc["phone"] | "";
+    uint32_t t0 = micros();
+    if (!applyConfigJson(UserConfig::schema(), &userCfg)) return;
     
     bool ok = userCfg.save();
     
@@ -1220,6 +2248,7 @@ void setupMainDashboardRoutes() {
     
     String out;
     serializeJson(resp, out);
+    configSaveLatency.note(t0);
     sendJson(ok ? 200 : 500, out);
   });
   
@@ -1232,15 +2261,7 @@ void setupMainDashboardRoutes() {
    * Load GSM configuration
    */
   server.on("/api/load/gsm", HTTP_GET, []() {
-    DynamicJsonDocument doc(1024);
-    doc["carrierName"] = gsmCfg.carrierName;
-    doc["apn"] = gsmCfg.apn;
-    doc["apnUser"] = gsmCfg.apnUser;
-    doc["apnPass"] = gsmCfg.apnPass;
-    
-    String out;
-    serializeJson(doc, out);
-    sendJson(200, out);
+    sendConfigJson(GsmConfig::schema(), &gsmCfg);
   });
   
   /**
@@ -1249,17 +2270,12 @@ void setupMainDashboardRoutes() {
    * Request body: {"carrierName": "...", "apn": "...", "apnUser": "...", "apnPass": "..."}
    */
   server.on("/api/save/gsm", HTTP_POST, []() {
-    if (!server.hasArg("plain")) { sendText(400, "Invalid JSON"); return; }
-    
-    DynamicJsonDocument doc(1024);
-    if (deserializeJson(doc, server.arg("plain"))) { sendText(400, "Invalid JSON"); return; }
-    
-    gsmCfg.carrierName = doc["carrierName"] | "";
-    gsmCfg.apn = doc["apn"] | "";
-    gsmCfg.apnUser = doc["apnUser"] | "";
-    gsmCfg.apnPass = doc["apnPass"] | "";
+    uint32_t t0 = micros();
+    if (!applyConfigJson(GsmConfig::schema(), &gsmCfg)) return;
+    uplink.setApn(gsmCfg.apn);
     
     bool ok = gsmCfg.save();
+    configSaveLatency.note(t0);
     sendText(ok ? 200 : 500, ok ? "OK" : "SAVE_FAILED");
   });
 }
@@ -1284,16 +2300,15 @@ void setupEmailDashboardRoutes() {
    * Returns current sensor snapshot without mutating/simulating values
    */
   server.on("/api/sensors", HTTP_GET, []() {
-    sendJson(200, sensorData.toJson());
+    sendJson(200, buildSensorsJson());
   });
 
   /**
-   * GET /api/sensors/test
-   * Returns 10 immediate sensor samples without relying on periodic updates
+   * GET /api/sensors/test?count=10&format=json|csv&seed=<n>
+   * Returns immediate simulated samples without relying on periodic
+   * updates (streamed)
    */
-  server.on("/api/sensors/test", HTTP_GET, []() {
-    sendJson(200, buildSensorTestSamplesJson(10));
-  });
+  server.on("/api/sensors/test", HTTP_GET, handleSensorTest);
   
   // ============================================================================
   // SYSTEM INFORMATION ENDPOINT (for GSM mode)
@@ -1329,8 +2344,7 @@ void setupEmailDashboardRoutes() {
    */
   server.on("/api/load/ap", HTTP_GET, []() {
     DynamicJsonDocument doc(512);
-    doc["apSsid"] = wifiCfg.apSsid;
-    doc["apPass"] = wifiCfg.apPass;
+    cfgToJson(WifiConfig::schema(), &wifiCfg, doc.to<JsonObject>(), true);
     doc["currentApSsid"] = WiFi.softAPSSID();
     doc["currentApIp"] = ipToStr(WiFi.softAPIP());
     doc["connectedDevices"] = WiFi.softAPgetStationNum();
@@ -1343,37 +2357,12 @@ void setupEmailDashboardRoutes() {
   /**
    * POST /api/save/ap
    * Save Access Point configuration
-   * Request body: {"apSsid": "...", "apPass": "..."}
+   * Request body: {"apSsid": "...", "apPass": "...", "staReuseIp": false}
    */
   server.on("/api/save/ap", HTTP_POST, []() {
-    if (!server.hasArg("plain")) { sendText(400, "Invalid JSON"); return; }
-    
-    DynamicJsonDocument doc(512);
-    if (deserializeJson(doc, server.arg("plain"))) { sendText(400, "Invalid JSON"); return; }
-    
-    String newSsid = doc["apSsid"] | "";
-    String newPass = doc["apPass"] | "";
-    
-    // Validate SSID
-    if (newSsid.length() == 0) {
-      sendText(400, "SSID cannot be empty");
-      return;
-    }
-    
-    if (newSsid.length() > 32) {
-      sendText(400, "SSID too long (max 32 characters)");
-      return;
-    }
-    
-    // Validate password
-    if (newPass.length() > 0 && newPass.length() < 8) {
-      sendText(400, "Password must be at least 8 characters or empty");
-      return;
-    }
-    
-    // Update configuration
-    wifiCfg.apSsid = newSsid;
-    wifiCfg.apPass = newPass;
+    uint32_t t0 = micros();
+    // Validation (SSID required, max 32 characters, password empty or 8+) comes from the schema
+    if (!applyConfigJson(WifiConfig::schema(), &wifiCfg)) return;
     
     bool ok = wifiCfg.save();
     
@@ -1383,6 +2372,7 @@ void setupEmailDashboardRoutes() {
     
     String out;
     serializeJson(resp, out);
+    configSaveLatency.note(t0);
     sendJson(ok ? 200 : 500, out);
   });
 
@@ -1392,19 +2382,10 @@ void setupEmailDashboardRoutes() {
   
   /**
    * GET /api/load/email
-   * Load email configuration (password excluded for security)
+   * Load email configuration (password masked as "[SET]")
    */
   server.on("/api/load/email", HTTP_GET, []() {
-    DynamicJsonDocument doc(512);
-    doc["smtpHost"] = emailCfg.smtpHost;
-    doc["smtpPort"] = emailCfg.smtpPort;
-    doc["emailAccount"] = emailCfg.emailAccount;
-    doc["senderName"] = emailCfg.senderName;
-    // Note: Password is intentionally excluded for security
-    
-    String out;
-    serializeJson(doc, out);
-    sendJson(200, out);
+    sendConfigJson(EmailConfig::schema(), &emailCfg);
   });
   
   /**
@@ -1414,21 +2395,9 @@ void setupEmailDashboardRoutes() {
    *                "emailPassword": "...", "senderName": "..."}
    */
   server.on("/api/save/email", HTTP_POST, []() {
-    if (!server.hasArg("plain")) { sendText(400, "Invalid JSON"); return; }
-    
-    DynamicJsonDocument doc(1024);
-    if (deserializeJson(doc, server.arg("plain"))) { sendText(400, "Invalid JSON"); return; }
-    
-    emailCfg.smtpHost = doc["smtpHost"] | emailCfg.smtpHost;
-    emailCfg.smtpPort = doc["smtpPort"] | emailCfg.smtpPort;
-    emailCfg.emailAccount = doc["emailAccount"] | emailCfg.emailAccount;
-    
-    // Only update password if provided (allows saving other settings without password)
-    if (doc.containsKey("emailPassword")) {
-      emailCfg.emailPassword = String((const char*)doc["emailPassword"]);
-    }
-    
-    emailCfg.senderName = doc["senderName"] | emailCfg.senderName;
+    uint32_t t0 = micros();
+    // Keys left out, and "[SET]" for the password, keep the stored values
+    if (!applyConfigJson(EmailConfig::schema(), &emailCfg)) return;
     
     bool ok = emailCfg.save();
     
@@ -1437,6 +2406,7 @@ void setupEmailDashboardRoutes() {
     
     String out;
     serializeJson(resp, out);
+    configSaveLatency.note(t0);
     sendJson(ok ? 200 : 500, out);
   });
   
@@ -1520,6 +2490,235 @@ void setupEmailDashboardRoutes() {
   });
 }
 
+// ============================================================================
+// METRICS
+// ============================================================================
+// Registered by construction, rendered in this order at /metrics. Samplers
+// run at scrape time only.
+
+Metric_RouteTable httpRoutes("panel_http_requests_total", "panel_http_request_duration_seconds");
+
+Metric_Counter atCommands("panel_gsm_at_commands_total", "Blocking AT commands sent",
+  []() -> double { return gsmModem.atCommands(); });
+Metric_Counter atFailures("panel_gsm_at_failures_total", "AT commands answered with ERROR or not at all",
+  []() -> double { return gsmModem.atFailures(); });
+Metric_Counter atBusy("panel_gsm_at_busy_seconds_total", "Time spent waiting for AT responses",
+  []() -> double { return gsmModem.atBusyMs() / 1000.0; });
+Metric_Gauge modemReady("panel_gsm_modem_ready", "1 once the modem bring-up has finished",
+  []() -> double { return gsmModem.isReady() ? 1 : 0; });
+
+Metric_Gauge heapFree("panel_heap_free_bytes", "Free heap",
+  []() -> double { return ESP.getFreeHeap(); });
+Metric_Gauge heapMinFree("panel_heap_min_free_bytes", "Lowest free heap since boot",
+  []() -> double { return ESP.getMinFreeHeap(); });
+Metric_Gauge heapLargest("panel_heap_largest_free_block_bytes", "Largest allocatable heap block",
+  []() -> double { return ESP.getMaxAllocHeap(); });
+Metric_Gauge heapFragmentation("panel_heap_fragmentation_ratio", "Share of free heap not available as one block",
+  []() -> double { return Heap_Monitor::fragmentationPct(ESP.getFreeHeap(), ESP.getMaxAllocHeap()) / 100.0; });
+
+/**
+ * @brief Per-subsystem heap accounting, one series per tag
+ */
+class HeapTagMetrics : public Metric {
+public:
+  HeapTagMetrics() : Metric("panel_heap_allocations_total", "Allocations made by the loop task, by subsystem", "counter") {}
+
+  void render(Print& out) const override {
+    header(out);
+    for (uint8_t i = 0; i < HEAP_TAG_COUNT; i++) {
+      out.printf("%s{subsystem=\"%s\"} %u\n", _name, Heap_Monitor::tagName(i), heapMonitor.tag(i).allocs);
+    }
+    series(out, "panel_heap_subsystem_delta_bytes",
+           "Free heap drop over a subsystem's scopes (approximate, includes other tasks)", false);
+    series(out, "panel_heap_subsystem_peak_delta_bytes",
+           "Highest free heap drop over a subsystem's scopes (approximate)", true);
+  }
+
+private:
+  static void series(Print& out, const char* name, const char* help, bool peak) {
+    out.printf("# HELP %s %s\n# TYPE %s gauge\n", name, help, name);
+    for (uint8_t i = 0; i < HEAP_TAG_COUNT; i++) {
+      const Heap_Monitor::TagStats& t = heapMonitor.tag(i);
+      out.printf("%s{subsystem=\"%s\"} %d\n", name, Heap_Monitor::tagName(i), peak ? t.peak : t.current);
+    }
+  }
+};
+
+HeapTagMetrics heapTags;
+
+Metric_Gauge uptime("panel_uptime_seconds", "Time since boot",
+  []() -> double { return millis() / 1000.0; });
+
+Metric_Gauge wifiConnected("panel_wifi_sta_connected", "1 while the STA interface is connected",
+  []() -> double { return WiFi.status() == WL_CONNECTED ? 1 : 0; });
+Metric_Gauge wifiRssi("panel_wifi_rssi_dbm", "STA signal strength (0 while disconnected)",
+  []() -> double { return WiFi.status() == WL_CONNECTED ? WiFi.RSSI() : 0; });
+Metric_Gauge apStations("panel_ap_stations", "Clients associated with the soft-AP",
+  []() -> double { return WiFi.softAPgetStationNum(); });
+Metric_Gauge uplinkLink("panel_uplink_active_link", "Active uplink (0 none, 1 WiFi, 2 GSM)",
+  []() -> double { return uplink.activeLink(); });
+Metric_Counter uplinkFailovers("panel_uplink_failovers_total", "WiFi to GSM failovers",
+  []() -> double { return uplink.failoverCount(); });
+
+Metric_Counter dnsQueries("panel_dns_queries_total", "Captive portal DNS queries",
+  []() -> double { return captiveDns.queries(); });
+Metric_Counter dnsDropped("panel_dns_dropped_total", "DNS queries dropped",
+  []() -> double { return captiveDns.dropped(); });
+
+// Work waiting to be done (the firmware has no message queues of its own)
+Metric_Gauge configPending("panel_config_write_pending", "1 while a settings write is deferred",
+  []() -> double { return configStore.isDirty() ? 1 : 0; });
+Metric_Gauge configPendingAge("panel_config_write_pending_seconds", "Age of the deferred settings write",
+  []() -> double { return configStore.dirtyAgeMs() / 1000.0; });
+Metric_Counter loopStalls("panel_loop_stalls_total", "loop() iterations of 50 ms or more",
+  []() -> double { return stalls.stallCount(); });
+Metric_Gauge loopMax("panel_loop_max_seconds", "Longest loop() iteration since boot",
+  []() -> double { return stalls.maxIterationUs() / 1e6; });
+
+Metric_Counter sensorSamples("panel_sensor_samples_total", "Samples taken by the sensor task",
+  []() -> double { return sensors.samples(); });
+Metric_Counter sensorErrors("panel_sensor_read_errors_total", "Sensor driver reads that failed",
+  []() -> double { return sensors.readErrors(); });
+Metric_Gauge sensorJitter("panel_sensor_jitter_max_seconds", "Worst sampling wake-up jitter",
+  []() -> double { return sensors.maxJitterUs() / 1e6; });
+
+Metric_Counter logEntries("panel_log_entries_total", "Entries written to the log ring",
+  []() -> double { return logRing.head(); });
+Metric_Counter logDropped("panel_log_dropped_total", "Log entries overwritten before they were printed",
+  []() -> double { return logRing.dropped(); });
+
+// Cost of the previous scrape (this one is still being measured)
+Metric_Gauge renderTime("panel_metrics_render_seconds", "Time to render the previous /metrics response",
+  []() -> double { return metrics.lastRenderUs() / 1e6; });
+Metric_Gauge renderBytes("panel_metrics_render_bytes", "Size of the previous /metrics response",
+  []() -> double { return metrics.lastRenderBytes(); });
+
+// ============================================================================
+// SCHEDULED JOBS
+// ============================================================================
+
+/**
+ * @brief Advance the modem bring-up; enable GSM fallback once it is ready
+ */
+void pollModem() {
+  Heap_Scope scope(HEAP_MODEM);
+  gsmModem.loop();
+  if (currentMode == MODE_MAIN && gsmModem.isReady() && !uplinkGsmEnabled) {
+    uplinkGsmEnabled = true;
+    uplink.setGsmEnabled(true);  // Serial2 may now be shared with the uplink
+    bootTimeline.mark(Boot_Timeline::PHASE_MODEM_READY);
+  }
+}
+
+/**
+ * @brief Periodic status block on the serial console
+ */
+void printStatus() {
+  // Print status header
+  Serial.printf("\n📊 Status Update [%s mode]\n", 
+                (currentMode == MODE_MAIN) ? "MAIN (dashboard_html.h)" : "EMAIL (config_html.h)");
+  
+  // Access Point status
+  Serial.printf("  AP IP: %s\n", ipToStr(WiFi.softAPIP()).c_str());
+  Serial.printf("  Connected devices: %d\n", WiFi.softAPgetStationNum());
+  
+  // Station mode status
+  if (WiFi.status() == WL_CONNECTED) {
+    Serial.printf("  STA IP: %s\n", ipToStr(WiFi.localIP()).c_str());
+    Serial.printf("  RSSI: %d dBm (%s)\n", WiFi.RSSI(), rssiToStrength(WiFi.RSSI()));
+  } else {
+    Serial.println("  STA: Not connected");
+  }
+  Serial.printf("  Uplink: %s (%lu failovers)\n",
+                Uplink_Manager::linkName(uplink.activeLink()), (unsigned long)uplink.failoverCount());
+  
+  // Email configuration status (only in EMAIL mode)
+  if (currentMode == MODE_EMAIL) {
+    Serial.printf("  Email: %s\n", emailCfg.isValid() ? "Configured ✓" : "Not configured ✗");
+  }
+  
+  // GSM status (only in MAIN mode)
+  if (currentMode == MODE_MAIN) {
+    if (gsmCache.signalStrength != 0) {
+      Serial.printf("  GSM Signal: %d dBm (%s)\n", 
+                    gsmCache.signalStrength, 
+                    gsmCache.grade);
+      Serial.printf("  GSM Carrier: %s\n", gsmCache.carrierName);
+    } else {
+      Serial.println("  GSM: Not initialized");
+    }
+  }
+  
+  Serial.println("────────────────────────────────────────");
+}
+
+/**
+ * @brief First request handler: names the route for stall attribution
+ * and the per-route metrics (registered path, or "not_found").
+ * Never claims a request, so the real handler still runs next.
+ */
+class RouteTracer : public RequestHandler {
+public:
+  bool canHandle(HTTPMethod method, String uri) override {
+    stalls.setRoute(httpRoutes.label(uri.c_str()));
+    return false;
+  }
+};
+
+/**
+ * @brief Register every piece of loop() work with the scheduler
+ *
+ * Poll jobs run on every pass (request handling and state machines that
+ * read sockets/serial); the rest run on their own period. Budgets are the
+ * expected worst case, overruns show up at /api/metrics/scheduler.
+ */
+void registerJobs() {
+  scheduler.setRunHook([](const Job_Scheduler::Job& job, bool finished, uint32_t us) {
+    if (!finished) {
+      stalls.jobStart(job.name);
+      return;
+    }
+    stalls.jobEnd(job.name, us);
+    // An HTTP run that named a route handled a request
+    if (&job == &scheduler.job(httpJob) && stalls.route()[0]) httpRoutes.observe(stalls.route(), us);
+  });
+  
+  // Network handling
+  httpJob = scheduler.poll("http", []() {
+    Heap_Scope scope(HEAP_HTTP);
+    server.handleClient();
+  }, 50000);
+  scheduler.poll("wifi", []() { wifiMgr.loop(); }, 2000);
+  scheduler.poll("roaming", []() {
+    Heap_Scope scope(HEAP_SCAN);
+    roaming.loop();
+  }, 5000);
+  scheduler.poll("modem", pollModem, 5000);
+  scheduler.poll("uplink", []() {
+    Heap_Scope scope(HEAP_MODEM);  // Serial2 PPP/AT traffic when on GSM
+    uplink.loop();
+  }, 5000);
+  scheduler.poll("storage", []() { storage.loop(); }, 50000);  // FS benchmark steps
+  scheduler.poll("archive", []() { sensorArchive.loop(); }, 60000);  // Archive benchmark steps
+  
+  // Periodic work
+  scheduler.every("scan", 100, []() {
+    Heap_Scope scope(HEAP_SCAN);
+    scanCache.poll();
+  }, 20000);
+  scheduler.every("config", 250, []() {
+    Heap_Scope scope(HEAP_CONFIG);
+    configStore.loop();  // Debounced NVS write
+  }, 30000);
+  scheduler.every("sensors", 250, pollSensors, 2000);  // Samples come from the sampling task
+  scheduler.every("alerts", 1000, pollAlerts, 30000);  // Blocks while an SMS/email goes out
+  scheduler.every("status", 30000, printStatus, 10000);
+  scheduler.every("heap", Heap_Monitor::SAMPLE_MS, []() { heapMonitor.sample(); }, 2000);
+  
+  // Disarm the reset detector once the window has passed
+  scheduler.after("drd", DRD_TIMEOUT, []() { drd.loop(); }, 20000);
+}
+
 // ============================================================================
 // SETUP
 // ============================================================================
@@ -1529,8 +2728,12 @@ void setupEmailDashboardRoutes() {
  * Initializes all hardware and software components
  */
 void setup() {
+  bootTimeline.begin();
   Serial.begin(115200);
   delay(200);
+  logRing.begin();  // LOG_x output is formatted by a low-priority task
+  heapMonitor.begin();  // Allocation counting is bound to the loop task
+  bootTimeline.mark(Boot_Timeline::PHASE_SERIAL);
   
   // ============================================================================
   // DOUBLE RESET DETECTION
@@ -1552,39 +2755,38 @@ void setup() {
     Serial.println(" Loading MAIN Dashboard (dashboard_html.h)");
   }
   Serial.println("────────────────────────────────────────");
+  bootTimeline.mark(Boot_Timeline::PHASE_DRD);
   
   // ============================================================================
   // FILESYSTEM INITIALIZATION
   // ============================================================================
-  if (!SPIFFS.begin(true)) {
-    Serial.println(" SPIFFS mount failed");
-  } else {
-    Serial.println(" SPIFFS mounted successfully");
-  }
+  // LittleFS; a SPIFFS partition from older firmware is converted once
+  storage.begin();
+  bootTimeline.mark(Boot_Timeline::PHASE_FS);
   
   // ============================================================================
   // LOAD CONFIGURATIONS
   // ============================================================================
-  wifiCfg.load();
-  gsmCfg.load();
-  userCfg.load();
-  emailCfg.load();
+  configStore.setEncoder(encodeConfig);  // Deferred writes + flush on restart
+  loadConfig();
+  bootTimeline.mark(Boot_Timeline::PHASE_CONFIG);
   
   Serial.println("\n Configuration Status:");
-  Serial.printf("  WiFi AP: %s\n", wifiCfg.apSsid.length() ? wifiCfg.apSsid.c_str() : DEFAULT_AP_SSID);
-  Serial.printf("  WiFi STA: %s\n", wifiCfg.staSsid.length() ? wifiCfg.staSsid.c_str() : "Not configured");
-  Serial.printf("  GSM APN: %s\n", gsmCfg.apn.length() ? gsmCfg.apn.c_str() : "Not configured");
-  Serial.printf("  Email: %s\n", emailCfg.isValid() ? emailCfg.emailAccount.c_str() : "Not configured");
+  Serial.printf("  WiFi AP: %s\n", wifiCfg.apSsid[0] ? wifiCfg.apSsid : DEFAULT_AP_SSID);
+  Serial.printf("  WiFi STA: %s\n", wifiCfg.staSsid[0] ? wifiCfg.staSsid : "Not configured");
+  Serial.printf("  GSM APN: %s\n", gsmCfg.apn[0] ? gsmCfg.apn : "Not configured");
+  Serial.printf("  Email: %s\n", emailCfg.isValid() ? emailCfg.emailAccount : "Not configured");
   
   // ============================================================================
   // WIFI ACCESS POINT
   // ============================================================================
-  String apSsid, apPass;
+  const char* apSsid;
+  const char* apPass;
   
   if (currentMode == MODE_MAIN) {
     // Main dashboard - use configured AP settings
-    apSsid = wifiCfg.apSsid.length() ? wifiCfg.apSsid : DEFAULT_AP_SSID;
-    apPass = wifiCfg.apPass.length() ? wifiCfg.apPass : DEFAULT_AP_PASS;
+    apSsid = wifiCfg.apSsid[0] ? wifiCfg.apSsid : DEFAULT_AP_SSID;
+    apPass = wifiCfg.apPass[0] ? wifiCfg.apPass : DEFAULT_AP_PASS;
   } else {
     // Email config dashboard - use same default AP for consistency
     apSsid = DEFAULT_AP_SSID;
@@ -1592,31 +2794,62 @@ void setup() {
   }
   
   startAP(apSsid, apPass);
+  wifiMgr.begin();
+  wifiMgr.onConnected(onWifiConnected);
+  roaming.begin(wifiCfg.profiles);
+  roaming.setEnabled(wifiCfg.staAutoConnect);
   
   Serial.println("\n Access Point Started:");
-  Serial.printf("  SSID: %s\n", apSsid.c_str());
-  Serial.printf("  Password: %s\n", apPass.c_str());
+  Serial.printf("  SSID: %s\n", apSsid);
+  Serial.printf("  Password: %s\n", apPass);
   Serial.printf("  IP: %s\n", ipToStr(WiFi.softAPIP()).c_str());
   Serial.printf("  Mode: %s\n", (currentMode == MODE_MAIN) ? "MAIN Dashboard" : "EMAIL Dashboard");
+  bootTimeline.mark(Boot_Timeline::PHASE_AP);
   
   // ============================================================================
   // WIFI STATION MODE
   // ============================================================================
-  if (wifiCfg.staSsid.length()) {
-    Serial.printf("\n🔌 Connecting to: %s\n", wifiCfg.staSsid.c_str());
+  if (wifiCfg.staSsid[0]) {
+    Serial.printf("\n🔌 Connecting to: %s\n", wifiCfg.staSsid);
     connectSTA(wifiCfg.staSsid, wifiCfg.staPass);
+    bootTimeline.mark(Boot_Timeline::PHASE_STA_START);
   }
   
   // ============================================================================
   // GSM INITIALIZATION (Only for MAIN mode)
   // ============================================================================
+  // Bring-up runs from loop(); the portal does not wait for the modem
   if (currentMode == MODE_MAIN) {
-    Serial.println("\n Initializing GSM modem...");
+    Serial.println("\n Starting GSM modem bring-up...");
     gsmModem.begin();
-    delay(2000);  // Allow modem to stabilize
-    Serial.println(" GSM modem initialized");
+    bootTimeline.mark(Boot_Timeline::PHASE_MODEM);
+  }
+  
+  // GSM fallback is enabled from loop() once the modem is ready
+  uplink.begin(gsmCfg.apn, false);
+  uplink.setStaConfigured(wifiCfg.staSsid[0] != '\0');
+  
+  // ============================================================================
+  // SENSORS
+  // ============================================================================
+  // Sampled by their own task from here on; handlers read the latest slot
+  Wire.begin(I2C_SDA, I2C_SCL);
+#ifndef SENSOR_SIMULATOR
+  sensors.addDriver(&sht3x);
+  sensors.addDriver(&bh1750);
+#endif
+  sensors.setFallback(&sensorSimulator);
+  sensors.begin(SENSOR_PERIOD_MS);
+  
+  // History time continues after the newest sample stored in flash
+  if (sensorArchive.begin()) {
+    sensorHistory.setArchive(&sensorArchive);
+    if (!sensorArchive.isEmpty()) sensorHistory.setTimeBase(sensorArchive.newestMs() + SENSOR_PERIOD_MS);
   }
   
+  char alertErr[48];
+  if (!applyAlertConfig(alertErr, sizeof(alertErr))) Serial.printf("⚠ Alert rules ignored: %s\n", alertErr);
+  
   // ============================================================================
   // WEB SERVER SETUP
   // ============================================================================
@@ -1625,6 +2858,9 @@ void setup() {
   // ============================================================================
   // COMMON ROUTES
   // ============================================================================
+  // Must be the first handler: sees every request URI before its route runs
+  server.addHandler(new RouteTracer());
+  
   
   // Main dashboard pages
   server.on("/", HTTP_GET, handleRoot);
@@ -1669,6 +2905,7 @@ void setup() {
 // RESTART ENDPOINT
 // ============================================================================
 server.on("/api/restart", HTTP_GET, []() {
+  configStore.flush();  // Pending settings (also covered by the shutdown handler)
   sendText(200, "Restarting ESP32...");
   delay(200);
   ESP.restart();
@@ -1678,9 +2915,773 @@ server.on("/api/restart", HTTP_GET, []() {
   // COMMON STATUS ENDPOINT
   // ============================================================================
   server.on("/api/status", HTTP_GET, []() { 
+    Heap_Scope scope(HEAP_JSON);
     sendJson(200, buildStatusJson()); 
   });
   
+  /**
+   * GET /api/boot/timeline
+   * Boot phase timestamps of this boot and of the previous one
+   * (the previous timeline survives software/watchdog resets, not power loss)
+   */
+  server.on("/api/boot/timeline", HTTP_GET, []() {
+    DynamicJsonDocument doc(2048);
+    doc["budgetMs"] = BOOT_BUDGET_MS;
+    
+    JsonObject resets = doc.createNestedObject("drd");
+    resets["resetCount"] = drd.resetCount();
+    resets["maxResets"] = drd.getMaxResets();
+    resets["source"] = DRD_Manager::sourceName(drd.source());
+    resets["detectUs"] = drd.detectUs();
+    resets["flashWrites"] = drd.flashWrites();
+    addBootTimeline(doc.createNestedObject("current"), bootTimeline.current());
+    if (bootTimeline.previous()) {
+      addBootTimeline(doc.createNestedObject("previous"), *bootTimeline.previous());
+    }
+    
+    String out;
+    serializeJson(doc, out);
+    sendJson(200, out);
+  });
+  
+  /**
+   * GET /metrics
+   * Prometheus text exposition, streamed metric by metric
+   */
+  server.on("/metrics", HTTP_GET, []() {
+    ChunkedResponse out;
+    out.begin(200, "text/plain; version=0.0.4");
+    metrics.render(out);
+    out.end();
+  });
+  
+  /**
+   * GET /api/logs?since=<seq>&limit=<n>
+   * Entries from the binary log ring, formatted on request
+   */
+  server.on("/api/logs", HTTP_GET, []() {
+    uint32_t head = logRing.head();
+    uint32_t from = logRing.oldest();
+    if (server.hasArg("since")) {
+      uint32_t since = strtoul(server.arg("since").c_str(), nullptr, 10);
+      if (since > from) from = since < head ? since : head;
+    }
+    uint32_t limit = server.hasArg("limit") ? server.arg("limit").toInt() : Log_Ring::CAPACITY;
+    if (limit > Log_Ring::CAPACITY) limit = Log_Ring::CAPACITY;
+    if (head - from > limit) from = head - limit;
+    
+    ChunkedResponse out;
+    out.begin(200, "application/json");
+    out.printf("{\"next\":%u,\"dropped\":%u,\"torn\":%u,\"collisions\":%u,\"entries\":[",
+               head, logRing.dropped(), logRing.torn(), logRing.collisions());
+    
+    DynamicJsonDocument doc(384);
+    Log_Ring::Entry e;
+    char msg[160];
+    bool first = true;
+    for (uint32_t i = from; i != head; i++) {
+      if (!logRing.read(i, e)) continue;  // Overwritten or still being written
+      Log_Ring::format(e, msg, sizeof(msg));
+      doc.clear();
+      doc["seq"] = i;
+      doc["ms"] = e.ms;
+      doc["level"] = String(Log_Ring::levelChar(e.level));
+      doc["module"] = Log_Ring::moduleName(e.module);
+      doc["msg"] = msg;
+      if (!first) out.print(',');
+      serializeJson(doc, out);
+      first = false;
+    }
+    out.print("]}");
+    out.end();
+  });
+  
+  /**
+   * POST /api/logs/benchmark
+   * CPU cycles per log call: ring write vs. the String + Serial path
+   */
+  server.on("/api/logs/benchmark", HTTP_POST, []() {
+    const int N = 200;
+    Log_Ring* ring = new Log_Ring();  // Scratch ring, keeps the real log intact
+    String carrier = "Operator";
+    int dbm = -71;
+    
+    uint32_t c0 = ESP.getCycleCount();
+    for (int i = 0; i < N; i++) {
+      ring->write(LOG_LEVEL_INFO, LOG_GSM, "Signal Strength: %d dBm on %s", dbm, carrier);
+    }
+    uint32_t ringCycles = (ESP.getCycleCount() - c0) / N;
+    delete ring;
+    
+    // The previous path: String concatenation, then println (UART excluded here)
+    class NullPrint : public Print {
+    public:
+      size_t write(uint8_t) override { return 1; }
+      size_t write(const uint8_t*, size_t n) override { return n; }
+    } sink;
+    c0 = ESP.getCycleCount();
+    for (int i = 0; i < N; i++) {
+      sink.println("GSM_Test: Signal Strength: " + String(dbm) + " dBm on " + carrier);
+    }
+    uint32_t stringCycles = (ESP.getCycleCount() - c0) / N;
+    
+    // One real line to the UART at 115200 baud
+    uint32_t t0 = micros();
+    Serial.println("GSM_Test: Signal Strength: " + String(dbm) + " dBm on " + carrier);
+    Serial.flush();
+    uint32_t serialUs = micros() - t0;
+    
+    DynamicJsonDocument doc(256);
+    doc["iterations"] = N;
+    doc["ringCycles"] = ringCycles;
+    doc["stringCycles"] = stringCycles;
+    doc["serialLineUs"] = serialUs;
+    doc["cpuMhz"] = ESP.getCpuFreqMHz();
+    
+    String out;
+    serializeJson(doc, out);
+    sendJson(200, out);
+  });
+  
+  /**
+   * GET /api/metrics/scheduler
+   * Per-job run counts, runtimes, budget overruns and deadline lateness
+   */
+  server.on("/api/metrics/scheduler", HTTP_GET, []() {
+    DynamicJsonDocument doc(4096);
+    JsonObject pass = doc.createNestedObject("loop");
+    pass["passes"] = scheduler.passes();
+    pass["lastUs"] = scheduler.lastPassUs();
+    pass["avgUs"] = scheduler.avgPassUs();
+    pass["maxUs"] = scheduler.maxPassUs();
+    pass["timedRuns"] = scheduler.timedRuns();
+    pass["slotsScanned"] = scheduler.slotsScanned();
+    pass["tickMs"] = Job_Scheduler::TICK_MS;
+    
+    JsonArray jobs = doc.createNestedArray("jobs");
+    for (uint8_t i = 0; i < scheduler.jobCount(); i++) {
+      const Job_Scheduler::Job& j = scheduler.job(i);
+      JsonObject o = jobs.createNestedObject();
+      o["name"] = j.name;
+      o["kind"] = Job_Scheduler::kindName(j.kind);
+      o["active"] = j.active;
+      if (j.kind == Job_Scheduler::KIND_PERIODIC) o["periodMs"] = j.periodMs;
+      o["budgetUs"] = j.budgetUs;
+      o["runs"] = j.runs;
+      o["overruns"] = j.overruns;
+      o["avgUs"] = j.runs ? (uint32_t)(j.totalUs / j.runs) : 0;
+      o["lastUs"] = j.lastUs;
+      o["maxUs"] = j.maxUs;
+      if (j.kind != Job_Scheduler::KIND_POLL) o["maxLateMs"] = j.maxLateMs;
+    }
+    
+    String out;
+    serializeJson(doc, out);
+    sendJson(200, out);
+  });
+  
+  /**
+   * GET /api/metrics/stalls
+   * loop() iteration histogram, worst stalls with the job/route that caused
+   * them, and what was running when the previous boot was reset by a watchdog
+   */
+  server.on("/api/metrics/stalls", HTTP_GET, []() {
+    DynamicJsonDocument doc(3072);
+    doc["iterations"] = stalls.iterations();
+    doc["stalls"] = stalls.stallCount();
+    doc["stallThresholdUs"] = Stall_Monitor::STALL_US;
+    doc["lastUs"] = stalls.lastIterationUs();
+    doc["maxUs"] = stalls.maxIterationUs();
+    
+    JsonObject histogram = doc.createNestedObject("histogram");
+    for (uint8_t i = 0; i < Stall_Monitor::HISTOGRAM_BUCKETS; i++) {
+      histogram[Stall_Monitor::bucketName(i)] = stalls.bucket(i);
+    }
+    
+    JsonArray top = doc.createNestedArray("top");
+    for (uint8_t i = 0; i < stalls.topCount(); i++) {
+      const Stall_Monitor::Stall& st = stalls.top(i);
+      JsonObject o = top.createNestedObject();
+      o["atMs"] = st.atMs;
+      o["us"] = st.us;
+      o["job"] = st.job;
+      o["jobUs"] = st.jobUs;
+      if (st.route[0]) o["route"] = st.route;
+    }
+    
+    JsonObject wdt = doc.createNestedObject("watchdog");
+    wdt["enabled"] = stalls.watchdogEnabled();
+    wdt["timeoutS"] = Stall_Monitor::WDT_TIMEOUT_S;
+    wdt["paused"] = stalls.watchdogPaused();
+    wdt["pauses"] = stalls.watchdogPauses();
+    const Stall_Monitor::WatchdogReport& fired = stalls.watchdogReport();
+    wdt["expiries"] = fired.count;
+    if (fired.count) {
+      JsonObject last = wdt.createNestedObject("lastExpiry");
+      last["atMs"] = fired.atMs;
+      last["job"] = fired.job;
+      if (fired.route[0]) last["route"] = fired.route;
+    }
+    const Stall_Monitor::ResetReport& rep = stalls.resetReport();
+    if (rep.valid) {
+      JsonObject last = wdt.createNestedObject("lastReset");
+      last["reason"] = Boot_Timeline::resetReasonName(rep.resetReason);
+      last["uptimeMs"] = rep.uptimeMs;
+      last["job"] = rep.job;
+      if (rep.route[0]) last["route"] = rep.route;
+    }
+    
+    String out;
+    serializeJson(doc, out);
+    sendJson(200, out);
+  });
+  
+  /**
+   * GET /api/metrics/heap
+   * Free heap, largest block and fragmentation now, per-subsystem
+   * allocation accounting, and the 24 h trend (streamed)
+   */
+  server.on("/api/metrics/heap", HTTP_GET, []() {
+    uint32_t free = Heap_Monitor::freeBytes();
+    uint32_t largest = Heap_Monitor::largestBlock();
+    
+    ChunkedResponse out;
+    out.begin(200, "application/json");
+    out.printf("{\"free\":%u,\"largest\":%u,\"minFree\":%u,\"fragmentationPct\":%u,"
+               "\"countingAllocs\":%s,\"foreignAllocs\":%u,\"lowWaterChecks\":%u,\"subsystems\":[",
+               free, largest, Heap_Monitor::minFreeBytes(),
+               Heap_Monitor::fragmentationPct(free, largest),
+               Heap_Monitor::wrapped() ? "true" : "false", heapMonitor.foreignAllocs(),
+               heapMonitor.lowWaterChecks());
+    for (uint8_t i = 0; i < HEAP_TAG_COUNT; i++) {
+      const Heap_Monitor::TagStats& t = heapMonitor.tag(i);
+      out.printf("%s{\"name\":\"%s\",\"runs\":%u,\"allocs\":%u,\"allocBytes\":%u,"
+                 "\"currentBytes\":%d,\"peakBytes\":%d,\"peakRunBytes\":%u}",
+                 i ? "," : "", Heap_Monitor::tagName(i), t.runs, t.allocs, t.allocBytes,
+                 t.current, t.peak, t.peakRun);
+    }
+    
+    // One row per sample: [ms, free, largest, minFree]
+    out.printf("],\"trend\":{\"intervalMs\":%u,\"samples\":[", Heap_Monitor::SAMPLE_MS);
+    for (uint16_t i = 0; i < heapMonitor.sampleCount(); i++) {
+      Heap_Monitor::Sample h = heapMonitor.history(i);
+      out.printf("%s[%u,%u,%u,%u]", i ? "," : "", h.ms, h.free, h.largest, h.minFree);
+    }
+    out.print("]}}");
+    out.end();
+  });
+  
+  /**
+   * GET /api/sensors/history?from=<ms>&to=<ms>&step=<ms>
+   * Stored samples in [from, to] (history ms, default: everything in RAM
+   * and flash), as the mean of each step-wide bucket. step is raised so at
+   * most HISTORY_MAX_POINTS points are returned. Streamed.
+   */
+  server.on("/api/sensors/history", HTTP_GET, []() {
+    const uint32_t HISTORY_MAX_POINTS = 1000;
+    uint64_t from = server.hasArg("from") ? strtoull(server.arg("from").c_str(), nullptr, 10) : sensorHistory.oldestMs();
+    uint64_t to = server.hasArg("to") ? strtoull(server.arg("to").c_str(), nullptr, 10) : sensorHistory.newestMs();
+    uint32_t step = server.hasArg("step") ? strtoul(server.arg("step").c_str(), nullptr, 10) : 0;
+    if (to < from) {
+      sendJson(400, "{\"success\":false,\"error\":\"to is before from\"}");
+      return;
+    }
+    uint64_t minStep = (to - from) / HISTORY_MAX_POINTS + 1;
+    if (step < minStep) step = (uint32_t)min<uint64_t>(minStep, UINT32_MAX);
+    
+    struct Emit {
+      ChunkedResponse out;
+      uint32_t points = 0;
+      
+      static void point(const Sensor_History::Point& p, void* arg) {
+        Emit* e = (Emit*)arg;
+        e->out.printf("%s[%llu", e->points++ ? "," : "", (unsigned long long)p.ms);
+        for (uint8_t c = 0; c < SENSOR_CHANNELS; c++) {
+          if (p.valid & SENSOR_BIT(c)) e->out.printf(c == SENSOR_LIGHT ? ",%.0f" : ",%.1f", p.value[c]);
+          else e->out.print(",null");
+        }
+        e->out.print(']');
+      }
+    } emit;
+    
+    uint32_t t0 = micros();
+    emit.out.begin(200, "application/json");
+    emit.out.printf("{\"from\":%llu,\"to\":%llu,\"step\":%u,"
+                    "\"columns\":[\"ms\",\"temperature\",\"humidity\",\"light\"],\"points\":[",
+                    (unsigned long long)from, (unsigned long long)to, (unsigned)step);
+    size_t decoded = sensorHistory.downsample(from, to, step, Emit::point, &emit);
+    emit.out.printf("],\"decoded\":%u,\"queryUs\":%u}", (unsigned)decoded, (unsigned)(micros() - t0));
+    emit.out.end();
+  });
+  
+  /**
+   * GET /api/sensors/history/stats
+   * RAM store size, compression ratio and decode throughput, flash archive
+   * state and the results of the last archive benchmark
+   */
+  server.on("/api/sensors/history/stats", HTTP_GET, []() {
+    struct Counter {
+      static void point(const Sensor_History::Point&, void*) {}
+    };
+    uint32_t t0 = micros();
+    size_t decoded = sensorHistory.forEach(sensorHistory.ramOldestMs(), UINT64_MAX, Counter::point, nullptr);
+    uint32_t decodeUs = micros() - t0;
+    
+    uint32_t samples = sensorHistory.sampleCount();
+    uint32_t payload = sensorHistory.payloadBytes();
+    DynamicJsonDocument doc(1536);
+    doc["nowMs"] = sensorHistory.now();
+    doc["timeBaseMs"] = sensorHistory.timeBase();
+    doc["samples"] = samples;
+    doc["oldestMs"] = sensorHistory.oldestMs();
+    doc["newestMs"] = sensorHistory.newestMs();
+    doc["blocks"] = sensorHistory.blocksUsed();
+    doc["blockCapacity"] = Sensor_History::BLOCK_COUNT;
+    doc["blockBytes"] = Sensor_History::BLOCK_BYTES;
+    doc["blocksDropped"] = sensorHistory.blocksDropped();
+    doc["blocksPending"] = sensorHistory.blocksPending();
+    doc["archiveFailures"] = sensorHistory.archiveFailures();
+    doc["archiveLost"] = sensorHistory.archiveLost();
+    doc["payloadBytes"] = payload;
+    doc["bytesPerSample"] = samples ? (float)payload / samples : 0;
+    doc["compressionRatio"] = payload ? (float)samples * Sensor_History::RAW_SAMPLE_BYTES / payload : 0;
+    
+    JsonObject decode = doc.createNestedObject("decode");
+    decode["samples"] = (uint32_t)decoded;
+    decode["us"] = decodeUs;
+    decode["samplesPerSec"] = decodeUs ? (uint32_t)((uint64_t)decoded * 1000000 / decodeUs) : 0;
+    
+    JsonObject archive = doc.createNestedObject("archive");
+    archive["ready"] = sensorArchive.isReady();
+    archive["partitionOffset"] = sensorArchive.partitionOffset();
+    archive["partitionBytes"] = sensorArchive.partitionBytes();
+    archive["sectors"] = sensorArchive.sectors();
+    archive["blocks"] = sensorArchive.storedBlocks();
+    archive["blockCapacity"] = sensorArchive.capacityBlocks();
+    archive["fillPct"] = sensorArchive.fillPct();
+    archive["oldestMs"] = sensorArchive.oldestMs();
+    archive["newestMs"] = sensorArchive.newestMs();
+    archive["recoveryUs"] = sensorArchive.recoveryUs();
+    archive["blocksWritten"] = sensorArchive.blocksWritten();
+    archive["writeFailures"] = sensorArchive.writeFailures();
+    archive["erases"] = sensorArchive.erases();
+    archive["crcErrors"] = sensorArchive.crcErrors();
+    archive["lastWriteUs"] = sensorArchive.lastWriteUs();
+    archive["maxWriteUs"] = sensorArchive.maxWriteUs();
+    archive["writeAmplification"] = sensorArchive.writeAmplification();
+    
+    JsonObject bench = archive.createNestedObject("benchmark");
+    bench["running"] = sensorArchive.benchRunning();
+    if (sensorArchive.benchDone()) {
+      const Sensor_Archive::BenchResult& r = sensorArchive.benchResult();
+      bench["fillPct"] = r.fillPct;
+      bench["blocks"] = r.blocks;
+      bench["fillMs"] = r.fillMs;
+      bench["avgWriteUs"] = r.avgWriteUs;
+      bench["avgEraseUs"] = r.avgEraseUs;
+      bench["writeAmplification"] = r.writeAmplification;
+      bench["recoveryUs"] = r.recoveryUs;
+      bench["queryHourUs"] = r.queryHourUs;
+      bench["queryAllUs"] = r.queryAllUs;
+      bench["querySamples"] = r.querySamples;
+    }
+    
+    String out;
+    serializeJson(doc, out);
+    sendJson(200, out);
+  });
+  
+  /**
+   * POST /api/sensors/history/benchmark?fill=80&erase=1
+   * Fill the flash archive to fill % with copies of the newest sealed
+   * block, measure, and erase it again. Refused while the archive holds
+   * history unless erase=1 (stored history is then lost).
+   * Poll GET /api/sensors/history/stats for results.
+   */
+  server.on("/api/sensors/history/benchmark", HTTP_POST, []() {
+    uint8_t fill = server.hasArg("fill") ? server.arg("fill").toInt() : 80;
+    bool discard = server.arg("erase") == "1";
+    const Sensor_History::Block* sample = sensorHistory.lastSealed();
+    if (sensorArchive.storedBlocks() && !sensorArchive.benchRunning() && !discard) {
+      sendJson(409, "{\"success\":false,\"error\":\"Archive holds history; pass erase=1 to discard it\"}");
+      return;
+    }
+    // The erase runs one sector per loop() pass, not in this handler
+    if (!sample || !sensorArchive.startBenchmark(*sample, fill, discard)) {
+      sendJson(409, "{\"success\":false,\"error\":\"No archive partition, no sealed block yet or benchmark running\"}");
+      return;
+    }
+    sendJson(202, "{\"success\":true}");
+  });
+  
+  /**
+   * GET /api/sensors/pipeline
+   * Sampling task statistics (read time, wake-up jitter, drops), detected
+   * drivers, and the measured cost of a latest-value read
+   */
+  server.on("/api/sensors/pipeline", HTTP_GET, []() {
+    const int N = 1000;
+    Sensor_Sample s;
+    uint32_t c0 = ESP.getCycleCount();
+    for (int i = 0; i < N; i++) sensors.latest(s);
+    uint32_t readCycles = (ESP.getCycleCount() - c0) / N;
+    
+    DynamicJsonDocument doc(1024);
+    doc["periodMs"] = sensors.periodMs();
+    doc["samples"] = sensors.samples();
+    doc["readErrors"] = sensors.readErrors();
+    doc["queueDropped"] = sensors.queueDropped();
+    doc["simulated"] = sensors.simulated();
+    
+    JsonObject read = doc.createNestedObject("readUs");
+    read["last"] = sensors.lastReadUs();
+    read["max"] = sensors.maxReadUs();
+    JsonObject jitter = doc.createNestedObject("jitterUs");
+    jitter["last"] = sensors.lastJitterUs();
+    jitter["avg"] = sensors.avgJitterUs();
+    jitter["max"] = sensors.maxJitterUs();
+    
+    JsonArray drivers = doc.createNestedArray("drivers");
+    for (uint8_t i = 0; i < sensors.driverCount(); i++) {
+      JsonObject d = drivers.createNestedObject();
+      d["name"] = sensors.driver(i)->name();
+      d["present"] = sensors.driverPresent(i);
+    }
+    
+    JsonObject latest = doc.createNestedObject("latestRead");
+    latest["cycles"] = readCycles;
+    latest["ns"] = readCycles * 1000 / ESP.getCpuFreqMHz();
+    
+    String out;
+    serializeJson(doc, out);
+    sendJson(200, out);
+  });
+  
+  /**
+   * GET /api/sensors/stats?verify=1
+   * Rolling min/max/mean/stddev and sketch percentiles per window and
+   * channel, and the per-sample update cost. verify=1 also compares each
+   * window holding up to VERIFY_MAX samples against exact values decoded
+   * from the history.
+   */
+  server.on("/api/sensors/stats", HTTP_GET, []() {
+    bool verify = server.hasArg("verify") && server.arg("verify") != "0";
+    uint32_t mhz = ESP.getCpuFreqMHz();
+    
+    DynamicJsonDocument doc(verify ? 6144 : 3072);
+    doc["samples"] = sensorStats.samples();
+    doc["newestMs"] = sensorStats.newestMs();
+    JsonObject update = doc.createNestedObject("update");
+    update["avgCycles"] = sensorStats.avgAddCycles();
+    update["avgNs"] = sensorStats.avgAddCycles() * 1000 / mhz;
+    update["maxCycles"] = sensorStats.maxAddCycles();
+    
+    JsonArray windows = doc.createNestedArray("windows");
+    for (uint8_t w = 0; w < Sensor_Stats::WINDOW_COUNT; w++) {
+      Sensor_Stats::Window win = (Sensor_Stats::Window)w;
+      JsonObject o = windows.createNestedObject();
+      o["window"] = Sensor_Stats::windowName(win);
+      o["bucketMs"] = Sensor_Stats::bucketMs(win);
+      o["sketchFromMs"] = sensorStats.sketchFromMs(win);
+      
+      JsonObject channels = o.createNestedObject("channels");
+      for (uint8_t ch = 0; ch < SENSOR_CHANNELS; ch++) {
+        Sensor_Stats::Summary sum;
+        if (!sensorStats.summary(win, ch, sum)) {
+          channels[Sensor_Pipeline::channelName(ch)] = nullptr;
+          continue;
+        }
+        JsonObject c = channels.createNestedObject(Sensor_Pipeline::channelName(ch));
+        c["count"] = sum.count;
+        c["fromMs"] = sum.fromMs;
+        c["min"] = sum.min;
+        c["max"] = sum.max;
+        c["mean"] = sum.mean;
+        c["stddev"] = sum.stddev;
+        c["p50"] = sensorStats.percentile(win, ch, 0.50f);
+        c["p90"] = sensorStats.percentile(win, ch, 0.90f);
+        c["p99"] = sensorStats.percentile(win, ch, 0.99f);
+        
+        Sensor_Stats::Check check;
+        if (verify && sensorStats.verify(win, ch, sensorHistory, check)) {
+          JsonObject v = c.createNestedObject("verify");
+          v["exactCount"] = check.count;
+          v["countError"] = check.countError;
+          v["meanError"] = check.meanError;
+          v["stddevError"] = check.stddevError;
+          v["minError"] = check.minError;
+          v["maxError"] = check.maxError;
+          JsonArray exact = v.createNestedArray("exact");
+          JsonArray sketch = v.createNestedArray("sketch");
+          for (uint8_t i = 0; i < 3; i++) {
+            exact.add(check.pExact[i]);
+            sketch.add(check.pSketch[i]);
+          }
+        }
+      }
+    }
+    
+    String out;
+    serializeJson(doc, out);
+    sendJson(200, out);
+  });
+  
+  /**
+   * GET /api/sensors/test/stats?bench=<samples>
+   * Size, duration, throughput and heap peak of the last /api/sensors/test
+   * run. bench=N (at most SENSOR_TEST_MAX; the three passes run inside
+   * this handler) also generates N samples into a discarding sink, with
+   * the fixed-point generator and with the float model it replaced
+   * (random() per step, printf formatting), to separate generation cost
+   * from network time.
+   */
+  server.on("/api/sensors/test/stats", HTTP_GET, []() {
+    uint32_t bench = server.hasArg("bench") ? strtoul(server.arg("bench").c_str(), nullptr, 10) : 0;
+    if (bench > SENSOR_TEST_MAX) {
+      sendJson(400, "{\"success\":false,\"error\":\"bench must be 0-5000\"}");
+      return;
+    }
+    
+    DynamicJsonDocument doc(768);
+    JsonObject last = doc.createNestedObject("last");
+    last["count"] = sensorTestRun.count;
+    last["format"] = sensorTestRun.csv ? "csv" : "json";
+    last["bytes"] = sensorTestRun.bytes;
+    last["us"] = sensorTestRun.us;
+    last["samplesPerSec"] = sensorTestRun.us ? (uint32_t)((uint64_t)sensorTestRun.count * 1000000 / sensorTestRun.us) : 0;
+    last["heapPeakBytes"] = sensorTestRun.heapPeakBytes;
+    
+    if (bench) {
+      struct Discard : Print {
+        size_t write(uint8_t) override { return 1; }
+        size_t write(const uint8_t*, size_t n) override { return n; }
+      } sink;
+      
+      JsonObject b = doc.createNestedObject("bench");
+      b["samples"] = bench;
+      for (uint8_t csv = 0; csv < 2; csv++) {
+        uint32_t heapStart = Heap_Monitor::freeBytes();
+        uint32_t heapLow = heapStart;
+        uint32_t t0 = micros();
+        size_t bytes = writeSensorTestSamples(sink, bench, csv, 1, heapLow);
+        uint32_t us = micros() - t0;
+        JsonObject o = b.createNestedObject(csv ? "csv" : "json");
+        o["bytes"] = bytes;
+        o["us"] = us;
+        o["samplesPerSec"] = us ? (uint32_t)((uint64_t)bench * 1000000 / us) : 0;
+        o["heapPeakBytes"] = heapStart - heapLow;
+      }
+      
+      // Previous model: float walk, random() per field, printf formatting
+      float t = 22.5f, h = 65.0f, l = 850.0f;
+      char line[96];
+      uint32_t t0 = micros();
+      for (uint32_t i = 0; i < bench; i++) {
+        t = constrain(t + random(-20, 21) / 100.0f, 18.0f, 32.0f);
+        h = constrain(h + random(-30, 31) / 100.0f, 30.0f, 90.0f);
+        l = constrain(l + random(-200, 201) / 10.0f, 0.0f, 2000.0f);
+        int n = snprintf(line, sizeof(line), "%s{\"temperature\":%.1f,\"humidity\":%.1f,\"light\":%.0f,\"index\":%u}",
+                         i ? "," : "", round(t * 10) / 10.0, round(h * 10) / 10.0, round(l), i);
+        sink.write((const uint8_t*)line, n);
+      }
+      uint32_t us = micros() - t0;
+      JsonObject o = b.createNestedObject("floatJson");
+      o["us"] = us;
+      o["samplesPerSec"] = us ? (uint32_t)((uint64_t)bench * 1000000 / us) : 0;
+    }
+    
+    String out;
+    serializeJson(doc, out);
+    sendJson(200, out);
+  });
+  
+  // ============================================================================
+  // SENSOR ALERT ENDPOINTS
+  // ============================================================================
+  
+  /**
+   * GET /api/load/alerts
+   * Load alert configuration
+   */
+  server.on("/api/load/alerts", HTTP_GET, []() {
+    sendConfigJson(AlertConfig::schema(), &alertCfg, 2048);
+  });
+  
+  /**
+   * POST /api/save/alerts
+   * Save alert configuration; the rules are compiled first and a syntax
+   * error is answered with 400 (nothing is saved, cooldown unchanged).
+   * Every rule restarts IDLE; unchanged rules keep their cooldown, so an
+   * active condition is not notified again by the save
+   * Request body: {"enabled": true, "smsTo": "+94...", "emailTo": "...", "postTo": "host:port/path",
+   *                "cooldown": 900, "rules": "temperature > 30 hyst 0.5 for 60 sms"}
+   */
+  server.on("/api/save/alerts", HTTP_POST, []() {
+    uint32_t t0 = micros();
+    AlertConfig previous = alertCfg;
+    if (!applyConfigJson(AlertConfig::schema(), &alertCfg, 2048)) return;
+    
+    char err[48];
+    if (!applyAlertConfig(err, sizeof(err))) {
+      alertCfg = previous;
+      DynamicJsonDocument resp(128);
+      resp["success"] = false;
+      resp["error"] = err;
+      String out;
+      serializeJson(resp, out);
+      sendJson(400, out);
+      return;
+    }
+    bool ok = alertCfg.save();
+    
+    DynamicJsonDocument resp(128);
+    resp["success"] = ok;
+    resp["rules"] = alerts.ruleCount();
+    
+    String out;
+    serializeJson(resp, out);
+    configSaveLatency.note(t0);
+    sendJson(ok ? 200 : 500, out);
+  });
+  
+  /**
+   * GET /api/alerts
+   * Compiled rules with their state, the current signal values, the
+   * per-sample evaluation cost and notification counters
+   */
+  server.on("/api/alerts", HTTP_GET, []() {
+    uint32_t mhz = ESP.getCpuFreqMHz();
+    DynamicJsonDocument doc(4096 + alerts.ruleCount() * 160);
+    doc["enabled"] = alertCfg.enabled;
+    
+    JsonObject eval = doc.createNestedObject("evaluation");
+    eval["samples"] = alerts.evaluations();
+    eval["avgCycles"] = alerts.avgCycles();
+    eval["avgNs"] = alerts.avgCycles() * 1000 / mhz;
+    eval["maxCycles"] = alerts.maxCycles();
+    eval["avgRulesVisited"] = alerts.avgVisited();
+    
+    JsonObject events = doc.createNestedObject("events");
+    events["total"] = alerts.events();
+    events["suppressed"] = alerts.suppressed();
+    events["dropped"] = alerts.dropped();
+    events["sms"] = alertNotify.sms;
+    events["smsFailed"] = alertNotify.smsFailed;
+    events["email"] = alertNotify.email;
+    events["emailFailed"] = alertNotify.emailFailed;
+    events["post"] = alertNotify.post;
+    events["postFailed"] = alertNotify.postFailed;
+    
+    JsonObject signals = doc.createNestedObject("signals");
+    for (uint8_t ch = 0; ch < SENSOR_CHANNELS; ch++) {
+      JsonObject o = signals.createNestedObject(Sensor_Pipeline::channelName(ch));
+      for (uint8_t k = 0; k < ALERT_SIGNALS; k++) {
+        float v = alerts.signalValue(ch, k);
+        if (isnan(v)) o[Alert_Engine::signalName(k)] = nullptr;
+        else o[Alert_Engine::signalName(k)] = v;
+      }
+    }
+    
+    JsonArray rules = doc.createNestedArray("rules");
+    char text[64];
+    for (uint8_t i = 0; i < alerts.ruleCount(); i++) {
+      const Alert_Engine::Rule& r = alerts.rule(i);
+      alerts.describe(i, text, sizeof(text));
+      JsonObject o = rules.createNestedObject();
+      o["rule"] = text;
+      o["state"] = Alert_Engine::stateName(r.state);
+      o["sinceMs"] = r.sinceMs;
+      o["raised"] = r.raised;
+      o["value"] = r.value;
+    }
+    
+    String out;
+    serializeJson(doc, out);
+    sendJson(200, out);
+  });
+  
+  /**
+   * POST /api/alerts/benchmark?rules=100&samples=2000
+   * Evaluate a synthetic rule set over a replayed random walk twice: with
+   * the compiled table and checking every rule on every sample. Runs on a
+   * scratch engine; the configured rules are not touched.
+   */
+  server.on("/api/alerts/benchmark", HTTP_POST, []() {
+    uint8_t count = server.hasArg("rules") ? constrain(server.arg("rules").toInt(), 1, Alert_Engine::MAX_RULES) : 100;
+    uint32_t samples = server.hasArg("samples") ? constrain(server.arg("samples").toInt(), 10, 20000) : 2000;
+    
+    Alert_Engine* bench = new (std::nothrow) Alert_Engine();
+    if (!bench) {
+      sendJson(503, "{\"success\":false,\"error\":\"Out of memory\"}");
+      return;
+    }
+    bench->setLogging(false);
+    
+    // Levels spread over the simulator's ranges, a third of them with a duration
+    static const float BASE[SENSOR_CHANNELS][ALERT_SIGNALS] = {
+      { 18, -2, 30 }, { 30, -5, 30 }, { 0, -200, 30 }
+    };
+    static const float SPAN[SENSOR_CHANNELS][ALERT_SIGNALS] = {
+      { 14, 4, 600 }, { 60, 10, 600 }, { 2000, 400, 600 }
+    };
+    for (uint8_t i = 0; i < count; i++) {
+      uint8_t ch = i % SENSOR_CHANNELS;
+      uint8_t sig = (i / SENSOR_CHANNELS) % ALERT_SIGNALS;
+      float level = BASE[ch][sig] + SPAN[ch][sig] * ((i * 37) % 100) / 100.0f;
+      bool above = sig == ALERT_STUCK || (i & 1);
+      bench->addRule(ch, sig, above, level, SPAN[ch][sig] / 100, (i % 3 == 0) ? 30000 : 0, 0);
+    }
+    bench->build();
+    
+    DynamicJsonDocument doc(768);
+    doc["rules"] = count;
+    doc["samples"] = samples;
+    uint32_t mhz = ESP.getCpuFreqMHz();
+    uint32_t events[2], active[2];
+    
+    for (uint8_t pass = 0; pass < 2; pass++) {
+      bench->setLinear(pass == 1);
+      bench->build();                    // Every rule back to IDLE, signals reset
+      bench->resetStats();
+      
+      // Same walk for both passes (xorshift32, fixed seed)
+      uint32_t rng = 0x2545F491;
+      Sensor_Sample s = { 0, 0, SENSOR_BIT(SENSOR_TEMPERATURE) | SENSOR_BIT(SENSOR_HUMIDITY) | SENSOR_BIT(SENSOR_LIGHT), { 25, 60, 500 } };
+      for (uint32_t n = 0; n < samples; n++) {
+        rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+        s.seq = n + 1;
+        s.ms = n * SENSOR_PERIOD_MS;
+        s.value[SENSOR_TEMPERATURE] = constrain(s.value[SENSOR_TEMPERATURE] + ((int)(rng % 41) - 20) / 100.0f, 18.0f, 32.0f);
+        s.value[SENSOR_HUMIDITY] = constrain(s.value[SENSOR_HUMIDITY] + ((int)((rng >> 8) % 61) - 30) / 100.0f, 30.0f, 90.0f);
+        if ((rng >> 20) % 4) {           // Light holds still a quarter of the time
+          s.value[SENSOR_LIGHT] = constrain(s.value[SENSOR_LIGHT] + ((int)((rng >> 16) % 401) - 200) / 10.0f, 0.0f, 2000.0f);
+        }
+        bench->evaluate(s);
+      }
+      
+      active[pass] = 0;
+      for (uint8_t i = 0; i < count; i++) active[pass] += bench->rule(i).state == Alert_Engine::STATE_ACTIVE;
+      events[pass] = bench->events();
+      JsonObject o = doc.createNestedObject(pass ? "linear" : "table");
+      o["avgCycles"] = bench->avgCycles();
+      o["avgNs"] = bench->avgCycles() * 1000 / mhz;
+      o["maxCycles"] = bench->maxCycles();
+      o["avgRulesVisited"] = bench->avgVisited();
+      o["events"] = events[pass];
+      o["activeAtEnd"] = active[pass];
+    }
+    delete bench;
+    
+    // Both passes must reach the same decisions
+    doc["match"] = events[0] == events[1] && active[0] == active[1];
+    doc["speedup"] = doc["table"]["avgCycles"].as<uint32_t>() ?
+                     (float)doc["linear"]["avgCycles"].as<uint32_t>() / doc["table"]["avgCycles"].as<uint32_t>() : 0;
+    
+    String out;
+    serializeJson(doc, out);
+    sendJson(200, out);
+  });
+  
   // ============================================================================
   // SETUP MODE-SPECIFIC ROUTES
   // ============================================================================
@@ -1697,13 +3698,39 @@ server.on("/api/restart", HTTP_GET, []() {
   // ============================================================================
   // Handle preflight OPTIONS requests for all API endpoints
   server.on("/api/status", HTTP_OPTIONS, handleOptions);
+  server.on("/api/boot/timeline", HTTP_OPTIONS, handleOptions);
+  server.on("/api/metrics/scheduler", HTTP_OPTIONS, handleOptions);
+  server.on("/api/metrics/stalls", HTTP_OPTIONS, handleOptions);
+  server.on("/api/metrics/heap", HTTP_OPTIONS, handleOptions);
+  server.on("/api/sensors/pipeline", HTTP_OPTIONS, handleOptions);
+  server.on("/api/sensors/stats", HTTP_OPTIONS, handleOptions);
+  server.on("/api/sensors/test/stats", HTTP_OPTIONS, handleOptions);
+  server.on("/api/load/alerts", HTTP_OPTIONS, handleOptions);
+  server.on("/api/save/alerts", HTTP_OPTIONS, handleOptions);
+  server.on("/api/alerts", HTTP_OPTIONS, handleOptions);
+  server.on("/api/alerts/benchmark", HTTP_OPTIONS, handleOptions);
+  server.on("/api/sensors/history", HTTP_OPTIONS, handleOptions);
+  server.on("/api/sensors/history/stats", HTTP_OPTIONS, handleOptions);
+  server.on("/api/sensors/history/benchmark", HTTP_OPTIONS, handleOptions);
+  server.on("/api/logs", HTTP_OPTIONS, handleOptions);
+  server.on("/api/logs/benchmark", HTTP_OPTIONS, handleOptions);
+  server.on("/api/uplink", HTTP_OPTIONS, handleOptions);
+  server.on("/api/dns", HTTP_OPTIONS, handleOptions);
+  server.on("/api/config/store", HTTP_OPTIONS, handleOptions);
+  server.on("/api/fs", HTTP_OPTIONS, handleOptions);
+  server.on("/api/fs/benchmark", HTTP_OPTIONS, handleOptions);
   server.on("/api/sensors", HTTP_OPTIONS, handleOptions);
+  server.on("/api/sensors/test", HTTP_OPTIONS, handleOptions);
   server.on("/api/system/info", HTTP_OPTIONS, handleOptions);
   server.on("/api/mode", HTTP_OPTIONS, handleOptions);
   server.on("/api/wifi/scan", HTTP_OPTIONS, handleOptions);
   server.on("/api/wifi/scan/results", HTTP_OPTIONS, handleOptions);
   server.on("/api/wifi/connect", HTTP_OPTIONS, handleOptions);
+  server.on("/api/wifi/connect/status", HTTP_OPTIONS, handleOptions);
   server.on("/api/wifi/disconnect", HTTP_OPTIONS, handleOptions);
+  server.on("/api/wifi/profiles", HTTP_OPTIONS, handleOptions);
+  server.on("/api/wifi/profiles/delete", HTTP_OPTIONS, handleOptions);
+  server.on("/api/wifi/roaming", HTTP_OPTIONS, handleOptions);
   server.on("/api/gsm/signal", HTTP_OPTIONS, handleOptions);
   server.on("/api/gsm/network", HTTP_OPTIONS, handleOptions);
   server.on("/api/gsm/call", HTTP_OPTIONS, handleOptions);
@@ -1725,12 +3752,23 @@ server.on("/api/restart", HTTP_GET, []() {
   // ============================================================================
   server.on("/", HTTP_OPTIONS, handleOptions);
   server.onNotFound(handleNotFound);
+  bootTimeline.mark(Boot_Timeline::PHASE_ROUTES);
   
   // ============================================================================
   // START SERVER
   // ============================================================================
   server.begin();
   Serial.println(" HTTP server started");
+  bootTimeline.mark(Boot_Timeline::PHASE_READY);
+  
+  registerJobs();
+  stalls.begin(true);  // Task watchdog from here on; setup() is not covered
+  
+  uint32_t bootMs = Boot_Timeline::readyMs(bootTimeline.current());
+  Serial.printf(" Boot to portal ready: %u ms (budget %u ms)\n", bootMs, BOOT_BUDGET_MS);
+  if (Boot_Timeline::overBudget(bootTimeline.current(), BOOT_BUDGET_MS)) {
+    Serial.println("⚠ Boot time over budget, see /api/boot/timeline");
+  }
   
   // ============================================================================
   // STARTUP COMPLETE
@@ -1752,69 +3790,11 @@ server.on("/api/restart", HTTP_GET, []() {
 
 /**
  * @brief Main loop function
- * Handles ongoing network operations and periodic status updates
+ * All network handling and periodic work runs as scheduler jobs
+ * (see registerJobs())
  */
 void loop() {
-  // ============================================================================
-  // NETWORK HANDLING
-  // ============================================================================
-  dnsServer.processNextRequest();  // Handle DNS requests for captive portal
-  server.handleClient();            // Handle HTTP requests
-  
-  // ============================================================================
-  // WIFI SCAN PROCESSING
-  // ============================================================================
-  if (WiFi.scanComplete() >= 0) {
-    processWiFiScanResults();
-  }
-  
-  // ============================================================================
-  // DOUBLE RESET DETECTION
-  // ============================================================================
-  drd.loop();  // Auto-clear DRD flag after timeout
-  
-  // ============================================================================
-  // PERIODIC STATUS LOGGING
-  // ============================================================================
-  static unsigned long lastStatusPrint = 0;
-  const unsigned long STATUS_INTERVAL = 30000;  // 30 seconds
-  
-  if (millis() - lastStatusPrint > STATUS_INTERVAL) {
-    lastStatusPrint = millis();
-    
-    // Print status header
-    Serial.printf("\n📊 Status Update [%s mode]\n", 
-                  (currentMode == MODE_MAIN) ? "MAIN (dashboard_html.h)" : "EMAIL (config_html.h)");
-    
-    // Access Point status
-    Serial.printf("  AP IP: %s\n", ipToStr(WiFi.softAPIP()).c_str());
-    Serial.printf("  Connected devices: %d\n", WiFi.softAPgetStationNum());
-    
-    // Station mode status
-    if (WiFi.status() == WL_CONNECTED) {
-      Serial.printf("  STA IP: %s\n", ipToStr(WiFi.localIP()).c_str());
-      Serial.printf("  RSSI: %d dBm (%s)\n", WiFi.RSSI(), rssiToStrength(WiFi.RSSI()));
-    } else {
-      Serial.println("  STA: Not connected");
-    }
-    
-    // Email configuration status (only in EMAIL mode)
-    if (currentMode == MODE_EMAIL) {
-      Serial.printf("  Email: %s\n", emailCfg.isValid() ? "Configured ✓" : "Not configured ✗");
-    }
-    
-    // GSM status (only in MAIN mode)
-    if (currentMode == MODE_MAIN) {
-      if (gsmCache.signalStrength != 0) {
-        Serial.printf("  GSM Signal: %d dBm (%s)\n", 
-                      gsmCache.signalStrength, 
-                      gsmCache.grade.c_str());
-        Serial.printf("  GSM Carrier: %s\n", gsmCache.carrierName.c_str());
-      } else {
-        Serial.println("  GSM: Not initialized");
-      }
-    }
-    
-    Serial.println("────────────────────────────────────────");
-  }
-}
\ No newline at end of file
+  stalls.iterationStart();
+  scheduler.loop();
+  stalls.iterationEnd();  // Also feeds the task watchdog
+}
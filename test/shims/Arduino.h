@@ -0,0 +1,277 @@
+/**
+ * @file Arduino.h
+ * @brief Host stand-in for the Arduino core used by the [env:native] tests
+ *
+ * @details
+ * Only what the modules under test use. Time is simulated: millis(),
+ * micros() and esp_timer_get_time() read a clock that tests move with
+ * Native::advanceUs() / advanceMs() (delay() advances it too), and
+ * Native::millisHook() runs test code inside a millis() call. Serial
+ * output is discarded.
+ */
+
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+#define IRAM_ATTR
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+#define PROGMEM
+#define F(x) x
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+using std::min;
+using std::max;
+
+template <class T, class L, class H>
+T constrain(T x, L lo, H hi) { return x < lo ? lo : (x > hi ? hi : x); }
+
+// ============================================================================
+// SIMULATED CLOCK
+// ============================================================================
+
+namespace Native {
+inline uint64_t& clockUs() { static uint64_t us = 0; return us; }
+inline void setUs(uint64_t us) { clockUs() = us; }
+inline void advanceUs(uint64_t us) { clockUs() += us; }
+inline void advanceMs(uint64_t ms) { clockUs() += ms * 1000; }
+}
+
+namespace Native {
+// Called from millis(): lets a test run "another task" at that point
+inline void (*&millisHook())() { static void (*hook)() = nullptr; return hook; }
+}
+
+inline unsigned long millis() {
+  if (Native::millisHook()) Native::millisHook()();
+  return (unsigned long)(uint32_t)(Native::clockUs() / 1000);
+}
+inline unsigned long micros() { return (unsigned long)(uint32_t)Native::clockUs(); }
+inline void delay(unsigned long ms) { Native::advanceMs(ms); }
+inline void yield() {}
+
+// ============================================================================
+// STRING / PRINT
+// ============================================================================
+
+// Content lives in a std::string; the buffer the ESP32 core's WString
+// would hold is modelled alongside it so tests can count heap
+// allocations: 14 characters fit inline (SSO), longer text takes a
+// heap buffer rounded up to 16 bytes that is reused until it must grow.
+// Native::stringAllocs() counts every malloc/realloc that model makes.
+
+namespace Native {
+inline long& stringAllocs() { static long n = 0; return n; }
+}
+
+class String {
+public:
+  static constexpr unsigned SSO_CAPACITY = 14;
+
+  String() {}
+  String(const char* s) { assign(s ? s : ""); }
+  String(const std::string& s) { assign(s); }
+  String(const String& s) { assign(s._s); }
+  String(String&& s) noexcept : _s(std::move(s._s)), _cap(s._cap) { s._s.clear(); s._cap = SSO_CAPACITY; }
+  explicit String(char c) { assign(std::string(1, c)); }
+  String(int v) { assign(std::to_string(v)); }
+  String(unsigned v) { assign(std::to_string(v)); }
+  String(long v) { assign(std::to_string(v)); }
+  String(unsigned long v) { assign(std::to_string(v)); }
+
+  String& operator=(const String& s) { if (this != &s) assign(s._s); return *this; }
+  String& operator=(const char* s) { assign(s ? s : ""); return *this; }
+  String& operator=(String&& s) noexcept {
+    if (this == &s) return *this;
+    if (s._cap > SSO_CAPACITY) {
+      _s = std::move(s._s);
+      _cap = s._cap;
+      s._s.clear();
+      s._cap = SSO_CAPACITY;
+    } else {
+      assign(s._s);
+    }
+    return *this;
+  }
+
+  const char* c_str() const { return _s.c_str(); }
+  unsigned length() const { return _s.size(); }
+  bool isEmpty() const { return _s.empty(); }
+  bool reserve(unsigned n) { grow(n); return true; }
+  bool concat(const char* s, unsigned n) { append(std::string(s, n)); return true; }
+  String& operator+=(const String& s) { append(s._s); return *this; }
+  String& operator+=(const char* s) { append(s); return *this; }
+  String& operator+=(char c) { append(std::string(1, c)); return *this; }
+  String& operator+=(int v) { append(std::to_string(v)); return *this; }
+  String& operator+=(long v) { append(std::to_string(v)); return *this; }
+  String& operator+=(unsigned long v) { append(std::to_string(v)); return *this; }
+  bool operator==(const String& s) const { return _s == s._s; }
+  bool operator==(const char* s) const { return _s == s; }
+  bool operator!=(const String& s) const { return _s != s._s; }
+  bool operator!=(const char* s) const { return _s != s; }
+  char operator[](unsigned i) const { return i < _s.size() ? _s[i] : 0; }
+  const char* begin() const { return _s.c_str(); }
+  const char* end() const { return _s.c_str() + _s.size(); }
+
+  int indexOf(char c, unsigned from = 0) const { return found(_s.find(c, from)); }
+  int indexOf(const String& s, unsigned from = 0) const { return found(_s.find(s._s, from)); }
+  bool startsWith(const String& s) const { return _s.compare(0, s._s.size(), s._s) == 0; }
+  String substring(unsigned from) const { return substring(from, _s.size()); }
+  String substring(unsigned from, unsigned to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= _s.size()) return String();
+    return String(_s.substr(from, min((size_t)to, _s.size()) - from));
+  }
+  long toInt() const { return atol(_s.c_str()); }
+  void trim() {
+    size_t a = _s.find_first_not_of(" \t\r\n");
+    size_t b = _s.find_last_not_of(" \t\r\n");
+    _s = a == std::string::npos ? std::string() : _s.substr(a, b - a + 1);
+  }
+  void replace(const String& from, const String& to) {
+    if (from._s.empty()) return;
+    std::string r;
+    size_t pos = 0, hit;
+    while ((hit = _s.find(from._s, pos)) != std::string::npos) {
+      r.append(_s, pos, hit - pos).append(to._s);
+      pos = hit + from._s.size();
+    }
+    r.append(_s, pos, std::string::npos);
+    grow(r.size());
+    _s = r;
+  }
+
+private:
+  static int found(size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+
+  void grow(size_t len) {
+    if (len <= _cap) return;
+    _cap = (unsigned)((len + 16) & ~(size_t)15);
+    Native::stringAllocs()++;
+  }
+  void assign(const std::string& s) { grow(s.size()); _s = s; }
+  void append(const std::string& s) { grow(_s.size() + s.size()); _s += s; }
+
+  std::string _s;
+  unsigned _cap = SSO_CAPACITY;
+};
+
+// Like WString's StringSumHelper, a chain a + b + c copies a once and
+// appends the rest in place.
+inline String operator+(String a, const String& b) { a += b; return a; }
+inline String operator+(String a, const char* b) { a += b; return a; }
+inline String operator+(String a, char b) { a += b; return a; }
+inline String operator+(String a, int b) { a += b; return a; }
+inline String operator+(String a, long b) { a += b; return a; }
+inline String operator+(String a, unsigned long b) { a += b; return a; }
+inline String operator+(const char* a, const String& b) { String r(a); r += b; return r; }
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buf, size_t n) {
+    for (size_t i = 0; i < n; i++) write(buf[i]);
+    return n;
+  }
+  size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t print(const char* s) { return write(s); }
+  size_t print(const String& s) { return write(s.c_str()); }
+  size_t println(const char* s = "") { return write(s) + write("\n"); }
+  size_t println(const String& s) { return println(s.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(long v) { return print(String(v)); }
+  size_t print(unsigned long v) { return print(String(v)); }
+  size_t print(int v) { return print((long)v); }
+  size_t print(unsigned v) { return print((unsigned long)v); }
+  size_t println(long v) { return println(String(v)); }
+  size_t println(int v) { return println((long)v); }
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+    char buf[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    return n > 0 ? write((const uint8_t*)buf, min((size_t)n, sizeof(buf) - 1)) : 0;
+  }
+  virtual void flush() {}
+};
+
+#define SERIAL_8N1 0x800001c
+
+// available()/read() are virtual so a test can script a modem by
+// deriving from HardwareSerial.
+class Stream : public Print {
+public:
+  virtual int available() { return 0; }
+  virtual int read() { return -1; }
+  virtual int peek() { return -1; }
+};
+
+class HardwareSerial : public Stream {
+public:
+  using Print::write;
+  size_t write(uint8_t) override { return 1; }
+  void begin(unsigned long, uint32_t = SERIAL_8N1, int8_t = -1, int8_t = -1) {}
+  void end() {}
+};
+
+inline HardwareSerial Serial;
+
+// ============================================================================
+// ESP / FREERTOS
+// ============================================================================
+
+class IPAddress {
+public:
+  IPAddress() : _b{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _b{a, b, c, d} {}
+  uint8_t operator[](int i) const { return _b[i]; }
+  bool operator==(const IPAddress& o) const { return memcmp(_b, o._b, 4) == 0; }
+  bool operator!=(const IPAddress& o) const { return !(*this == o); }
+
+private:
+  uint8_t _b[4];
+};
+
+struct EspClass {
+  uint32_t getCycleCount() { return (uint32_t)(Native::clockUs() * 240); }
+};
+
+inline EspClass ESP;
+
+typedef void* TaskHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef void (*TaskFunction_t)(void*);
+#define pdPASS 1
+#define tskIDLE_PRIORITY 0
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+namespace Native {
+inline TaskHandle_t& currentTask() { static TaskHandle_t t = (TaskHandle_t)1; return t; }
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return Native::currentTask(); }
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char*, uint32_t, void*, int,
+                                          TaskHandle_t*, int) { return pdPASS; }
+inline void vTaskDelay(TickType_t ticks) { Native::advanceMs(ticks); }
+inline TickType_t xTaskGetTickCount() { return (TickType_t)millis(); }
+inline void vTaskDelayUntil(TickType_t* wake, TickType_t ticks) {
+  *wake += ticks;
+  if ((int32_t)(*wake - xTaskGetTickCount()) > 0) vTaskDelay(*wake - xTaskGetTickCount());
+}
+
+#endif // NATIVE_ARDUINO_H
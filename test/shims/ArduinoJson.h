@@ -0,0 +1,16 @@
+/**
+ * @file ArduinoJson.h
+ * @brief Host stand-in for the ArduinoJson types Config_Schema.h names
+ *
+ * @details
+ * Just enough for the schema declarations to compile (tests use cfgSet());
+ * no test builds JSON documents.
+ */
+
+#ifndef NATIVE_ARDUINOJSON_H
+#define NATIVE_ARDUINOJSON_H
+
+struct JsonObject {};
+struct JsonObjectConst {};
+
+#endif // NATIVE_ARDUINOJSON_H
@@ -0,0 +1,64 @@
+/**
+ * @file AsyncUDP.h
+ * @brief Host stand-in for AsyncUDP: tests deliver packets by hand
+ *
+ * @details
+ * AsyncUDP::deliver() hands a packet to the onPacket() callback of the
+ * last socket that listened, as the AsyncUDP task would. Replies written
+ * to the packet are kept in AsyncUDPPacket::reply.
+ */
+
+#ifndef NATIVE_ASYNC_UDP_H
+#define NATIVE_ASYNC_UDP_H
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+
+class AsyncUDPPacket {
+public:
+  AsyncUDPPacket(const uint8_t* data, size_t len, const IPAddress& local)
+    : _data(data, data + len), _local(local) {}
+
+  const uint8_t* data() { return _data.data(); }
+  size_t length() { return _data.size(); }
+  IPAddress localIP() { return _local; }
+  size_t write(const uint8_t* buf, size_t n) {
+    reply.assign(buf, buf + n);
+    replies++;
+    return n;
+  }
+
+  std::vector<uint8_t> reply;
+  uint32_t replies = 0;
+
+private:
+  std::vector<uint8_t> _data;
+  IPAddress _local;
+};
+
+class AsyncUDP {
+public:
+  typedef std::function<void(AsyncUDPPacket&)> PacketHandler;
+
+  bool listen(uint16_t) {
+    listener() = this;
+    return true;
+  }
+  void onPacket(PacketHandler handler) { _handler = handler; }
+  void close() {
+    if (listener() == this) listener() = nullptr;
+  }
+
+  static bool deliver(AsyncUDPPacket& packet) {
+    if (!listener() || !listener()->_handler) return false;
+    listener()->_handler(packet);
+    return true;
+  }
+
+private:
+  static AsyncUDP*& listener() { static AsyncUDP* l = nullptr; return l; }
+  PacketHandler _handler;
+};
+
+#endif // NATIVE_ASYNC_UDP_H
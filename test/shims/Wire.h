@@ -0,0 +1,22 @@
+/**
+ * @file Wire.h
+ * @brief Host stand-in for the I2C driver (declarations only; no bus)
+ */
+
+#ifndef NATIVE_WIRE_H
+#define NATIVE_WIRE_H
+
+#include <Arduino.h>
+
+class TwoWire {
+public:
+  void beginTransmission(uint8_t) {}
+  size_t write(uint8_t) { return 1; }
+  uint8_t endTransmission(bool = true) { return 2; }    // NACK: no device
+  uint8_t requestFrom(uint8_t, uint8_t) { return 0; }
+  int read() { return -1; }
+};
+
+inline TwoWire Wire;
+
+#endif // NATIVE_WIRE_H
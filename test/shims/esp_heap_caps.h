@@ -0,0 +1,40 @@
+/**
+ * @file esp_heap_caps.h
+ * @brief Host stand-in for the heap statistics, driven by the test
+ *
+ * @details
+ * The test plays the allocator: Native::heapTake() / heapGive() move the
+ * free size, heap_caps_* report it.
+ */
+
+#ifndef NATIVE_ESP_HEAP_CAPS_H
+#define NATIVE_ESP_HEAP_CAPS_H
+
+#include <Arduino.h>
+
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+namespace Native {
+struct Heap {
+  size_t free = 200000;
+  size_t minFree = 200000;
+  size_t largest = 110000;
+  uint32_t freeQueries = 0;
+};
+inline Heap& heap() { static Heap h; return h; }
+inline void heapTake(size_t n) {
+  heap().free -= n;
+  if (heap().free < heap().minFree) heap().minFree = heap().free;
+}
+inline void heapGive(size_t n) { heap().free += n; }
+}
+
+inline size_t heap_caps_get_free_size(uint32_t) {
+  Native::heap().freeQueries++;
+  return Native::heap().free;
+}
+inline size_t heap_caps_get_largest_free_block(uint32_t) { return Native::heap().largest; }
+inline size_t heap_caps_get_minimum_free_size(uint32_t) { return Native::heap().minFree; }
+
+#endif // NATIVE_ESP_HEAP_CAPS_H
@@ -0,0 +1,62 @@
+/**
+ * @file esp_partition.h
+ * @brief Host stand-in for a raw flash partition, backed by RAM
+ *
+ * @details
+ * One "history" data partition of Native::PARTITION_BYTES. Writes AND the
+ * data into the array like NOR flash (bits only go from 1 to 0), erase
+ * sets whole 4 KB sectors back to 0xFF.
+ */
+
+#ifndef NATIVE_ESP_PARTITION_H
+#define NATIVE_ESP_PARTITION_H
+
+#include <esp_system.h>
+
+typedef enum { ESP_PARTITION_TYPE_APP = 0x00, ESP_PARTITION_TYPE_DATA = 0x01 } esp_partition_type_t;
+typedef enum { ESP_PARTITION_SUBTYPE_ANY = 0xff } esp_partition_subtype_t;
+
+typedef struct {
+  esp_partition_type_t type;
+  esp_partition_subtype_t subtype;
+  uint32_t address;
+  uint32_t size;
+  char label[17];
+  bool encrypted;
+} esp_partition_t;
+
+namespace Native {
+static const uint32_t PARTITION_BYTES = 0x80000;
+inline uint8_t* flash() { static uint8_t f[PARTITION_BYTES]; return f; }
+inline void eraseFlash() { memset(flash(), 0xFF, PARTITION_BYTES); }
+inline const esp_partition_t* partition() {
+  static const esp_partition_t p = { ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                     0x370000, PARTITION_BYTES, "history", false };
+  return &p;
+}
+}
+
+inline const esp_partition_t* esp_partition_find_first(esp_partition_type_t, esp_partition_subtype_t,
+                                                       const char* label) {
+  return strcmp(label, "history") == 0 ? Native::partition() : nullptr;
+}
+
+inline esp_err_t esp_partition_read(const esp_partition_t* p, size_t offset, void* dst, size_t n) {
+  if (offset + n > p->size) return ESP_FAIL;
+  memcpy(dst, Native::flash() + offset, n);
+  return ESP_OK;
+}
+
+inline esp_err_t esp_partition_write(const esp_partition_t* p, size_t offset, const void* src, size_t n) {
+  if (offset + n > p->size) return ESP_FAIL;
+  for (size_t i = 0; i < n; i++) Native::flash()[offset + i] &= ((const uint8_t*)src)[i];
+  return ESP_OK;
+}
+
+inline esp_err_t esp_partition_erase_range(const esp_partition_t* p, size_t offset, size_t n) {
+  if (offset % 4096 || n % 4096 || offset + n > p->size) return ESP_FAIL;
+  memset(Native::flash() + offset, 0xFF, n);
+  return ESP_OK;
+}
+
+#endif // NATIVE_ESP_PARTITION_H
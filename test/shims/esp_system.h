@@ -0,0 +1,38 @@
+/**
+ * @file esp_system.h
+ * @brief Host stand-in for reset reason and shutdown handlers
+ */
+
+#ifndef NATIVE_ESP_SYSTEM_H
+#define NATIVE_ESP_SYSTEM_H
+
+#include <Arduino.h>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+typedef enum {
+  ESP_RST_UNKNOWN,
+  ESP_RST_POWERON,
+  ESP_RST_EXT,
+  ESP_RST_SW,
+  ESP_RST_PANIC,
+  ESP_RST_INT_WDT,
+  ESP_RST_TASK_WDT,
+  ESP_RST_WDT,
+  ESP_RST_DEEPSLEEP,
+  ESP_RST_BROWNOUT,
+  ESP_RST_SDIO
+} esp_reset_reason_t;
+
+typedef void (*shutdown_handler_t)(void);
+
+namespace Native {
+inline esp_reset_reason_t& resetReason() { static esp_reset_reason_t r = ESP_RST_POWERON; return r; }
+}
+
+inline esp_reset_reason_t esp_reset_reason() { return Native::resetReason(); }
+inline esp_err_t esp_register_shutdown_handler(shutdown_handler_t) { return ESP_OK; }
+
+#endif // NATIVE_ESP_SYSTEM_H
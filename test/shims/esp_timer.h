@@ -0,0 +1,13 @@
+/**
+ * @file esp_timer.h
+ * @brief Host stand-in: esp_timer_get_time() reads the simulated clock
+ */
+
+#ifndef NATIVE_ESP_TIMER_H
+#define NATIVE_ESP_TIMER_H
+
+#include <Arduino.h>
+
+inline int64_t esp_timer_get_time() { return (int64_t)Native::clockUs(); }
+
+#endif // NATIVE_ESP_TIMER_H
@@ -0,0 +1,215 @@
+/**
+ * @file test_alert_engine.cpp
+ * @brief Alert_Engine: compiled table against the linear baseline
+ *
+ * @details
+ * The rule set and the random walk are the ones /api/alerts/benchmark
+ * replays (default 100 rules, 2000 samples). The table may only skip rules
+ * whose state cannot change, so both evaluations must reach the same
+ * state for every rule after every sample.
+ */
+
+#include <unity.h>
+#include "Alert_Engine.h"
+
+static const uint8_t RULES = 100;
+static const uint32_t SAMPLES = 2000;
+static const uint32_t PERIOD_MS = 1000;          // SENSOR_PERIOD_MS in main.cpp
+
+void setUp() {}
+void tearDown() {}
+
+static void addBenchmarkRules(Alert_Engine& e) {
+  static const float BASE[SENSOR_CHANNELS][ALERT_SIGNALS] = {
+    { 18, -2, 30 }, { 30, -5, 30 }, { 0, -200, 30 }
+  };
+  static const float SPAN[SENSOR_CHANNELS][ALERT_SIGNALS] = {
+    { 14, 4, 600 }, { 60, 10, 600 }, { 2000, 400, 600 }
+  };
+  for (uint8_t i = 0; i < RULES; i++) {
+    uint8_t ch = i % SENSOR_CHANNELS;
+    uint8_t sig = (i / SENSOR_CHANNELS) % ALERT_SIGNALS;
+    float level = BASE[ch][sig] + SPAN[ch][sig] * ((i * 37) % 100) / 100.0f;
+    bool above = sig == ALERT_STUCK || (i & 1);
+    e.addRule(ch, sig, above, level, SPAN[ch][sig] / 100, (i % 3 == 0) ? 30000 : 0, 0);
+  }
+  e.setLogging(false);
+  e.build();
+}
+
+/**
+ * @brief Random walk of the benchmark (xorshift32, fixed seed)
+ */
+struct Walk {
+  uint32_t rng = 0x2545F491;
+  Sensor_Sample s = { 0, 0, SENSOR_BIT(SENSOR_TEMPERATURE) | SENSOR_BIT(SENSOR_HUMIDITY) | SENSOR_BIT(SENSOR_LIGHT),
+                      { 25, 60, 500 } };
+
+  const Sensor_Sample& next(uint32_t n) {
+    rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+    s.seq = n + 1;
+    s.ms = n * PERIOD_MS;
+    s.value[SENSOR_TEMPERATURE] = constrain(s.value[SENSOR_TEMPERATURE] + ((int)(rng % 41) - 20) / 100.0f, 18.0f, 32.0f);
+    s.value[SENSOR_HUMIDITY] = constrain(s.value[SENSOR_HUMIDITY] + ((int)((rng >> 8) % 61) - 30) / 100.0f, 30.0f, 90.0f);
+    if ((rng >> 20) % 4) {
+      s.value[SENSOR_LIGHT] = constrain(s.value[SENSOR_LIGHT] + ((int)((rng >> 16) % 401) - 200) / 10.0f, 0.0f, 2000.0f);
+    }
+    return s;
+  }
+};
+
+static uint32_t activeCount(const Alert_Engine& e) {
+  uint32_t n = 0;
+  for (uint8_t i = 0; i < e.ruleCount(); i++) n += e.rule(i).state == Alert_Engine::STATE_ACTIVE;
+  return n;
+}
+
+/**
+ * @brief One benchmark pass: rebuild, replay the walk
+ */
+static void replay(Alert_Engine& e, bool linear) {
+  e.setLinear(linear);
+  e.build();
+  e.resetStats();
+  Walk w;
+  for (uint32_t n = 0; n < SAMPLES; n++) e.evaluate(w.next(n));
+}
+
+void test_table_matches_linear_after_every_sample() {
+  Alert_Engine* table = new Alert_Engine();
+  Alert_Engine* linear = new Alert_Engine();
+  addBenchmarkRules(*table);
+  addBenchmarkRules(*linear);
+  linear->setLinear(true);
+
+  Walk w;
+  for (uint32_t n = 0; n < SAMPLES; n++) {
+    const Sensor_Sample& s = w.next(n);
+    table->evaluate(s);
+    linear->evaluate(s);
+    for (uint8_t i = 0; i < RULES; i++) {
+      if (table->rule(i).state == linear->rule(i).state) continue;
+      char msg[48];
+      snprintf(msg, sizeof(msg), "rule %u at sample %u", i + 1, (unsigned)n);
+      TEST_ASSERT_EQUAL_UINT32_MESSAGE(linear->rule(i).state, table->rule(i).state, msg);
+    }
+  }
+  TEST_ASSERT_TRUE(table->events() > 0);
+  TEST_ASSERT_EQUAL_UINT32(linear->events(), table->events());
+  for (uint8_t i = 0; i < RULES; i++) TEST_ASSERT_EQUAL_UINT32(linear->rule(i).raised, table->rule(i).raised);
+  // The table visits far fewer rules than the baseline
+  TEST_ASSERT_TRUE(table->avgVisited() * 4 < linear->avgVisited());
+  delete table;
+  delete linear;
+}
+
+void test_rebuild_restarts_every_rule() {
+  // The benchmark reuses one engine: each pass must start from IDLE
+  Alert_Engine* e = new Alert_Engine();
+  addBenchmarkRules(*e);
+  uint32_t events[3], active[3];
+  for (uint8_t pass = 0; pass < 3; pass++) {
+    replay(*e, pass == 1);
+    events[pass] = e->events();
+    active[pass] = activeCount(*e);
+  }
+  TEST_ASSERT_TRUE(active[0] > 0);
+  TEST_ASSERT_EQUAL_UINT32(events[0], events[1]);
+  TEST_ASSERT_EQUAL_UINT32(events[0], events[2]);
+  TEST_ASSERT_EQUAL_UINT32(active[0], active[1]);
+  TEST_ASSERT_EQUAL_UINT32(active[0], active[2]);
+
+  e->build();
+  for (uint8_t i = 0; i < RULES; i++) {
+    TEST_ASSERT_EQUAL(Alert_Engine::STATE_IDLE, e->rule(i).state);
+    TEST_ASSERT_EQUAL_UINT32(0, e->rule(i).notifiedMs);
+  }
+  delete e;
+}
+
+void test_duration_and_hysteresis() {
+  Alert_Engine* e = new Alert_Engine();
+  char err[48];
+  TEST_ASSERT_TRUE(e->compile("temperature > 30 hyst 0.5 for 60 sms", err, sizeof(err)));
+  e->setLogging(false);
+
+  Sensor_Sample s = { 0, 0, SENSOR_BIT(SENSOR_TEMPERATURE), { 29, 0, 0 } };
+  auto at = [&](uint32_t sec, float t) {
+    s.seq++;
+    s.ms = sec * 1000;
+    s.value[SENSOR_TEMPERATURE] = t;
+    e->evaluate(s);
+    return e->rule(0).state;
+  };
+
+  TEST_ASSERT_EQUAL(Alert_Engine::STATE_IDLE, at(0, 29));
+  TEST_ASSERT_EQUAL(Alert_Engine::STATE_PENDING, at(10, 31));
+  TEST_ASSERT_EQUAL(Alert_Engine::STATE_PENDING, at(69, 31));
+  TEST_ASSERT_EQUAL(Alert_Engine::STATE_ACTIVE, at(70, 31));
+  TEST_ASSERT_EQUAL(Alert_Engine::STATE_ACTIVE, at(80, 29.6f));   // Inside the hysteresis
+  TEST_ASSERT_EQUAL(Alert_Engine::STATE_IDLE, at(90, 29.4f));
+
+  Alert_Engine::Event ev;
+  TEST_ASSERT_TRUE(e->pop(ev));
+  TEST_ASSERT_TRUE(ev.raised);
+  TEST_ASSERT_EQUAL_UINT32(70000, ev.ms);
+  TEST_ASSERT_TRUE(e->pop(ev));
+  TEST_ASSERT_FALSE(ev.raised);
+  TEST_ASSERT_FALSE(e->pop(ev));
+  delete e;
+}
+
+void test_recompile_keeps_the_cooldown() {
+  Alert_Engine* e = new Alert_Engine();
+  char err[48];
+  const char* RULES_TEXT = "temperature > 30 sms; humidity > 80 email";
+  TEST_ASSERT_TRUE(e->compile(RULES_TEXT, err, sizeof(err)));
+  e->setCooldown(600000);
+  e->setLogging(false);
+
+  Sensor_Sample s = { 0, 0, SENSOR_BIT(SENSOR_TEMPERATURE) | SENSOR_BIT(SENSOR_HUMIDITY), { 25, 50, 0 } };
+  auto at = [&](uint32_t sec, float t, float h) {
+    s.seq++;
+    s.ms = sec * 1000;
+    s.value[SENSOR_TEMPERATURE] = t;
+    s.value[SENSOR_HUMIDITY] = h;
+    e->evaluate(s);
+  };
+  Alert_Engine::Event ev;
+
+  at(10, 25, 50);
+  at(20, 31, 50);
+  TEST_ASSERT_TRUE(e->pop(ev));
+  TEST_ASSERT_EQUAL(0, ev.rule);
+  TEST_ASSERT_FALSE(e->pop(ev));
+
+  // Saving the same rule (and adding one) restarts it, but it stays quiet
+  TEST_ASSERT_TRUE(e->compile("humidity > 80 email; temperature > 30 sms; light > 100 sms", err, sizeof(err)));
+  TEST_ASSERT_EQUAL_UINT32(20000, e->rule(1).notifiedMs);
+  TEST_ASSERT_EQUAL_UINT32(0, e->rule(0).notifiedMs);
+  at(30, 31, 50);
+  TEST_ASSERT_EQUAL(Alert_Engine::STATE_ACTIVE, e->rule(1).state);
+  TEST_ASSERT_FALSE(e->pop(ev));
+  TEST_ASSERT_EQUAL_UINT32(1, e->suppressed());
+
+  // A changed rule is a new rule
+  TEST_ASSERT_TRUE(e->compile("temperature > 30.5 sms", err, sizeof(err)));
+  at(40, 31, 50);
+  TEST_ASSERT_TRUE(e->pop(ev));
+  TEST_ASSERT_TRUE(ev.raised);
+
+  // Once the cooldown has passed, a re-raise is notified again
+  TEST_ASSERT_TRUE(e->compile("temperature > 30.5 sms", err, sizeof(err)));
+  at(700, 31, 50);
+  TEST_ASSERT_TRUE(e->pop(ev));
+  delete e;
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_table_matches_linear_after_every_sample);
+  RUN_TEST(test_rebuild_restarts_every_rule);
+  RUN_TEST(test_duration_and_hysteresis);
+  RUN_TEST(test_recompile_keeps_the_cooldown);
+  return UNITY_END();
+}
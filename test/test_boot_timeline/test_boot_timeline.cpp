@@ -0,0 +1,177 @@
+/**
+ * @file test_boot_timeline.cpp
+ * @brief Boot_Timeline phase ordering, warm-reset carry-over and budget arithmetic
+ *
+ * @details
+ * The timeline lives in RTC_NOINIT statics, which on the host are plain
+ * zero-initialised globals that persist between tests. Each test starts
+ * with begin() like a (warm) boot; the first test is the power-on boot.
+ *
+ * Phase times here are synthetic (Native::advanceUs()), so these tests
+ * check the timeline's arithmetic, not how long setup() really takes. The
+ * boot budget itself is only checked on the device (overBudget in
+ * /api/boot/timeline and the warning logged at the end of setup()).
+ */
+
+#include <unity.h>
+#include <esp_system.h>
+#include "Boot_Timeline.h"
+
+static const uint32_t BUDGET_MS = 8000;
+
+static Boot_Timeline timeline;
+
+void setUp() {
+  Native::setUs(5000);                   // Application start to setup()
+}
+
+void tearDown() {
+}
+
+/**
+ * @brief Mark every setup() phase in order, stepUs apart
+ */
+static void bootThroughSetup(uint32_t stepUs) {
+  for (int i = 0; i <= Boot_Timeline::PHASE_READY; i++) {
+    Native::advanceUs(stepUs);
+    timeline.mark((Boot_Timeline::Phase)i);
+  }
+}
+
+void test_power_on_has_no_previous_timeline() {
+  Native::resetReason() = ESP_RST_POWERON;
+  timeline.begin();
+  TEST_ASSERT_NULL(timeline.previous());
+  TEST_ASSERT_EQUAL_UINT32(1, timeline.current().bootCount);
+  TEST_ASSERT_EQUAL_STRING("power_on", Boot_Timeline::resetReasonName(timeline.current().resetReason));
+  TEST_ASSERT_EQUAL_UINT32(5000, timeline.current().startUs);
+}
+
+void test_phases_are_recorded_in_order() {
+  timeline.begin();
+  bootThroughSetup(100000);
+  const Boot_Timeline::Record& r = timeline.current();
+  uint32_t last = r.startUs;
+  for (int i = 0; i <= Boot_Timeline::PHASE_READY; i++) {
+    TEST_ASSERT_GREATER_THAN(last, r.us[i]);
+    TEST_ASSERT_EQUAL_UINT32(100000, Boot_Timeline::deltaUs(r, (Boot_Timeline::Phase)i));
+    last = r.us[i];
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, r.us[Boot_Timeline::PHASE_STA_CONNECTED]);
+  TEST_ASSERT_EQUAL_UINT32(0, Boot_Timeline::deltaUs(r, Boot_Timeline::PHASE_STA_CONNECTED));
+}
+
+void test_first_mark_wins() {
+  timeline.begin();
+  Native::advanceUs(1000);
+  timeline.mark(Boot_Timeline::PHASE_FS);
+  uint32_t first = timeline.current().us[Boot_Timeline::PHASE_FS];
+  Native::advanceUs(1000);
+  timeline.mark(Boot_Timeline::PHASE_FS);
+  TEST_ASSERT_EQUAL_UINT32(first, timeline.current().us[Boot_Timeline::PHASE_FS]);
+  timeline.mark(Boot_Timeline::PHASE_COUNT);   // Ignored, no out-of-bounds write
+}
+
+void test_skipped_phase_is_measured_from_the_previous_reached_one() {
+  timeline.begin();
+  Native::advanceUs(1000);
+  timeline.mark(Boot_Timeline::PHASE_SERIAL);
+  Native::advanceUs(2000);
+  timeline.mark(Boot_Timeline::PHASE_FS);      // PHASE_DRD skipped
+  Native::advanceUs(3000);
+  timeline.mark(Boot_Timeline::PHASE_AP);      // PHASE_CONFIG skipped
+  const Boot_Timeline::Record& r = timeline.current();
+  TEST_ASSERT_EQUAL_UINT32(1000, Boot_Timeline::deltaUs(r, Boot_Timeline::PHASE_SERIAL));
+  TEST_ASSERT_EQUAL_UINT32(2000, Boot_Timeline::deltaUs(r, Boot_Timeline::PHASE_FS));
+  TEST_ASSERT_EQUAL_UINT32(3000, Boot_Timeline::deltaUs(r, Boot_Timeline::PHASE_AP));
+}
+
+void test_after_setup_phases_are_measured_from_ready() {
+  timeline.begin();
+  bootThroughSetup(10000);
+  Native::advanceUs(900000);
+  timeline.mark(Boot_Timeline::PHASE_MODEM_READY);   // Modem answers first
+  Native::advanceUs(2000000);
+  timeline.mark(Boot_Timeline::PHASE_STA_CONNECTED);
+  const Boot_Timeline::Record& r = timeline.current();
+  TEST_ASSERT_EQUAL_UINT32(2900000, Boot_Timeline::deltaUs(r, Boot_Timeline::PHASE_STA_CONNECTED));
+  TEST_ASSERT_EQUAL_UINT32(900000, Boot_Timeline::deltaUs(r, Boot_Timeline::PHASE_MODEM_READY));
+}
+
+void test_warm_reset_keeps_the_previous_timeline() {
+  timeline.begin();
+  uint32_t boots = timeline.current().bootCount;
+  bootThroughSetup(50000);
+  Boot_Timeline::Record before = timeline.current();
+
+  // Watchdog reset: the new boot archives the old timeline
+  Native::resetReason() = ESP_RST_TASK_WDT;
+  Native::setUs(4000);
+  timeline.begin();
+  const Boot_Timeline::Record* prev = timeline.previous();
+  TEST_ASSERT_NOT_NULL(prev);
+  TEST_ASSERT_EQUAL_MEMORY(&before, prev, sizeof(before));
+  TEST_ASSERT_EQUAL_UINT32(boots + 1, timeline.current().bootCount);
+  TEST_ASSERT_EQUAL_STRING("task_wdt", Boot_Timeline::resetReasonName(timeline.current().resetReason));
+  TEST_ASSERT_EQUAL_UINT32(0, timeline.current().us[Boot_Timeline::PHASE_READY]);
+}
+
+void test_corrupt_rtc_memory_is_treated_as_power_on() {
+  timeline.begin();
+  bootThroughSetup(1000);
+  // Power loss leaves random RTC content: the checksum no longer matches
+  const_cast<Boot_Timeline::Record&>(timeline.current()).us[Boot_Timeline::PHASE_FS] ^= 0x5A5A;
+  timeline.begin();
+  TEST_ASSERT_NULL(timeline.previous());
+  TEST_ASSERT_EQUAL_UINT32(1, timeline.current().bootCount);
+}
+
+void test_over_budget_arithmetic() {
+  timeline.begin();
+  TEST_ASSERT_FALSE(Boot_Timeline::overBudget(timeline.current(), BUDGET_MS));   // Not ready yet
+
+  // 9 phases up to ready, from 5 ms: ready at 5 ms + 9 * step
+  bootThroughSetup(888000);                                   // 7.997 s
+  TEST_ASSERT_EQUAL_UINT32(7997, Boot_Timeline::readyMs(timeline.current()));
+  TEST_ASSERT_FALSE(Boot_Timeline::overBudget(timeline.current(), BUDGET_MS));
+
+  Native::setUs(5000);
+  timeline.begin();
+  bootThroughSetup(888334);                                   // 8.000 s
+  TEST_ASSERT_EQUAL_UINT32(8000, Boot_Timeline::readyMs(timeline.current()));
+  TEST_ASSERT_FALSE(Boot_Timeline::overBudget(timeline.current(), BUDGET_MS));
+
+  Native::setUs(5000);
+  timeline.begin();
+  bootThroughSetup(889000);                                   // 8.006 s
+  TEST_ASSERT_TRUE(Boot_Timeline::overBudget(timeline.current(), BUDGET_MS));
+  // The verdict travels with the archived timeline
+  Native::setUs(5000);
+  timeline.begin();
+  TEST_ASSERT_TRUE(Boot_Timeline::overBudget(*timeline.previous(), BUDGET_MS));
+  TEST_ASSERT_FALSE(Boot_Timeline::overBudget(timeline.current(), BUDGET_MS));
+}
+
+void test_phase_names_are_unique() {
+  for (int i = 0; i < Boot_Timeline::PHASE_COUNT; i++) {
+    TEST_ASSERT_TRUE(strcmp("unknown", Boot_Timeline::phaseName((Boot_Timeline::Phase)i)) != 0);
+    for (int j = 0; j < i; j++) {
+      TEST_ASSERT_TRUE(strcmp(Boot_Timeline::phaseName((Boot_Timeline::Phase)i),
+                              Boot_Timeline::phaseName((Boot_Timeline::Phase)j)) != 0);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_power_on_has_no_previous_timeline);   // Must run first
+  RUN_TEST(test_phases_are_recorded_in_order);
+  RUN_TEST(test_first_mark_wins);
+  RUN_TEST(test_skipped_phase_is_measured_from_the_previous_reached_one);
+  RUN_TEST(test_after_setup_phases_are_measured_from_ready);
+  RUN_TEST(test_warm_reset_keeps_the_previous_timeline);
+  RUN_TEST(test_corrupt_rtc_memory_is_treated_as_power_on);
+  RUN_TEST(test_over_budget_arithmetic);
+  RUN_TEST(test_phase_names_are_unique);
+  return UNITY_END();
+}
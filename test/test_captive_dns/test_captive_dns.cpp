@@ -0,0 +1,319 @@
+/**
+ * @file test_captive_dns.cpp
+ * @brief Captive_DNS query parsing and reply building, malformed input
+ *
+ * @details
+ * Packets are handed to the responder through the AsyncUDP shim, as the
+ * AsyncUDP task would, and the reply written back is decoded here. The
+ * load test replays the burst a phone sends when it joins the portal,
+ * checks every reply and reports queries per second and handling time
+ * percentiles on the host (informational, no timing assertion).
+ */
+
+#include <unity.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "Captive_DNS.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+static const IPAddress AP_IP(192, 168, 4, 1);
+static const IPAddress STA_IP(10, 0, 0, 23);
+static const uint16_t TYPE_A = 1;
+static const uint16_t TYPE_AAAA = 28;
+static const uint16_t TYPE_HTTPS = 65;
+
+static Captive_DNS* dns;
+
+void setUp() {
+  dns = new Captive_DNS();
+  TEST_ASSERT_TRUE(dns->start(53, AP_IP));
+}
+
+void tearDown() {
+  dns->stop();
+  delete dns;
+}
+
+static void put16(Bytes& b, uint16_t v) {
+  b.push_back(v >> 8);
+  b.push_back(v & 0xFF);
+}
+
+static uint16_t get16(const Bytes& b, size_t at) {
+  return (b[at] << 8) | b[at + 1];
+}
+
+/**
+ * @brief Standard query for one name (dotted), RD set
+ */
+static Bytes query(const char* name, uint16_t type, uint16_t id = 0x1234) {
+  Bytes b;
+  put16(b, id);
+  put16(b, 0x0100);          // RD
+  put16(b, 1);               // QDCOUNT
+  put16(b, 0);
+  put16(b, 0);
+  put16(b, 0);
+  const char* p = name;
+  while (*p) {
+    const char* dot = strchr(p, '.');
+    size_t n = dot ? (size_t)(dot - p) : strlen(p);
+    b.push_back(n);
+    b.insert(b.end(), p, p + n);
+    p += n + (dot ? 1 : 0);
+  }
+  b.push_back(0);
+  put16(b, type);
+  put16(b, 1);               // IN
+  return b;
+}
+
+/**
+ * @brief Deliver a packet; return the reply (empty if none was sent)
+ */
+static Bytes send(const Bytes& packet, const IPAddress& local = AP_IP) {
+  AsyncUDPPacket p(packet.data(), packet.size(), local);
+  TEST_ASSERT_TRUE(AsyncUDP::deliver(p));
+  TEST_ASSERT_TRUE(p.replies <= 1);
+  return p.reply;
+}
+
+static void assertDropped(const Bytes& packet, const IPAddress& local = AP_IP) {
+  uint32_t dropped = dns->dropped();
+  TEST_ASSERT_EQUAL_UINT32(0, send(packet, local).size());
+  TEST_ASSERT_EQUAL_UINT32(dropped + 1, dns->dropped());
+}
+
+// ============================================================================
+// REPLIES
+// ============================================================================
+
+void test_a_query_gets_the_portal_address() {
+  Bytes q = query("connectivitycheck.gstatic.com", TYPE_A, 0xBEEF);
+  Bytes r = send(q);
+  TEST_ASSERT_EQUAL_UINT32(q.size() + 16, r.size());
+
+  TEST_ASSERT_EQUAL_HEX16(0xBEEF, get16(r, 0));          // ID echoed
+  TEST_ASSERT_EQUAL_HEX8(0x85, r[2]);                     // QR, AA, RD kept
+  TEST_ASSERT_EQUAL_HEX8(0x00, r[3]);                     // NOERROR
+  TEST_ASSERT_EQUAL_UINT16(1, get16(r, 4));               // QDCOUNT
+  TEST_ASSERT_EQUAL_UINT16(1, get16(r, 6));               // ANCOUNT
+  TEST_ASSERT_EQUAL_UINT16(0, get16(r, 8));
+  TEST_ASSERT_EQUAL_UINT16(0, get16(r, 10));
+  TEST_ASSERT_EQUAL_MEMORY(q.data() + 12, r.data() + 12, q.size() - 12);   // Question
+
+  size_t a = q.size();
+  TEST_ASSERT_EQUAL_HEX16(0xC00C, get16(r, a));           // Name: pointer to the question
+  TEST_ASSERT_EQUAL_UINT16(TYPE_A, get16(r, a + 2));
+  TEST_ASSERT_EQUAL_UINT16(1, get16(r, a + 4));           // IN
+  TEST_ASSERT_EQUAL_UINT32(Captive_DNS::ANSWER_TTL, ((uint32_t)get16(r, a + 6) << 16) | get16(r, a + 8));
+  TEST_ASSERT_EQUAL_UINT16(4, get16(r, a + 10));
+  const uint8_t ip[4] = { 192, 168, 4, 1 };
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(ip, r.data() + a + 12, 4);
+  TEST_ASSERT_EQUAL_UINT32(1, dns->answeredA());
+}
+
+void test_rd_clear_stays_clear() {
+  Bytes q = query("example.com", TYPE_A);
+  q[2] = 0x00;
+  TEST_ASSERT_EQUAL_HEX8(0x84, send(q)[2]);
+}
+
+void test_other_types_get_nodata() {
+  static const uint16_t TYPES[] = { TYPE_AAAA, TYPE_HTTPS, 64 /* SVCB */, 16 /* TXT */ };
+  for (uint16_t type : TYPES) {
+    Bytes q = query("captive.apple.com", type);
+    Bytes r = send(q);
+    TEST_ASSERT_EQUAL_UINT32(q.size(), r.size());         // Question only
+    TEST_ASSERT_EQUAL_HEX8(0x85, r[2]);
+    TEST_ASSERT_EQUAL_HEX8(0x00, r[3]);                   // NOERROR, not NXDOMAIN
+    TEST_ASSERT_EQUAL_UINT16(0, get16(r, 6));
+  }
+  TEST_ASSERT_EQUAL_UINT32(4, dns->answeredEmpty());
+  TEST_ASSERT_EQUAL_UINT32(0, dns->answeredA());
+}
+
+void test_edns_opt_record_is_dropped_from_the_reply() {
+  Bytes q = query("msftconnecttest.com", TYPE_A);
+  size_t questionEnd = q.size();
+  q[11] = 1;                                             // ARCOUNT
+  const uint8_t opt[] = { 0x00, 0x00, 0x29, 0x04, 0xD0, 0, 0, 0, 0, 0x00, 0x00 };
+  q.insert(q.end(), opt, opt + sizeof(opt));
+  Bytes r = send(q);
+  TEST_ASSERT_EQUAL_UINT32(questionEnd + 16, r.size());
+  TEST_ASSERT_EQUAL_UINT16(0, get16(r, 10));
+  TEST_ASSERT_EQUAL_HEX16(0xC00C, get16(r, questionEnd));
+}
+
+void test_root_name_is_answered() {
+  Bytes q = query("", TYPE_A);
+  TEST_ASSERT_EQUAL_UINT32(12 + 5, q.size());            // Smallest valid query
+  TEST_ASSERT_EQUAL_UINT32(q.size() + 16, send(q).size());
+}
+
+void test_longest_packet_is_answered() {
+  // 63-byte labels, then one that brings the packet to MAX_PACKET
+  Bytes q = query("a", TYPE_A);
+  q.resize(12);
+  while (q.size() + 64 + 5 <= Captive_DNS::MAX_PACKET) {
+    q.push_back(63);
+    q.insert(q.end(), 63, 'x');
+  }
+  size_t n = Captive_DNS::MAX_PACKET - q.size() - 1 - 5;   // Length byte, root, type, class
+  q.push_back(n);
+  q.insert(q.end(), n, 'y');
+  q.push_back(0);
+  put16(q, TYPE_A);
+  put16(q, 1);
+  TEST_ASSERT_EQUAL_UINT32(Captive_DNS::MAX_PACKET, q.size());
+  TEST_ASSERT_EQUAL_UINT32(Captive_DNS::MAX_PACKET + 16, send(q).size());
+}
+
+void test_set_ip_changes_the_answer() {
+  dns->setIP(IPAddress(10, 1, 2, 3));
+  Bytes q = query("example.com", TYPE_A);
+  Bytes r = send(q, IPAddress(10, 1, 2, 3));
+  const uint8_t ip[4] = { 10, 1, 2, 3 };
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(ip, r.data() + q.size() + 12, 4);
+}
+
+// ============================================================================
+// DROPPED PACKETS
+// ============================================================================
+
+void test_queries_from_the_sta_side_are_ignored() {
+  assertDropped(query("example.com", TYPE_A), STA_IP);
+}
+
+void test_responses_and_other_opcodes_are_dropped() {
+  Bytes q = query("example.com", TYPE_A);
+  q[2] |= 0x80;                                          // QR: a response
+  assertDropped(q);
+  q = query("example.com", TYPE_A);
+  q[2] |= 0x28;                                          // OPCODE 5 (UPDATE)
+  assertDropped(q);
+}
+
+void test_question_count_must_be_one() {
+  Bytes q = query("example.com", TYPE_A);
+  q[5] = 0;
+  assertDropped(q);
+  q[5] = 2;
+  assertDropped(q);
+  q[5] = 1;
+  q[4] = 1;                                              // 257 questions
+  assertDropped(q);
+}
+
+void test_truncated_packets_are_dropped() {
+  Bytes q = query("example.com", TYPE_A);
+  // Every prefix shorter than the full question
+  for (size_t len = 0; len < q.size(); len++) {
+    assertDropped(Bytes(q.begin(), q.begin() + len));
+  }
+  TEST_ASSERT_EQUAL_UINT32(q.size() + 16, send(q).size());
+}
+
+void test_label_running_past_the_end_is_dropped() {
+  Bytes q = query("example.com", TYPE_A);
+  q[12] = 60;                                            // "example" claims 60 bytes
+  assertDropped(q);
+  q[12] = 0xFF;                                          // Also a reserved label type
+  assertDropped(q);
+}
+
+void test_compressed_question_name_is_dropped() {
+  Bytes q = query("example.com", TYPE_A);
+  q[12 + 8] = 0xC0;                                      // "com" replaced by a pointer
+  q[12 + 9] = 0x0C;
+  assertDropped(q);
+}
+
+void test_oversized_packet_is_dropped() {
+  Bytes q = query("example.com", TYPE_A);
+  q.resize(Captive_DNS::MAX_PACKET + 1, 0);
+  assertDropped(q);
+}
+
+void test_counters_add_up() {
+  send(query("a.example", TYPE_A));
+  send(query("b.example", TYPE_AAAA));
+  send(Bytes(5, 0));
+  send(query("c.example", TYPE_A), STA_IP);
+  TEST_ASSERT_EQUAL_UINT32(4, dns->queries());
+  TEST_ASSERT_EQUAL_UINT32(dns->queries(), dns->answeredA() + dns->answeredEmpty() + dns->dropped());
+}
+
+// ============================================================================
+// LOAD
+// ============================================================================
+
+void test_benchmark_mixed_query_load() {
+  // Connectivity probes as Android, iOS and Windows send them on join
+  static const char* NAMES[] = {
+    "connectivitycheck.gstatic.com", "www.google.com", "captive.apple.com",
+    "www.msftconnecttest.com", "dns.msftncsi.com", "clients3.google.com",
+    "mtalk.google.com", "gateway.icloud.com",
+  };
+  const uint32_t QUERIES = 20000;
+  srand(3);
+  std::vector<Bytes> packets;
+  uint32_t wantA = 0;
+  for (uint32_t i = 0; i < QUERIES; i++) {
+    // Half A, the rest AAAA and HTTPS as dual-stack clients ask in parallel
+    int r = rand() % 20;
+    uint16_t type = r < 10 ? TYPE_A : r < 17 ? TYPE_AAAA : TYPE_HTTPS;
+    if (type == TYPE_A) wantA++;
+    packets.push_back(query(NAMES[rand() % 8], type, (uint16_t)i));
+  }
+
+  std::vector<double> us;
+  us.reserve(QUERIES);
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < QUERIES; i++) {
+    AsyncUDPPacket p(packets[i].data(), packets[i].size(), AP_IP);
+    auto t0 = std::chrono::steady_clock::now();
+    AsyncUDP::deliver(p);
+    us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count());
+    TEST_ASSERT_EQUAL_UINT32(1, p.replies);
+    TEST_ASSERT_EQUAL_HEX16(i & 0xFFFF, get16(p.reply, 0));
+  }
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::sort(us.begin(), us.end());
+  double p50 = us[QUERIES / 2];
+  double p99 = us[QUERIES * 99 / 100];
+  char msg[128];
+  snprintf(msg, sizeof(msg), "host: %u queries, %.0f k qps, p50 %.2f us, p99 %.2f us, max %.2f us",
+           (unsigned)QUERIES, QUERIES / s / 1000, p50, p99, us.back());
+  TEST_MESSAGE(msg);
+
+  TEST_ASSERT_EQUAL_UINT32(QUERIES, dns->queries());
+  TEST_ASSERT_EQUAL_UINT32(wantA, dns->answeredA());
+  TEST_ASSERT_EQUAL_UINT32(QUERIES - wantA, dns->answeredEmpty());
+  TEST_ASSERT_EQUAL_UINT32(0, dns->dropped());
+  // Timings are reported, not asserted: they depend on the host's load
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_a_query_gets_the_portal_address);
+  RUN_TEST(test_rd_clear_stays_clear);
+  RUN_TEST(test_other_types_get_nodata);
+  RUN_TEST(test_edns_opt_record_is_dropped_from_the_reply);
+  RUN_TEST(test_root_name_is_answered);
+  RUN_TEST(test_longest_packet_is_answered);
+  RUN_TEST(test_set_ip_changes_the_answer);
+  RUN_TEST(test_queries_from_the_sta_side_are_ignored);
+  RUN_TEST(test_responses_and_other_opcodes_are_dropped);
+  RUN_TEST(test_question_count_must_be_one);
+  RUN_TEST(test_truncated_packets_are_dropped);
+  RUN_TEST(test_label_running_past_the_end_is_dropped);
+  RUN_TEST(test_compressed_question_name_is_dropped);
+  RUN_TEST(test_oversized_packet_is_dropped);
+  RUN_TEST(test_counters_add_up);
+  RUN_TEST(test_benchmark_mixed_query_load);
+  return UNITY_END();
+}
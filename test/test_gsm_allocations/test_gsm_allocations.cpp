@@ -0,0 +1,223 @@
+/**
+ * @file test_gsm_allocations.cpp
+ * @brief Heap allocations of a GSM network/signal refresh, scripted modem
+ *
+ * @details
+ * GSM_Test runs against a Serial2 stand-in that answers each AT command
+ * with a canned reply. Allocations are counted by the String shim, which
+ * models the ESP32 core's WString buffer (14 inline characters, 16-byte
+ * growth), so the counts are what the same calls make on the device.
+ *
+ * A refresh is what GET /api/gsm/network and /api/gsm/signal do when the
+ * GSMCache entry is stale: detectCarrierNetwork() or getSignalStrength()
+ * plus the copy into the cache. The cache mirrors below have the field
+ * types of GSMCache in main.cpp (char[] set with cfgSet()) and, for
+ * comparison, of the String members it had before.
+ *
+ * Not covered here: GET /api/status reads neither GSMCache nor
+ * NetworkInfo, and a settings save only touches the char[] schema fields,
+ * so neither path changes with the cache fields. Both need main.cpp and
+ * ArduinoJson; their per-request counts come from a heapdiag build:
+ * "json" and "config" in /api/metrics/heap (README: Heap Accounting).
+ */
+
+#include <unity.h>
+#include <map>
+#include <string>
+#include "GSM_Test.h"
+#include "Config_Schema.h"
+
+// ============================================================================
+// SCRIPTED MODEM
+// ============================================================================
+
+/**
+ * @brief Serial2 stand-in: each "AT...\r\n" line queues its canned reply
+ *
+ * AT+COPS=3,0 / 3,2 switch AT+COPS? between the long name and the
+ * numeric MCC/MNC like a real modem. Unknown commands answer ERROR.
+ */
+class ScriptedModem : public HardwareSerial {
+public:
+  std::map<std::string, std::string> replies;
+  std::string carrier = "Vodafone UK";
+
+  using Print::write;
+  size_t write(uint8_t c) override {
+    if (c != '\n') {
+      if (c != '\r') _line += (char)c;
+      return 1;
+    }
+    if (_line == "AT+COPS=3,0") _numeric = false;
+    if (_line == "AT+COPS=3,2") _numeric = true;
+    _out = reply(_line);
+    _pos = 0;
+    _line.clear();
+    return 1;
+  }
+
+  int available() override { return (int)(_out.size() - _pos); }
+  int read() override { return _pos < _out.size() ? (uint8_t)_out[_pos++] : -1; }
+
+private:
+  std::string reply(const std::string& cmd) const {
+    if (cmd == "AT+COPS?") {
+      std::string op = _numeric ? "23415\",7" : carrier + "\",7";
+      return "\r\n+COPS: 0," + std::string(_numeric ? "2" : "0") + ",\"" + op + "\r\n\r\nOK\r\n";
+    }
+    auto it = replies.find(cmd);
+    return it != replies.end() ? it->second : "\r\nERROR\r\n";
+  }
+
+  std::string _line, _out;
+  size_t _pos = 0;
+  bool _numeric = false;
+};
+
+static ScriptedModem modem;
+static GSM_Test gsm(modem, 16, 17, 115200);
+
+// GSMCache text fields as of this tree
+struct CharCache {
+  char grade[10] = "Unknown";
+  char carrierName[33] = "Unknown";
+  char networkMode[16] = "Unknown";
+};
+
+// GSMCache text fields before
+struct StringCache {
+  String grade = "Unknown";
+  String carrierName = "Unknown";
+  String networkMode = "Unknown";
+};
+
+/**
+ * @brief Allocations made by fn()
+ */
+template <class Fn>
+static long allocations(Fn fn) {
+  long before = Native::stringAllocs();
+  fn();
+  return Native::stringAllocs() - before;
+}
+
+/**
+ * @brief Copy of the refreshed text fields into a cache that lives across refreshes
+ */
+static long storeFields(const GSM_Test::NetworkInfo& info, CharCache& cache) {
+  return allocations([&]() {
+    cfgSet(cache.carrierName, info.carrierName.c_str());
+    cfgSet(cache.networkMode, info.networkMode.c_str());
+  });
+}
+
+static long storeFields(const GSM_Test::NetworkInfo& info, StringCache& cache) {
+  return allocations([&]() {
+    cache.carrierName = info.carrierName;
+    cache.networkMode = info.networkMode;
+  });
+}
+
+/**
+ * @brief One stale /api/gsm/network poll
+ * @param refreshAllocs Allocations of detectCarrierNetwork() itself
+ * @return Allocations of the text fields (storeFields())
+ */
+template <class Cache>
+static long networkRefresh(Cache& cache, long& refreshAllocs) {
+  GSM_Test::NetworkInfo info;
+  refreshAllocs = allocations([&]() { info = gsm.detectCarrierNetwork(); });
+  return storeFields(info, cache);
+}
+
+void setUp() {
+  modem.replies["AT+CPIN?"] = "\r\n+CPIN: READY\r\n\r\nOK\r\n";
+  modem.replies["AT+CSQ"] = "\r\n+CSQ: 21,99\r\n\r\nOK\r\n";
+  modem.replies["AT+CREG?"] = "\r\n+CREG: 2,1,\"1A2B\",\"01C3D4E5\",7\r\n\r\nOK\r\n";
+  modem.replies["AT+CREG=2"] = "\r\nOK\r\n";
+  modem.replies["AT+COPS=3,0"] = "\r\nOK\r\n";
+  modem.replies["AT+COPS=3,2"] = "\r\nOK\r\n";
+  modem.replies["AT+QNWINFO"] = "\r\n+QNWINFO: \"FDD LTE\",\"23415\",\"LTE BAND 20\",6300\r\n\r\nOK\r\n";
+  modem.carrier = "Vodafone UK";
+}
+
+void tearDown() {
+}
+
+// ============================================================================
+// NETWORK REFRESH
+// ============================================================================
+
+void test_scripted_modem_is_parsed() {
+  modem.carrier = "Telefonica O2 UK Ltd";
+  GSM_Test::NetworkInfo info = gsm.detectCarrierNetwork();
+  TEST_ASSERT_EQUAL_STRING("Telefonica O2 UK Ltd", info.carrierName.c_str());
+  TEST_ASSERT_EQUAL_STRING("234", info.mcc.c_str());
+  TEST_ASSERT_EQUAL_STRING("15", info.mnc.c_str());
+  TEST_ASSERT_EQUAL_STRING("1A2B", info.locationAreaCode.c_str());
+  TEST_ASSERT_EQUAL_STRING("01C3D4E5", info.cellId.c_str());
+  TEST_ASSERT_EQUAL_INT(-71, info.signalStrength);
+  TEST_ASSERT_TRUE(info.isRegistered);
+}
+
+void test_cache_update_does_not_allocate() {
+  const char* carriers[] = { "EE", "Vodafone UK", "Telefonica O2 UK Ltd",
+                             "A carrier name of thirty-two ch" };
+  CharCache cache;
+  long refresh = 0;
+  for (const char* c : carriers) {
+    modem.carrier = c;
+    TEST_ASSERT_EQUAL(0, networkRefresh(cache, refresh));
+    TEST_ASSERT_EQUAL_STRING(c, cache.carrierName);
+  }
+}
+
+void test_report_allocations_per_network_refresh() {
+  const char* carriers[] = { "Vodafone UK", "Telefonica O2 UK Ltd" };
+  char msg[200];
+  for (const char* c : carriers) {
+    modem.carrier = c;
+    CharCache chars;
+    StringCache strings;
+    long refresh = 0, refreshAgain = 0;
+    long fieldsStrings = networkRefresh(strings, refresh);
+    long fieldsChars = networkRefresh(chars, refreshAgain);
+    TEST_ASSERT_EQUAL(refresh, refreshAgain);
+    TEST_ASSERT_EQUAL(0, fieldsChars);
+    // Only a carrier name past the SSO buffer costs the String cache,
+    // and only until its buffer has grown to the name
+    TEST_ASSERT_EQUAL(strlen(c) > String::SSO_CAPACITY ? 1 : 0, fieldsStrings);
+    TEST_ASSERT_EQUAL(0, networkRefresh(strings, refresh));
+    snprintf(msg, sizeof(msg),
+             "carrier \"%s\" (%u chars): detectCarrierNetwork() %ld allocations, "
+             "cache copy %ld with String fields, 0 with char[]",
+             c, (unsigned)strlen(c), refreshAgain, fieldsStrings);
+    TEST_MESSAGE(msg);
+  }
+}
+
+// ============================================================================
+// SIGNAL REFRESH
+// ============================================================================
+
+void test_report_allocations_per_signal_refresh() {
+  CharCache chars;
+  StringCache strings;
+  int dbm = 0;
+  long refresh = allocations([&]() { dbm = gsm.getSignalStrength(); });
+  TEST_ASSERT_EQUAL_INT(-71, dbm);
+  TEST_ASSERT_EQUAL(0, allocations([&]() { cfgSet(chars.grade, "Excellent"); }));
+  TEST_ASSERT_EQUAL(0, allocations([&]() { strings.grade = "Excellent"; }));  // Fits the SSO
+  char msg[96];
+  snprintf(msg, sizeof(msg), "getSignalStrength() %ld, grade update 0", refresh);
+  TEST_MESSAGE(msg);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_scripted_modem_is_parsed);
+  RUN_TEST(test_cache_update_does_not_allocate);
+  RUN_TEST(test_report_allocations_per_network_refresh);
+  RUN_TEST(test_report_allocations_per_signal_refresh);
+  return UNITY_END();
+}
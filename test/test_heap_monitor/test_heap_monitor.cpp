@@ -0,0 +1,563 @@
+/**
+ * @file test_heap_monitor.cpp
+ * @brief Heap_Monitor attribution, drift, foreign tasks, check rate, and a
+ *        replayed day of dashboard traffic
+ *
+ * @details
+ * The test plays the allocator through the esp_heap_caps shim: every
+ * allocation is Native::heapTake() followed by onAlloc(), as the malloc
+ * wrapper would do, and every free is Native::heapGive(). The random-scope
+ * test opens nested scopes (deeper than MAX_DEPTH too), allocates, frees
+ * and leaks, and checks the monitor against a model that books each block
+ * to the innermost tracked scope.
+ *
+ * The day replay runs the handler mix of a dashboard left open for 24 h
+ * (status and sensor polls, WiFi scans, settings saves, GSM queries, lwIP
+ * buffers from the WiFi task) on the simulated clock, against a first-fit
+ * allocator model that feeds free size, largest block and minimum free to
+ * the shim. It is NOT the ESP-IDF heap (TLSF in multi_heap, several
+ * regions, per-block overhead of its own), and block sizes are estimates
+ * of what the handlers allocate, so the trend it reports shows how the
+ * mix fragments a heap and that nothing drifts, not the device's figures.
+ */
+
+#include <unity.h>
+#include <map>
+#include <vector>
+#include <esp_heap_caps.h>
+#include "Heap_Monitor.h"
+
+static TaskHandle_t const LOOP_TASK = (TaskHandle_t)1;
+static TaskHandle_t const WIFI_TASK = (TaskHandle_t)2;
+
+void setUp() {
+  Native::setUs(0);
+  Native::heap() = Native::Heap();
+  Native::currentTask() = LOOP_TASK;
+  heapMonitor = Heap_Monitor();
+  heapMonitor.begin();
+  srand(7);
+}
+
+void tearDown() {}
+
+static void alloc(size_t n) {
+  Native::heapTake(n);
+  heapMonitor.onAlloc(n);
+}
+
+static void release(size_t n) {
+  Native::heapGive(n);
+}
+
+// ============================================================================
+// SOAK MODEL
+// ============================================================================
+
+/**
+ * @brief One scope the monitor tracks (depth < MAX_DEPTH)
+ */
+struct ModelFrame {
+  uint8_t tag;
+  std::vector<size_t> blocks;   // Allocated here or in untracked children
+  int32_t own;                  // Bytes booked to this frame
+  uint32_t startFree;
+  uint32_t lowFree;
+};
+
+struct Model {
+  std::vector<ModelFrame> frames;
+  uint8_t overflow = 0;
+  std::vector<size_t> leaked[HEAP_TAG_COUNT];
+  int32_t current[HEAP_TAG_COUNT] = {};
+  uint32_t allocs[HEAP_TAG_COUNT] = {};
+  uint32_t runs[HEAP_TAG_COUNT] = {};
+  uint32_t peakRun[HEAP_TAG_COUNT] = {};
+  uint32_t small = 0;           // Allocations inside scopes, by size class
+  uint32_t large = 0;
+  uint32_t tracked = 0;         // Scopes entered below MAX_DEPTH
+
+  void enter(uint8_t tag) {
+    heapMonitor.enter((HeapTag)tag);
+    if (frames.size() == Heap_Monitor::MAX_DEPTH) {
+      overflow++;
+      return;
+    }
+    uint32_t free = Native::heap().free;
+    frames.push_back({ tag, {}, 0, free, free });
+    runs[tag]++;
+    tracked++;
+  }
+
+  void alloc(size_t n) {
+    ::alloc(n);
+    if (frames.empty()) {
+      allocs[HEAP_OTHER]++;
+      leaked[HEAP_OTHER].push_back(n);
+      return;
+    }
+    ModelFrame& f = frames.back();
+    allocs[f.tag]++;
+    f.blocks.push_back(n);
+    f.own += n;
+    if (n >= Heap_Monitor::LOW_WATER_BYTES) large++;
+    else small++;
+    for (ModelFrame& m : frames) {
+      if (Native::heap().free < m.lowFree) m.lowFree = Native::heap().free;
+    }
+  }
+
+  void freeOne() {
+    ModelFrame& f = frames.back();
+    // Mostly its own blocks; sometimes one its tag leaked earlier
+    std::vector<size_t>& from = !f.blocks.empty() && rand() % 4 ? f.blocks : leaked[f.tag];
+    if (from.empty()) return;
+    size_t i = rand() % from.size();
+    release(from[i]);
+    f.own -= from[i];
+    from.erase(from.begin() + i);
+  }
+
+  void exit() {
+    heapMonitor.exit();
+    if (overflow) {
+      overflow--;
+      return;
+    }
+    ModelFrame f = frames.back();
+    frames.pop_back();
+    current[f.tag] += f.own;
+    uint32_t run = f.startFree - f.lowFree;
+    if (run > peakRun[f.tag]) peakRun[f.tag] = run;
+    leaked[f.tag].insert(leaked[f.tag].end(), f.blocks.begin(), f.blocks.end());
+  }
+
+  size_t depth() const { return frames.size() + overflow; }
+};
+
+static size_t randomSize() {
+  // Mostly String growth and small objects, some buffers
+  return rand() % 5 ? 8 + rand() % 200 : Heap_Monitor::LOW_WATER_BYTES + rand() % 2048;
+}
+
+static void checkAgainst(const Model& m) {
+  for (uint8_t i = 0; i < HEAP_TAG_COUNT; i++) {
+    const Heap_Monitor::TagStats& t = heapMonitor.tag(i);
+    TEST_ASSERT_EQUAL_INT32(m.current[i], t.current);
+    TEST_ASSERT_EQUAL_UINT32(m.allocs[i], t.allocs);
+    TEST_ASSERT_EQUAL_UINT32(m.runs[i], t.runs);
+    TEST_ASSERT_TRUE(t.peak >= t.current);
+  }
+}
+
+// ============================================================================
+// TESTS
+// ============================================================================
+
+void test_model_random_nested_scopes() {
+  Model m;
+  Native::heap().free = Native::heap().minFree = 4000000;   // Room for the leaks
+  uint32_t start = Native::heap().free;
+  uint32_t queries0 = Native::heap().freeQueries;
+
+  for (uint32_t round = 0; round < 20000; round++) {
+    uint8_t tag = rand() % HEAP_OTHER;
+    m.enter(tag);
+    // A random walk of nested work, up to two levels past MAX_DEPTH
+    do {
+      int op = rand() % 10;
+      if (op < 4) m.alloc(randomSize());
+      else if (op < 7) m.freeOne();
+      else if (op < 8 && m.depth() < Heap_Monitor::MAX_DEPTH + 2) m.enter(rand() % HEAP_OTHER);
+      else if (m.depth() > 1) m.exit();
+    } while (m.depth() > 1 || rand() % 8);
+    m.exit();
+    if (rand() % 50 == 0) m.alloc(randomSize());      // Outside any scope
+    checkAgainst(m);
+    // Keep the simulated heap from running dry
+    for (uint8_t i = 0; i < HEAP_OTHER; i++) {
+      if (m.leaked[i].size() > 200) {
+        m.enter(i);
+        while (m.leaked[i].size() > 100) m.freeOne();
+        m.exit();
+      }
+    }
+  }
+  checkAgainst(m);
+
+  // The low point can only be missed by less than LOW_WATER_EVERY small
+  // allocations since the last check
+  const uint32_t slack = (Heap_Monitor::LOW_WATER_EVERY - 1) * (Heap_Monitor::LOW_WATER_BYTES - 1);
+  for (uint8_t i = 0; i < HEAP_OTHER; i++) {
+    uint32_t peakRun = heapMonitor.tag(i).peakRun;
+    TEST_ASSERT_TRUE(peakRun <= m.peakRun[i]);
+    TEST_ASSERT_TRUE(peakRun + slack >= m.peakRun[i]);
+  }
+
+  // Overhead: one free heap read per tracked enter and exit, plus the
+  // throttled checks (every large allocation, every 16th small one)
+  uint32_t checks = heapMonitor.lowWaterChecks();
+  TEST_ASSERT_EQUAL_UINT32(2 * m.tracked + checks, Native::heap().freeQueries - queries0);
+  TEST_ASSERT_TRUE(checks >= m.large);
+  TEST_ASSERT_TRUE(checks <= m.large + m.small / Heap_Monitor::LOW_WATER_EVERY);
+  TEST_ASSERT_TRUE(checks * 3 < m.small + m.large);
+
+  // Free everything in a scope of the tag it was booked to: no drift
+  for (uint8_t i = 0; i < HEAP_OTHER; i++) {
+    m.enter(i);
+    while (!m.leaked[i].empty()) m.freeOne();
+    m.exit();
+  }
+  for (size_t n : m.leaked[HEAP_OTHER]) release(n);
+  for (uint8_t i = 0; i < HEAP_TAG_COUNT; i++) {
+    TEST_ASSERT_EQUAL_INT32(0, heapMonitor.tag(i).current);
+  }
+  TEST_ASSERT_EQUAL_UINT32(start, Native::heap().free);
+}
+
+void test_nested_scope_is_booked_to_its_own_tag() {
+  {
+    Heap_Scope http(HEAP_HTTP);
+    alloc(100);
+    {
+      Heap_Scope json(HEAP_JSON);
+      alloc(300);
+      alloc(40);
+    }
+    alloc(60);
+  }
+  TEST_ASSERT_EQUAL_INT32(160, heapMonitor.tag(HEAP_HTTP).current);
+  TEST_ASSERT_EQUAL_INT32(340, heapMonitor.tag(HEAP_JSON).current);
+  TEST_ASSERT_EQUAL_UINT32(2, heapMonitor.tag(HEAP_HTTP).allocs);
+  TEST_ASSERT_EQUAL_UINT32(2, heapMonitor.tag(HEAP_JSON).allocs);
+  // The parent's transient use includes the child's
+  TEST_ASSERT_EQUAL_UINT32(340, heapMonitor.tag(HEAP_JSON).peakRun);
+  TEST_ASSERT_EQUAL_UINT32(500, heapMonitor.tag(HEAP_HTTP).peakRun);
+}
+
+void test_scopes_past_max_depth_are_booked_to_the_deepest_tracked_one() {
+  for (uint8_t i = 0; i < Heap_Monitor::MAX_DEPTH; i++) heapMonitor.enter(HEAP_MODEM);
+  heapMonitor.enter(HEAP_SMTP);
+  heapMonitor.enter(HEAP_CONFIG);
+  alloc(500);
+  heapMonitor.exit();
+  heapMonitor.exit();
+  TEST_ASSERT_EQUAL_UINT32(0, heapMonitor.tag(HEAP_SMTP).runs);
+  TEST_ASSERT_EQUAL_UINT32(0, heapMonitor.tag(HEAP_CONFIG).runs);
+  for (uint8_t i = 0; i < Heap_Monitor::MAX_DEPTH; i++) heapMonitor.exit();
+
+  TEST_ASSERT_EQUAL_UINT32(Heap_Monitor::MAX_DEPTH, heapMonitor.tag(HEAP_MODEM).runs);
+  TEST_ASSERT_EQUAL_INT32(500, heapMonitor.tag(HEAP_MODEM).current);
+  TEST_ASSERT_EQUAL_UINT32(1, heapMonitor.tag(HEAP_MODEM).allocs);
+
+  // Unbalanced exits are ignored
+  heapMonitor.exit();
+  TEST_ASSERT_EQUAL_INT32(500, heapMonitor.tag(HEAP_MODEM).current);
+}
+
+void test_foreign_allocations_are_counted_but_land_in_the_delta() {
+  {
+    Heap_Scope scope(HEAP_SMTP);
+    alloc(64);
+    Native::currentTask() = WIFI_TASK;
+    alloc(1600);                       // lwIP buffer while the scope is open
+    Native::currentTask() = LOOP_TASK;
+  }
+  TEST_ASSERT_EQUAL_UINT32(1, heapMonitor.foreignAllocs());
+  TEST_ASSERT_EQUAL_UINT32(1, heapMonitor.tag(HEAP_SMTP).allocs);
+  TEST_ASSERT_EQUAL_UINT32(64, heapMonitor.tag(HEAP_SMTP).allocBytes);
+  // The documented approximation: the delta includes the other task's bytes
+  TEST_ASSERT_EQUAL_INT32(64 + 1600, heapMonitor.tag(HEAP_SMTP).current);
+}
+
+void test_small_allocations_are_checked_every_nth_time() {
+  Heap_Scope scope(HEAP_JSON);
+  uint32_t queries0 = Native::heap().freeQueries;
+  for (uint8_t i = 1; i < Heap_Monitor::LOW_WATER_EVERY; i++) alloc(16);
+  TEST_ASSERT_EQUAL_UINT32(0, heapMonitor.lowWaterChecks());
+  alloc(16);
+  TEST_ASSERT_EQUAL_UINT32(1, heapMonitor.lowWaterChecks());
+  alloc(Heap_Monitor::LOW_WATER_BYTES);
+  alloc(Heap_Monitor::LOW_WATER_BYTES);
+  TEST_ASSERT_EQUAL_UINT32(3, heapMonitor.lowWaterChecks());
+  TEST_ASSERT_EQUAL_UINT32(3, Native::heap().freeQueries - queries0);
+}
+
+void test_allocations_before_begin_are_ignored() {
+  heapMonitor = Heap_Monitor();
+  alloc(100);
+  TEST_ASSERT_EQUAL_UINT32(0, heapMonitor.tag(HEAP_OTHER).allocs);
+  heapMonitor.begin();
+  alloc(100);
+  TEST_ASSERT_EQUAL_UINT32(1, heapMonitor.tag(HEAP_OTHER).allocs);
+  TEST_ASSERT_EQUAL_INT32(0, heapMonitor.tag(HEAP_OTHER).current);
+}
+
+void test_trend_ring_keeps_the_last_day() {
+  // begin() took the first sample at 0 ms
+  for (uint16_t i = 1; i < Heap_Monitor::HISTORY + 10; i++) {
+    Native::advanceMs(Heap_Monitor::SAMPLE_MS);
+    Native::heapTake(16);
+    heapMonitor.sample();
+  }
+  TEST_ASSERT_EQUAL_UINT16(Heap_Monitor::HISTORY, heapMonitor.sampleCount());
+
+  Heap_Monitor::Sample oldest = heapMonitor.history(0);
+  Heap_Monitor::Sample newest = heapMonitor.history(Heap_Monitor::HISTORY - 1);
+  TEST_ASSERT_EQUAL_UINT32(10 * Heap_Monitor::SAMPLE_MS, oldest.ms);
+  TEST_ASSERT_EQUAL_UINT32((uint32_t)(Heap_Monitor::HISTORY + 9) * Heap_Monitor::SAMPLE_MS, newest.ms);
+  // Sizes are stored in 16-byte units
+  TEST_ASSERT_EQUAL_UINT32(200000 - 10 * 16, oldest.free);
+  TEST_ASSERT_EQUAL_UINT32(Native::heap().free & ~15u, newest.free);
+  TEST_ASSERT_EQUAL_UINT32(newest.free, newest.minFree);
+  for (uint16_t i = 1; i < Heap_Monitor::HISTORY; i++) {
+    TEST_ASSERT_EQUAL_UINT32(Heap_Monitor::SAMPLE_MS, heapMonitor.history(i).ms - heapMonitor.history(i - 1).ms);
+  }
+}
+
+void test_fragmentation() {
+  TEST_ASSERT_EQUAL_UINT32(0, Heap_Monitor::fragmentationPct(0, 0));
+  TEST_ASSERT_EQUAL_UINT32(0, Heap_Monitor::fragmentationPct(100000, 100000));
+  TEST_ASSERT_EQUAL_UINT32(45, Heap_Monitor::fragmentationPct(200000, 110000));
+  TEST_ASSERT_EQUAL_UINT32(23, Heap_Monitor::fragmentationPct(142360, 110580));
+}
+
+// ============================================================================
+// DAY REPLAY
+// ============================================================================
+
+/**
+ * @brief First-fit allocator over one region, lowest address first
+ *
+ * Blocks carry an 8-byte header and are rounded to 8 bytes; freed blocks
+ * coalesce with their neighbours. Free size, largest free block and the
+ * minimum free size are published to the heap shim after every call.
+ */
+class FirstFit {
+public:
+  static const uint32_t HEADER = 8;
+
+  explicit FirstFit(uint32_t size) : _free(size) {
+    _holes[0] = size;
+    publish();
+    Native::heap().minFree = _free;
+  }
+
+  uint32_t alloc(size_t n) {
+    uint32_t need = HEADER + ((n + 7) & ~7u);
+    for (auto it = _holes.begin(); it != _holes.end(); ++it) {
+      if (it->second < need) continue;
+      uint32_t at = it->first;
+      uint32_t rest = it->second - need;
+      _holes.erase(it);
+      if (rest) _holes[at + need] = rest;
+      _used[at] = need;
+      _free -= need;
+      publish();
+      return at + 1;                     // 0 is "failed"
+    }
+    return 0;
+  }
+
+  void free(uint32_t handle) {
+    if (!handle) return;
+    auto u = _used.find(handle - 1);
+    TEST_ASSERT_TRUE(u != _used.end());
+    uint32_t at = u->first;
+    uint32_t size = u->second;
+    _used.erase(u);
+    _free += size;
+    auto next = _holes.lower_bound(at);
+    if (next != _holes.end() && at + size == next->first) {
+      size += next->second;
+      next = _holes.erase(next);
+    }
+    if (next != _holes.begin()) {
+      auto prev = std::prev(next);
+      if (prev->first + prev->second == at) {
+        prev->second += size;
+        publish();
+        return;
+      }
+    }
+    _holes[at] = size;
+    publish();
+  }
+
+  uint32_t freeBytes() const { return _free; }
+  size_t blocks() const { return _used.size(); }
+
+private:
+  void publish() {
+    uint32_t largest = 0;
+    for (auto& h : _holes) largest = std::max(largest, h.second);
+    Native::Heap& heap = Native::heap();
+    heap.free = _free;
+    heap.largest = largest >= HEADER ? largest - HEADER : 0;
+    if (heap.free < heap.minFree) heap.minFree = heap.free;
+  }
+
+  std::map<uint32_t, uint32_t> _holes;   // Offset -> size
+  std::map<uint32_t, uint32_t> _used;
+  uint32_t _free;
+};
+
+static FirstFit* arena;
+
+static uint32_t take(size_t n) {
+  uint32_t h = arena->alloc(n);
+  TEST_ASSERT_TRUE(h != 0);
+  heapMonitor.onAlloc(n);
+  return h;
+}
+
+static uint32_t takeForeign(size_t n) {
+  Native::currentTask() = WIFI_TASK;
+  uint32_t h = take(n);
+  Native::currentTask() = LOOP_TASK;
+  return h;
+}
+
+/**
+ * @brief A String grown by appending, as Arduino String reallocates
+ */
+static uint32_t growString(size_t finalLen) {
+  uint32_t h = 0;
+  for (size_t cap = 32;; cap *= 2) {
+    uint32_t bigger = take(std::min(cap, finalLen) + 1);
+    arena->free(h);                      // realloc(): copy, then free the old block
+    h = bigger;
+    if (cap >= finalLen) return h;
+  }
+}
+
+/**
+ * @brief Blocks that outlive one request
+ */
+struct LongLived {
+  std::vector<uint32_t> scanCache;       // WiFi_ScanCache entries
+  uint32_t carrier = 0;                  // Carrier name / network mode Strings
+  uint32_t mode = 0;
+  uint32_t unacked = 0;                  // TCP segment of the last response
+};
+
+static void httpRequest(LongLived& keep, size_t docBytes, size_t jsonLen) {
+  // The request arrives in a pbuf from the WiFi/lwIP task
+  uint32_t pbuf = takeForeign(600);
+  Heap_Scope http(HEAP_HTTP);
+  uint32_t uri = take(48);
+  arena->free(pbuf);
+  uint32_t out;
+  {
+    Heap_Scope json(HEAP_JSON);
+    uint32_t doc = take(docBytes);
+    out = growString(jsonLen);
+    arena->free(doc);
+  }
+  // The previous response's segment is ACKed by now; this one waits
+  arena->free(keep.unacked);
+  keep.unacked = takeForeign(std::min(jsonLen, (size_t)1460) + 54);
+  arena->free(out);
+  arena->free(uri);
+}
+
+static void wifiScan(LongLived& keep) {
+  Heap_Scope scan(HEAP_SCAN);
+  uint32_t raw = takeForeign(20 * 80);   // Driver's scan record buffer
+  for (uint32_t h : keep.scanCache) arena->free(h);
+  keep.scanCache.clear();
+  uint8_t n = 6 + rand() % 14;
+  for (uint8_t i = 0; i < n; i++) keep.scanCache.push_back(take(40 + rand() % 24));
+  arena->free(raw);
+}
+
+static void saveSettings() {
+  uint32_t body = takeForeign(700);
+  Heap_Scope http(HEAP_HTTP);
+  Heap_Scope config(HEAP_CONFIG);
+  uint32_t doc = take(2048);
+  arena->free(body);
+  uint32_t record = take(1536);          // Config_Store payload
+  arena->free(record);
+  arena->free(doc);
+}
+
+static void gsmQuery(LongLived& keep) {
+  Heap_Scope modem(HEAP_MODEM);
+  uint32_t reply = growString(90 + rand() % 60);   // AT+COPS? / AT+CPSI? lines
+  arena->free(keep.carrier);
+  arena->free(keep.mode);
+  keep.carrier = take(8 + rand() % 16);
+  keep.mode = take(16 + rand() % 48);
+  arena->free(reply);
+}
+
+void test_replay_a_day_of_dashboard_traffic() {
+  const uint32_t HEAP_BYTES = 300 * 1024;
+  arena = new FirstFit(HEAP_BYTES);
+  // Boot: WiFi/lwIP, web server, sensors and the rest stay allocated
+  for (int i = 0; i < 400; i++) arena->alloc(64 + rand() % 400);
+  heapMonitor = Heap_Monitor();
+  heapMonitor.begin();
+
+  LongLived keep;
+  uint32_t freeAfterHour = 0;
+  uint32_t requests = 0;
+  for (uint32_t t = 1; t <= 86400; t++) {
+    Native::advanceMs(1000);
+    if (t % 2 == 0) { httpRequest(keep, 1024, 700 + rand() % 300); requests++; }   // /api/status
+    if (t % 5 == 0) { httpRequest(keep, 2048, 1200 + rand() % 400); requests++; }  // /api/sensors
+    if (t % 60 == 0) gsmQuery(keep);
+    if (t % 300 == 0) wifiScan(keep);
+    if (t % 1800 == 0) saveSettings();
+    if (t % (Heap_Monitor::SAMPLE_MS / 1000) == 0) heapMonitor.sample();
+    if (t == 3600) freeAfterHour = arena->freeBytes();
+  }
+
+  TEST_ASSERT_EQUAL_UINT16(Heap_Monitor::HISTORY, heapMonitor.sampleCount());
+  uint32_t worstFrag = 0;
+  uint32_t lowFree = UINT32_MAX;
+  char msg[128];
+  for (uint16_t i = 0; i < heapMonitor.sampleCount(); i++) {
+    Heap_Monitor::Sample h = heapMonitor.history(i);
+    uint32_t frag = Heap_Monitor::fragmentationPct(h.free, h.largest);
+    worstFrag = std::max(worstFrag, frag);
+    lowFree = std::min(lowFree, h.free);
+    if (i % 36 == 35) {                  // Every 3 h
+      snprintf(msg, sizeof(msg), "%02u:%02u free %u largest %u minFree %u fragmentation %u%%",
+               h.ms / 3600000, h.ms / 60000 % 60, h.free, h.largest, h.minFree, frag);
+      TEST_MESSAGE(msg);
+    }
+  }
+  Heap_Monitor::Sample last = heapMonitor.history(Heap_Monitor::HISTORY - 1);
+  snprintf(msg, sizeof(msg), "%u requests, worst fragmentation %u%%, lowest sampled free %u",
+           (unsigned)requests, worstFrag, lowFree);
+  TEST_MESSAGE(msg);
+
+  TEST_ASSERT_EQUAL_UINT32(86400000, last.ms);
+  // Nothing drifts: the long-lived set only varies with the scan cache
+  TEST_ASSERT_TRUE(last.free + 1024 >= freeAfterHour && last.free <= freeAfterHour + 1024);
+  // The minimum ever is the transient low, below every sampled free size
+  TEST_ASSERT_TRUE(last.minFree <= lowFree);
+  // Long-lived blocks between request buffers must not split the heap up
+  TEST_ASSERT_TRUE(last.largest >= 64 * 1024);
+  TEST_ASSERT_TRUE(worstFrag <= 50);
+  for (uint8_t i = 0; i < HEAP_OTHER; i++) {
+    TEST_ASSERT_TRUE(heapMonitor.tag(i).peakRun < 16 * 1024);
+  }
+  delete arena;
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_model_random_nested_scopes);
+  RUN_TEST(test_nested_scope_is_booked_to_its_own_tag);
+  RUN_TEST(test_scopes_past_max_depth_are_booked_to_the_deepest_tracked_one);
+  RUN_TEST(test_foreign_allocations_are_counted_but_land_in_the_delta);
+  RUN_TEST(test_small_allocations_are_checked_every_nth_time);
+  RUN_TEST(test_allocations_before_begin_are_ignored);
+  RUN_TEST(test_trend_ring_keeps_the_last_day);
+  RUN_TEST(test_fragmentation);
+  RUN_TEST(test_replay_a_day_of_dashboard_traffic);
+  return UNITY_END();
+}
@@ -0,0 +1,228 @@
+/**
+ * @file test_log_ring.cpp
+ * @brief Log_Ring wraparound, string truncation and torn-entry detection
+ *
+ * @details
+ * Each test logs into its own ring. A writer stalled mid-entry is
+ * simulated through Native::millisHook(), which claim() calls after taking
+ * the slot. The concurrent test runs real host threads (writers lapping
+ * each other and a reader) and checks that no entry read() accepts mixes
+ * two writes; the torn / collision counts it prints depend on the host's
+ * cores and scheduling (on one core, copies are rarely interrupted).
+ */
+
+#include <unity.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Log_Ring.h"
+
+/**
+ * @brief Print that keeps what drain() writes
+ */
+class Capture : public Print {
+public:
+  std::string text;
+  using Print::write;
+  size_t write(uint8_t c) override { text += (char)c; return 1; }
+};
+
+static Log_Ring* fresh = nullptr;
+#define ring (*fresh)
+
+static std::string formatted(uint32_t index) {
+  Log_Ring::Entry e;
+  TEST_ASSERT_TRUE(ring.read(index, e));
+  char msg[160];
+  Log_Ring::format(e, msg, sizeof(msg));
+  return msg;
+}
+
+void setUp() {
+  fresh = new Log_Ring();
+}
+
+void tearDown() {
+  delete fresh;
+  fresh = nullptr;
+}
+
+// ============================================================================
+// WRAPAROUND
+// ============================================================================
+
+void test_wraparound_keeps_the_newest_capacity_entries() {
+  const uint32_t total = Log_Ring::CAPACITY * 3 + 17;
+  for (uint32_t i = 0; i < total; i++) ring.write(LOG_LEVEL_INFO, LOG_MAIN, "entry %u", i);
+
+  TEST_ASSERT_EQUAL_UINT32(total, ring.head());
+  TEST_ASSERT_EQUAL_UINT32(total - Log_Ring::CAPACITY, ring.oldest());
+  Log_Ring::Entry e;
+  TEST_ASSERT_FALSE(ring.read(ring.oldest() - 1, e));  // Overwritten
+  TEST_ASSERT_FALSE(ring.read(total, e));              // Not written yet
+  TEST_ASSERT_EQUAL_STRING(("entry " + std::to_string(ring.oldest())).c_str(),
+                           formatted(ring.oldest()).c_str());
+  TEST_ASSERT_EQUAL_STRING(("entry " + std::to_string(total - 1)).c_str(),
+                           formatted(total - 1).c_str());
+}
+
+void test_drain_counts_entries_lost_to_wraparound() {
+  Capture out;
+  for (uint32_t i = 0; i < 10; i++) ring.write(LOG_LEVEL_WARN, LOG_GSM, "early %u", i);
+  TEST_ASSERT_EQUAL(10, ring.drain(out));
+
+  for (uint32_t i = 0; i < Log_Ring::CAPACITY + 5; i++) ring.write(LOG_LEVEL_INFO, LOG_GSM, "late %u", i);
+  out.text.clear();
+  TEST_ASSERT_EQUAL(Log_Ring::CAPACITY, ring.drain(out));
+  TEST_ASSERT_EQUAL_UINT32(5, ring.dropped());
+  TEST_ASSERT_EQUAL_UINT32(10 + Log_Ring::CAPACITY, ring.drained());
+  TEST_ASSERT_TRUE(out.text.find("late 4\n") == std::string::npos);
+  TEST_ASSERT_TRUE(out.text.find("I gsm    late 5\n") != std::string::npos);
+  TEST_ASSERT_TRUE(out.text.find("late 132\n") != std::string::npos);
+  TEST_ASSERT_EQUAL(0, ring.drain(out));
+}
+
+// ============================================================================
+// STRING ARGUMENTS
+// ============================================================================
+
+void test_strings_that_fit_are_copied_unmarked() {
+  String carrier("Telefonica O2 UK Ltd");
+  ring.write(LOG_LEVEL_INFO, LOG_GSM, "Network: %s (%s)", carrier, "LTE");
+  TEST_ASSERT_EQUAL_STRING("Network: Telefonica O2 UK Ltd (LTE)", formatted(0).c_str());
+
+  std::string full(Log_Ring::STR_BYTES - 1, 'x');  // Exactly fills the area
+  ring.write(LOG_LEVEL_INFO, LOG_GSM, "%s", full.c_str());
+  TEST_ASSERT_EQUAL_STRING(full.c_str(), formatted(1).c_str());
+}
+
+void test_long_string_is_cut_and_marked() {
+  std::string name = "A carrier name that is longer than the string area";
+  ring.write(LOG_LEVEL_INFO, LOG_GSM, "Network: %s", name.c_str());
+  Log_Ring::Entry e;
+  TEST_ASSERT_TRUE(ring.read(0, e));
+  TEST_ASSERT_TRUE(e.strMask & (1 << Log_Ring::TRUNC_SHIFT));
+  std::string expect = "Network: " + name.substr(0, Log_Ring::STR_BYTES - 1) + "\xE2\x80\xA6";
+  TEST_ASSERT_EQUAL_STRING(expect.c_str(), formatted(0).c_str());
+}
+
+void test_string_after_a_full_area_is_marked_empty() {
+  std::string first(40, 'a');
+  ring.write(LOG_LEVEL_INFO, LOG_GSM, "%s|%s|%d", first.c_str(), "mode", 7);
+  std::string expect = first.substr(0, Log_Ring::STR_BYTES - 1) + "\xE2\x80\xA6|\xE2\x80\xA6|7";
+  TEST_ASSERT_EQUAL_STRING(expect.c_str(), formatted(0).c_str());
+}
+
+void test_cut_does_not_split_a_utf8_character() {
+  std::string checks;
+  for (int i = 0; i < 15; i++) checks += "\xE2\x9C\x93";  // "✓", 3 bytes each
+  ring.write(LOG_LEVEL_INFO, LOG_GSM, "%s", checks.c_str());
+  // 31 bytes would end inside the 11th character: 10 are kept
+  std::string expect = checks.substr(0, 30) + "\xE2\x80\xA6";
+  TEST_ASSERT_EQUAL_STRING(expect.c_str(), formatted(0).c_str());
+}
+
+// ============================================================================
+// TORN ENTRIES
+// ============================================================================
+
+static bool readDuringWrite;
+static size_t drainedDuringWrite;
+
+/**
+ * @brief Other tasks, run while the first writer is inside its entry
+ */
+static void otherTasks() {
+  Native::millisHook() = nullptr;
+  Log_Ring::Entry e;
+  readDuringWrite = ring.read(0, e);
+  for (uint32_t i = 1; i <= 3; i++) ring.write(LOG_LEVEL_INFO, LOG_WIFI, "other %u", i);
+  Capture out;
+  drainedDuringWrite = ring.drain(out);  // Stops at the unfinished entry
+  // Lap the stalled writer: entry CAPACITY lands on its slot
+  for (uint32_t i = 4; i <= Log_Ring::CAPACITY; i++) ring.write(LOG_LEVEL_INFO, LOG_WIFI, "other %u", i);
+}
+
+void test_entry_being_written_is_neither_read_nor_shared() {
+  Native::millisHook() = otherTasks;
+  ring.write(LOG_LEVEL_INFO, LOG_GSM, "stalled %s", "writer");
+
+  TEST_ASSERT_FALSE(readDuringWrite);
+  TEST_ASSERT_EQUAL(0, drainedDuringWrite);
+  // The lapping write gave up instead of mixing into the slot
+  TEST_ASSERT_EQUAL_UINT32(1, ring.collisions());
+  TEST_ASSERT_EQUAL_STRING("stalled writer", formatted(0).c_str());
+  Log_Ring::Entry e;
+  TEST_ASSERT_FALSE(ring.read(Log_Ring::CAPACITY, e));
+
+  Capture out;
+  TEST_ASSERT_EQUAL(Log_Ring::CAPACITY - 1, ring.drain(out));
+  TEST_ASSERT_EQUAL_UINT32(2, ring.dropped());  // Entry 0 fell out of the window, CAPACITY was given up
+  TEST_ASSERT_TRUE(out.text.find("other 127\n") != std::string::npos);
+}
+
+/**
+ * @brief Writers lap each other and a reader; accepted entries must be whole
+ *
+ * Every entry carries its writer and sequence in three words and again in
+ * its string. An accepted entry whose four copies disagree was torn.
+ */
+void test_concurrent_reads_never_accept_a_torn_entry() {
+  const int WRITERS = 3;
+  const uint32_t PER_WRITER = 200000;
+  std::atomic<bool> done(false);
+  std::atomic<uint32_t> accepted(0), mixed(0);
+
+  std::thread reader([&]() {
+    Log_Ring::Entry e;
+    char msg[160];
+    while (!done.load()) {
+      // The newest entries: the slots writers are most likely inside
+      uint32_t head = ring.head();
+      for (uint32_t i = head > 8 ? head - 8 : 0; i != head; i++) {
+        if (!ring.read(i, e)) continue;
+        accepted++;
+        Log_Ring::format(e, msg, sizeof(msg));
+        char expect[64];
+        snprintf(expect, sizeof(expect), "%u %u %u w%u", e.args[0], e.args[0], e.args[0], e.args[0]);
+        if (e.args[1] != e.args[0] || e.args[2] != e.args[0] || strcmp(msg, expect) != 0) mixed++;
+      }
+    }
+  });
+
+  std::vector<std::thread> writers;
+  for (int w = 0; w < WRITERS; w++) {
+    writers.emplace_back([w, PER_WRITER]() {
+      char tag[16];
+      for (uint32_t i = 0; i < PER_WRITER; i++) {
+        uint32_t v = w * PER_WRITER + i;
+        snprintf(tag, sizeof(tag), "w%u", v);
+        ring.write(LOG_LEVEL_INFO, LOG_MAIN, "%u %u %u %s", v, v, v, tag);
+      }
+    });
+  }
+  for (std::thread& t : writers) t.join();
+  done = true;
+  reader.join();
+
+  char msg[160];
+  snprintf(msg, sizeof(msg), "%u entries accepted, %u copies rejected as torn, %u writes given up on collisions",
+           accepted.load(), ring.torn(), ring.collisions());
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_EQUAL_UINT32(0, mixed.load());
+  TEST_ASSERT_EQUAL_UINT32(WRITERS * PER_WRITER, ring.head());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_wraparound_keeps_the_newest_capacity_entries);
+  RUN_TEST(test_drain_counts_entries_lost_to_wraparound);
+  RUN_TEST(test_strings_that_fit_are_copied_unmarked);
+  RUN_TEST(test_long_string_is_cut_and_marked);
+  RUN_TEST(test_string_after_a_full_area_is_marked_empty);
+  RUN_TEST(test_cut_does_not_split_a_utf8_character);
+  RUN_TEST(test_entry_being_written_is_neither_read_nor_shared);
+  RUN_TEST(test_concurrent_reads_never_accept_a_torn_entry);
+  return UNITY_END();
+}
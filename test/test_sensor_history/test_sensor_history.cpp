@@ -0,0 +1,373 @@
+/**
+ * @file test_sensor_history.cpp
+ * @brief Sensor_History encode/decode round trips, edge cases and benchmarks
+ *
+ * @details
+ * Samples are appended at simulated uptimes (the clock behind
+ * esp_timer_get_time() is moved to each sample's time first, as on the
+ * device where a sample is appended right after it was taken) and decoded
+ * again with forEach(). Every decoded point must equal the fixed-point
+ * input exactly. The benchmarks report compression ratio and decode
+ * throughput on the host and check the ratios quoted in the README.
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <vector>
+#include "Sensor_History.h"
+#include "Sensor_Archive.h"
+
+static const uint8_t ALL = SENSOR_BIT(SENSOR_TEMPERATURE) | SENSOR_BIT(SENSOR_HUMIDITY) |
+                           SENSOR_BIT(SENSOR_LIGHT);
+
+static Sensor_History* history;
+static std::vector<Sensor_History::Point> expected;
+static std::vector<Sensor_History::Point> decoded;
+
+void setUp() {
+  history = new Sensor_History();
+  expected.clear();
+  decoded.clear();
+  Native::setUs(0);
+  Native::eraseFlash();
+  srand(11);
+}
+
+void tearDown() {
+  delete history;
+}
+
+static void collect(const Sensor_History::Point& p, void*) {
+  decoded.push_back(p);
+}
+
+/**
+ * @brief Append one sample taken at uptime upMs (history time = upMs + base)
+ */
+static void appendAt(uint64_t upMs, uint8_t valid, float t, float h, float lux) {
+  Native::setUs(upMs * 1000);
+  Sensor_Sample s;
+  memset(&s, 0, sizeof(s));
+  s.ms = (uint32_t)upMs;
+  s.valid = valid;
+  s.value[SENSOR_TEMPERATURE] = t;
+  s.value[SENSOR_HUMIDITY] = h;
+  s.value[SENSOR_LIGHT] = lux;
+  history->append(s);
+
+  Sensor_History::Point p;
+  memset(&p, 0, sizeof(p));
+  p.ms = upMs + history->timeBase();
+  p.valid = valid;
+  p.samples = 1;
+  for (uint8_t ch = 0; ch < SENSOR_CHANNELS; ch++) {
+    float scale = Sensor_History::scale(ch);
+    p.value[ch] = (valid & SENSOR_BIT(ch)) ? lroundf(s.value[ch] * scale) / scale : 0;
+  }
+  expected.push_back(p);
+}
+
+static void checkRoundTrip(uint64_t from = 0, uint64_t to = UINT64_MAX) {
+  decoded.clear();
+  history->forEach(from, to, collect, nullptr);
+  std::vector<Sensor_History::Point> want;
+  for (const Sensor_History::Point& p : expected) {
+    if (p.ms >= from && p.ms <= to) want.push_back(p);
+  }
+  TEST_ASSERT_EQUAL_UINT32(want.size(), decoded.size());
+  for (size_t i = 0; i < want.size(); i++) {
+    char msg[48];
+    snprintf(msg, sizeof(msg), "point %u", (unsigned)i);
+    TEST_ASSERT_EQUAL_UINT64_MESSAGE(want[i].ms, decoded[i].ms, msg);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(want[i].valid, decoded[i].valid, msg);
+    for (uint8_t ch = 0; ch < SENSOR_CHANNELS; ch++) {
+      if (!(want[i].valid & SENSOR_BIT(ch))) continue;
+      TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0, want[i].value[ch], decoded[i].value[ch], msg);
+    }
+  }
+}
+
+/**
+ * @brief Indoor-like trace: slow drift, sensor-resolution noise
+ */
+static void feedIndoor(uint64_t fromMs, uint32_t samples) {
+  float t = 22.0f, h = 45.0f, lux = 300.0f;
+  for (uint32_t i = 0; i < samples; i++) {
+    if (rand() % 20 == 0) t += (rand() % 3 - 1) * 0.1f;
+    if (rand() % 10 == 0) h += (rand() % 3 - 1) * 0.1f;
+    if (rand() % 5 == 0) lux += rand() % 3 - 1;
+    appendAt(fromMs + (uint64_t)i * 1000, ALL, t, h, lux);
+  }
+}
+
+/**
+ * @brief The simulator's noisy random walk
+ */
+static void feedNoisy(uint64_t fromMs, uint32_t samples) {
+  float t = 22.0f, h = 45.0f, lux = 300.0f;
+  for (uint32_t i = 0; i < samples; i++) {
+    t += (rand() % 41 - 20) / 100.0f;
+    h += (rand() % 81 - 40) / 100.0f;
+    lux = constrain(lux + rand() % 41 - 20, 0.0f, 1000.0f);
+    appendAt(fromMs + (uint64_t)i * 1000, ALL, t, h, lux);
+  }
+}
+
+// ============================================================================
+// ROUND TRIP
+// ============================================================================
+
+void test_round_trip_steady_rate() {
+  feedNoisy(5000, 5000);
+  checkRoundTrip();
+  TEST_ASSERT_GREATER_THAN(1, history->blocksUsed());
+}
+
+void test_round_trip_sub_range() {
+  feedNoisy(0, 3000);
+  checkRoundTrip(1234000, 2345000);
+  TEST_ASSERT_EQUAL_UINT64(1234000, decoded.front().ms);
+  TEST_ASSERT_EQUAL_UINT64(2345000, decoded.back().ms);
+}
+
+void test_round_trip_across_millis_wrap() {
+  // millis() wraps to 0 halfway through; history time keeps counting
+  uint64_t start = 0xFFFFFFFFull - 1500 * 1000;
+  feedNoisy(start, 3000);
+  checkRoundTrip();
+  TEST_ASSERT_EQUAL_UINT64(start + 2999 * 1000, decoded.back().ms);
+  for (size_t i = 1; i < decoded.size(); i++) {
+    TEST_ASSERT_EQUAL_UINT64(1000, decoded[i].ms - decoded[i - 1].ms);
+  }
+}
+
+void test_round_trip_with_time_base() {
+  history->setTimeBase(10ull * 24 * 3600 * 1000);   // Ten days of earlier history
+  feedNoisy(0, 500);
+  checkRoundTrip();
+  TEST_ASSERT_EQUAL_UINT64(history->timeBase(), decoded.front().ms);
+}
+
+void test_round_trip_large_value_deltas() {
+  // Full-scale jumps need the 32-bit value class
+  for (uint32_t i = 0; i < 400; i++) {
+    bool hi = i % 2;
+    appendAt((uint64_t)i * 1000, ALL, hi ? 85.0f : -40.0f, hi ? 100.0f : 0.0f,
+             hi ? 120000.0f : 0.0f);
+  }
+  appendAt(400000, ALL, 2000000.0f, -2000000.0f, 4.0e8f);
+  appendAt(401000, ALL, -2000000.0f, 2000000.0f, 0.0f);
+  checkRoundTrip();
+}
+
+void test_round_trip_large_time_deltas() {
+  // Jittered period, then gaps of an hour, a day and 30 days
+  uint64_t ms = 0;
+  for (uint32_t i = 0; i < 300; i++) {
+    ms += 700 + rand() % 600;
+    appendAt(ms, ALL, 20.0f + i % 7, 40.0f, 100.0f);
+  }
+  static const uint64_t GAPS[] = { 3600000ull, 86400000ull, 30ull * 86400000ull, 1 };
+  for (uint64_t gap : GAPS) {
+    ms += gap;
+    appendAt(ms, ALL, 21.0f, 41.0f, 101.0f);
+    ms += 1000;
+    appendAt(ms, ALL, 21.1f, 41.0f, 101.0f);
+  }
+  checkRoundTrip();
+}
+
+void test_channel_mask_change_opens_a_block() {
+  uint8_t masks[] = { ALL, SENSOR_BIT(SENSOR_LIGHT), ALL,
+                      SENSOR_BIT(SENSOR_TEMPERATURE) | SENSOR_BIT(SENSOR_HUMIDITY) };
+  uint64_t ms = 0;
+  for (uint8_t m : masks) {
+    for (uint32_t i = 0; i < 50; i++, ms += 1000) appendAt(ms, m, 23.4f, 55.5f, 321.0f + i);
+  }
+  TEST_ASSERT_EQUAL_UINT16(4, history->blocksUsed());
+  checkRoundTrip();
+}
+
+// One channel at a steady 1 s period, value unchanged. The second sample
+// costs 17 bits of timestamp (first delta, zigzag 2000) + 1 bit of value,
+// every later one 1 + 1 bits.
+static const uint16_t FIRST_DELTA_BITS = 17 + 1;
+
+void test_block_exactly_full() {
+  const uint16_t perBlock = 2 + (Sensor_History::DATA_BYTES * 8 - FIRST_DELTA_BITS) / 2;
+  for (uint32_t i = 0; i < perBlock; i++) {
+    appendAt((uint64_t)i * 1000, SENSOR_BIT(SENSOR_TEMPERATURE), 19.5f, 0, 0);
+  }
+  TEST_ASSERT_EQUAL_UINT16(1, history->blocksUsed());
+  TEST_ASSERT_NULL(history->lastSealed());
+
+  appendAt((uint64_t)perBlock * 1000, SENSOR_BIT(SENSOR_TEMPERATURE), 19.5f, 0, 0);
+  TEST_ASSERT_EQUAL_UINT16(2, history->blocksUsed());
+  const Sensor_History::Block* full = history->lastSealed();
+  TEST_ASSERT_NOT_NULL(full);
+  TEST_ASSERT_EQUAL_UINT16(perBlock, full->count);
+  TEST_ASSERT_EQUAL_UINT16(Sensor_History::DATA_BYTES * 8, full->bits);
+  TEST_ASSERT_EQUAL_UINT32((perBlock - 1) * 1000, full->spanMs);
+  checkRoundTrip();
+}
+
+void test_wide_sample_does_not_fit_a_nearly_full_block() {
+  // Two bits short of full: an unchanged sample would fit, a changed value
+  // (1 bit timestamp + 6 bit value) must go to a new block
+  const uint16_t bits = Sensor_History::DATA_BYTES * 8;
+  const uint16_t samples = 2 + (bits - 2 - FIRST_DELTA_BITS) / 2;
+  for (uint32_t i = 0; i < samples; i++) appendAt((uint64_t)i * 1000, SENSOR_BIT(SENSOR_HUMIDITY), 0, 60.0f, 0);
+  TEST_ASSERT_EQUAL_UINT16(1, history->blocksUsed());
+
+  appendAt((uint64_t)samples * 1000, SENSOR_BIT(SENSOR_HUMIDITY), 0, 60.1f, 0);
+  TEST_ASSERT_EQUAL_UINT16(2, history->blocksUsed());
+  TEST_ASSERT_EQUAL_UINT16(bits - 2, history->lastSealed()->bits);
+  TEST_ASSERT_EQUAL_UINT16(samples, history->lastSealed()->count);
+  checkRoundTrip();
+}
+
+void test_ring_drops_oldest_blocks() {
+  feedNoisy(0, 60000);
+  TEST_ASSERT_EQUAL_UINT16(Sensor_History::BLOCK_COUNT, history->blocksUsed());
+  TEST_ASSERT_GREATER_THAN(0, history->blocksDropped());
+  // Only the samples still in RAM come back
+  uint64_t oldest = history->ramOldestMs();
+  checkRoundTrip(oldest, UINT64_MAX);
+  TEST_ASSERT_EQUAL_UINT32(history->sampleCount(), decoded.size());
+}
+
+void test_round_trip_through_the_archive_and_reboot() {
+  static Sensor_Archive archive;
+  TEST_ASSERT_TRUE(archive.begin());
+  history->setArchive(&archive);
+  feedNoisy(0, 40000);
+  history->flush();
+  TEST_ASSERT_GREATER_THAN(0, history->blocksDropped());
+  checkRoundTrip();                      // Older part from flash, rest from RAM
+
+  // Reboot: a fresh archive recovers, a fresh history continues after it
+  static Sensor_Archive rebooted;
+  TEST_ASSERT_TRUE(rebooted.begin());
+  TEST_ASSERT_EQUAL_UINT64(expected.back().ms, rebooted.newestMs());
+  delete history;
+  history = new Sensor_History();
+  history->setArchive(&rebooted);
+  history->setTimeBase(rebooted.newestMs() + 1000);
+  feedNoisy(0, 100);
+  checkRoundTrip();
+  TEST_ASSERT_EQUAL_UINT32(0, rebooted.crcErrors());
+}
+
+// ============================================================================
+// DOWNSAMPLING
+// ============================================================================
+
+void test_downsample_day_buckets() {
+  // More samples per bucket than a 16-bit counter holds (1 Hz, 1 day steps)
+  static Sensor_Archive archive;
+  TEST_ASSERT_TRUE(archive.begin());
+  history->setArchive(&archive);
+  const uint32_t SAMPLES = 200000;
+  const uint32_t DAY_MS = 86400000;
+  for (uint32_t i = 0; i < SAMPLES; i++) {
+    appendAt((uint64_t)i * 1000, SENSOR_BIT(SENSOR_TEMPERATURE), (i & 1) ? 20.1f : 20.0f, 0, 0);
+  }
+  history->flush();
+
+  decoded.clear();
+  TEST_ASSERT_EQUAL_UINT32(SAMPLES, history->downsample(0, UINT64_MAX, DAY_MS, collect, nullptr));
+  TEST_ASSERT_EQUAL_UINT32(3, decoded.size());
+  uint32_t total = 0;
+  for (size_t i = 0; i < decoded.size(); i++) {
+    const Sensor_History::Point& p = decoded[i];
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)i * DAY_MS, p.ms);
+    TEST_ASSERT_EQUAL_UINT32(i < 2 ? DAY_MS / 1000 : SAMPLES - 2 * DAY_MS / 1000, p.samples);
+    TEST_ASSERT_EQUAL_INT(SENSOR_BIT(SENSOR_TEMPERATURE), p.valid);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 20.05f, p.value[SENSOR_TEMPERATURE]);
+    total += p.samples;
+  }
+  TEST_ASSERT_EQUAL_UINT32(SAMPLES, total);
+}
+
+// ============================================================================
+// BENCHMARKS
+// ============================================================================
+
+static float bytesPerSample() {
+  return (float)history->payloadBytes() / history->sampleCount();
+}
+
+static void report(const char* trace) {
+  char msg[160];
+  float bps = bytesPerSample();
+  snprintf(msg, sizeof(msg), "%s: %u samples, %.2f bytes/sample, ratio %.1f:1", trace,
+           (unsigned)history->sampleCount(), bps, Sensor_History::RAW_SAMPLE_BYTES / bps);
+  TEST_MESSAGE(msg);
+}
+
+void test_benchmark_compression_indoor() {
+  feedIndoor(0, 20000);
+  report("indoor");
+  TEST_ASSERT_TRUE(bytesPerSample() <= 2.0f);          // README: about 1-2 bytes
+}
+
+void test_benchmark_compression_noisy() {
+  feedNoisy(0, 20000);
+  report("noisy");
+  TEST_ASSERT_TRUE(bytesPerSample() <= 3.5f);          // README: about 3 bytes
+}
+
+void test_benchmark_throughput() {
+  feedNoisy(0, 30000);
+  uint32_t inRam = history->sampleCount();
+
+  struct Count {
+    static void point(const Sensor_History::Point&, void* ctx) { (*(uint32_t*)ctx)++; }
+  };
+  const int rounds = 20;
+  uint32_t points = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) history->forEach(0, UINT64_MAX, Count::point, &points);
+  double decodeS = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  delete history;
+  history = new Sensor_History();
+  Sensor_Sample s;
+  memset(&s, 0, sizeof(s));
+  s.valid = ALL;
+  t0 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < 100000; i++) {
+    Native::setUs((uint64_t)i * 1000000);
+    s.ms = i * 1000;
+    s.value[SENSOR_TEMPERATURE] = 22.0f + (i % 13) * 0.1f;
+    s.value[SENSOR_LIGHT] = 300.0f + i % 5;
+    history->append(s);
+  }
+  double appendS = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  char msg[128];
+  snprintf(msg, sizeof(msg), "host: decode %.1f M samples/s, append %.1f M samples/s",
+           points / decodeS / 1e6, 100000 / appendS / 1e6);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_EQUAL_UINT32(rounds * inRam, points);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip_steady_rate);
+  RUN_TEST(test_round_trip_sub_range);
+  RUN_TEST(test_round_trip_across_millis_wrap);
+  RUN_TEST(test_round_trip_with_time_base);
+  RUN_TEST(test_round_trip_large_value_deltas);
+  RUN_TEST(test_round_trip_large_time_deltas);
+  RUN_TEST(test_channel_mask_change_opens_a_block);
+  RUN_TEST(test_block_exactly_full);
+  RUN_TEST(test_wide_sample_does_not_fit_a_nearly_full_block);
+  RUN_TEST(test_ring_drops_oldest_blocks);
+  RUN_TEST(test_round_trip_through_the_archive_and_reboot);
+  RUN_TEST(test_downsample_day_buckets);
+  RUN_TEST(test_benchmark_compression_indoor);
+  RUN_TEST(test_benchmark_compression_noisy);
+  RUN_TEST(test_benchmark_throughput);
+  return UNITY_END();
+}
@@ -0,0 +1,220 @@
+/**
+ * @file test_sensor_stats.cpp
+ * @brief Sensor_Stats moments and percentiles against exact computation
+ *
+ * @details
+ * Samples are kept next to the stats in fixed point (the resolution the
+ * stats and the history work in). Exact figures are computed by sorting
+ * the samples that fall in the span the stats report for the window.
+ */
+
+#include <unity.h>
+#include <vector>
+#include "Sensor_Stats.h"
+#include "Sensor_History.h"
+
+static const uint32_t PERIOD_MS = 1000;
+static const float Q[] = { 0.01f, 0.1f, 0.5f, 0.9f, 0.99f };
+
+static Sensor_Stats* stats;
+
+struct Recorded {
+  uint64_t ms;
+  float value[SENSOR_CHANNELS];
+};
+static std::vector<Recorded> recorded;
+
+void setUp() {
+  stats = new Sensor_Stats();
+  recorded.clear();
+  srand(7);
+}
+
+void tearDown() {
+  delete stats;
+}
+
+static float quantize(uint8_t ch, float v) {
+  float scale = Sensor_History::scale(ch);
+  return lroundf(v * scale) / scale;
+}
+
+static void add(uint64_t ms, float t, float h, float lux) {
+  Sensor_Sample s;
+  memset(&s, 0, sizeof(s));
+  s.valid = SENSOR_BIT(SENSOR_TEMPERATURE) | SENSOR_BIT(SENSOR_HUMIDITY) | SENSOR_BIT(SENSOR_LIGHT);
+  s.value[SENSOR_TEMPERATURE] = t;
+  s.value[SENSOR_HUMIDITY] = h;
+  s.value[SENSOR_LIGHT] = lux;
+  stats->add(s, ms);
+
+  Recorded r;
+  r.ms = ms;
+  for (uint8_t ch = 0; ch < SENSOR_CHANNELS; ch++) r.value[ch] = quantize(ch, s.value[ch]);
+  recorded.push_back(r);
+}
+
+static float noise(float amplitude) {
+  return amplitude * ((rand() % 2001) - 1000) / 1000.0f;
+}
+
+/**
+ * @brief Random walk with noise: a day-like temperature / humidity / light trace
+ */
+static void feed(uint64_t fromMs, uint32_t samples) {
+  float t = 22.0f, h = 45.0f, lux = 300.0f;
+  for (uint32_t i = 0; i < samples; i++) {
+    t = constrain(t + noise(0.05f), 5.0f, 40.0f);
+    h = constrain(h + noise(0.2f), 10.0f, 90.0f);
+    lux = constrain(lux * (1.0f + noise(0.02f)), 1.0f, 50000.0f);
+    add(fromMs + (uint64_t)i * PERIOD_MS, t + noise(0.3f), h + noise(1.0f), lux);
+  }
+}
+
+static std::vector<float> exactValues(uint8_t ch, uint64_t fromMs) {
+  std::vector<float> v;
+  for (const Recorded& r : recorded) {
+    if (r.ms >= fromMs) v.push_back(r.value[ch]);
+  }
+  std::sort(v.begin(), v.end());
+  return v;
+}
+
+static float exactPercentile(const std::vector<float>& sorted, float q) {
+  float rank = q * (sorted.size() - 1);
+  size_t k = (size_t)rank;
+  if (k + 1 >= sorted.size()) return sorted.back();
+  return sorted[k] + (sorted[k + 1] - sorted[k]) * (rank - k);
+}
+
+/**
+ * @brief Error bound documented in Sensor_Stats.h: half a sketch bin
+ */
+static float tolerance(uint8_t ch, float value) {
+  switch (ch) {
+    case SENSOR_TEMPERATURE: return 0.3f;
+    case SENSOR_HUMIDITY:    return 0.4f;
+    default:                 return 0.045f * value + 0.5f;   // + rounding to 1 lx
+  }
+}
+
+static void checkPercentiles(Sensor_Stats::Window w) {
+  uint64_t from = stats->sketchFromMs(w);
+  for (uint8_t ch = 0; ch < SENSOR_CHANNELS; ch++) {
+    std::vector<float> exact = exactValues(ch, from);
+    TEST_ASSERT_GREATER_THAN(0, exact.size());
+    for (float q : Q) {
+      float e = exactPercentile(exact, q);
+      float sketch = stats->percentile(w, ch, q);
+      char msg[96];
+      snprintf(msg, sizeof(msg), "window %s channel %u q %.2f", Sensor_Stats::windowName(w), ch, q);
+      TEST_ASSERT_FLOAT_WITHIN_MESSAGE(tolerance(ch, e), e, sketch, msg);
+    }
+  }
+}
+
+static void checkMoments(Sensor_Stats::Window w) {
+  for (uint8_t ch = 0; ch < SENSOR_CHANNELS; ch++) {
+    Sensor_Stats::Summary s;
+    TEST_ASSERT_TRUE(stats->summary(w, ch, s));
+    std::vector<float> exact = exactValues(ch, s.fromMs);
+
+    double sum = 0, sumSq = 0;
+    for (float v : exact) {
+      sum += v;
+      sumSq += (double)v * v;
+    }
+    double mean = sum / exact.size();
+    double stddev = sqrt(fmax(0.0, sumSq / exact.size() - mean * mean));
+
+    TEST_ASSERT_EQUAL_UINT32(exact.size(), s.count);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3 * fabs(mean) + 1e-3, mean, s.mean);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3 * stddev + 1e-3, stddev, s.stddev);
+    TEST_ASSERT_EQUAL_FLOAT(exact.front(), s.min);
+    TEST_ASSERT_EQUAL_FLOAT(exact.back(), s.max);
+  }
+}
+
+// ============================================================================
+// TESTS
+// ============================================================================
+
+void test_empty_window_has_no_data() {
+  Sensor_Stats::Summary s;
+  TEST_ASSERT_FALSE(stats->summary(Sensor_Stats::WINDOW_1H, SENSOR_TEMPERATURE, s));
+  TEST_ASSERT_FLOAT_IS_NAN(stats->percentile(Sensor_Stats::WINDOW_1H, SENSOR_TEMPERATURE, 0.5f));
+}
+
+void test_percentiles_1m_match_exact() {
+  feed(0, 600);
+  checkPercentiles(Sensor_Stats::WINDOW_1M);
+}
+
+void test_percentiles_1h_match_exact() {
+  feed(0, 3 * 3600);
+  checkPercentiles(Sensor_Stats::WINDOW_1H);
+}
+
+void test_percentiles_24h_match_exact() {
+  feed(0, 30 * 3600);
+  checkPercentiles(Sensor_Stats::WINDOW_24H);
+}
+
+void test_moments_match_exact() {
+  feed(0, 3 * 3600);
+  checkMoments(Sensor_Stats::WINDOW_1M);
+  checkMoments(Sensor_Stats::WINDOW_1H);
+  checkMoments(Sensor_Stats::WINDOW_24H);
+}
+
+void test_constant_signal_is_exact() {
+  for (uint32_t i = 0; i < 1800; i++) add((uint64_t)i * PERIOD_MS, 21.4f, 50.0f, 120.0f);
+  for (float q : Q) {
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 21.4f, stats->percentile(Sensor_Stats::WINDOW_1H, SENSOR_TEMPERATURE, q));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 120.0f, stats->percentile(Sensor_Stats::WINDOW_1H, SENSOR_LIGHT, q));
+  }
+}
+
+void test_values_outside_the_bins_are_clamped_to_min_max() {
+  // Below the -20 °C and above the 65536 lx end bins
+  for (uint32_t i = 0; i < 600; i++) add((uint64_t)i * PERIOD_MS, -35.0f - i % 3, 50.0f, 90000.0f + i);
+  Sensor_Stats::Summary s;
+  TEST_ASSERT_TRUE(stats->summary(Sensor_Stats::WINDOW_1H, SENSOR_TEMPERATURE, s));
+  float p0 = stats->percentile(Sensor_Stats::WINDOW_1H, SENSOR_TEMPERATURE, 0.0f);
+  float p100 = stats->percentile(Sensor_Stats::WINDOW_1H, SENSOR_TEMPERATURE, 1.0f);
+  TEST_ASSERT_TRUE(p0 >= s.min);
+  TEST_ASSERT_TRUE(p100 <= s.max);
+  TEST_ASSERT_TRUE(stats->percentile(Sensor_Stats::WINDOW_1H, SENSOR_LIGHT, 1.0f) <= 90599.0f);
+}
+
+void test_gap_longer_than_window_starts_over() {
+  feed(0, 600);
+  // 10 minutes later the 1 min window only holds the new samples
+  for (uint32_t i = 0; i < 30; i++) add(1200000 + (uint64_t)i * PERIOD_MS, 30.0f, 60.0f, 10.0f);
+  Sensor_Stats::Summary s;
+  TEST_ASSERT_TRUE(stats->summary(Sensor_Stats::WINDOW_1M, SENSOR_TEMPERATURE, s));
+  TEST_ASSERT_EQUAL_UINT32(30, s.count);
+  TEST_ASSERT_EQUAL_FLOAT(30.0f, s.min);
+  TEST_ASSERT_EQUAL_FLOAT(30.0f, stats->percentile(Sensor_Stats::WINDOW_1M, SENSOR_TEMPERATURE, 0.5f));
+}
+
+void test_times_past_32_bits() {
+  // History time is 64-bit; windows keep sliding past 2^32 ms
+  feed(0xFFFFFFFFull - 1800 * PERIOD_MS, 3600);
+  checkMoments(Sensor_Stats::WINDOW_1H);
+  checkPercentiles(Sensor_Stats::WINDOW_1H);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_window_has_no_data);
+  RUN_TEST(test_percentiles_1m_match_exact);
+  RUN_TEST(test_percentiles_1h_match_exact);
+  RUN_TEST(test_percentiles_24h_match_exact);
+  RUN_TEST(test_moments_match_exact);
+  RUN_TEST(test_constant_signal_is_exact);
+  RUN_TEST(test_values_outside_the_bins_are_clamped_to_min_max);
+  RUN_TEST(test_gap_longer_than_window_starts_over);
+  RUN_TEST(test_times_past_32_bits);
+  return UNITY_END();
+}